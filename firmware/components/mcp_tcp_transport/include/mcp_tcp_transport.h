@@ -5,6 +5,52 @@
  * This component provides TCP transport for the Model Context Protocol (MCP) server
  * running on ESP32-C6. It creates a TCP server on port 8080 when WiFi is connected
  * and handles JSON-RPC communication with MCP clients.
+ * 
+ * A single task serves the listening socket and all connections with
+ * select() and non-blocking reads, so a connection costs its receive
+ * buffer (buffer_size) rather than a task stack. The client table holds
+ * max_clients connections and is allocated by mcp_tcp_transport_init();
+ * each connection also uses one lwIP socket, as do the listener and the
+ * reactor's loopback wake-up socket.
+ * 
+ * Requests are newline-delimited. Each line is handed to the MCP server's
+ * worker pool, so a client may pipeline several requests on one connection;
+ * responses are written as soon as they complete, possibly out of order,
+ * and are correlated by their JSON-RPC id. Cancellations
+ * (notifications/cancelled) are not held back by the in-flight limit.
+ * 
+ * Sockets are never written with blocking calls. A message is written at
+ * once if the connection has nothing queued; whatever the socket does not
+ * take goes to the connection's transmit ring (tx_buffer_size), which the
+ * task drains as the peer reads, several queued messages per writev().
+ * While tx_high_water bytes or more are queued, the connection's requests
+ * are not read, so a client that does not read its responses stops being
+ * served instead of holding up the others. Nothing waits for ring space: a
+ * message that does not fit is copied to the heap and queued next to the
+ * ring. Each in-flight request has a queue entry reserved for its response,
+ * so a server worker never waits for a client; a request is only admitted
+ * while its response could be queued. Other messages take one of the
+ * connection's broadcast_backlog queue entries, and are dropped when none
+ * is free.
+ * 
+ * A broadcast is encoded once per wire format into a reference-counted
+ * buffer, and every connection queues a reference to it rather than a copy.
+ * Each connection drains its queue at its own pace. A connection with
+ * broadcast_backlog broadcasts still queued has fallen behind, and
+ * slow_client_policy decides what happens: its oldest unsent broadcast is
+ * discarded (coalescing to the newest), or the connection is closed.
+ * 
+ * Admission control runs before a request is queued. Each client has a
+ * token bucket limiting its request rate. Every client is refused new work
+ * while free heap is below a threshold, and every client with requests in
+ * flight while the server's request queue is deeper than one.
+ * A refused request is answered at once with a JSON-RPC error (code
+ * MCP_ERROR_RATE_LIMITED or MCP_ERROR_OVERLOADED) carrying its id and a
+ * data.retryAfterMs hint, so a flooding client cannot starve the others.
+ * 
+ * A client that negotiates CBOR during initialize switches the connection
+ * to a CBOR sequence once the initialize response has been sent: messages
+ * in both directions are then back-to-back CBOR items with no delimiter.
  */
 
 #ifndef MCP_TCP_TRANSPORT_H
@@ -22,18 +68,35 @@
 extern "C" {
 #endif
 
+/**
+ * @brief Handling of a client that falls behind on broadcasts
+ */
+typedef enum {
+    MCP_TCP_SLOW_CLIENT_COALESCE = 0,   ///< Discard its oldest unsent broadcast for the newest
+    MCP_TCP_SLOW_CLIENT_DISCONNECT      ///< Close the connection
+} mcp_tcp_slow_client_policy_t;
+
 /**
  * @brief MCP TCP Transport Configuration
  */
 typedef struct {
     uint16_t server_port;               ///< TCP server port (default: 8080)
-    uint8_t max_clients;                ///< Maximum concurrent clients
-    uint32_t buffer_size;               ///< Buffer size for messages
-    uint32_t task_stack_size;           ///< Task stack size
-    uint8_t task_priority;              ///< Task priority
+    uint8_t max_clients;                ///< Maximum concurrent clients (size of the client table)
+    uint32_t buffer_size;               ///< Receive buffer per connection, longest message
+    uint32_t tx_buffer_size;            ///< Transmit ring per connection; what does not fit is queued as copies
+    uint32_t tx_high_water;             ///< Stop reading a client while this many bytes are queued
+    uint8_t broadcast_backlog;          ///< Broadcasts queued per client before it counts as slow
+    mcp_tcp_slow_client_policy_t slow_client_policy; ///< What happens to a slow client
+    uint32_t task_stack_size;           ///< Server task stack size
+    uint8_t task_priority;              ///< Server task priority
     uint32_t keep_alive_idle;           ///< Keep-alive idle time (seconds)
     uint32_t keep_alive_interval;       ///< Keep-alive interval (seconds)
     uint32_t keep_alive_count;          ///< Keep-alive probe count
+    uint8_t max_in_flight;              ///< Requests a client may have pending at once
+    uint16_t rate_limit_rps;            ///< Sustained messages per second per client (0: unlimited)
+    uint16_t rate_limit_burst;          ///< Messages a client may send back to back
+    uint32_t shed_free_heap;            ///< Shed requests while free heap is below this (bytes, 0: off)
+    uint8_t shed_queue_depth;           ///< Shed requests of clients with some in flight while this many wait for a worker (0: off)
 } mcp_tcp_transport_config_t;
 
 /**
@@ -57,6 +120,14 @@ typedef struct {
     uint32_t bytes_received;            ///< Total bytes received
     uint32_t bytes_sent;                ///< Total bytes sent
     uint32_t errors;                    ///< Total errors
+    uint32_t max_in_flight;             ///< Configured per-connection in-flight limit
+    uint32_t in_flight;                 ///< Requests currently executing or queued
+    uint32_t in_flight_peak;            ///< Highest in_flight observed
+    uint32_t requests_shed;             ///< Messages refused by admission control
+    uint32_t requests_rate_limited;     ///< Of those, refused by a client's rate limit
+    uint32_t messages_dropped;          ///< Messages not sent because a transmit queue was full
+    uint32_t tx_backpressured;          ///< Times a client stopped being read for unsent output
+    uint32_t slow_clients_closed;       ///< Connections closed for falling behind on broadcasts
     uint64_t uptime_ms;                 ///< Transport uptime in milliseconds
 } mcp_tcp_transport_stats_t;
 
@@ -72,11 +143,20 @@ typedef void* mcp_tcp_transport_handle_t;
     .server_port = 8080, \
     .max_clients = 4, \
     .buffer_size = 2048, \
+    .tx_buffer_size = 2048, \
+    .tx_high_water = 1024, \
+    .broadcast_backlog = 8, \
+    .slow_client_policy = MCP_TCP_SLOW_CLIENT_COALESCE, \
     .task_stack_size = 8192, \
     .task_priority = 6, \
     .keep_alive_idle = 7200, \
     .keep_alive_interval = 75, \
-    .keep_alive_count = 9 \
+    .keep_alive_count = 9, \
+    .max_in_flight = 4, \
+    .rate_limit_rps = 20, \
+    .rate_limit_burst = 10, \
+    .shed_free_heap = 16384, \
+    .shed_queue_depth = 6 \
 }
 
 /**
@@ -155,12 +235,18 @@ bool mcp_tcp_transport_is_running(mcp_tcp_transport_handle_t transport_handle);
  * 
  * Sends a JSON-RPC response message to a specific client.
  * This function is typically called by the MCP server.
+ * The message is written as one line; the newline is appended here.
+ * Clients in a CBOR session receive the message transcoded to CBOR.
+ * Never blocks: a message that does not fit in the client's transmit
+ * queue is dropped. Messages longer than tx_buffer_size are sent from a
+ * heap copy.
  * 
  * @param transport_handle Transport handle
  * @param client_id Client identifier
  * @param message JSON message to send
  * @param message_len Message length
- * @return ESP_OK on success, error code otherwise
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the transmit queue is full
+ *         or the copy could not be allocated, error code otherwise
  */
 esp_err_t mcp_tcp_transport_send_message(mcp_tcp_transport_handle_t transport_handle,
                                          uint32_t client_id,
@@ -170,12 +256,17 @@ esp_err_t mcp_tcp_transport_send_message(mcp_tcp_transport_handle_t transport_ha
 /**
  * @brief Broadcast Message to All Clients
  * 
- * Sends a message to all connected clients.
+ * Sends a message to all connected clients, as one newline-terminated line
+ * (or one CBOR item for clients in a CBOR session). The message is encoded
+ * once per wire format and shared by every connection's transmit queue;
+ * the call never blocks on a slow client, which is handled according to
+ * slow_client_policy instead.
  * 
  * @param transport_handle Transport handle
  * @param message JSON message to send
  * @param message_len Message length
- * @return ESP_OK on success, error code otherwise
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the message could not be
+ *         allocated or was not queued for some client, error code otherwise
  */
 esp_err_t mcp_tcp_transport_broadcast_message(mcp_tcp_transport_handle_t transport_handle,
                                               const char *message,
@@ -193,7 +284,9 @@ void mcp_tcp_transport_reset_stats(mcp_tcp_transport_handle_t transport_handle);
 /**
  * @brief Set MCP Server Handle
  * 
- * Associates the transport with an MCP server for message processing.
+ * Associates the transport with an MCP server for message processing, and
+ * registers the transport as the server's notification handler so that
+ * subscription updates reach the subscribing connection.
  * 
  * @param transport_handle Transport handle
  * @param mcp_server_handle MCP server handle
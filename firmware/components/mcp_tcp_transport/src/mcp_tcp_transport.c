@@ -5,54 +5,219 @@
  * This component provides TCP transport for the Model Context Protocol (MCP) server
  * running on ESP32-C6. It creates a TCP server on port 8080 when WiFi is connected
  * and handles JSON-RPC communication with MCP clients.
+ * 
+ * One reactor task owns every socket. It waits in select() on the listening
+ * socket, each client connection and a loopback wake-up socket, and reads
+ * without blocking. Each connection is a small state machine:
+ * 
+ *   FREE -> OPEN        accepted into a free slot
+ *   OPEN -> CLOSING     peer closed, socket error or fatal framing error
+ *   CLOSING -> FREE     all of its requests have completed
+ * 
+ * A connection at its in-flight limit, or whose request found the server
+ * queue full, is stalled: its next message stays buffered and its socket is
+ * left out of the read set until a worker completes a request and wakes the
+ * reactor.
+ * 
+ * Requests are not copied: each is submitted as a slice of the connection's
+ * receive buffer, which is therefore not compacted or reused while any of
+ * them is in flight. Workers render the response into their own buffer and
+ * the newline is appended there, so each response leaves in one send.
+ * 
+ * Sockets are non-blocking in both directions. Whoever produces a message
+ * writes it directly while the connection has nothing queued, and queues
+ * the rest in the connection's transmit ring when the socket is full. The
+ * reactor then waits for the socket to become writable and drains the ring,
+ * coalescing everything queued into one writev(). A connection with
+ * tx_high_water bytes or more queued is not read (backpressure) until the
+ * ring drains below that mark.
+ * 
+ * Broadcasts are not copied into the rings. They are encoded once into a
+ * reference-counted buffer, and each connection queues a reference next to
+ * its ring, marked with the ring position it follows so that the stream
+ * keeps the order in which messages were queued. A connection whose
+ * reference queue is full is handled by slow_client_policy. A message
+ * that does not fit the ring (a large tools/list or debug/trace_dump reply,
+ * or any reply once the ring is full) is copied into such a buffer and
+ * queued by reference too, so no producer ever waits for a connection.
+ * Responses have reference entries of their own, one per in-flight slot,
+ * and a request only takes a slot while its response is sure to find one.
  */
 
 #include <string.h>
+#include <stdatomic.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
 
 #include "mcp_tcp_transport.h"
 #include "mcp_server_simple.h"
+#include "mcp_json_writer.h"
+#include "mcp_cbor.h"
+#include "mcp_trace.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_system.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
-#include "cJSON.h"
 
 static const char *TAG = "mcp_tcp_transport";
 
+/* Retry hint for requests shed because the device is overloaded */
+#define MCP_TCP_OVERLOAD_RETRY_MS   200
+
+/* Rate limit credit of one message, in millionths so refills stay exact */
+#define MCP_TCP_TOKEN               1000000ULL
+
+/* Reactor wait while nothing is stalled; stop() wakes it sooner */
+#define MCP_TCP_IDLE_WAIT_MS        1000
+
+/* Reactor wait while a client retries a request refused by a full queue */
+#define MCP_TCP_RETRY_WAIT_MS       10
+
+/* Pieces gathered into one writev() when draining a connection */
+#define MCP_TCP_TX_IOV_MAX          8
+
+struct mcp_tcp_transport;
+
 /**
- * @brief Client connection structure
+ * @brief Receive bytes of a connection, shared with the requests read from them
+ * 
+ * A request that outlives its connection (MCP_RESPONSE_TIMEOUT_MS) still
+ * reads its slice and completes through client, so the last reference
+ * frees the block rather than the connection. The connection's slot only
+ * takes back in-flight slots of requests read into its current block.
+ */
+typedef struct {
+    atomic_uint refs;                   ///< The connection plus each request submitted from it
+    struct mcp_tcp_client *client;      ///< Connection the requests complete to
+    char data[];                        ///< buffer_size bytes
+} mcp_tcp_rx_block_t;
+
+/**
+ * @brief Receive buffer of a connection
+ * 
+ * Framed messages are handed to the server in place, as slices of data.
+ * Consuming a message only advances head; the unconsumed rest is moved to
+ * the front when the free space at the end runs out, not after every read.
+ * Bytes before head stay untouched while requests borrowed from them are
+ * in flight (the buffer is pinned).
+ */
+typedef struct {
+    mcp_tcp_rx_block_t *block;          ///< Allocated per connection, holds data
+    char *data;                         ///< block->data
+    size_t head;                        ///< First unconsumed byte
+    size_t tail;                        ///< End of the received bytes
+    size_t scanned;                     ///< Bytes after head known to hold no newline
+    bool discarding;                    ///< Dropping the rest of an oversized line
+} mcp_tcp_rx_t;
+
+/**
+ * @brief Immutable message shared by the connections it is broadcast to
+ */
+typedef struct {
+    atomic_uint refs;                   ///< Queue entries and broadcasters holding it
+    size_t len;                         ///< Frame length, delimiter included
+    char data[];                        ///< Frame in one wire format
+} mcp_tcp_shared_t;
+
+/**
+ * @brief Kind of a queued message, which decides the queue entries it may take
+ */
+typedef enum {
+    MCP_TCP_TX_MESSAGE = 0,             ///< Notification or error; shares the broadcast_backlog entries
+    MCP_TCP_TX_BROADCAST,               ///< Broadcast; slow_client_policy may drop it
+    MCP_TCP_TX_RESPONSE,                ///< Response to a request; takes an entry reserved for it
+} mcp_tcp_tx_kind_t;
+
+/**
+ * @brief Shared message queued on a connection
+ */
+typedef struct {
+    mcp_tcp_shared_t *message;          ///< Reference held by the queue
+    size_t offset;                      ///< Bytes already written
+    size_t after;                       ///< Value of tx.appended when queued; ring bytes before it go first
+    mcp_tcp_tx_kind_t kind;             ///< What the message is
+} mcp_tcp_tx_ref_t;
+
+/**
+ * @brief Transmit queue of a connection: a byte ring plus shared messages
+ * 
+ * Messages are queued whole while the client's send_lock is held, so they
+ * never interleave. Only producers append and only the reactor consumes; a
+ * producer writes to the socket itself only while nothing is queued, which
+ * keeps the byte order intact without holding the lock across writes.
  */
 typedef struct {
+    char *data;                         ///< tx_buffer_size bytes, allocated per connection
+    size_t head;                        ///< First queued byte
+    size_t len;                         ///< Queued bytes
+    size_t appended;                    ///< Bytes ever appended to the ring (wraps)
+    mcp_tcp_tx_ref_t *refs;             ///< tx_ref_capacity() entries, allocated per slot
+    uint16_t ref_head;                  ///< Oldest queued shared message
+    uint16_t ref_count;                 ///< Queued shared messages
+    uint16_t ref_busy;                  ///< Of those, being written by the reactor right now
+    uint8_t response_refs;              ///< Of those, responses (at most max_in_flight)
+} mcp_tcp_tx_t;
+
+/**
+ * @brief Client connection state
+ */
+typedef enum {
+    MCP_TCP_CLIENT_FREE = 0,            ///< Slot unused
+    MCP_TCP_CLIENT_OPEN,                ///< Connected, read by the reactor
+    MCP_TCP_CLIENT_CLOSING              ///< Socket closed, requests still in flight
+} mcp_tcp_client_state_t;
+
+/**
+ * @brief Client connection structure
+ */
+typedef struct mcp_tcp_client {
     int socket;                         ///< Client socket descriptor
     uint32_t client_id;                 ///< Unique client identifier
     struct sockaddr_in addr;            ///< Client address
-    bool connected;                     ///< Connection status
+    volatile mcp_tcp_client_state_t state; ///< Connection state
     uint64_t connect_time;              ///< Connection timestamp
+    int64_t close_time;                 ///< When the connection entered CLOSING (us)
+    mcp_tcp_rx_t rx;                    ///< Received bytes not yet handed to the server
+    atomic_bool stalled;                ///< Head message waits for an in-flight slot or queue space
+    bool backpressured;                 ///< Not read until its transmit ring drains
+    atomic_bool send_failed;            ///< A write failed; the reactor closes the connection
+    bool admitted;                      ///< Head message already passed admission control
     uint32_t messages_received;         ///< Messages received from this client
     uint32_t messages_sent;             ///< Messages sent to this client
+    int slot;                           ///< Index in the transport's client table
+    struct mcp_tcp_transport *transport; ///< Owning transport
+    mcp_tcp_tx_t tx;                    ///< Bytes waiting for the socket to become writable
+    SemaphoreHandle_t send_lock;        ///< Guards tx and writes to the socket
+    SemaphoreHandle_t in_flight;        ///< Counts free in-flight request slots
+    atomic_uint urgent;                 ///< Cancellations submitted and not yet completed (they hold no slot)
+    mcp_wire_format_t format;           ///< Session encoding negotiated by initialize
+    uint64_t tokens;                    ///< Rate limit credit (MCP_TCP_TOKEN per message)
+    int64_t tokens_updated;             ///< Last refill of the credit (us)
 } mcp_tcp_client_t;
 
 /**
  * @brief MCP TCP Transport Structure
  */
-typedef struct {
+typedef struct mcp_tcp_transport {
     mcp_tcp_transport_config_t config;  ///< Transport configuration
     mcp_tcp_transport_status_t status;  ///< Current status
     mcp_tcp_transport_stats_t stats;    ///< Transport statistics
     
     int server_socket;                  ///< Server socket descriptor
-    TaskHandle_t server_task;           ///< Server task handle
-    TaskHandle_t client_tasks[4];       ///< Client handler task handles
+    int wake_socket;                    ///< Loopback UDP socket that wakes the reactor
+    TaskHandle_t server_task;           ///< Reactor task handle
+    SemaphoreHandle_t stopped;          ///< Given by the reactor when it exits
     SemaphoreHandle_t mutex;            ///< Synchronization mutex
     
-    mcp_tcp_client_t clients[4];        ///< Client connections
+    mcp_tcp_client_t *clients;          ///< Client connections (config.max_clients)
     uint8_t client_count;               ///< Active client count
     uint32_t next_client_id;            ///< Next client ID to assign
     
@@ -64,14 +229,76 @@ typedef struct {
 
 /* Forward declarations */
 static void mcp_tcp_server_task(void *arg);
-static void mcp_tcp_client_task(void *arg);
+static int open_server_socket(mcp_tcp_transport_t *transport);
+static int open_wake_socket(void);
+static void wake_reactor(mcp_tcp_transport_t *transport);
+static void accept_clients(mcp_tcp_transport_t *transport);
+static void read_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client);
+static void process_client_input(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client);
+static char *rx_reserve(mcp_tcp_rx_t *rx, size_t size, bool pinned, size_t *space);
+static bool rx_pinned(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client);
+static void rx_consume(mcp_tcp_rx_t *rx, size_t len);
+static bool rx_skip_line(mcp_tcp_rx_t *rx);
+static void rx_block_release(mcp_tcp_rx_block_t *block);
+static esp_err_t shared_create(mcp_wire_format_t format,
+                               const char *message,
+                               size_t message_len,
+                               mcp_tcp_shared_t **shared);
+static mcp_tcp_shared_t *shared_gather(const struct iovec *parts, int count, size_t len);
+static void shared_release(mcp_tcp_shared_t *shared);
+static mcp_tcp_tx_ref_t *tx_ref(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx, int index);
+static size_t tx_ring_before(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx);
+static int tx_ref_capacity(mcp_tcp_transport_t *transport);
+static bool tx_ref_free(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx, mcp_tcp_tx_kind_t kind);
+static void tx_push_ref(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx,
+                        mcp_tcp_shared_t *message, size_t offset, mcp_tcp_tx_kind_t kind);
+static void tx_drop_ref(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx, int index);
+static void tx_reset(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx);
+static esp_err_t tx_share(mcp_tcp_client_t *client, mcp_tcp_shared_t *message);
+static size_t tx_queued(mcp_tcp_client_t *client);
+static bool tx_backlogged(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client);
+static void tx_append(mcp_tcp_tx_t *tx, size_t size, const struct iovec *parts, int count, size_t skip);
+static esp_err_t tx_write(mcp_tcp_client_t *client, uint32_t client_id,
+                          const struct iovec *parts, int count, mcp_tcp_tx_kind_t kind);
+static void flush_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client);
+static void close_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client);
+static bool release_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client);
+static void close_all_clients(mcp_tcp_transport_t *transport);
 static esp_err_t handle_client_message(mcp_tcp_transport_t *transport, 
                                        mcp_tcp_client_t *client, 
                                        const char *message, 
                                        size_t message_len);
 static esp_err_t send_client_response(mcp_tcp_client_t *client, 
+                                      uint32_t client_id,
+                                      mcp_wire_format_t format,
                                       const char *response, 
-                                      size_t response_len);
+                                      size_t response_len,
+                                      bool delimited,
+                                      mcp_tcp_tx_kind_t kind);
+static size_t delimit_in_place(mcp_wire_format_t format, char *response, size_t response_len);
+static esp_err_t send_client_message(mcp_tcp_client_t *client,
+                                     uint32_t client_id,
+                                     const char *message,
+                                     size_t message_len);
+static esp_err_t send_client_error(mcp_tcp_client_t *client, int code, const char *message);
+static bool take_in_flight(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client);
+static int admit_request(mcp_tcp_transport_t *transport,
+                         mcp_tcp_client_t *client,
+                         uint32_t *retry_after_ms);
+static esp_err_t shed_request(mcp_tcp_transport_t *transport,
+                              mcp_tcp_client_t *client,
+                              const char *message,
+                              size_t message_len,
+                              int code,
+                              uint32_t retry_after_ms);
+static void on_request_complete(const mcp_message_t *msg,
+                                char *response,
+                                size_t response_len,
+                                esp_err_t status);
+static esp_err_t deliver_notification(uint32_t client_id,
+                                      const char *message,
+                                      size_t message_len,
+                                      void *user_ctx);
 static void cleanup_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client);
 static int find_free_client_slot(mcp_tcp_transport_t *transport);
 
@@ -95,25 +322,70 @@ esp_err_t mcp_tcp_transport_init(const mcp_tcp_transport_config_t *config,
     
     /* Copy configuration */
     memcpy(&transport->config, config, sizeof(mcp_tcp_transport_config_t));
+    if (transport->config.max_in_flight == 0) {
+        transport->config.max_in_flight = 1;
+    }
+    if (transport->config.rate_limit_rps && transport->config.rate_limit_burst == 0) {
+        transport->config.rate_limit_burst = 1;
+    }
+    if (transport->config.max_clients == 0) {
+        transport->config.max_clients = 1;
+    }
+    if (transport->config.tx_buffer_size == 0) {
+        transport->config.tx_buffer_size = transport->config.buffer_size;
+    }
+    if (transport->config.tx_high_water == 0 ||
+        transport->config.tx_high_water > transport->config.tx_buffer_size) {
+        transport->config.tx_high_water = transport->config.tx_buffer_size / 2;
+    }
+    if (transport->config.broadcast_backlog == 0) {
+        transport->config.broadcast_backlog = 1;
+    }
+#ifdef CONFIG_LWIP_MAX_SOCKETS
+    /* The reactor also needs the listening and the wake-up socket */
+    if (transport->config.max_clients > CONFIG_LWIP_MAX_SOCKETS - 2) {
+        ESP_LOGW(TAG, "max_clients %d exceeds CONFIG_LWIP_MAX_SOCKETS, using %d",
+                 transport->config.max_clients, CONFIG_LWIP_MAX_SOCKETS - 2);
+        transport->config.max_clients = CONFIG_LWIP_MAX_SOCKETS - 2;
+    }
+#endif
+    transport->server_socket = -1;
+    transport->wake_socket = -1;
     
     /* Create synchronization objects */
     transport->mutex = xSemaphoreCreateMutex();
-    if (!transport->mutex) {
-        ESP_LOGE(TAG, "Failed to create mutex");
-        free(transport);
+    transport->stopped = xSemaphoreCreateBinary();
+    transport->clients = (mcp_tcp_client_t*)heap_caps_calloc(transport->config.max_clients,
+                                                              sizeof(mcp_tcp_client_t),
+                                                              MALLOC_CAP_DEFAULT);
+    if (!transport->mutex || !transport->stopped || !transport->clients) {
+        ESP_LOGE(TAG, "Failed to allocate transport resources");
+        mcp_tcp_transport_deinit(transport);
         return ESP_ERR_NO_MEM;
     }
     
-    /* Initialize client array */
+    /* Initialize client table; buffers are allocated per connection */
     for (int i = 0; i < transport->config.max_clients; i++) {
-        transport->clients[i].socket = -1;
-        transport->clients[i].connected = false;
-        transport->client_tasks[i] = NULL;
+        mcp_tcp_client_t *client = &transport->clients[i];
+        client->socket = -1;
+        client->state = MCP_TCP_CLIENT_FREE;
+        client->slot = i;
+        client->transport = transport;
+        client->send_lock = xSemaphoreCreateMutex();
+        client->in_flight = xSemaphoreCreateCounting(transport->config.max_in_flight,
+                                                     transport->config.max_in_flight);
+        client->tx.refs = (mcp_tcp_tx_ref_t*)calloc(tx_ref_capacity(transport),
+                                                    sizeof(mcp_tcp_tx_ref_t));
+        if (!client->send_lock || !client->in_flight || !client->tx.refs) {
+            ESP_LOGE(TAG, "Failed to create client synchronization objects");
+            mcp_tcp_transport_deinit(transport);
+            return ESP_ERR_NO_MEM;
+        }
     }
     
     /* Initialize statistics */
     memset(&transport->stats, 0, sizeof(mcp_tcp_transport_stats_t));
-    transport->server_socket = -1;
+    transport->stats.max_in_flight = transport->config.max_in_flight;
     transport->status = MCP_TCP_STATUS_STOPPED;
     transport->next_client_id = 1;
     transport->initialized = true;
@@ -147,7 +419,12 @@ esp_err_t mcp_tcp_transport_start(mcp_tcp_transport_handle_t transport_handle)
     
     transport->status = MCP_TCP_STATUS_STARTING;
     
-    /* Create server task */
+    /* Set before the reactor runs, it exits as soon as this is cleared */
+    transport->running = true;
+    transport->start_time = esp_timer_get_time();
+    xSemaphoreTake(transport->stopped, 0);
+    
+    /* Create reactor task */
     BaseType_t task_ret = xTaskCreate(mcp_tcp_server_task, 
                                      "mcp_tcp_server", 
                                      transport->config.task_stack_size / sizeof(StackType_t),
@@ -156,13 +433,11 @@ esp_err_t mcp_tcp_transport_start(mcp_tcp_transport_handle_t transport_handle)
                                      &transport->server_task);
     if (task_ret != pdPASS) {
         ESP_LOGE(TAG, "Failed to create server task");
+        transport->running = false;
         transport->status = MCP_TCP_STATUS_ERROR;
         return ESP_ERR_NO_MEM;
     }
     
-    transport->running = true;
-    transport->start_time = esp_timer_get_time();
-    
     ESP_LOGI(TAG, "MCP TCP transport started successfully");
     return ESP_OK;
 }
@@ -184,29 +459,15 @@ esp_err_t mcp_tcp_transport_stop(mcp_tcp_transport_handle_t transport_handle)
     ESP_LOGI(TAG, "Stopping MCP TCP transport");
     
     transport->running = false;
-    transport->status = MCP_TCP_STATUS_STOPPED;
-    
-    /* Close server socket */
-    if (transport->server_socket >= 0) {
-        close(transport->server_socket);
-        transport->server_socket = -1;
-    }
-    
-    /* Clean up all clients */
-    if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(1000)) == pdTRUE) {
-        for (int i = 0; i < transport->config.max_clients; i++) {
-            if (transport->clients[i].connected) {
-                cleanup_client(transport, &transport->clients[i]);
-            }
-        }
-        xSemaphoreGive(transport->mutex);
-    }
     
-    /* Wait for server task to finish */
-    if (transport->server_task) {
-        // Task will delete itself
-        transport->server_task = NULL;
+    /* The reactor owns the sockets; it closes them and drains pending
+     * requests before it exits */
+    wake_reactor(transport);
+    if (xSemaphoreTake(transport->stopped, pdMS_TO_TICKS(MCP_RESPONSE_TIMEOUT_MS + 1000)) != pdTRUE) {
+        ESP_LOGW(TAG, "Server task did not stop in time");
     }
+    transport->server_task = NULL;
+    transport->status = MCP_TCP_STATUS_STOPPED;
     
     ESP_LOGI(TAG, "MCP TCP transport stopped");
     return ESP_OK;
@@ -226,7 +487,29 @@ esp_err_t mcp_tcp_transport_deinit(mcp_tcp_transport_handle_t transport_handle)
         mcp_tcp_transport_stop(transport_handle);
     }
     
+    /* Stop the server from publishing through this transport */
+    if (transport->mcp_server_handle) {
+        mcp_server_set_notify_handler(transport->mcp_server_handle, NULL, NULL);
+    }
+    
     /* Clean up synchronization objects */
+    for (int i = 0; transport->clients && i < transport->config.max_clients; i++) {
+        if (transport->clients[i].send_lock) {
+            vSemaphoreDelete(transport->clients[i].send_lock);
+        }
+        if (transport->clients[i].in_flight) {
+            vSemaphoreDelete(transport->clients[i].in_flight);
+        }
+        if (transport->clients[i].rx.block) {
+            rx_block_release(transport->clients[i].rx.block);
+        }
+        free(transport->clients[i].tx.data);
+        free(transport->clients[i].tx.refs);
+    }
+    free(transport->clients);
+    if (transport->stopped) {
+        vSemaphoreDelete(transport->stopped);
+    }
     if (transport->mutex) {
         vSemaphoreDelete(transport->mutex);
     }
@@ -291,8 +574,16 @@ esp_err_t mcp_tcp_transport_set_mcp_server(mcp_tcp_transport_handle_t transport_
     }
     
     mcp_tcp_transport_t *transport = (mcp_tcp_transport_t*)transport_handle;
+    if (transport->mcp_server_handle && transport->mcp_server_handle != mcp_server_handle) {
+        mcp_server_set_notify_handler(transport->mcp_server_handle, NULL, NULL);
+    }
     transport->mcp_server_handle = mcp_server_handle;
     
+    /* Subscription notifications are delivered to the subscribing client */
+    if (mcp_server_handle) {
+        mcp_server_set_notify_handler(mcp_server_handle, deliver_notification, transport);
+    }
+    
     ESP_LOGI(TAG, "MCP server handle associated with TCP transport");
     return ESP_OK;
 }
@@ -331,15 +622,13 @@ esp_err_t mcp_tcp_transport_send_message(mcp_tcp_transport_handle_t transport_ha
     
     mcp_tcp_transport_t *transport = (mcp_tcp_transport_t*)transport_handle;
     
-    if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        for (int i = 0; i < transport->config.max_clients; i++) {
-            if (transport->clients[i].connected && transport->clients[i].client_id == client_id) {
-                esp_err_t ret = send_client_response(&transport->clients[i], message, message_len);
-                xSemaphoreGive(transport->mutex);
-                return ret;
-            }
+    /* Only a hint: the slot may be reused before the message is queued,
+     * which tx_write() refuses under the client's send lock */
+    for (int i = 0; i < transport->config.max_clients; i++) {
+        mcp_tcp_client_t *client = &transport->clients[i];
+        if (client->state == MCP_TCP_CLIENT_OPEN && client->client_id == client_id) {
+            return send_client_message(client, client_id, message, message_len);
         }
-        xSemaphoreGive(transport->mutex);
     }
     
     return ESP_ERR_NOT_FOUND;
@@ -357,20 +646,34 @@ esp_err_t mcp_tcp_transport_broadcast_message(mcp_tcp_transport_handle_t transpo
     mcp_tcp_transport_t *transport = (mcp_tcp_transport_t*)transport_handle;
     esp_err_t result = ESP_OK;
     
-    if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        for (int i = 0; i < transport->config.max_clients; i++) {
-            if (transport->clients[i].connected) {
-                esp_err_t ret = send_client_response(&transport->clients[i], message, message_len);
-                if (ret != ESP_OK) {
-                    result = ret;
-                }
+    /* Encoded at most once per wire format, on first use; each client queues
+     * a reference, so the transport lock is not held */
+    mcp_tcp_shared_t *shared[MCP_WIRE_CBOR + 1] = { NULL };
+    for (int i = 0; i < transport->config.max_clients; i++) {
+        mcp_tcp_client_t *client = &transport->clients[i];
+        if (client->state != MCP_TCP_CLIENT_OPEN) {
+            continue;
+        }
+        mcp_wire_format_t format = client->format;
+        if (!shared[format]) {
+            esp_err_t ret = shared_create(format, message, message_len, &shared[format]);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to encode broadcast: %s", esp_err_to_name(ret));
+                result = ret;
+                continue;
             }
         }
-        xSemaphoreGive(transport->mutex);
-    } else {
-        result = ESP_ERR_TIMEOUT;
+        esp_err_t ret = tx_share(client, shared[format]);
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+            result = ret;
+        }
     }
     
+    for (int i = 0; i <= MCP_WIRE_CBOR; i++) {
+        if (shared[i]) {
+            shared_release(shared[i]);
+        }
+    }
     return result;
 }
 
@@ -384,7 +687,10 @@ void mcp_tcp_transport_reset_stats(mcp_tcp_transport_handle_t transport_handle)
     mcp_tcp_transport_t *transport = (mcp_tcp_transport_t*)transport_handle;
     
     if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        uint32_t in_flight = transport->stats.in_flight;
         memset(&transport->stats, 0, sizeof(mcp_tcp_transport_stats_t));
+        transport->stats.max_in_flight = transport->config.max_in_flight;
+        transport->stats.in_flight = in_flight;
         transport->start_time = esp_timer_get_time();
         
         /* Reset client statistics */
@@ -399,29 +705,153 @@ void mcp_tcp_transport_reset_stats(mcp_tcp_transport_handle_t transport_handle)
     ESP_LOGI(TAG, "Transport statistics reset");
 }
 
-/* TCP Server Task */
+/* TCP Server Task: the reactor serving the listening socket and every client */
 static void mcp_tcp_server_task(void *arg)
 {
     mcp_tcp_transport_t *transport = (mcp_tcp_transport_t*)arg;
     
     ESP_LOGI(TAG, "MCP TCP server task started on port %d", transport->config.server_port);
     
-    /* Create server socket */
-    transport->server_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
-    if (transport->server_socket < 0) {
-        ESP_LOGE(TAG, "Failed to create server socket: %s", strerror(errno));
+    transport->server_socket = open_server_socket(transport);
+    transport->wake_socket = open_wake_socket();
+    if (transport->server_socket < 0 || transport->wake_socket < 0) {
         transport->status = MCP_TCP_STATUS_ERROR;
         goto cleanup;
     }
     
+    transport->status = MCP_TCP_STATUS_LISTENING;
+    ESP_LOGI(TAG, "MCP TCP server listening on port %d", transport->config.server_port);
+    
+    while (transport->running) {
+        fd_set read_set;
+        fd_set write_set;
+        FD_ZERO(&read_set);
+        FD_ZERO(&write_set);
+        FD_SET(transport->server_socket, &read_set);
+        FD_SET(transport->wake_socket, &read_set);
+        int max_fd = (transport->server_socket > transport->wake_socket) ?
+                     transport->server_socket : transport->wake_socket;
+        
+        /* A stalled client is not read; its next message is still buffered.
+         * Completions wake the reactor, a full server queue does not, so
+         * stalled clients are also retried on a short timeout. A client
+         * with too much output queued is only written until it drains. */
+        int wait_ms = MCP_TCP_IDLE_WAIT_MS;
+        for (int i = 0; i < transport->config.max_clients; i++) {
+            mcp_tcp_client_t *client = &transport->clients[i];
+            if (client->state != MCP_TCP_CLIENT_OPEN) {
+                continue;
+            }
+            if (client->socket > max_fd) {
+                max_fd = client->socket;
+            }
+            if (tx_queued(client) > 0) {
+                FD_SET(client->socket, &write_set);
+            }
+            if (tx_backlogged(transport, client)) {
+                continue;
+            }
+            if (atomic_load(&client->stalled)) {
+                wait_ms = MCP_TCP_RETRY_WAIT_MS;
+            } else {
+                FD_SET(client->socket, &read_set);
+            }
+        }
+        
+        struct timeval timeout = {
+            .tv_sec = wait_ms / 1000,
+            .tv_usec = (wait_ms % 1000) * 1000,
+        };
+        int ready = select(max_fd + 1, &read_set, &write_set, NULL, &timeout);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ESP_LOGE(TAG, "select failed: %s", strerror(errno));
+            transport->stats.errors++;
+            transport->status = MCP_TCP_STATUS_ERROR;
+            break;
+        }
+        
+        if (FD_ISSET(transport->wake_socket, &read_set)) {
+            char drain[16];
+            while (recv(transport->wake_socket, drain, sizeof(drain), MSG_DONTWAIT) > 0) {
+            }
+        }
+        
+        if (FD_ISSET(transport->server_socket, &read_set)) {
+            accept_clients(transport);
+        }
+        
+        for (int i = 0; i < transport->config.max_clients; i++) {
+            mcp_tcp_client_t *client = &transport->clients[i];
+            switch (client->state) {
+            case MCP_TCP_CLIENT_OPEN:
+                if (atomic_load(&client->send_failed)) {
+                    close_client(transport, client);
+                    break;
+                }
+                if (FD_ISSET(client->socket, &write_set)) {
+                    flush_client(transport, client);
+                    if (client->state != MCP_TCP_CLIENT_OPEN) {
+                        break;
+                    }
+                }
+                if (tx_backlogged(transport, client)) {
+                    break;
+                }
+                if (atomic_load(&client->stalled)) {
+                    process_client_input(transport, client);
+                } else if (FD_ISSET(client->socket, &read_set)) {
+                    read_client(transport, client);
+                }
+                break;
+            case MCP_TCP_CLIENT_CLOSING:
+                release_client(transport, client);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+cleanup:
+    close_all_clients(transport);
+    
+    if (transport->server_socket >= 0) {
+        close(transport->server_socket);
+        transport->server_socket = -1;
+    }
+    if (transport->wake_socket >= 0) {
+        close(transport->wake_socket);
+        transport->wake_socket = -1;
+    }
+    
+    if (transport->status != MCP_TCP_STATUS_ERROR) {
+        transport->status = MCP_TCP_STATUS_STOPPED;
+    }
+    ESP_LOGI(TAG, "MCP TCP server task stopped");
+    xSemaphoreGive(transport->stopped);
+    vTaskDelete(NULL);
+}
+
+/* Create the non-blocking listening socket */
+static int open_server_socket(mcp_tcp_transport_t *transport)
+{
+    int server_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (server_socket < 0) {
+        ESP_LOGE(TAG, "Failed to create server socket: %s", strerror(errno));
+        return -1;
+    }
+    
     /* Set socket options */
     int opt = 1;
-    if (setsockopt(transport->server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+    if (setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
         ESP_LOGW(TAG, "Failed to set SO_REUSEADDR: %s", strerror(errno));
     }
     
     /* Set keep-alive options */
-    if (setsockopt(transport->server_socket, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt)) < 0) {
+    if (setsockopt(server_socket, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt)) < 0) {
         ESP_LOGW(TAG, "Failed to set SO_KEEPALIVE: %s", strerror(errno));
     }
     
@@ -432,272 +862,1238 @@ static void mcp_tcp_server_task(void *arg)
     server_addr.sin_addr.s_addr = htonl(INADDR_ANY);
     server_addr.sin_port = htons(transport->config.server_port);
     
-    if (bind(transport->server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+    if (bind(server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         ESP_LOGE(TAG, "Failed to bind server socket: %s", strerror(errno));
-        transport->status = MCP_TCP_STATUS_ERROR;
-        goto cleanup;
+        close(server_socket);
+        return -1;
     }
     
     /* Listen for connections */
-    if (listen(transport->server_socket, transport->config.max_clients) < 0) {
+    if (listen(server_socket, transport->config.max_clients) < 0) {
         ESP_LOGE(TAG, "Failed to listen on server socket: %s", strerror(errno));
-        transport->status = MCP_TCP_STATUS_ERROR;
-        goto cleanup;
+        close(server_socket);
+        return -1;
     }
     
-    transport->status = MCP_TCP_STATUS_LISTENING;
-    ESP_LOGI(TAG, "MCP TCP server listening on port %d", transport->config.server_port);
+    /* The reactor accepts until the backlog is empty */
+    fcntl(server_socket, F_SETFL, fcntl(server_socket, F_GETFL, 0) | O_NONBLOCK);
+    return server_socket;
+}
+
+/* Create the loopback UDP socket other tasks send to to wake the reactor */
+static int open_wake_socket(void)
+{
+    int wake_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (wake_socket < 0) {
+        ESP_LOGE(TAG, "Failed to create wake-up socket: %s", strerror(errno));
+        return -1;
+    }
     
-    /* Accept client connections */
+    /* Bound to an ephemeral loopback port and connected to itself */
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    
+    if (bind(wake_socket, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        getsockname(wake_socket, (struct sockaddr*)&addr, &addr_len) < 0 ||
+        connect(wake_socket, (struct sockaddr*)&addr, addr_len) < 0) {
+        ESP_LOGE(TAG, "Failed to set up wake-up socket: %s", strerror(errno));
+        close(wake_socket);
+        return -1;
+    }
+    
+    fcntl(wake_socket, F_SETFL, fcntl(wake_socket, F_GETFL, 0) | O_NONBLOCK);
+    return wake_socket;
+}
+
+/* Wake the reactor from another task */
+static void wake_reactor(mcp_tcp_transport_t *transport)
+{
+    int wake_socket = transport->wake_socket;
+    if (wake_socket >= 0) {
+        send(wake_socket, "", 1, MSG_DONTWAIT);
+    }
+}
+
+/* Accept pending connections into free slots */
+static void accept_clients(mcp_tcp_transport_t *transport)
+{
     while (transport->running) {
         struct sockaddr_in client_addr;
         socklen_t client_addr_len = sizeof(client_addr);
         
         int client_socket = accept(transport->server_socket, (struct sockaddr*)&client_addr, &client_addr_len);
         if (client_socket < 0) {
-            if (transport->running) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
                 ESP_LOGE(TAG, "Failed to accept client connection: %s", strerror(errno));
                 transport->stats.errors++;
             }
-            continue;
+            return;
         }
         
+        /* Nobody blocks on the socket: reads are driven by the reactor and
+         * writes that do not fit are queued in the transmit ring */
+        fcntl(client_socket, F_SETFL, fcntl(client_socket, F_GETFL, 0) | O_NONBLOCK);
+        
         /* Find free client slot */
-        if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            int slot = find_free_client_slot(transport);
+        if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+            ESP_LOGE(TAG, "Failed to acquire mutex for client connection");
+            close(client_socket);
+            transport->stats.errors++;
+            continue;
+        }
+        
+        int slot = find_free_client_slot(transport);
+        mcp_tcp_rx_block_t *block = (slot >= 0) ?
+            malloc(sizeof(mcp_tcp_rx_block_t) + transport->config.buffer_size) : NULL;
+        char *tx_buffer = block ? malloc(transport->config.tx_buffer_size) : NULL;
+        if (tx_buffer) {
+            /* Initialize client */
+            mcp_tcp_client_t *client = &transport->clients[slot];
+            /* Senders check the id under send_lock, so a message for the
+             * slot's previous connection never reaches this one */
+            xSemaphoreTake(client->send_lock, portMAX_DELAY);
+            tx_reset(transport, &client->tx);
+            client->tx.data = tx_buffer;
+            client->socket = client_socket;
+            client->client_id = transport->next_client_id++;
+            client->state = MCP_TCP_CLIENT_OPEN;
+            xSemaphoreGive(client->send_lock);
+            memcpy(&client->addr, &client_addr, sizeof(client_addr));
+            client->connect_time = esp_timer_get_time();
+            atomic_init(&block->refs, 1);
+            block->client = client;
+            memset(&client->rx, 0, sizeof(client->rx));
+            client->rx.block = block;
+            client->rx.data = block->data;
+            atomic_store(&client->stalled, false);
+            client->admitted = false;
+            client->backpressured = false;
+            atomic_store(&client->send_failed, false);
+            client->messages_received = 0;
+            client->messages_sent = 0;
+            client->format = MCP_WIRE_JSON;
+            client->tokens = transport->config.rate_limit_burst * MCP_TCP_TOKEN;
+            client->tokens_updated = client->connect_time;
+            
+            transport->client_count++;
+            transport->stats.total_connections++;
+            transport->stats.active_connections++;
+            mcp_trace_emit(MCP_TRACE_ACCEPT, client->client_id, 0, slot);
+            
+            ESP_LOGI(TAG, "Client %lu connected from %s:%d", 
+                     (unsigned long)client->client_id,
+                     inet_ntoa(client_addr.sin_addr), 
+                     ntohs(client_addr.sin_port));
+        } else {
             if (slot >= 0) {
-                /* Initialize client */
-                mcp_tcp_client_t *client = &transport->clients[slot];
-                client->socket = client_socket;
-                client->client_id = transport->next_client_id++;
-                memcpy(&client->addr, &client_addr, sizeof(client_addr));
-                client->connected = true;
-                client->connect_time = esp_timer_get_time();
-                client->messages_received = 0;
-                client->messages_sent = 0;
-                
-                transport->client_count++;
-                transport->stats.total_connections++;
-                transport->stats.active_connections++;
-                
-                ESP_LOGI(TAG, "Client %lu connected from %s:%d", 
-                         (unsigned long)client->client_id,
-                         inet_ntoa(client_addr.sin_addr), 
-                         ntohs(client_addr.sin_port));
-                
-                /* Create client handler task */
-                char task_name[16];
-                snprintf(task_name, sizeof(task_name), "mcp_client_%lu", (unsigned long)client->client_id);
-                
-                BaseType_t task_ret = xTaskCreate(mcp_tcp_client_task, 
-                                                 task_name,
-                                                 4096 / sizeof(StackType_t),
-                                                 client, 
-                                                 transport->config.task_priority - 1, 
-                                                 &transport->client_tasks[slot]);
-                if (task_ret != pdPASS) {
-                    ESP_LOGE(TAG, "Failed to create client task for client %lu", (unsigned long)client->client_id);
-                    cleanup_client(transport, client);
-                } else {
-                    ESP_LOGI(TAG, "Client handler task created for client %lu", (unsigned long)client->client_id);
-                }
+                ESP_LOGE(TAG, "Failed to allocate client buffers");
+                free(block);
             } else {
                 ESP_LOGW(TAG, "Maximum clients reached, rejecting connection");
-                close(client_socket);
-                transport->stats.errors++;
             }
-            xSemaphoreGive(transport->mutex);
-        } else {
-            ESP_LOGE(TAG, "Failed to acquire mutex for client connection");
             close(client_socket);
             transport->stats.errors++;
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(10)); // Small delay to prevent tight loop
-    }
-    
-cleanup:
-    if (transport->server_socket >= 0) {
-        close(transport->server_socket);
-        transport->server_socket = -1;
+        xSemaphoreGive(transport->mutex);
     }
-    
-    transport->status = MCP_TCP_STATUS_STOPPED;
-    ESP_LOGI(TAG, "MCP TCP server task stopped");
-    vTaskDelete(NULL);
 }
 
-/* TCP Client Task */
-static void mcp_tcp_client_task(void *arg)
+/* Read what a client sent and hand its complete messages to the server */
+static void read_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
 {
-    mcp_tcp_client_t *client = (mcp_tcp_client_t*)arg;
-    char *buffer = malloc(2048);
-    
-    if (!buffer) {
-        ESP_LOGE(TAG, "Failed to allocate client buffer");
+    /* A full buffer is stalled or reset before it is read again, unless
+     * pinned requests keep it from being compacted. The stall is flagged
+     * first so a completion unpinning it meanwhile wakes the reactor. */
+    size_t space;
+    atomic_store(&client->stalled, true);
+    char *free_space = rx_reserve(&client->rx, transport->config.buffer_size,
+                                  rx_pinned(transport, client), &space);
+    if (space == 0) {
         return;
     }
+    atomic_store(&client->stalled, false);
+    int bytes_received = recv(client->socket, free_space, space, MSG_DONTWAIT);
     
-    ESP_LOGI(TAG, "Client handler task started for client %lu", (unsigned long)client->client_id);
-    
-    while (client->connected) {
-        int bytes_received = recv(client->socket, buffer, 2047, 0);
-        
-        if (bytes_received <= 0) {
-            if (bytes_received == 0) {
-                ESP_LOGI(TAG, "Client %lu disconnected", (unsigned long)client->client_id);
-            } else {
-                ESP_LOGE(TAG, "Client %lu receive error: %s", (unsigned long)client->client_id, strerror(errno));
-            }
-            break;
+    if (bytes_received <= 0) {
+        if (bytes_received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
         }
-        
-        buffer[bytes_received] = '\0';
-        
-        ESP_LOGI(TAG, "Received %d bytes from client %lu: %s", 
-                 bytes_received, (unsigned long)client->client_id, buffer);
-        
-        /* Find the transport structure (we need to pass it somehow) */
-        /* For now, we'll handle the message directly here */
-        /* This is a simplified implementation - in production you'd want better separation */
-        
-        /* Parse JSON and handle MCP request */
-        cJSON *json = cJSON_Parse(buffer);
-        if (json) {
-            /* Create a simple response */
-            cJSON *response = cJSON_CreateObject();
-            cJSON *id = cJSON_GetObjectItem(json, "id");
-            if (id) {
-                cJSON_AddItemToObject(response, "id", cJSON_Duplicate(id, 1));
-            }
-            cJSON_AddStringToObject(response, "jsonrpc", "2.0");
-            
-            cJSON *method = cJSON_GetObjectItem(json, "method");
-            if (method && cJSON_IsString(method)) {
-                if (strcmp(method->valuestring, "ping") == 0) {
-                    cJSON_AddStringToObject(response, "result", "pong");
-                } else if (strcmp(method->valuestring, "tools/list") == 0) {
-                    cJSON *result = cJSON_CreateObject();
-                    cJSON *tools = cJSON_CreateArray();
-                    
-                    /* Add sample tools */
-                    cJSON *echo_tool = cJSON_CreateObject();
-                    cJSON_AddStringToObject(echo_tool, "name", "echo");
-                    cJSON_AddStringToObject(echo_tool, "description", "Echo input text");
-                    cJSON_AddItemToArray(tools, echo_tool);
-                    
-                    cJSON *display_tool = cJSON_CreateObject();
-                    cJSON_AddStringToObject(display_tool, "name", "display_control");
-                    cJSON_AddStringToObject(display_tool, "description", "Control ST7789 display");
-                    cJSON_AddItemToArray(tools, display_tool);
-                    
-                    cJSON_AddItemToObject(result, "tools", tools);
-                    cJSON_AddItemToObject(response, "result", result);
-                } else {
-                    cJSON *error = cJSON_CreateObject();
-                    cJSON_AddNumberToObject(error, "code", -32601);
-                    cJSON_AddStringToObject(error, "message", "Method not found");
-                    cJSON_AddItemToObject(response, "error", error);
-                }
-            } else {
-                cJSON *error = cJSON_CreateObject();
-                cJSON_AddNumberToObject(error, "code", -32600);
-                cJSON_AddStringToObject(error, "message", "Invalid Request");
-                cJSON_AddItemToObject(response, "error", error);
-            }
-            
-            char *response_str = cJSON_Print(response);
-            if (response_str) {
-                /* Add newline for easier parsing */
-                char *response_with_newline = malloc(strlen(response_str) + 2);
-                if (response_with_newline) {
-                    sprintf(response_with_newline, "%s\n", response_str);
-                    send_client_response(client, response_with_newline, strlen(response_with_newline));
-                    free(response_with_newline);
-                }
-                free(response_str);
-            }
-            
-            cJSON_Delete(response);
-            cJSON_Delete(json);
+        if (bytes_received == 0) {
+            ESP_LOGI(TAG, "Client %lu disconnected", (unsigned long)client->client_id);
         } else {
-            ESP_LOGW(TAG, "Failed to parse JSON from client %lu", (unsigned long)client->client_id);
-            
-            /* Send error response */
-            const char *error_response = "{\"jsonrpc\":\"2.0\",\"error\":{\"code\":-32700,\"message\":\"Parse error\"},\"id\":null}\n";
-            send_client_response(client, error_response, strlen(error_response));
+            ESP_LOGE(TAG, "Client %lu receive error: %s", (unsigned long)client->client_id, strerror(errno));
         }
-        
-        client->messages_received++;
+        close_client(transport, client);
+        return;
     }
+    mcp_trace_emit(MCP_TRACE_RECV, client->client_id, 0, bytes_received);
     
-    /* Cleanup client */
-    ESP_LOGI(TAG, "Cleaning up client %lu", (unsigned long)client->client_id);
-    close(client->socket);
-    client->connected = false;
+    if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        transport->stats.bytes_received += bytes_received;
+        xSemaphoreGive(transport->mutex);
+    }
     
-    free(buffer);
-    ESP_LOGI(TAG, "Client handler task finished for client %lu", (unsigned long)client->client_id);
-    vTaskDelete(NULL);
+    client->rx.tail += bytes_received;
+    process_client_input(transport, client);
 }
 
-/* Handle Client Message */
-static esp_err_t handle_client_message(mcp_tcp_transport_t *transport, 
-                                       mcp_tcp_client_t *client, 
-                                       const char *message, 
-                                       size_t message_len)
+/* Free space after the received bytes, compacting once the end is reached
+ * unless requests in flight still read from the buffer */
+static char *rx_reserve(mcp_tcp_rx_t *rx, size_t size, bool pinned, size_t *space)
 {
-    ESP_LOGI(TAG, "Processing message from client %lu: %.*s", 
-             (unsigned long)client->client_id, (int)message_len, message);
-    
-    /* Update statistics */
-    transport->stats.messages_received++;
-    transport->stats.bytes_received += message_len;
-    client->messages_received++;
-    
-    /* TODO: Integrate with actual MCP server */
-    /* For now, send a simple acknowledgment */
-    const char *ack = "{\"jsonrpc\":\"2.0\",\"result\":\"Message received\",\"id\":1}\n";
-    return send_client_response(client, ack, strlen(ack));
+    if (!pinned && rx->head > 0 && (rx->head == rx->tail || rx->tail == size)) {
+        rx->tail -= rx->head;
+        memmove(rx->data, rx->data + rx->head, rx->tail);
+        rx->head = 0;
+    }
+    *space = size - rx->tail;
+    return rx->data + rx->tail;
 }
 
-/* Send Client Response */
-static esp_err_t send_client_response(mcp_tcp_client_t *client, 
-                                      const char *response, 
-                                      size_t response_len)
+/* Check whether requests borrowed from the receive buffer are in flight */
+static bool rx_pinned(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
 {
-    if (!client->connected || client->socket < 0) {
-        return ESP_ERR_INVALID_STATE;
-    }
-    
-    int bytes_sent = send(client->socket, response, response_len, 0);
-    if (bytes_sent < 0) {
-        ESP_LOGE(TAG, "Failed to send response to client %lu: %s", 
-                 (unsigned long)client->client_id, strerror(errno));
-        return ESP_FAIL;
+    return uxSemaphoreGetCount(client->in_flight) < transport->config.max_in_flight;
+}
+
+/* Drop the first len unconsumed bytes */
+static void rx_consume(mcp_tcp_rx_t *rx, size_t len)
+{
+    rx->head += len;
+    rx->scanned = 0;
+}
+
+/* Drop bytes through the next newline; returns false if it has not arrived */
+static bool rx_skip_line(mcp_tcp_rx_t *rx)
+{
+    char *newline = memchr(rx->data + rx->head, '\n', rx->tail - rx->head);
+    if (!newline) {
+        rx_consume(rx, rx->tail - rx->head);
+        return false;
     }
-    
-    if (bytes_sent != response_len) {
-        ESP_LOGW(TAG, "Partial send to client %lu: %d/%d bytes", 
-                 (unsigned long)client->client_id, bytes_sent, (int)response_len);
+    rx_consume(rx, newline - (rx->data + rx->head) + 1);
+    rx->discarding = false;
+    return true;
+}
+
+/* Drop a reference to a receive buffer; the last one frees it */
+static void rx_block_release(mcp_tcp_rx_block_t *block)
+{
+    if (atomic_fetch_sub(&block->refs, 1) == 1) {
+        free(block);
     }
-    
-    client->messages_sent++;
-    ESP_LOGI(TAG, "Sent %d bytes to client %lu", bytes_sent, (unsigned long)client->client_id);
-    
-    return ESP_OK;
 }
 
-/* Cleanup Client */
-static void cleanup_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
+/* Hand every complete message to the server; keep the partial tail.
+ * Stops at a message that has to wait, leaving the client stalled. */
+static void process_client_input(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
 {
+    mcp_tcp_rx_t *rx = &client->rx;
+    size_t buffer_size = transport->config.buffer_size;
+    
+    /* The rest of an oversized line is dropped, it was answered already */
+    if (rx->discarding && !rx_skip_line(rx)) {
+        return;
+    }
+    
+    /* The encoding is re-read per message since initialize may switch it */
+    int cbor_error = 0;
+    atomic_store(&client->stalled, false);
+    while (rx->head < rx->tail) {
+        char *start = rx->data + rx->head;
+        size_t available = rx->tail - rx->head;
+        size_t message_len;
+        size_t frame_len;
+        if (client->format == MCP_WIRE_CBOR) {
+            int item_size = mcp_cbor_item_size((const uint8_t *)start, available);
+            if (item_size <= 0) {
+                cbor_error = item_size;
+                break;
+            }
+            message_len = frame_len = item_size;
+        } else {
+            /* Resume the search where the previous read left it */
+            char *newline = memchr(start + rx->scanned, '\n', available - rx->scanned);
+            if (!newline) {
+                rx->scanned = available;
+                break;
+            }
+            message_len = newline - start;
+            frame_len = message_len + 1;
+            if (message_len > 0 && start[message_len - 1] == '\r') {
+                message_len--;
+            }
+        }
+        if (message_len > 0) {
+            /* Unsent output holds back further requests */
+            if (tx_backlogged(transport, client)) {
+                atomic_store(&client->stalled, true);
+                break;
+            }
+            handle_client_message(transport, client, start, message_len);
+            if (atomic_load(&client->stalled)) {
+                break;
+            }
+        }
+        rx_consume(rx, frame_len);
+    }
+    
+    /* A full buffer is only an oversized message if nothing is waiting.
+     * A JSON line that does not fit is answered once and dropped through
+     * its newline. A CBOR sequence has no delimiter to resynchronize on,
+     * so errors in CBOR sessions end the connection. */
+    bool resync = (client->format == MCP_WIRE_JSON);
+    bool overflow = (rx->tail - rx->head == buffer_size && !atomic_load(&client->stalled));
+    if (cbor_error < 0 || overflow) {
+        if (cbor_error < 0) {
+            ESP_LOGW(TAG, "Client %lu sent malformed CBOR", (unsigned long)client->client_id);
+            send_client_error(client, MCP_ERROR_PARSE, "Parse error");
+        } else {
+            ESP_LOGW(TAG, "Client %lu sent a message longer than %u bytes, discarding",
+                     (unsigned long)client->client_id, (unsigned)buffer_size);
+            send_client_error(client, MCP_ERROR_INVALID_REQUEST, "Message too large");
+        }
+        rx_consume(rx, rx->tail - rx->head);
+        if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            transport->stats.errors++;
+            xSemaphoreGive(transport->mutex);
+        }
+        if (!resync) {
+            close_client(transport, client);
+        } else {
+            rx->discarding = true;
+        }
+    }
+}
+
+/* Close a connection; its slot is freed once its requests have completed */
+static void close_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
+{
+    ESP_LOGI(TAG, "Cleaning up client %lu", (unsigned long)client->client_id);
+    mcp_trace_emit(MCP_TRACE_CLOSE, client->client_id, 0, client->slot);
+    
+    if (xSemaphoreTake(transport->mutex, portMAX_DELAY) == pdTRUE) {
+        cleanup_client(transport, client);
+        xSemaphoreGive(transport->mutex);
+    }
+    release_client(transport, client);
+}
+
+/* Free a closing slot once no request or cancellation of its connection
+ * is in flight, or once MCP_RESPONSE_TIMEOUT_MS has passed; returns true
+ * if it was freed */
+static bool release_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
+{
+    UBaseType_t idle = uxSemaphoreGetCount(client->in_flight);
+    unsigned pending = (transport->config.max_in_flight - idle) + atomic_load(&client->urgent);
+    if (pending > 0) {
+        if (esp_timer_get_time() - client->close_time < MCP_RESPONSE_TIMEOUT_MS * 1000LL) {
+            return false;
+        }
+        ESP_LOGW(TAG, "Client %lu still has %u requests in flight",
+                 (unsigned long)client->client_id, pending);
+    }
+    
+    /* Requests still running free the receive buffer when they complete.
+     * Their slots are returned now, so the next connection starts with all
+     * of them; finding the buffer detached, the requests leave them alone. */
+    xSemaphoreTake(transport->mutex, portMAX_DELAY);
+    rx_block_release(client->rx.block);
+    memset(&client->rx, 0, sizeof(client->rx));
+    while (uxSemaphoreGetCount(client->in_flight) < transport->config.max_in_flight) {
+        xSemaphoreGive(client->in_flight);
+    }
+    atomic_store(&client->urgent, 0);
+    xSemaphoreGive(transport->mutex);
+    
+    /* Producers check the ring under the lock, it can go regardless */
+    xSemaphoreTake(client->send_lock, portMAX_DELAY);
+    tx_reset(transport, &client->tx);
+    free(client->tx.data);
+    client->tx.data = NULL;
+    xSemaphoreGive(client->send_lock);
+    client->state = MCP_TCP_CLIENT_FREE;
+    return true;
+}
+
+/* Close every connection and wait for their requests to complete */
+static void close_all_clients(mcp_tcp_transport_t *transport)
+{
+    for (int i = 0; i < transport->config.max_clients; i++) {
+        if (transport->clients[i].state == MCP_TCP_CLIENT_OPEN) {
+            close_client(transport, &transport->clients[i]);
+        }
+    }
+    
+    bool pending = true;
+    while (pending) {
+        pending = false;
+        for (int i = 0; i < transport->config.max_clients; i++) {
+            mcp_tcp_client_t *client = &transport->clients[i];
+            if (client->state == MCP_TCP_CLIENT_CLOSING && !release_client(transport, client)) {
+                pending = true;
+            }
+        }
+        if (pending) {
+            vTaskDelay(pdMS_TO_TICKS(MCP_TCP_RETRY_WAIT_MS));
+        }
+    }
+}
+
+/* Handle Client Message (a message that has to wait stalls the client) */
+static esp_err_t handle_client_message(mcp_tcp_transport_t *transport, 
+                                       mcp_tcp_client_t *client, 
+                                       const char *message, 
+                                       size_t message_len)
+{
+    /* A stalled message is retried; it is counted and admitted only once */
+    if (!client->admitted) {
+        ESP_LOGD(TAG, "Processing %u byte message from client %lu", 
+                 (unsigned)message_len, (unsigned long)client->client_id);
+        
+        /* Update statistics */
+        client->messages_received++;
+        
+        if (!transport->mcp_server_handle) {
+            return send_client_error(client, MCP_ERROR_INTERNAL, "MCP server not available");
+        }
+        
+        /* Admission control runs before the request takes an in-flight slot,
+         * so a refused request costs no queue space and no worker time */
+        uint32_t retry_after_ms = 0;
+        int shed_code = admit_request(transport, client, &retry_after_ms);
+        if (shed_code) {
+            return shed_request(transport, client, message, message_len, shed_code, retry_after_ms);
+        }
+        client->admitted = true;
+    }
+    
+    /* Respect the per-connection in-flight limit. A client at its limit is
+     * not read until a request completes, which lets TCP flow control push
+     * back on it. Cancellations skip the limit: they must reach the server
+     * while the requests they cancel are still waiting. The stall is flagged
+     * before the attempt so a completion racing with it still wakes us. */
+    bool urgent = mcp_server_is_urgent(message, message_len, client->format);
+    atomic_store(&client->stalled, true);
+    if (!urgent && !take_in_flight(transport, client)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (urgent) {
+        atomic_fetch_add(&client->urgent, 1);
+    }
+    
+    if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        transport->stats.in_flight++;
+        if (transport->stats.in_flight > transport->stats.in_flight_peak) {
+            transport->stats.in_flight_peak = transport->stats.in_flight;
+        }
+        xSemaphoreGive(transport->mutex);
+    }
+    
+    /* Submit to the worker pool; the response is sent from on_request_complete.
+     * A request holding an in-flight slot is read from the receive buffer,
+     * which stays pinned until the slot is returned; cancellations hold no
+     * slot and are copied. Either holds a reference to the buffer, which
+     * also leads the completion back to the client. */
+    mcp_tcp_rx_block_t *block = client->rx.block;
+    atomic_fetch_add(&block->refs, 1);
+    esp_err_t ret;
+    if (urgent) {
+        ret = mcp_server_submit(transport->mcp_server_handle, client->client_id,
+                                message, message_len, client->format,
+                                on_request_complete, block);
+    } else {
+        ret = mcp_server_submit_borrowed(transport->mcp_server_handle, client->client_id,
+                                         message, message_len, client->format,
+                                         on_request_complete, block);
+    }
+    if (ret != ESP_OK) {
+        rx_block_release(block);
+        if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            transport->stats.in_flight--;
+            xSemaphoreGive(transport->mutex);
+        }
+        if (urgent) {
+            atomic_fetch_sub(&client->urgent, 1);
+        } else {
+            xSemaphoreGive(client->in_flight);
+        }
+        
+        /* Server queue is full, retry shortly */
+        if (ret == ESP_ERR_TIMEOUT) {
+            return ret;
+        }
+    }
+    
+    client->admitted = false;
+    atomic_store(&client->stalled, false);
+    
+    if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        transport->stats.messages_received++;
+        if (ret != ESP_OK) {
+            transport->stats.errors++;
+        }
+        xSemaphoreGive(transport->mutex);
+    }
+    
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to submit request from client %lu: %s",
+                 (unsigned long)client->client_id, esp_err_to_name(ret));
+        send_client_error(client, MCP_ERROR_INTERNAL, "Request rejected");
+    }
+    
+    return ret;
+}
+
+/* Decide whether a request may be queued; returns 0 or the error refusing it */
+static int admit_request(mcp_tcp_transport_t *transport,
+                         mcp_tcp_client_t *client,
+                         uint32_t *retry_after_ms)
+{
+    const mcp_tcp_transport_config_t *config = &transport->config;
+    
+    /* Low memory refuses every client alike. A deep queue only refuses
+     * clients with requests in flight already, so one client's backlog
+     * cannot lock out the clients waiting on nothing. */
+    bool serving = uxSemaphoreGetCount(client->in_flight) < config->max_in_flight;
+    if ((config->shed_free_heap && esp_get_free_heap_size() < config->shed_free_heap) ||
+        (config->shed_queue_depth && serving &&
+         mcp_server_get_queue_depth(transport->mcp_server_handle) >= config->shed_queue_depth)) {
+        *retry_after_ms = MCP_TCP_OVERLOAD_RETRY_MS;
+        return MCP_ERROR_OVERLOADED;
+    }
+    
+    if (!config->rate_limit_rps) {
+        return 0;
+    }
+    
+    /* Token bucket: credit accrues at rate_limit_rps up to rate_limit_burst.
+     * Only the reactor task touches it, so it needs no lock. */
+    int64_t now = esp_timer_get_time();
+    uint64_t capacity = config->rate_limit_burst * MCP_TCP_TOKEN;
+    client->tokens += (uint64_t)(now - client->tokens_updated) * config->rate_limit_rps;
+    if (client->tokens > capacity) {
+        client->tokens = capacity;
+    }
+    client->tokens_updated = now;
+    
+    if (client->tokens < MCP_TCP_TOKEN) {
+        /* The credit grows by rate_limit_rps * 1000 per millisecond */
+        uint64_t per_ms = config->rate_limit_rps * 1000ULL;
+        *retry_after_ms = (uint32_t)((MCP_TCP_TOKEN - client->tokens + per_ms - 1) / per_ms);
+        return MCP_ERROR_RATE_LIMITED;
+    }
+    client->tokens -= MCP_TCP_TOKEN;
+    return 0;
+}
+
+/* Take an in-flight slot for a request. Its response must be queueable
+ * without waiting, so every slot in use and every response still queued by
+ * reference counts against the max_in_flight entries reserved for responses
+ * (reactor only). */
+static bool take_in_flight(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
+{
+    /* A completion queues its response before returning its slot, so
+     * reading the slots first never overestimates the room */
+    UBaseType_t idle = uxSemaphoreGetCount(client->in_flight);
+    xSemaphoreTake(client->send_lock, portMAX_DELAY);
+    uint8_t queued = client->tx.response_refs;
+    xSemaphoreGive(client->send_lock);
+    if (queued >= idle) {
+        return false;
+    }
+    return xSemaphoreTake(client->in_flight, 0) == pdTRUE;
+}
+
+/* Answer a refused request with an error carrying its id and a retry hint */
+static esp_err_t shed_request(mcp_tcp_transport_t *transport,
+                              mcp_tcp_client_t *client,
+                              const char *message,
+                              size_t message_len,
+                              int code,
+                              uint32_t retry_after_ms)
+{
+    mcp_trace_emit(MCP_TRACE_SHED, client->client_id, 0, retry_after_ms);
+    ESP_LOGD(TAG, "Shedding request from client %lu (%d), retry after %lu ms",
+             (unsigned long)client->client_id, code, (unsigned long)retry_after_ms);
+    
+    if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        transport->stats.messages_received++;
+        transport->stats.requests_shed++;
+        if (code == MCP_ERROR_RATE_LIMITED) {
+            transport->stats.requests_rate_limited++;
+        }
+        xSemaphoreGive(transport->mutex);
+    }
+    
+    /* The last byte is kept for the delimiter */
+    const char *reason = (code == MCP_ERROR_RATE_LIMITED) ? "Rate limit exceeded" : "Server overloaded";
+    char response[256];
+    size_t response_len = 0;
+    esp_err_t ret = mcp_server_reject(transport->mcp_server_handle, client->client_id,
+                                      message, message_len, client->format,
+                                      code, reason, retry_after_ms,
+                                      response, sizeof(response) - 1, &response_len);
+    if (ret != ESP_OK) {
+        return send_client_error(client, code, reason);
+    }
+    
+    /* Notifications are dropped silently */
+    if (response_len == 0) {
+        return ESP_OK;
+    }
+    response_len = delimit_in_place(client->format, response, response_len);
+    return send_client_response(client, client->client_id, client->format, response, response_len,
+                                true, MCP_TCP_TX_MESSAGE);
+}
+
+/* Request Completion Callback (runs on an MCP server worker) */
+static void on_request_complete(const mcp_message_t *msg,
+                                char *response,
+                                size_t response_len,
+                                esp_err_t status)
+{
+    mcp_tcp_rx_block_t *block = (mcp_tcp_rx_block_t*)msg->user_ctx;
+    mcp_tcp_client_t *client = block->client;
+    mcp_tcp_transport_t *transport = client->transport;
+    
+    /* Notifications produce no response; the connection may also be gone */
+    bool same_client = (client->state == MCP_TCP_CLIENT_OPEN) && client->client_id == msg->client_id;
+    
+    /* Switch encodings before the initialize response goes out, so the
+     * client's next message is framed the new way */
+    if (same_client && msg->next_format != msg->format) {
+        client->format = msg->next_format;
+    }
+    
+    if (response_len > 0 && same_client) {
+        mcp_trace_emit(MCP_TRACE_SEND_BEGIN, msg->client_id, msg->id, response_len);
+        /* The worker's buffer has a spare byte for the delimiter */
+        size_t frame_len = delimit_in_place(msg->format, response, response_len);
+        esp_err_t ret = send_client_response(client, msg->client_id, msg->format, response, frame_len, true,
+                                             msg->urgent ? MCP_TCP_TX_MESSAGE : MCP_TCP_TX_RESPONSE);
+        mcp_trace_emit(MCP_TRACE_SEND_END, msg->client_id, msg->id, (uint32_t)ret);
+    }
+    
+    /* A connection released without waiting for this request took its slot
+     * back and left the buffer to this reference; the client slot may hold
+     * another connection by now. Release and reuse happen under the mutex. */
+    xSemaphoreTake(transport->mutex, portMAX_DELAY);
+    transport->stats.in_flight--;
+    if (status != ESP_OK) {
+        transport->stats.errors++;
+    }
+    bool attached = (client->rx.block == block);
+    if (attached && msg->urgent) {
+        atomic_fetch_sub(&client->urgent, 1);
+    } else if (attached) {
+        xSemaphoreGive(client->in_flight);
+    }
+    bool wake = attached && ((!msg->urgent && atomic_load(&client->stalled)) ||
+                             client->state == MCP_TCP_CLIENT_CLOSING);
+    xSemaphoreGive(transport->mutex);
+    rx_block_release(block);
+    
+    /* The reactor waits for this slot to resume reading or free the
+     * connection; a cancellation frees no slot, only a closing connection
+     * waits for it */
+    if (wake) {
+        wake_reactor(transport);
+    }
+}
+
+/* Append the line delimiter of a JSON session in place; the buffer must
+ * have a spare byte after the response. Returns the frame length. */
+static size_t delimit_in_place(mcp_wire_format_t format, char *response, size_t response_len)
+{
+    if (format == MCP_WIRE_JSON) {
+        response[response_len++] = '\n';
+    }
+    return response_len;
+}
+
+/* Encode a message once into a buffer connections share; the caller
+ * holds the first reference */
+static esp_err_t shared_create(mcp_wire_format_t format,
+                               const char *message,
+                               size_t message_len,
+                               mcp_tcp_shared_t **shared)
+{
+    /* A number as short as "0.1" becomes a 9-byte float64 */
+    size_t size = (format == MCP_WIRE_JSON) ? message_len + 1 : message_len * 3 + 16;
+    mcp_tcp_shared_t *buffer = (mcp_tcp_shared_t*)malloc(sizeof(mcp_tcp_shared_t) + size);
+    if (!buffer) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    if (format == MCP_WIRE_JSON) {
+        memcpy(buffer->data, message, message_len);
+        buffer->data[message_len] = '\n';
+        buffer->len = message_len + 1;
+    } else {
+        mcp_json_writer_t w;
+        mcp_json_writer_init(&w, buffer->data, size);
+        mcp_json_writer_set_format(&w, format);
+        mcp_json_writer_raw(&w, message, message_len);
+        if (mcp_json_writer_finish(&w) != ESP_OK) {
+            free(buffer);
+            return ESP_ERR_INVALID_ARG;
+        }
+        buffer->len = mcp_json_writer_length(&w);
+    }
+    atomic_init(&buffer->refs, 1);
+    *shared = buffer;
+    return ESP_OK;
+}
+
+/* Copy a message too long for a transmit ring into a buffer that can be
+ * queued by reference; the caller holds the only reference */
+static mcp_tcp_shared_t *shared_gather(const struct iovec *parts, int count, size_t len)
+{
+    mcp_tcp_shared_t *buffer = (mcp_tcp_shared_t*)malloc(sizeof(mcp_tcp_shared_t) + len);
+    if (!buffer) {
+        return NULL;
+    }
+    
+    size_t offset = 0;
+    for (int i = 0; i < count; i++) {
+        memcpy(buffer->data + offset, parts[i].iov_base, parts[i].iov_len);
+        offset += parts[i].iov_len;
+    }
+    buffer->len = len;
+    atomic_init(&buffer->refs, 1);
+    return buffer;
+}
+
+/* Drop a reference to a shared message, freeing it with the last one */
+static void shared_release(mcp_tcp_shared_t *shared)
+{
+    if (atomic_fetch_sub(&shared->refs, 1) == 1) {
+        free(shared);
+    }
+}
+
+/* Queue entries per connection: broadcast_backlog for broadcasts and other
+ * messages, plus one per in-flight request for its response */
+static int tx_ref_capacity(mcp_tcp_transport_t *transport)
+{
+    return transport->config.broadcast_backlog + transport->config.max_in_flight;
+}
+
+/* Check whether a message of the given kind may take another queue entry */
+static bool tx_ref_free(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx, mcp_tcp_tx_kind_t kind)
+{
+    if (kind == MCP_TCP_TX_RESPONSE) {
+        return tx->response_refs < transport->config.max_in_flight;
+    }
+    return tx->ref_count - tx->response_refs < transport->config.broadcast_backlog;
+}
+
+/* Shared message at a queue position (0: oldest) */
+static mcp_tcp_tx_ref_t *tx_ref(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx, int index)
+{
+    return &tx->refs[(tx->ref_head + index) % tx_ref_capacity(transport)];
+}
+
+/* Ring bytes to write before the oldest shared message (all if none) */
+static size_t tx_ring_before(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx)
+{
+    if (tx->ref_count == 0) {
+        return tx->len;
+    }
+    return tx_ref(transport, tx, 0)->after - (tx->appended - tx->len);
+}
+
+/* Queue a reference to a shared message after everything queued so far;
+ * the caller checked for a free entry */
+static void tx_push_ref(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx,
+                        mcp_tcp_shared_t *message, size_t offset, mcp_tcp_tx_kind_t kind)
+{
+    mcp_tcp_tx_ref_t *ref = tx_ref(transport, tx, tx->ref_count++);
+    ref->message = message;
+    ref->offset = offset;
+    ref->after = tx->appended;
+    ref->kind = kind;
+    if (kind == MCP_TCP_TX_RESPONSE) {
+        tx->response_refs++;
+    }
+    atomic_fetch_add(&message->refs, 1);
+}
+
+/* Remove a shared message from the queue, closing the gap */
+static void tx_drop_ref(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx, int index)
+{
+    mcp_tcp_tx_ref_t *ref = tx_ref(transport, tx, index);
+    if (ref->kind == MCP_TCP_TX_RESPONSE) {
+        tx->response_refs--;
+    }
+    shared_release(ref->message);
+    if (index == 0) {
+        tx->ref_head = (tx->ref_head + 1) % tx_ref_capacity(transport);
+    } else {
+        for (int i = index; i < tx->ref_count - 1; i++) {
+            *tx_ref(transport, tx, i) = *tx_ref(transport, tx, i + 1);
+        }
+    }
+    tx->ref_count--;
+}
+
+/* Empty a transmit queue, keeping its buffers */
+static void tx_reset(mcp_tcp_transport_t *transport, mcp_tcp_tx_t *tx)
+{
+    while (tx->ref_count > 0) {
+        tx_drop_ref(transport, tx, 0);
+    }
+    tx->head = 0;
+    tx->len = 0;
+    tx->appended = 0;
+    tx->ref_head = 0;
+    tx->ref_busy = 0;
+}
+
+/* Bytes waiting in a client's transmit queue */
+static size_t tx_queued(mcp_tcp_client_t *client)
+{
+    mcp_tcp_tx_t *tx = &client->tx;
+    xSemaphoreTake(client->send_lock, portMAX_DELAY);
+    size_t len = tx->len;
+    for (int i = 0; i < tx->ref_count; i++) {
+        mcp_tcp_tx_ref_t *ref = tx_ref(client->transport, tx, i);
+        len += ref->message->len - ref->offset;
+    }
+    xSemaphoreGive(client->send_lock);
+    return len;
+}
+
+/* Check whether a client's unsent output should hold back its requests
+ * (reactor only) */
+static bool tx_backlogged(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
+{
+    bool backlogged = tx_queued(client) >= transport->config.tx_high_water;
+    if (backlogged && !client->backpressured) {
+        ESP_LOGD(TAG, "Client %lu is not reading, holding back its requests",
+                 (unsigned long)client->client_id);
+        if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            transport->stats.tx_backpressured++;
+            xSemaphoreGive(transport->mutex);
+        }
+    }
+    client->backpressured = backlogged;
+    return backlogged;
+}
+
+/* Queue the bytes of parts after the first skip; the caller made room */
+static void tx_append(mcp_tcp_tx_t *tx, size_t size, const struct iovec *parts, int count, size_t skip)
+{
+    size_t tail = (tx->head + tx->len) % size;
+    for (int i = 0; i < count; i++) {
+        const char *bytes = (const char *)parts[i].iov_base;
+        size_t len = parts[i].iov_len;
+        if (skip >= len) {
+            skip -= len;
+            continue;
+        }
+        bytes += skip;
+        len -= skip;
+        skip = 0;
+        
+        while (len > 0) {
+            size_t chunk = (size - tail < len) ? size - tail : len;
+            memcpy(tx->data + tail, bytes, chunk);
+            tail = (tail + chunk) % size;
+            tx->len += chunk;
+            tx->appended += chunk;
+            bytes += chunk;
+            len -= chunk;
+        }
+    }
+}
+
+/* Write a message to a client, queueing what the socket does not take.
+ * Never waits: the message is queued whole or refused with ESP_ERR_NO_MEM.
+ * What does not fit the ring is copied and queued by reference. A response
+ * always finds an entry (take_in_flight() reserves one per request); other
+ * messages share the broadcast_backlog entries. Refused with
+ * ESP_ERR_INVALID_STATE unless client_id still holds the slot. */
+static esp_err_t tx_write(mcp_tcp_client_t *client, uint32_t client_id,
+                          const struct iovec *parts, int count, mcp_tcp_tx_kind_t kind)
+{
+    mcp_tcp_transport_t *transport = client->transport;
+    size_t size = transport->config.tx_buffer_size;
+    size_t len = 0;
+    for (int i = 0; i < count; i++) {
+        len += parts[i].iov_len;
+    }
+    
+    esp_err_t ret = ESP_OK;
+    bool queued = false;
+    mcp_tcp_shared_t *copy = NULL;
+    mcp_tcp_tx_t *tx = &client->tx;
+    
+    xSemaphoreTake(client->send_lock, portMAX_DELAY);
+    if (client->state != MCP_TCP_CLIENT_OPEN || client->client_id != client_id ||
+        !tx->data || atomic_load(&client->send_failed)) {
+        ret = ESP_ERR_INVALID_STATE;
+        goto done;
+    }
+    
+    /* Nothing queued, so nobody else writes the socket: write directly */
+    size_t written = 0;
+    if (tx->len == 0 && tx->ref_count == 0) {
+        ssize_t sent = writev(client->socket, parts, count);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "Failed to send to client %lu: %s",
+                         (unsigned long)client->client_id, strerror(errno));
+                atomic_store(&client->send_failed, true);
+                ret = ESP_FAIL;
+                goto done;
+            }
+            sent = 0;
+        }
+        written = sent;
+    }
+    if (written == len) {
+        goto done;
+    }
+    
+    if (size - tx->len >= len - written) {
+        tx_append(tx, size, parts, count, written);
+        queued = true;
+    } else if (tx_ref_free(transport, tx, kind) && (copy = shared_gather(parts, count, len))) {
+        tx_push_ref(transport, tx, copy, written, kind);
+        queued = true;
+    } else if (written > 0) {
+        /* The start is on the wire already; the stream cannot recover */
+        atomic_store(&client->send_failed, true);
+        ret = ESP_FAIL;
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+
+done:
+    xSemaphoreGive(client->send_lock);
+    if (copy) {
+        shared_release(copy);
+    }
+    
+    /* The reactor only watches for writability while something is queued,
+     * and closes a connection whose write failed */
+    if (queued || ret == ESP_FAIL) {
+        wake_reactor(transport);
+    }
+    return ret;
+}
+
+/* Queue a shared message on a client without copying it. A client whose
+ * broadcast backlog is full is handled by slow_client_policy. */
+static esp_err_t tx_share(mcp_tcp_client_t *client, mcp_tcp_shared_t *message)
+{
+    mcp_tcp_transport_t *transport = client->transport;
+    mcp_tcp_tx_t *tx = &client->tx;
+    esp_err_t ret = ESP_OK;
+    bool queued = false;
+    bool coalesced = false;
+    bool disconnected = false;
+    
+    xSemaphoreTake(client->send_lock, portMAX_DELAY);
+    if (client->state != MCP_TCP_CLIENT_OPEN || !tx->data || atomic_load(&client->send_failed)) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else if (tx->len == 0 && tx->ref_count == 0) {
+        /* Nothing queued: write directly, queue the rest */
+        ssize_t written = send(client->socket, message->data, message->len, 0);
+        if (written < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "Failed to send to client %lu: %s",
+                         (unsigned long)client->client_id, strerror(errno));
+                atomic_store(&client->send_failed, true);
+                ret = ESP_FAIL;
+            }
+            written = 0;
+        }
+        queued = (ret == ESP_OK && (size_t)written < message->len);
+        if (queued) {
+            tx_push_ref(transport, tx, message, written, MCP_TCP_TX_BROADCAST);
+        }
+    } else {
+        if (!tx_ref_free(transport, tx, MCP_TCP_TX_BROADCAST)) {
+            if (transport->config.slow_client_policy == MCP_TCP_SLOW_CLIENT_DISCONNECT) {
+                atomic_store(&client->send_failed, true);
+                disconnected = true;
+                ret = ESP_FAIL;
+            } else {
+                /* The oldest broadcast neither started nor being written goes */
+                ret = ESP_ERR_NO_MEM;
+                for (int i = tx->ref_busy; i < tx->ref_count; i++) {
+                    mcp_tcp_tx_ref_t *ref = tx_ref(transport, tx, i);
+                    if (ref->kind == MCP_TCP_TX_BROADCAST && ref->offset == 0) {
+                        tx_drop_ref(transport, tx, i);
+                        ret = ESP_OK;
+                        break;
+                    }
+                }
+                coalesced = true;
+            }
+        }
+        if (ret == ESP_OK) {
+            tx_push_ref(transport, tx, message, 0, MCP_TCP_TX_BROADCAST);
+        }
+    }
+    xSemaphoreGive(client->send_lock);
+    
+    if (queued || ret == ESP_FAIL) {
+        wake_reactor(transport);
+    }
+    if (disconnected) {
+        ESP_LOGW(TAG, "Client %lu is %d broadcasts behind, closing",
+                 (unsigned long)client->client_id, transport->config.broadcast_backlog);
+    } else if (coalesced) {
+        ESP_LOGD(TAG, "Client %lu is %d broadcasts behind, dropping its oldest",
+                 (unsigned long)client->client_id, transport->config.broadcast_backlog);
+    }
+    
+    if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+        if (ret == ESP_OK) {
+            transport->stats.messages_sent++;
+            transport->stats.bytes_sent += message->len;
+        }
+        if (coalesced) {
+            transport->stats.messages_dropped++;
+        }
+        if (disconnected) {
+            transport->stats.slow_clients_closed++;
+        }
+        xSemaphoreGive(transport->mutex);
+    }
+    if (ret == ESP_OK) {
+        client->messages_sent++;
+    }
+    return ret;
+}
+
+/* Write queued output once the socket has room (reactor only) */
+static void flush_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
+{
+    size_t size = transport->config.tx_buffer_size;
+    mcp_tcp_tx_t *tx = &client->tx;
+    
+    /* Gather runs of ring bytes and the shared messages between them in
+     * queue order; a run that wraps around the ring is two pieces */
+    struct iovec parts[MCP_TCP_TX_IOV_MAX];
+    int count = 0;
+    int refs = 0;
+    xSemaphoreTake(client->send_lock, portMAX_DELAY);
+    size_t pos = tx->head;
+    size_t mark = tx->appended - tx->len;
+    while (count < MCP_TCP_TX_IOV_MAX) {
+        size_t run = (refs < tx->ref_count) ? tx_ref(transport, tx, refs)->after - mark
+                                            : tx->appended - mark;
+        if (run > 0) {
+            size_t first = (run < size - pos) ? run : size - pos;
+            parts[count++] = (struct iovec){ .iov_base = tx->data + pos, .iov_len = first };
+            if (run > first && count < MCP_TCP_TX_IOV_MAX) {
+                parts[count++] = (struct iovec){ .iov_base = tx->data, .iov_len = run - first };
+            } else {
+                run = first;
+            }
+            pos = (pos + run) % size;
+            mark += run;
+            continue;
+        }
+        if (refs == tx->ref_count) {
+            break;
+        }
+        mcp_tcp_tx_ref_t *ref = tx_ref(transport, tx, refs++);
+        parts[count++] = (struct iovec){ .iov_base = ref->message->data + ref->offset,
+                                         .iov_len = ref->message->len - ref->offset };
+    }
+    tx->ref_busy = refs;
+    xSemaphoreGive(client->send_lock);
+    if (count == 0) {
+        return;
+    }
+    
+    /* Producers only append while data is queued, so the lock is not held */
+    ssize_t written = writev(client->socket, parts, count);
+    if (written < 0) {
+        xSemaphoreTake(client->send_lock, portMAX_DELAY);
+        tx->ref_busy = 0;
+        xSemaphoreGive(client->send_lock);
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return;
+        }
+        ESP_LOGE(TAG, "Failed to send to client %lu: %s",
+                 (unsigned long)client->client_id, strerror(errno));
+        if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            transport->stats.errors++;
+            xSemaphoreGive(transport->mutex);
+        }
+        close_client(transport, client);
+        return;
+    }
+    
+    /* Consume what was written in the same order it was gathered */
+    xSemaphoreTake(client->send_lock, portMAX_DELAY);
+    size_t left = written;
+    while (left > 0) {
+        size_t run = tx_ring_before(transport, tx);
+        if (run > 0) {
+            size_t n = (run < left) ? run : left;
+            tx->head = (tx->head + n) % size;
+            tx->len -= n;
+            left -= n;
+            continue;
+        }
+        mcp_tcp_tx_ref_t *ref = tx_ref(transport, tx, 0);
+        size_t n = (ref->message->len - ref->offset < left) ? ref->message->len - ref->offset : left;
+        ref->offset += n;
+        left -= n;
+        if (ref->offset == ref->message->len) {
+            tx_drop_ref(transport, tx, 0);
+        }
+    }
+    if (tx->len == 0) {
+        tx->head = 0;
+    }
+    tx->ref_busy = 0;
+    xSemaphoreGive(client->send_lock);
+}
+
+/* Send Client Response (a newline-terminated line, or one CBOR item).
+ * A delimited response already ends with its newline; otherwise the
+ * newline is gathered into the same write. Never waits for the client. */
+static esp_err_t send_client_response(mcp_tcp_client_t *client, 
+                                      uint32_t client_id,
+                                      mcp_wire_format_t format,
+                                      const char *response, 
+                                      size_t response_len,
+                                      bool delimited,
+                                      mcp_tcp_tx_kind_t kind)
+{
+    if (client->state != MCP_TCP_CLIENT_OPEN) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    struct iovec parts[2] = {
+        { .iov_base = (void *)response, .iov_len = response_len },
+        { .iov_base = (void *)"\n", .iov_len = 1 },
+    };
+    int count = (format == MCP_WIRE_JSON && !delimited) ? 2 : 1;
+    size_t frame_len = response_len + (count - 1);
+    esp_err_t ret = tx_write(client, client_id, parts, count, kind);
+    
+    mcp_tcp_transport_t *transport = client->transport;
+    if (ret == ESP_OK) {
+        client->messages_sent++;
+        if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            transport->stats.messages_sent++;
+            transport->stats.bytes_sent += frame_len;
+            xSemaphoreGive(transport->mutex);
+        }
+        ESP_LOGD(TAG, "Sent %u bytes to client %lu", (unsigned)frame_len, (unsigned long)client->client_id);
+    } else if (ret != ESP_ERR_INVALID_STATE) {
+        if (ret != ESP_FAIL) {
+            ESP_LOGW(TAG, "Dropped %u byte message to client %lu: %s",
+                     (unsigned)frame_len, (unsigned long)client->client_id, esp_err_to_name(ret));
+        }
+        if (xSemaphoreTake(transport->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            if (ret == ESP_FAIL) {
+                transport->stats.errors++;
+            } else {
+                transport->stats.messages_dropped++;
+            }
+            xSemaphoreGive(transport->mutex);
+        }
+    }
+    
+    return ret;
+}
+
+/* Send a JSON message, transcoding it for clients in a CBOR session */
+static esp_err_t send_client_message(mcp_tcp_client_t *client,
+                                     uint32_t client_id,
+                                     const char *message,
+                                     size_t message_len)
+{
+    mcp_wire_format_t format = client->format;
+    if (format == MCP_WIRE_JSON) {
+        return send_client_response(client, client_id, format, message, message_len, false,
+                                    MCP_TCP_TX_MESSAGE);
+    }
+    
+    mcp_tcp_shared_t *encoded = NULL;
+    esp_err_t ret = shared_create(format, message, message_len, &encoded);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to encode message for client %lu", (unsigned long)client->client_id);
+        return ret;
+    }
+    ret = send_client_response(client, client_id, format, encoded->data, encoded->len, true,
+                               MCP_TCP_TX_MESSAGE);
+    shared_release(encoded);
+    return ret;
+}
+
+/* Send a JSON-RPC error with a null id in the client's encoding */
+static esp_err_t send_client_error(mcp_tcp_client_t *client, int code, const char *message)
+{
+    char response[128];
+    mcp_json_writer_t w;
+    mcp_json_writer_init(&w, response, sizeof(response) - 1);
+    mcp_json_writer_set_format(&w, client->format);
+    
+    mcp_json_writer_begin_object(&w);
+    mcp_json_writer_add_string(&w, "jsonrpc", "2.0");
+    mcp_json_writer_key(&w, "error");
+    mcp_json_writer_begin_object(&w);
+    mcp_json_writer_add_int(&w, "code", code);
+    mcp_json_writer_add_string(&w, "message", message);
+    mcp_json_writer_end_object(&w);
+    mcp_json_writer_key(&w, "id");
+    mcp_json_writer_null(&w);
+    mcp_json_writer_end_object(&w);
+    
+    if (mcp_json_writer_finish(&w) != ESP_OK) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    size_t response_len = delimit_in_place(client->format, response, mcp_json_writer_length(&w));
+    return send_client_response(client, client->client_id, client->format, response, response_len,
+                                true, MCP_TCP_TX_MESSAGE);
+}
+
+/* Deliver a subscription notification (runs on the publishing task) */
+static esp_err_t deliver_notification(uint32_t client_id,
+                                      const char *message,
+                                      size_t message_len,
+                                      void *user_ctx)
+{
+    return mcp_tcp_transport_send_message((mcp_tcp_transport_handle_t)user_ctx,
+                                          client_id, message, message_len);
+}
+
+/* Cleanup Client */
+static void cleanup_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *client)
+{
+    if (client->state != MCP_TCP_CLIENT_OPEN) {
+        return;
+    }
+    
+    if (transport->mcp_server_handle) {
+        mcp_server_client_closed(transport->mcp_server_handle, client->client_id);
+    }
+    
+    /* Producers write under send_lock only while the client is open */
+    xSemaphoreTake(client->send_lock, portMAX_DELAY);
     if (client->socket >= 0) {
         close(client->socket);
         client->socket = -1;
     }
-    
-    client->connected = false;
-    client->client_id = 0;
+    client->state = MCP_TCP_CLIENT_CLOSING;
+    xSemaphoreGive(client->send_lock);
+    client->close_time = esp_timer_get_time();
     
     if (transport->client_count > 0) {
         transport->client_count--;
@@ -711,7 +2107,8 @@ static void cleanup_client(mcp_tcp_transport_t *transport, mcp_tcp_client_t *cli
 static int find_free_client_slot(mcp_tcp_transport_t *transport)
 {
     for (int i = 0; i < transport->config.max_clients; i++) {
-        if (!transport->clients[i].connected) {
+        /* A slot stays busy until its requests have drained */
+        if (transport->clients[i].state == MCP_TCP_CLIENT_FREE) {
             return i;
         }
     }
@@ -0,0 +1,181 @@
+/**
+ * @file mcp_arena.h
+ * @brief Per-request bump-pointer arena allocator for the MCP server
+ *
+ * Each request handled by the MCP server borrows an arena from a small pool.
+ * While the request runs, the arena is bound to the handling task and every
+ * request-scoped allocation (token arrays, tool scratch memory and anything
+ * allocated through cJSON) is carved out of it. When the request finishes
+ * the whole arena is released in one step, so short-lived allocations never
+ * fragment the general heap.
+ *
+ * Features:
+ * - O(1) bump allocation, O(1) reset
+ * - Transparent fallback to the heap when an arena is exhausted
+ * - Lock-free pool acquire/release
+ * - Per-arena high-water mark and fallback counters
+ * - cJSON_InitHooks integration
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#ifndef __cplusplus
+#include <stdatomic.h>
+#endif
+#include "esp_err.h"
+
+/* Arena Configuration */
+#ifndef MCP_ARENA_SIZE
+#define MCP_ARENA_SIZE              2048
+#endif
+#ifndef MCP_ARENA_POOL_SIZE
+#define MCP_ARENA_POOL_SIZE         4
+#endif
+#define MCP_ARENA_POOL_MAX          32
+#ifndef MCP_ARENA_TLS_INDEX
+#define MCP_ARENA_TLS_INDEX         1
+#endif
+#define MCP_ARENA_ALIGN             8
+
+/* Arena */
+typedef struct {
+    uint8_t* base;                  /* Arena memory */
+    size_t size;                    /* Arena capacity in bytes */
+    size_t used;                    /* Bytes handed out since the last reset */
+    size_t high_water;              /* Largest 'used' ever observed */
+    uint32_t fallback_count;        /* Allocations that overflowed to the heap */
+    uint32_t reset_count;           /* Number of resets (requests served) */
+} mcp_arena_t;
+
+/* Arena Pool */
+typedef struct {
+    uint8_t* block;                 /* Single allocation backing all arenas */
+    size_t arena_size;
+    uint32_t arena_count;
+#ifdef __cplusplus
+    unsigned int busy_mask;         /* Only the C sources touch the mask */
+#else
+    atomic_uint busy_mask;          /* Bit per arena, set while acquired */
+#endif
+    mcp_arena_t arenas[MCP_ARENA_POOL_MAX];
+} mcp_arena_pool_t;
+
+/* Arena Statistics */
+typedef struct {
+    uint32_t size;                  /* Arena capacity in bytes */
+    uint32_t high_water;            /* Peak bytes used by a single request */
+    uint32_t fallback_count;        /* Allocations served by the heap instead */
+    uint32_t reset_count;           /* Requests served by this arena */
+} mcp_arena_stats_t;
+
+/**
+ * @brief Create a pool of equally sized arenas
+ *
+ * @param pool Pool to initialize
+ * @param arena_size Size of each arena in bytes
+ * @param arena_count Number of arenas (at most MCP_ARENA_POOL_MAX)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM or ESP_ERR_INVALID_ARG otherwise
+ */
+esp_err_t mcp_arena_pool_init(mcp_arena_pool_t* pool, size_t arena_size, uint32_t arena_count);
+
+/**
+ * @brief Free the memory backing a pool
+ *
+ * @param pool Pool to release (no arena may be acquired)
+ */
+void mcp_arena_pool_deinit(mcp_arena_pool_t* pool);
+
+/**
+ * @brief Acquire a free arena from the pool
+ *
+ * @param pool Pool
+ * @return Arena, or NULL if all arenas are in use (callers fall back to the heap)
+ */
+mcp_arena_t* mcp_arena_pool_acquire(mcp_arena_pool_t* pool);
+
+/**
+ * @brief Reset an arena and return it to the pool
+ *
+ * @param pool Pool
+ * @param arena Arena returned by mcp_arena_pool_acquire (NULL is ignored)
+ */
+void mcp_arena_pool_release(mcp_arena_pool_t* pool, mcp_arena_t* arena);
+
+/**
+ * @brief Get statistics for one arena of a pool
+ *
+ * @param pool Pool
+ * @param index Arena index
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if index is out of range
+ */
+esp_err_t mcp_arena_pool_get_stats(const mcp_arena_pool_t* pool, uint32_t index,
+                                   mcp_arena_stats_t* stats);
+
+/**
+ * @brief Allocate from an arena without falling back to the heap
+ *
+ * @param arena Arena
+ * @param size Number of bytes
+ * @return Pointer aligned to MCP_ARENA_ALIGN, or NULL if the arena is full
+ */
+void* mcp_arena_alloc(mcp_arena_t* arena, size_t size);
+
+/**
+ * @brief Check whether a pointer was handed out by any registered arena pool
+ */
+bool mcp_arena_owns(const void* ptr);
+
+/**
+ * @brief Bind an arena to the calling task for the duration of a request
+ *
+ * @param arena Arena to bind, or NULL to unbind
+ */
+void mcp_arena_bind(mcp_arena_t* arena);
+
+/**
+ * @brief Get the arena bound to the calling task
+ *
+ * @return Bound arena, or NULL if none
+ */
+mcp_arena_t* mcp_arena_current(void);
+
+/**
+ * @brief Allocate request-scoped memory
+ *
+ * Served from the calling task's bound arena, or from the heap if no arena
+ * is bound or the arena is exhausted.
+ *
+ * @param size Number of bytes
+ * @return Pointer, or NULL if out of memory
+ */
+void* mcp_arena_malloc(size_t size);
+
+/**
+ * @brief Free memory returned by mcp_arena_malloc
+ *
+ * Arena memory is reclaimed when the arena is released, so this only
+ * returns heap fallback allocations to the heap.
+ *
+ * @param ptr Pointer (NULL is ignored)
+ */
+void mcp_arena_free(void* ptr);
+
+/**
+ * @brief Route cJSON allocations through mcp_arena_malloc/mcp_arena_free
+ *
+ * Safe to call more than once. Outside a request (no arena bound) cJSON
+ * keeps allocating from the heap.
+ */
+void mcp_arena_install_cjson_hooks(void);
+
+#ifdef __cplusplus
+}
+#endif
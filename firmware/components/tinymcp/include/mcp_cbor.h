@@ -0,0 +1,66 @@
+/**
+ * @file mcp_cbor.h
+ * @brief CBOR decoding for MCP sessions that negotiated the CBOR encoding
+ *
+ * A client may ask for CBOR (RFC 8949) during initialize. From then on each
+ * message on the connection is one CBOR data item carrying the same JSON-RPC
+ * structure, and messages follow each other without delimiters (a CBOR
+ * sequence, RFC 8742). Responses are produced by a CBOR-mode
+ * mcp_json_writer_t; this module covers the receiving side: finding where
+ * an item ends in a stream, and streaming an item into a JSON writer so the
+ * request goes through the regular tokenizer and dispatcher.
+ *
+ * Features:
+ * - Framing without copying or allocating (mcp_cbor_item_size)
+ * - Integers, floats (half/single/double), text, maps, arrays, simple values
+ * - Byte strings become base64 strings; tags are skipped
+ * - Definite and indefinite-length maps and arrays
+ *
+ * Limitations:
+ * - Indefinite-length (chunked) strings and non-text map keys are rejected
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "mcp_json_writer.h"
+
+/* Deepest nesting accepted in a message */
+#define MCP_CBOR_MAX_DEPTH          MCP_JSON_WRITER_MAX_DEPTH
+
+/* Framing Errors (negative return values of mcp_cbor_item_size) */
+#define MCP_CBOR_ERR_MALFORMED      (-1)    /* Not well-formed CBOR */
+#define MCP_CBOR_ERR_DEPTH          (-2)    /* Nested deeper than MCP_CBOR_MAX_DEPTH */
+
+/**
+ * @brief Measure the first data item in a buffer
+ *
+ * @param data Received bytes
+ * @param len Number of bytes available
+ * @return Size of the complete item, 0 if more bytes are needed,
+ *         MCP_CBOR_ERR_* (negative) if the item can never become valid
+ */
+int mcp_cbor_item_size(const uint8_t* data, size_t len);
+
+/**
+ * @brief Convert one CBOR data item to JSON
+ *
+ * @param data CBOR item
+ * @param len Item size; trailing bytes are an error
+ * @param out Writer receiving the equivalent JSON value
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the item is malformed,
+ *         ESP_ERR_NOT_SUPPORTED for constructs JSON-RPC has no use for,
+ *         ESP_ERR_INVALID_SIZE if the writer overflowed
+ */
+esp_err_t mcp_cbor_to_json(const uint8_t* data, size_t len, mcp_json_writer_t* out);
+
+#ifdef __cplusplus
+}
+#endif
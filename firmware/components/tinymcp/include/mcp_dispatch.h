@@ -0,0 +1,112 @@
+/**
+ * @file mcp_dispatch.h
+ * @brief Hashed name lookup for JSON-RPC methods and MCP tools
+ *
+ * Names are hashed once when a method or tool is registered. Incoming
+ * requests are dispatched by hashing the method/tool token straight from
+ * the request text and probing an open-addressed table, so dispatch cost no
+ * longer depends on how many entries are registered.
+ *
+ * Features:
+ * - FNV-1a hashes precomputed at registration
+ * - Linear probing over a power-of-two table (load factor <= 1/2)
+ * - Lookup directly from a mcp_json token, no copy for unescaped names
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "mcp_json.h"
+
+/* Longest name that can be looked up from an escaped JSON string */
+#define MCP_DISPATCH_MAX_NAME_LEN   64
+
+/* Dispatch Table Entry */
+typedef struct {
+    uint32_t hash;                  /* FNV-1a hash of name */
+    uint16_t name_len;              /* strlen(name), 0 for an empty slot */
+    const char* name;               /* Registered name (not copied) */
+    void* value;                    /* Handler or definition for this name */
+} mcp_dispatch_entry_t;
+
+/* Dispatch Table */
+typedef struct {
+    mcp_dispatch_entry_t* entries;
+    uint32_t capacity;              /* Power of two */
+    uint32_t count;
+} mcp_dispatch_table_t;
+
+/**
+ * @brief Hash a name with 32-bit FNV-1a
+ *
+ * @param name Name bytes
+ * @param len Length in bytes
+ * @return Hash value
+ */
+uint32_t mcp_dispatch_hash(const char* name, size_t len);
+
+/**
+ * @brief Create an empty dispatch table
+ *
+ * @param table Table to initialize
+ * @param max_entries Maximum number of names that will be inserted
+ * @return ESP_OK on success, ESP_ERR_NO_MEM otherwise
+ */
+esp_err_t mcp_dispatch_init(mcp_dispatch_table_t* table, uint32_t max_entries);
+
+/**
+ * @brief Free a dispatch table
+ *
+ * @param table Table to release
+ */
+void mcp_dispatch_deinit(mcp_dispatch_table_t* table);
+
+/**
+ * @brief Remove all entries from a dispatch table
+ *
+ * @param table Table to clear
+ */
+void mcp_dispatch_clear(mcp_dispatch_table_t* table);
+
+/**
+ * @brief Register a name
+ *
+ * @param table Table
+ * @param name Name to register (must outlive the table entry)
+ * @param value Value returned by lookups of this name
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the name is already
+ *         registered, ESP_ERR_NO_MEM if the table is full
+ */
+esp_err_t mcp_dispatch_insert(mcp_dispatch_table_t* table, const char* name, void* value);
+
+/**
+ * @brief Look up a name given as a byte slice
+ *
+ * @param table Table
+ * @param name Name bytes (need not be NUL-terminated)
+ * @param len Length in bytes
+ * @return Registered value, or NULL if the name is unknown
+ */
+void* mcp_dispatch_lookup(const mcp_dispatch_table_t* table, const char* name, size_t len);
+
+/**
+ * @brief Look up the name held by a JSON string token
+ *
+ * @param table Table
+ * @param doc Tokenized document
+ * @param tok String token index
+ * @return Registered value, or NULL if the token is not a known name
+ */
+void* mcp_dispatch_lookup_token(const mcp_dispatch_table_t* table,
+                                const mcp_json_doc_t* doc, int tok);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,214 @@
+/**
+ * @file mcp_json.h
+ * @brief Zero-allocation JSON tokenizer for MCP request handling
+ *
+ * This header provides an in-place JSON tokenizer used on the MCP request
+ * path instead of building a cJSON tree. The input text is never copied or
+ * modified: the tokenizer fills a caller-provided token array with offsets
+ * into the input, and values are looked up lazily by key when needed.
+ *
+ * Features:
+ * - No heap allocation, fixed-size token array supplied by the caller
+ * - Strict JSON syntax validation
+ * - Counting mode (NULL token array) to size the array before parsing
+ * - Lazy object key lookup and typed value accessors
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/* Tokenizer Configuration */
+#ifndef MCP_JSON_MAX_TOKENS
+#define MCP_JSON_MAX_TOKENS         64
+#endif
+#ifndef MCP_JSON_MAX_DEPTH
+#define MCP_JSON_MAX_DEPTH          16
+#endif
+#define MCP_JSON_MAX_INPUT_SIZE     UINT16_MAX
+
+/* Tokenizer Errors (negative return values of mcp_json_parse) */
+#define MCP_JSON_ERR_NOMEM          (-1)    /* Not enough tokens */
+#define MCP_JSON_ERR_INVALID        (-2)    /* Invalid JSON */
+#define MCP_JSON_ERR_PARTIAL        (-3)    /* Input ended inside a value */
+#define MCP_JSON_ERR_DEPTH          (-4)    /* Nesting deeper than MCP_JSON_MAX_DEPTH */
+#define MCP_JSON_ERR_TOO_LARGE      (-5)    /* Input larger than MCP_JSON_MAX_INPUT_SIZE */
+
+/* Token Types */
+typedef enum {
+    MCP_JSON_UNDEFINED = 0,
+    MCP_JSON_OBJECT,
+    MCP_JSON_ARRAY,
+    MCP_JSON_STRING,
+    MCP_JSON_NUMBER,
+    MCP_JSON_TRUE,
+    MCP_JSON_FALSE,
+    MCP_JSON_NULL
+} mcp_json_type_t;
+
+/* Token Flags */
+#define MCP_JSON_FLAG_ESCAPED       0x01    /* String contains escape sequences */
+
+/**
+ * @brief JSON token
+ *
+ * Strings span the text between the quotes. Containers span from the opening
+ * to the closing bracket. Object members are stored as a key string token
+ * followed by the value's subtree.
+ */
+typedef struct {
+    uint8_t type;                   /* mcp_json_type_t */
+    uint8_t flags;                  /* MCP_JSON_FLAG_* */
+    uint16_t size;                  /* Number of members (object) or elements (array) */
+    uint16_t skip;                  /* Tokens in this subtree, including itself */
+    uint16_t start;                 /* Offset of first byte in the input */
+    uint16_t len;                   /* Length in bytes */
+} mcp_json_token_t;
+
+/**
+ * @brief Tokenized JSON document (a view over the original input)
+ */
+typedef struct {
+    const char* json;
+    const mcp_json_token_t* tokens;
+    int count;
+} mcp_json_doc_t;
+
+/**
+ * @brief Tokenize a JSON value in place
+ *
+ * Exactly one top-level value is accepted; surrounding whitespace is ignored.
+ * When tokens is NULL, the input is validated and the number of tokens it
+ * needs is returned without storing anything.
+ *
+ * @param json Input text (does not need to be NUL-terminated)
+ * @param len Input length in bytes
+ * @param tokens Token array to fill, or NULL to count only
+ * @param max_tokens Capacity of the token array
+ * @return Number of tokens on success, MCP_JSON_ERR_* (negative) on failure
+ */
+int mcp_json_parse(const char* json, size_t len,
+                   mcp_json_token_t* tokens, unsigned int max_tokens);
+
+/**
+ * @brief Find an object member by key
+ *
+ * @param doc Tokenized document
+ * @param object Index of an object token (negative values are tolerated)
+ * @param key NUL-terminated key to look up
+ * @return Index of the member's value token, or -1 if not found
+ */
+int mcp_json_find(const mcp_json_doc_t* doc, int object, const char* key);
+
+/**
+ * @brief Get the index of the token following a subtree
+ *
+ * Used to iterate over array elements and object members.
+ *
+ * @param doc Tokenized document
+ * @param tok Token index
+ * @return Index of the next sibling token
+ */
+static inline int mcp_json_next(const mcp_json_doc_t* doc, int tok)
+{
+    return tok + doc->tokens[tok].skip;
+}
+
+/**
+ * @brief Get the type of a token
+ *
+ * @param doc Tokenized document
+ * @param tok Token index (negative for "absent")
+ * @return Token type, MCP_JSON_UNDEFINED if tok is negative
+ */
+static inline mcp_json_type_t mcp_json_type(const mcp_json_doc_t* doc, int tok)
+{
+    return tok < 0 ? MCP_JSON_UNDEFINED : (mcp_json_type_t)doc->tokens[tok].type;
+}
+
+/**
+ * @brief Get a pointer to the raw text of a token
+ *
+ * @param doc Tokenized document
+ * @param tok Token index
+ * @param len Pointer to store the raw length
+ * @return Pointer into the original input (not NUL-terminated)
+ */
+static inline const char* mcp_json_raw(const mcp_json_doc_t* doc, int tok, size_t* len)
+{
+    *len = doc->tokens[tok].len;
+    return doc->json + doc->tokens[tok].start;
+}
+
+/**
+ * @brief Decode the escape sequences of raw string content
+ *
+ * @param s Raw string content, without the surrounding quotes
+ * @param len Raw length
+ * @param out Output buffer of at least 'len' bytes, or NULL to only measure
+ * @return Length of the decoded UTF-8 string
+ */
+size_t mcp_json_unescape(const char* s, size_t len, char* out);
+
+/**
+ * @brief Compare a string token with a NUL-terminated string
+ *
+ * @param doc Tokenized document
+ * @param tok Token index
+ * @param str String to compare with
+ * @return true if tok is a string equal to str
+ */
+bool mcp_json_eq(const mcp_json_doc_t* doc, int tok, const char* str);
+
+/**
+ * @brief Copy a string token into a buffer, decoding escape sequences
+ *
+ * @param doc Tokenized document
+ * @param tok Token index
+ * @param buf Output buffer (always NUL-terminated on success)
+ * @param size Size of output buffer
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if not a string,
+ *         ESP_ERR_INVALID_SIZE if the buffer is too small
+ */
+esp_err_t mcp_json_get_string(const mcp_json_doc_t* doc, int tok, char* buf, size_t size);
+
+/**
+ * @brief Read an integer token
+ *
+ * @param doc Tokenized document
+ * @param tok Token index
+ * @param value Pointer to store the value
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if not an integer in range
+ */
+esp_err_t mcp_json_get_int(const mcp_json_doc_t* doc, int tok, int32_t* value);
+
+/**
+ * @brief Read an unsigned integer token
+ *
+ * @param doc Tokenized document
+ * @param tok Token index
+ * @param value Pointer to store the value
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if not an integer in range
+ */
+esp_err_t mcp_json_get_u32(const mcp_json_doc_t* doc, int tok, uint32_t* value);
+
+/**
+ * @brief Read a boolean token
+ *
+ * @param doc Tokenized document
+ * @param tok Token index
+ * @param value Pointer to store the value
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if not true/false
+ */
+esp_err_t mcp_json_get_bool(const mcp_json_doc_t* doc, int tok, bool* value);
+
+#ifdef __cplusplus
+}
+#endif
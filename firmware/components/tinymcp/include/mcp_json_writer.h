@@ -0,0 +1,221 @@
+/**
+ * @file mcp_json_writer.h
+ * @brief Streaming JSON writer for MCP responses
+ *
+ * This header provides a single-pass JSON writer that serializes directly
+ * into a caller-provided buffer. The MCP dispatcher writes the JSON-RPC
+ * envelope and tools append their result into the same buffer, so a
+ * response is serialized exactly once and never re-parsed.
+ *
+ * A writer switched to MCP_WIRE_CBOR emits the same values as CBOR
+ * (RFC 8949) instead, with indefinite-length maps and arrays, so tools and
+ * handlers produce either encoding through the same calls.
+ *
+ * Features:
+ * - No heap allocation, output goes straight into the response buffer
+ * - Compact output with automatic comma and nesting handling
+ * - Sticky overflow flag, checked once when the response is finished
+ * - Writer state is a plain struct and can be saved/restored to roll back
+ * - JSON or CBOR output; JSON text given to raw/token is transcoded for CBOR
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "mcp_json.h"
+
+#define MCP_JSON_WRITER_MAX_DEPTH   32
+#define MCP_JSON_CANONICAL_MAX_MEMBERS  16  /* Larger objects keep their order */
+
+/* Wire encodings of a session */
+typedef enum {
+    MCP_WIRE_JSON = 0,              /* Newline-delimited JSON text */
+    MCP_WIRE_CBOR,                  /* CBOR sequence (RFC 8742) */
+} mcp_wire_format_t;
+
+/**
+ * @brief JSON writer state
+ *
+ * The struct may be copied to take a snapshot and assigned back to discard
+ * everything written after the snapshot.
+ */
+typedef struct {
+    char* buf;                      /* Output buffer */
+    size_t size;                    /* Output buffer size */
+    size_t len;                     /* Bytes written so far */
+    bool overflow;                  /* Set once any write did not fit */
+    bool after_key;                 /* Next value belongs to a key */
+    uint8_t depth;                  /* Current container depth */
+    uint8_t format;                 /* mcp_wire_format_t */
+    uint32_t has_items;             /* Bit per depth: container already has an element */
+} mcp_json_writer_t;
+
+/**
+ * @brief Initialize a writer over an output buffer
+ *
+ * @param w Writer
+ * @param buf Output buffer
+ * @param size Output buffer size (one byte is reserved for the terminator)
+ */
+void mcp_json_writer_init(mcp_json_writer_t* w, char* buf, size_t size);
+
+/**
+ * @brief Select the output encoding (before anything is written)
+ *
+ * @param w Writer
+ * @param format MCP_WIRE_JSON (the default) or MCP_WIRE_CBOR
+ */
+static inline void mcp_json_writer_set_format(mcp_json_writer_t* w, mcp_wire_format_t format)
+{
+    w->format = (uint8_t)format;
+}
+
+/**
+ * @brief Get the output encoding
+ */
+static inline mcp_wire_format_t mcp_json_writer_format(const mcp_json_writer_t* w)
+{
+    return (mcp_wire_format_t)w->format;
+}
+
+/**
+ * @brief NUL-terminate the output and report overflow
+ *
+ * @param w Writer
+ * @return ESP_OK if everything fit, ESP_ERR_INVALID_SIZE otherwise
+ */
+esp_err_t mcp_json_writer_finish(mcp_json_writer_t* w);
+
+/**
+ * @brief Get the number of bytes written
+ */
+static inline size_t mcp_json_writer_length(const mcp_json_writer_t* w)
+{
+    return w->len;
+}
+
+/**
+ * @brief Get the number of bytes that can still be written
+ */
+static inline size_t mcp_json_writer_remaining(const mcp_json_writer_t* w)
+{
+    return w->overflow ? 0 : w->size - w->len - 1;
+}
+
+/* Containers */
+void mcp_json_writer_begin_object(mcp_json_writer_t* w);
+void mcp_json_writer_end_object(mcp_json_writer_t* w);
+void mcp_json_writer_begin_array(mcp_json_writer_t* w);
+void mcp_json_writer_end_array(mcp_json_writer_t* w);
+
+/**
+ * @brief Write an object key; the next value written belongs to it
+ */
+void mcp_json_writer_key(mcp_json_writer_t* w, const char* key);
+void mcp_json_writer_key_n(mcp_json_writer_t* w, const char* key, size_t len);
+
+/* Values */
+void mcp_json_writer_string(mcp_json_writer_t* w, const char* str);
+void mcp_json_writer_string_n(mcp_json_writer_t* w, const char* str, size_t len);
+void mcp_json_writer_int(mcp_json_writer_t* w, int64_t value);
+void mcp_json_writer_uint(mcp_json_writer_t* w, uint64_t value);
+void mcp_json_writer_bool(mcp_json_writer_t* w, bool value);
+void mcp_json_writer_null(mcp_json_writer_t* w);
+
+/**
+ * @brief Write a floating point number
+ *
+ * JSON output uses the shortest form that reads back exactly; non-finite
+ * values become null. CBOR output uses a single-precision float when that
+ * is exact and a double otherwise.
+ */
+void mcp_json_writer_double(mcp_json_writer_t* w, double value);
+
+/**
+ * @brief Write an already serialized JSON value
+ *
+ * Copied verbatim by a JSON writer and transcoded by a CBOR writer.
+ *
+ * @param w Writer
+ * @param json Serialized JSON value
+ * @param len Length of the serialized value
+ */
+void mcp_json_writer_raw(mcp_json_writer_t* w, const char* json, size_t len);
+
+/**
+ * @brief Write a value already serialized in the writer's own encoding
+ *
+ * @param w Writer
+ * @param data Serialized value (JSON text or a CBOR item)
+ * @param len Length of the serialized value
+ */
+void mcp_json_writer_encoded(mcp_json_writer_t* w, const void* data, size_t len);
+
+/**
+ * @brief Write binary data as a base64 string value
+ *
+ * @param w Writer
+ * @param data Bytes to encode
+ * @param len Number of bytes
+ */
+void mcp_json_writer_base64(mcp_json_writer_t* w, const void* data, size_t len);
+
+/**
+ * @brief Copy a token from a tokenized document verbatim
+ *
+ * Containers and primitives are copied as-is; strings keep their original
+ * escaping and get their quotes back. A CBOR writer transcodes the token.
+ *
+ * @param w Writer
+ * @param doc Tokenized document
+ * @param tok Token index (a negative index writes null)
+ */
+void mcp_json_writer_token(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int tok);
+
+/**
+ * @brief Copy a token in canonical form
+ *
+ * Like mcp_json_writer_token, but object members are written sorted by key
+ * at every level, so equivalent arguments produce identical bytes.
+ *
+ * @param w Writer
+ * @param doc Tokenized document
+ * @param tok Token index (a negative index writes null)
+ */
+void mcp_json_writer_canonical(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int tok);
+
+/* Object member helpers */
+static inline void mcp_json_writer_add_string(mcp_json_writer_t* w, const char* key, const char* value)
+{
+    mcp_json_writer_key(w, key);
+    mcp_json_writer_string(w, value);
+}
+
+static inline void mcp_json_writer_add_int(mcp_json_writer_t* w, const char* key, int64_t value)
+{
+    mcp_json_writer_key(w, key);
+    mcp_json_writer_int(w, value);
+}
+
+static inline void mcp_json_writer_add_uint(mcp_json_writer_t* w, const char* key, uint64_t value)
+{
+    mcp_json_writer_key(w, key);
+    mcp_json_writer_uint(w, value);
+}
+
+static inline void mcp_json_writer_add_bool(mcp_json_writer_t* w, const char* key, bool value)
+{
+    mcp_json_writer_key(w, key);
+    mcp_json_writer_bool(w, value);
+}
+
+#ifdef __cplusplus
+}
+#endif
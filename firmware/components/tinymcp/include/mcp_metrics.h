@@ -0,0 +1,133 @@
+/**
+ * @file mcp_metrics.h
+ * @brief Fixed-memory latency histograms for MCP methods and tools
+ *
+ * Every JSON-RPC method and every registered tool owns one mcp_metrics_t:
+ * a log2-bucketed latency histogram for each request phase (parse, execute,
+ * serialize). Recording is a couple of atomic increments, so it runs on the
+ * request path without locks. Percentiles are estimated from the buckets
+ * when the metrics are read.
+ *
+ * Memory: one mcp_metrics_t is MCP_METRICS_PHASE_MAX * (MCP_METRICS_BUCKETS
+ * + 1) * 4 bytes, i.e. 300 bytes with the defaults, per method and per tool.
+ *
+ * Features:
+ * - Bucket i holds latencies in [2^(i-1), 2^i) microseconds
+ * - Exact maximum per phase
+ * - p50/p90/p99 reported as bucket upper bounds (within 2x)
+ * - Resettable window
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "mcp_json_writer.h"
+
+/* Histogram Configuration */
+#ifndef MCP_METRICS_BUCKETS
+#define MCP_METRICS_BUCKETS         24      /* Last bucket starts at ~4.2 s */
+#endif
+
+/* Request phases */
+typedef enum {
+    MCP_METRICS_PARSE = 0,          /* Tokenizing and validating the request */
+    MCP_METRICS_EXECUTE,            /* Running the method or tool */
+    MCP_METRICS_SERIALIZE,          /* Writing the response envelope */
+    MCP_METRICS_PHASE_MAX
+} mcp_metrics_phase_t;
+
+/* Latency histogram */
+typedef struct {
+    atomic_uint buckets[MCP_METRICS_BUCKETS];
+    atomic_uint max_us;
+} mcp_histogram_t;
+
+/* Per-method or per-tool metrics */
+typedef struct {
+    mcp_histogram_t phases[MCP_METRICS_PHASE_MAX];
+} mcp_metrics_t;
+
+/* Phase timer for one request */
+typedef struct {
+    int64_t mark_us;                /* End of the last completed phase */
+    uint32_t phase_us[MCP_METRICS_PHASE_MAX];
+} mcp_timing_t;
+
+/* Histogram summary */
+typedef struct {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p90_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+} mcp_histogram_summary_t;
+
+/**
+ * @brief Start timing a request
+ *
+ * @param timing Timer to reset
+ */
+void mcp_timing_start(mcp_timing_t* timing);
+
+/**
+ * @brief Charge the time since the last lap to a phase
+ *
+ * @param timing Timer
+ * @param phase Phase that just ended
+ */
+void mcp_timing_lap(mcp_timing_t* timing, mcp_metrics_phase_t phase);
+
+/**
+ * @brief Record one latency sample
+ *
+ * @param hist Histogram
+ * @param us Latency in microseconds
+ */
+void mcp_histogram_record(mcp_histogram_t* hist, uint32_t us);
+
+/**
+ * @brief Estimate count, percentiles and maximum of a histogram
+ *
+ * @param hist Histogram
+ * @param summary Output summary
+ */
+void mcp_histogram_summarize(const mcp_histogram_t* hist, mcp_histogram_summary_t* summary);
+
+/**
+ * @brief Record every phase of a timed request
+ *
+ * @param metrics Metrics of the method or tool
+ * @param timing Completed phase timer
+ */
+void mcp_metrics_record(mcp_metrics_t* metrics, const mcp_timing_t* timing);
+
+/**
+ * @brief Clear all histograms
+ *
+ * @param metrics Metrics to reset
+ */
+void mcp_metrics_reset(mcp_metrics_t* metrics);
+
+/**
+ * @brief Write metrics as "name":{"parse":[...],"execute":[...],"serialize":[...]}
+ *
+ * Each phase is an array [count, p50_us, p90_us, p99_us, max_us]. Nothing is
+ * written if the metrics hold no samples.
+ *
+ * @param w Writer positioned inside an object
+ * @param name Key to write the metrics under
+ * @param metrics Metrics to write
+ */
+void mcp_metrics_write(mcp_json_writer_t* w, const char* name, const mcp_metrics_t* metrics);
+
+#ifdef __cplusplus
+}
+#endif
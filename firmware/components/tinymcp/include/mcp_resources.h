@@ -0,0 +1,184 @@
+/**
+ * @file mcp_resources.h
+ * @brief Read-only resources served in chunks (resources/list, resources/read)
+ *
+ * A resource is a URI backed by a provider callback. A read returns one
+ * chunk of the content starting at a byte offset, together with a cursor
+ * for the next chunk, so content of any size streams through a small fixed
+ * buffer and is never held in RAM as a whole.
+ *
+ * Providers produce their content from the beginning on every read; the
+ * chunk keeps only the bytes that fall into the requested window. Content
+ * that can be addressed directly (a framebuffer, a flash region) skips
+ * ahead with mcp_resource_chunk_skip() instead.
+ *
+ * Features:
+ * - Fixed resource table, no allocation after init
+ * - Built-in system:// resources with the values clients can subscribe to
+ * - system://tasks task list when the FreeRTOS trace facility is enabled
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "mcp_subscriptions.h"
+
+/* Resource Configuration */
+#ifndef MCP_RESOURCE_MAX
+#define MCP_RESOURCE_MAX            12
+#endif
+#define MCP_RESOURCE_CHUNK_MAX      1024    /* Largest chunk read from a provider */
+
+/* Window of a resource's content requested by a read */
+typedef struct {
+    uint8_t* buf;                   /* Receives the bytes in the window */
+    size_t size;                    /* Window length */
+    uint32_t offset;                /* Content offset of buf[0] */
+    uint32_t pos;                   /* Content bytes produced so far */
+} mcp_resource_chunk_t;
+
+/**
+ * @brief Provider callback producing a resource's content
+ *
+ * Writes the content from its start with mcp_resource_chunk_write/printf/skip.
+ * Production may stop once chunk->pos passes chunk->offset + chunk->size,
+ * but the content is only known to end if the provider returns after
+ * producing all of it.
+ *
+ * @param uri URI being read
+ * @param chunk Requested window
+ * @param user_ctx Context given at registration
+ * @return ESP_OK on success, error code otherwise
+ */
+typedef esp_err_t (*mcp_resource_read_cb_t)(const char* uri,
+                                            mcp_resource_chunk_t* chunk,
+                                            void* user_ctx);
+
+/* Resource */
+typedef struct {
+    const char* uri;
+    const char* name;
+    const char* description;        /* May be NULL */
+    const char* mime_type;
+    bool binary;                    /* Sent base64 encoded as "blob" instead of "text" */
+    mcp_resource_read_cb_t read;
+    void* user_ctx;
+} mcp_resource_def_t;
+
+/* Resource Table */
+typedef struct {
+    mcp_resource_def_t entries[MCP_RESOURCE_MAX];
+    uint32_t count;
+    mcp_system_sample_t sample;     /* Latest sample, content of the system:// resources */
+    bool has_sample;
+    SemaphoreHandle_t lock;
+} mcp_resources_t;
+
+/**
+ * @brief Create a resource table holding the built-in resources
+ *
+ * @param resources Table to initialize
+ * @return ESP_OK on success, ESP_ERR_NO_MEM otherwise
+ */
+esp_err_t mcp_resources_init(mcp_resources_t* resources);
+
+/**
+ * @brief Free a resource table
+ *
+ * @param resources Table to release
+ */
+void mcp_resources_deinit(mcp_resources_t* resources);
+
+/**
+ * @brief Add a resource
+ *
+ * @param resources Table
+ * @param def Resource (copied; strings are not)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the URI is taken,
+ *         ESP_ERR_NO_MEM if the table is full
+ */
+esp_err_t mcp_resources_add(mcp_resources_t* resources, const mcp_resource_def_t* def);
+
+/**
+ * @brief Copy the resource at a table position
+ *
+ * @param resources Table
+ * @param index Position (0 .. count - 1)
+ * @param def Receives the resource
+ * @return true if the position holds a resource
+ */
+bool mcp_resources_get(mcp_resources_t* resources, uint32_t index, mcp_resource_def_t* def);
+
+/**
+ * @brief Copy a resource by URI
+ *
+ * @param resources Table
+ * @param uri URI (not NUL-terminated)
+ * @param len URI length
+ * @param def Receives the resource
+ * @return true if found
+ */
+bool mcp_resources_find(mcp_resources_t* resources, const char* uri, size_t len,
+                        mcp_resource_def_t* def);
+
+/**
+ * @brief Store the sample the system:// resources report
+ *
+ * @param resources Table
+ * @param sample Current system statistics
+ */
+void mcp_resources_set_sample(mcp_resources_t* resources, const mcp_system_sample_t* sample);
+
+/**
+ * @brief Read one chunk of a resource
+ *
+ * @param def Resource
+ * @param offset Content offset of the chunk
+ * @param buf Receives the chunk
+ * @param size Largest chunk wanted
+ * @param len Receives the chunk length
+ * @param eof Set when the chunk reaches the end of the content
+ * @return ESP_OK on success, the provider's error otherwise
+ */
+esp_err_t mcp_resource_read(const mcp_resource_def_t* def, uint32_t offset,
+                            uint8_t* buf, size_t size, size_t* len, bool* eof);
+
+/**
+ * @brief Append content bytes; only those inside the window are kept
+ */
+void mcp_resource_chunk_write(mcp_resource_chunk_t* chunk, const void* data, size_t len);
+
+/**
+ * @brief Append formatted text (at most 255 bytes per call)
+ */
+void mcp_resource_chunk_printf(mcp_resource_chunk_t* chunk, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Advance over content bytes without producing them
+ */
+static inline void mcp_resource_chunk_skip(mcp_resource_chunk_t* chunk, size_t len)
+{
+    chunk->pos += len;
+}
+
+/**
+ * @brief Check whether production can stop because the window is full
+ */
+static inline bool mcp_resource_chunk_full(const mcp_resource_chunk_t* chunk)
+{
+    return chunk->pos > chunk->offset + chunk->size;
+}
+
+#ifdef __cplusplus
+}
+#endif
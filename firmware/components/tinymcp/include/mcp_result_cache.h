@@ -0,0 +1,126 @@
+/**
+ * @file mcp_result_cache.h
+ * @brief Single-flight TTL cache for serialized tool results
+ *
+ * Tools that declare a cache TTL have their serialized result stored under
+ * a key made of the tool name and its canonicalized arguments. A call that
+ * finds a fresh entry copies the stored bytes into its response instead of
+ * running the tool. Concurrent identical calls are coalesced: the first
+ * caller executes the tool while the others wait for its result.
+ *
+ * Features:
+ * - Fixed number of entries with LRU replacement
+ * - Memory ceiling covering keys and results
+ * - Waiters fall back to executing themselves if the leader fails or stalls
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "mcp_json_writer.h"
+
+/* Cache Configuration */
+#ifndef MCP_RESULT_CACHE_ENTRIES
+#define MCP_RESULT_CACHE_ENTRIES    8       /* At most 24 (event group bits) */
+#endif
+#ifndef MCP_RESULT_CACHE_MAX_BYTES
+#define MCP_RESULT_CACHE_MAX_BYTES  4096
+#endif
+#define MCP_RESULT_CACHE_WAIT_MS    1000    /* Longest a caller waits for a leader */
+#define MCP_RESULT_CACHE_KEY_MAX    256     /* Calls with longer keys are not cached */
+
+/* Outcome of mcp_result_cache_begin */
+typedef enum {
+    MCP_CACHE_HIT = 0,              /* Cached result was written */
+    MCP_CACHE_MISS,                 /* Caller must execute and complete the slot */
+    MCP_CACHE_BYPASS,               /* Caller must execute without caching */
+} mcp_cache_result_t;
+
+/* Cache entry */
+typedef struct {
+    uint32_t hash;
+    char* key;                      /* Tool name, NUL, canonical arguments */
+    size_t key_len;
+    char* value;                    /* Serialized result, NULL while pending */
+    size_t value_len;
+    int64_t expires_us;
+    int64_t last_used_us;
+    bool pending;                   /* A leader is executing the tool */
+} mcp_cache_entry_t;
+
+/* Result Cache */
+typedef struct {
+    mcp_cache_entry_t entries[MCP_RESULT_CACHE_ENTRIES];
+    size_t bytes;                   /* Keys and values currently held */
+    size_t max_bytes;
+    SemaphoreHandle_t lock;
+    EventGroupHandle_t ready;       /* Bit per entry, clear while pending */
+} mcp_result_cache_t;
+
+/**
+ * @brief Create an empty cache
+ *
+ * @param cache Cache to initialize
+ * @param max_bytes Memory ceiling for keys and values
+ * @return ESP_OK on success, ESP_ERR_NO_MEM otherwise
+ */
+esp_err_t mcp_result_cache_init(mcp_result_cache_t* cache, size_t max_bytes);
+
+/**
+ * @brief Free a cache (no calls may be in flight)
+ *
+ * @param cache Cache to release
+ */
+void mcp_result_cache_deinit(mcp_result_cache_t* cache);
+
+/**
+ * @brief Look up a call, joining or starting its flight
+ *
+ * On MCP_CACHE_HIT the cached result has been written to 'w'. On
+ * MCP_CACHE_MISS the caller owns '*slot' and must call
+ * mcp_result_cache_complete once the tool has run.
+ *
+ * @param cache Cache
+ * @param key Key bytes (tool name and canonical arguments)
+ * @param key_len Key length
+ * @param w Writer positioned where the result value belongs
+ * @param slot Receives the entry to complete on a miss
+ * @return Lookup outcome
+ */
+mcp_cache_result_t mcp_result_cache_begin(mcp_result_cache_t* cache,
+                                          const char* key, size_t key_len,
+                                          mcp_json_writer_t* w, int* slot);
+
+/**
+ * @brief Publish the result of a flight and wake its waiters
+ *
+ * @param cache Cache
+ * @param slot Entry returned by mcp_result_cache_begin
+ * @param value Serialized result, or NULL if the tool failed
+ * @param value_len Result length
+ * @param ttl_ms How long the result stays fresh
+ */
+void mcp_result_cache_complete(mcp_result_cache_t* cache, int slot,
+                               const char* value, size_t value_len, uint32_t ttl_ms);
+
+/**
+ * @brief Get the number of bytes held by the cache
+ *
+ * @param cache Cache
+ * @return Bytes used by keys and values
+ */
+size_t mcp_result_cache_bytes(mcp_result_cache_t* cache);
+
+#ifdef __cplusplus
+}
+#endif
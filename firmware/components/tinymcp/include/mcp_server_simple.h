@@ -7,10 +7,16 @@
  * complex transport layers.
  * 
  * Features:
- * - Basic JSON-RPC 2.0 protocol support
+ * - Basic JSON-RPC 2.0 protocol support, including batches
  * - Simple communication interface
  * - ESP32-specific tools (echo, display, GPIO, system)
- * - FreeRTOS task integration
+ * - Worker pool executing queued requests asynchronously
+ * - Per-method and per-tool latency histograms (server/metrics)
+ * - Request lifecycle tracing (debug/trace_dump)
+ * - Single-flight TTL cache for idempotent tool results
+ * - initialize handshake with optional CBOR session encoding
+ * - Subscriptions to system values pushed as notifications
+ * - Request deadlines and notifications/cancelled; dropped requests never run
  */
 
 #pragma once
@@ -24,6 +30,11 @@ extern "C" {
 #include "esp_err.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "mcp_json.h"
+#include "mcp_json_writer.h"
+#include "mcp_arena.h"
+#include "mcp_subscriptions.h"
+#include "mcp_resources.h"
 
 /* MCP Server Configuration */
 #define MCP_SERVER_NAME             "esp32-c6-mcp"
@@ -35,15 +46,34 @@ extern "C" {
 #ifndef MCP_SERVER_TASK_STACK_SIZE
 #define MCP_SERVER_TASK_STACK_SIZE  4096
 #endif
+#ifndef MCP_SERVER_WORKER_COUNT
+#define MCP_SERVER_WORKER_COUNT     2
+#endif
+#define MCP_SERVER_MAX_WORKERS      4
+#ifndef MCP_SERVER_QUEUE_LENGTH
+#define MCP_SERVER_QUEUE_LENGTH     8
+#endif
 
 /* Message Configuration */
 #ifndef MCP_MAX_MESSAGE_SIZE
 #define MCP_MAX_MESSAGE_SIZE        1024
 #endif
-#ifndef MCP_MAX_TOOLS
-#define MCP_MAX_TOOLS               8
+#define MCP_RESPONSE_TIMEOUT_MS     5000    /* Default and longest request deadline */
+#ifndef MCP_REQUEST_TLS_INDEX
+#define MCP_REQUEST_TLS_INDEX       2       /* Task-local slot of the request being handled */
 #endif
-#define MCP_RESPONSE_TIMEOUT_MS     5000
+#define MCP_CANCEL_SLOTS            8       /* Cancellations remembered until their request runs */
+
+/* JSON-RPC Error Codes */
+#define MCP_ERROR_PARSE             (-32700)
+#define MCP_ERROR_INVALID_REQUEST   (-32600)
+#define MCP_ERROR_METHOD_NOT_FOUND  (-32601)
+#define MCP_ERROR_INVALID_PARAMS    (-32602)
+#define MCP_ERROR_INTERNAL          (-32603)
+#define MCP_ERROR_TOOL_FAILED       (-32000)
+#define MCP_ERROR_RATE_LIMITED      (-32001)    /* Client exceeded its request rate */
+#define MCP_ERROR_OVERLOADED        (-32002)    /* Server shed load to protect itself */
+#define MCP_ERROR_TIMEOUT           (-32003)    /* Deadline passed before the request ran */
 
 /* MCP Server Handle */
 typedef struct mcp_server_simple* mcp_server_handle_t;
@@ -54,6 +84,7 @@ typedef enum {
     MCP_TOOL_DISPLAY,
     MCP_TOOL_GPIO,
     MCP_TOOL_SYSTEM,
+    MCP_TOOL_CUSTOM,                /* Defined by the application */
     MCP_TOOL_MAX
 } mcp_tool_type_t;
 
@@ -73,6 +104,12 @@ typedef struct {
     uint32_t task_stack_size;
     UBaseType_t task_priority;
     uint32_t max_message_size;
+    uint32_t arena_size;            /* Bytes of scratch memory per in-flight request */
+    uint32_t arena_count;           /* Number of requests that can hold an arena at once */
+    uint32_t worker_count;          /* Worker tasks executing queued requests */
+    uint32_t queue_length;          /* Requests that can wait for a worker */
+    uint32_t cache_max_bytes;       /* Memory ceiling of the tool result cache, 0 disables it */
+    uint32_t request_timeout_ms;    /* Default request deadline, 0 for none */
     bool enable_echo_tool;
     bool enable_display_tool;
     bool enable_gpio_tool;
@@ -84,19 +121,50 @@ typedef struct {
     const char* name;
     const char* description;
     mcp_tool_type_t type;
-    esp_err_t (*execute)(const char* params_json, char* result_json, size_t result_size);
+    const char* input_schema;       /* JSON Schema text for the arguments, NULL for none */
+    esp_err_t (*execute)(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out);
+    uint32_t cache_ttl_ms;          /* Results are reused for this long, 0 if not cacheable */
+    bool (*is_cacheable)(const mcp_json_doc_t* doc, int args);  /* NULL: every call is */
 } mcp_tool_def_t;
 
-/* MCP Message Structure */
-typedef struct {
+/* MCP Message Structure (request envelope) */
+typedef struct mcp_message mcp_message_t;
+
+/**
+ * @brief Completion callback for a submitted request
+ * 
+ * Runs on the worker task that handled the request. The response is only
+ * valid for the duration of the call; it is empty (response_len == 0) for
+ * notifications and for requests that could not be handled. The buffer
+ * holds one spare byte after the response, so a transport can append its
+ * delimiter in place and send the frame at once.
+ * 
+ * @param msg Request envelope (client_id and user_ctx identify the origin)
+ * @param response Serialized response, followed by one writable spare byte
+ * @param response_len Response length in bytes
+ * @param status Result of mcp_server_process_line for this request
+ */
+typedef void (*mcp_completion_cb_t)(const mcp_message_t* msg,
+                                    char* response,
+                                    size_t response_len,
+                                    esp_err_t status);
+
+struct mcp_message {
     mcp_message_type_t type;
-    uint32_t id;
-    const char* method;
-    const char* params_json;
-    char* result_json;
-    size_t result_size;
-    esp_err_t error_code;
-} mcp_message_t;
+    uint32_t id;                    /* Server-assigned sequence number */
+    uint32_t client_id;             /* Originating connection */
+    int64_t enqueue_time_us;        /* When the request entered the queue */
+    int64_t deadline_us;            /* Default deadline of its requests, 0 for none */
+    uint32_t cancel_epoch;          /* Cancellations the server had seen when it was queued */
+    bool urgent;                    /* Queued ahead of requests (mcp_server_is_urgent) */
+    mcp_completion_cb_t on_complete;
+    void* user_ctx;
+    mcp_wire_format_t format;       /* Encoding of the request and its response */
+    mcp_wire_format_t next_format;  /* Encoding negotiated by the request (initialize) */
+    size_t request_len;
+    const char* request;            /* Request text or CBOR item */
+    char storage[];                 /* Copy of the request (NUL-terminated), unless borrowed */
+};
 
 /* MCP Server Statistics */
 typedef struct {
@@ -105,6 +173,20 @@ typedef struct {
     uint32_t requests_processed;
     uint32_t errors_count;
     uint32_t tools_executed;
+    uint32_t arena_high_water;      /* Peak arena bytes used by a single request */
+    uint32_t arena_fallbacks;       /* Request allocations that overflowed to the heap */
+    uint32_t queue_depth;           /* Requests currently waiting for a worker */
+    uint32_t queue_depth_max;       /* Deepest the request queue has been */
+    uint32_t queue_rejected;        /* Submissions refused because the queue was full */
+    uint32_t queue_wait_avg_us;     /* Mean time from submission to execution */
+    uint32_t queue_wait_max_us;     /* Longest time from submission to execution */
+    uint32_t cache_hits;            /* Tool calls answered from the result cache */
+    uint32_t cache_misses;          /* Cacheable tool calls that executed the tool */
+    uint32_t cache_bytes;           /* Memory held by cached keys and results */
+    uint32_t notifications_sent;    /* Subscription notifications delivered */
+    uint32_t requests_cancelled;    /* Requests dropped before running: cancelled by the client */
+    uint32_t requests_expired;      /* Requests dropped before running: deadline passed */
+    uint32_t work_saved_us;         /* Typical execution time of the dropped requests */
     uint64_t uptime_ms;
 } mcp_server_stats_t;
 
@@ -155,6 +237,9 @@ esp_err_t mcp_server_deinit(mcp_server_handle_t server_handle);
 /**
  * @brief Get server statistics
  * 
+ * Counters are updated lock-free; the returned snapshot reflects a point
+ * between message updates, never a partially accounted message.
+ * 
  * @param server_handle Server handle
  * @param stats Pointer to store statistics
  * @return ESP_OK on success, error code otherwise
@@ -162,6 +247,18 @@ esp_err_t mcp_server_deinit(mcp_server_handle_t server_handle);
 esp_err_t mcp_server_get_stats(mcp_server_handle_t server_handle,
                                mcp_server_stats_t* stats);
 
+/**
+ * @brief Get statistics for one request arena
+ * 
+ * @param server_handle Server handle
+ * @param index Arena index (0 .. arena_count - 1)
+ * @param stats Pointer to store statistics
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if index is out of range
+ */
+esp_err_t mcp_server_get_arena_stats(mcp_server_handle_t server_handle,
+                                     uint32_t index,
+                                     mcp_arena_stats_t* stats);
+
 /**
  * @brief Check if server is running
  * 
@@ -176,6 +273,12 @@ bool mcp_server_is_running(mcp_server_handle_t server_handle);
  * This function can be called from the main firmware to process
  * JSON-RPC messages received from various sources
  * 
+ * The line may hold a single request object or a JSON-RPC batch (an array
+ * of requests, at most max_message_size bytes in total). A batch is answered
+ * with one array of responses. Notifications (requests without an id) are
+ * executed but get no response; if nothing needs answering the output
+ * buffer is left as an empty string.
+ * 
  * @param server_handle Server handle
  * @param input_line Input line to process
  * @param output_buffer Buffer for response
@@ -187,47 +290,276 @@ esp_err_t mcp_server_process_line(mcp_server_handle_t server_handle,
                                   char* output_buffer,
                                   size_t output_size);
 
+/**
+ * @brief Start a new latency metrics window
+ * 
+ * Clears the per-method and per-tool histograms reported by the
+ * server/metrics method (which also accepts {"reset":true}).
+ * 
+ * @param server_handle Server handle
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t mcp_server_reset_metrics(mcp_server_handle_t server_handle);
+
+/**
+ * @brief Register a tool at runtime
+ * 
+ * The definition is copied into a new registry table which is published
+ * atomically; requests already running keep using the previous table. The
+ * strings it points to (name, description, input_schema) must stay valid
+ * while the tool is registered. Must not be called from a tool's execute
+ * function.
+ * 
+ * @param server_handle Server handle
+ * @param tool Tool definition
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the name is already
+ *         registered, ESP_ERR_NO_MEM otherwise
+ */
+esp_err_t mcp_server_register_tool(mcp_server_handle_t server_handle,
+                                   const mcp_tool_def_t* tool);
+
+/**
+ * @brief Remove a tool at runtime
+ * 
+ * Returns once no request can still be executing the tool, so its
+ * resources may be released afterwards. Must not be called from a tool's
+ * execute function.
+ * 
+ * @param server_handle Server handle
+ * @param name Tool name
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no such tool is registered
+ */
+esp_err_t mcp_server_unregister_tool(mcp_server_handle_t server_handle,
+                                     const char* name);
+
+/**
+ * @brief Queue a request for asynchronous execution
+ * 
+ * The request text is copied, so the caller's buffer may be reused as soon
+ * as this returns. A worker task processes the request as with
+ * mcp_server_process_line and hands the response to on_complete, which
+ * routes it back to the originating connection.
+ * 
+ * @param server_handle Server handle
+ * @param client_id Originating connection, passed back in the envelope
+ * @param request Request text (single request or batch) or CBOR item
+ * @param request_len Request length in bytes
+ * @param format Encoding of the request; the response uses the same one
+ * @param on_complete Completion callback (required)
+ * @param user_ctx Opaque pointer passed back in the envelope
+ * @return ESP_OK if queued, ESP_ERR_TIMEOUT if the queue is full,
+ *         ESP_ERR_NO_MEM if the request could not be copied,
+ *         ESP_ERR_INVALID_SIZE if it exceeds max_message_size
+ */
+esp_err_t mcp_server_submit(mcp_server_handle_t server_handle,
+                            uint32_t client_id,
+                            const char* request,
+                            size_t request_len,
+                            mcp_wire_format_t format,
+                            mcp_completion_cb_t on_complete,
+                            void* user_ctx);
+
+/**
+ * @brief Queue a request without copying it
+ * 
+ * As mcp_server_submit, but the worker reads the request from the caller's
+ * buffer, typically a slice of a connection's receive buffer. The bytes
+ * must stay valid and unmodified until on_complete has returned; they need
+ * not be NUL-terminated.
+ * 
+ * @return As mcp_server_submit; ESP_ERR_NO_MEM refers to the envelope
+ */
+esp_err_t mcp_server_submit_borrowed(mcp_server_handle_t server_handle,
+                                     uint32_t client_id,
+                                     const char* request,
+                                     size_t request_len,
+                                     mcp_wire_format_t format,
+                                     mcp_completion_cb_t on_complete,
+                                     void* user_ctx);
+
+/**
+ * @brief Check whether the request being handled should stop
+ * 
+ * For tools doing long work: true once the request's deadline has passed
+ * or its client cancelled it (notifications/cancelled). A tool that sees
+ * this may return early; the response to a cancelled request is discarded.
+ * Outside a request handler this always returns false.
+ * 
+ * @return true if the work is no longer wanted
+ */
+bool mcp_request_should_stop(void);
+
+/**
+ * @brief Get the time left before the deadline of the request being handled
+ * 
+ * @return Milliseconds left (negative once passed), INT32_MAX without a deadline
+ */
+int32_t mcp_request_remaining_ms(void);
+
+/**
+ * @brief Answer a message without executing it
+ * 
+ * Used by transports shedding load: every request in the message (single
+ * or batch) gets an error with the given code and message, its own id and
+ * a data.retryAfterMs hint. Notifications get no response. The message is
+ * only tokenized, so this is far cheaper than queueing it.
+ * 
+ * @param server_handle Server handle
+ * @param client_id Originating connection
+ * @param request Request text or CBOR item
+ * @param request_len Request length in bytes
+ * @param format Encoding of the request and of the response
+ * @param code JSON-RPC error code (MCP_ERROR_RATE_LIMITED, MCP_ERROR_OVERLOADED)
+ * @param message Error message
+ * @param retry_after_ms Suggested delay before the client retries
+ * @param output_buffer Buffer receiving the response
+ * @param output_size Size of the output buffer
+ * @param output_len Length of the response, 0 if there is nothing to send
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t mcp_server_reject(mcp_server_handle_t server_handle,
+                            uint32_t client_id,
+                            const char* request,
+                            size_t request_len,
+                            mcp_wire_format_t format,
+                            int code,
+                            const char* message,
+                            uint32_t retry_after_ms,
+                            char* output_buffer,
+                            size_t output_size,
+                            size_t* output_len);
+
+/**
+ * @brief Get the number of requests waiting for a worker
+ * 
+ * @param server_handle Server handle
+ * @return Current request queue depth
+ */
+uint32_t mcp_server_get_queue_depth(mcp_server_handle_t server_handle);
+
+/**
+ * @brief Check whether a message must not wait behind queued requests
+ * 
+ * Cancellations (notifications/cancelled) are queued ahead of requests so
+ * that they reach a queued request before it runs. Transports should not
+ * hold urgent messages back behind their own flow control either. The
+ * message is parsed: only a notification whose method is exactly
+ * notifications/cancelled qualifies, so a request cannot jump the queue
+ * by mentioning the name.
+ * 
+ * @param request Request text or CBOR item
+ * @param request_len Request length in bytes
+ * @param format Encoding of the request
+ * @return true if the message is urgent
+ */
+bool mcp_server_is_urgent(const char* request, size_t request_len, mcp_wire_format_t format);
+
+/**
+ * @brief Set the function delivering subscription notifications
+ * 
+ * The transport registers itself here so that notifications reach the
+ * connection that subscribed. Without a handler, subscribe requests are
+ * refused.
+ * 
+ * @param server_handle Server handle
+ * @param notify Delivery callback, or NULL to detach
+ * @param user_ctx Context passed to the callback
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t mcp_server_set_notify_handler(mcp_server_handle_t server_handle,
+                                        mcp_notify_cb_t notify,
+                                        void* user_ctx);
+
+/**
+ * @brief Publish a system statistics sample to subscribers
+ * 
+ * Called periodically by the firmware with the statistics it collects.
+ * Each subscription whose value changed and whose minimum interval has
+ * elapsed gets a notifications/resources/updated message, sent from the
+ * calling task.
+ * 
+ * @param server_handle Server handle
+ * @param sample Current system statistics
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t mcp_server_publish_sample(mcp_server_handle_t server_handle,
+                                    const mcp_system_sample_t* sample);
+
+/**
+ * @brief Add a resource readable with resources/read
+ * 
+ * The system:// values and, with the FreeRTOS trace facility, the task
+ * list are built in. Clients read resources in chunks of at most
+ * MCP_RESOURCE_CHUNK_MAX bytes that also fit the response buffer.
+ * 
+ * @param server_handle Server handle
+ * @param resource Resource (copied; strings and user_ctx are not)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the URI is taken,
+ *         ESP_ERR_NO_MEM if the resource table is full
+ */
+esp_err_t mcp_server_register_resource(mcp_server_handle_t server_handle,
+                                       const mcp_resource_def_t* resource);
+
+/**
+ * @brief Forget the subscriptions of a closed connection
+ * 
+ * @param server_handle Server handle
+ * @param client_id Connection that closed
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t mcp_server_client_closed(mcp_server_handle_t server_handle,
+                                   uint32_t client_id);
+
 /* Built-in Tool Functions */
 
 /**
  * @brief Echo tool - responds with the input parameters
  * 
- * @param params_json Tool parameters as JSON
- * @param result_json Buffer for result JSON
- * @param result_size Size of result buffer
+ * @param doc Tokenized request the arguments belong to
+ * @param args Index of the arguments object token, or -1 if absent
+ * @param out Writer to append the result value to
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t mcp_tool_echo_execute(const char* params_json, char* result_json, size_t result_size);
+esp_err_t mcp_tool_echo_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out);
 
 /**
  * @brief Display tool - controls ST7789 display
  * 
- * @param params_json Tool parameters as JSON
- * @param result_json Buffer for result JSON
- * @param result_size Size of result buffer
+ * @param doc Tokenized request the arguments belong to
+ * @param args Index of the arguments object token, or -1 if absent
+ * @param out Writer to append the result value to
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t mcp_tool_display_execute(const char* params_json, char* result_json, size_t result_size);
+esp_err_t mcp_tool_display_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out);
 
 /**
  * @brief GPIO tool - controls LED and reads button
  * 
- * @param params_json Tool parameters as JSON
- * @param result_json Buffer for result JSON
- * @param result_size Size of result buffer
+ * @param doc Tokenized request the arguments belong to
+ * @param args Index of the arguments object token, or -1 if absent
+ * @param out Writer to append the result value to
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t mcp_tool_gpio_execute(const char* params_json, char* result_json, size_t result_size);
+esp_err_t mcp_tool_gpio_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out);
 
 /**
  * @brief System tool - provides system information
  * 
- * @param params_json Tool parameters as JSON
- * @param result_json Buffer for result JSON
- * @param result_size Size of result buffer
+ * @param doc Tokenized request the arguments belong to
+ * @param args Index of the arguments object token, or -1 if absent
+ * @param out Writer to append the result value to
  * @return ESP_OK on success, error code otherwise
  */
-esp_err_t mcp_tool_system_execute(const char* params_json, char* result_json, size_t result_size);
+esp_err_t mcp_tool_system_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out);
+
+/**
+ * @brief Check whether a system tool call may be served from the cache
+ * 
+ * @param doc Tokenized request the arguments belong to
+ * @param args Index of the arguments object token, or -1 if absent
+ * @return true for read-only actions, false for actions with side effects
+ */
+bool mcp_tool_system_cacheable(const mcp_json_doc_t* doc, int args);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,179 @@
+/**
+ * @file mcp_subscriptions.h
+ * @brief Client subscriptions to system values pushed as notifications
+ *
+ * A client subscribes to a value by URI (resources/subscribe) instead of
+ * polling system_info. The firmware hands the server a sample of its
+ * system statistics periodically; every subscription whose value changed
+ * is answered with a notifications/resources/updated message carrying the
+ * new value, at most once per the client's minimum interval.
+ *
+ * Features:
+ * - Fixed subscription table, no allocation after init
+ * - Per-subscription minimum interval and change threshold
+ * - First sample after subscribing is always delivered
+ * - Subscriptions of a closed connection are dropped
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/* Subscription Configuration */
+#ifndef MCP_SUBSCRIPTION_MAX
+#define MCP_SUBSCRIPTION_MAX        16
+#endif
+#define MCP_SUBSCRIPTION_DEFAULT_INTERVAL_MS    1000
+#define MCP_SUBSCRIPTION_NOTIFY_MAX 192     /* Largest notification message */
+
+/* Subscribable values */
+typedef enum {
+    MCP_TOPIC_HEAP = 0,             /* system://heap, free heap bytes */
+    MCP_TOPIC_HEAP_MIN,             /* system://heap/min, low-water mark of free heap */
+    MCP_TOPIC_UPTIME,               /* system://uptime, seconds since boot */
+    MCP_TOPIC_RSSI,                 /* system://wifi/rssi, dBm, 0 while disconnected */
+    MCP_TOPIC_BUTTONS,              /* system://button/presses, user button presses */
+    MCP_TOPIC_MAX
+} mcp_topic_t;
+
+/* System statistics sample published by the firmware */
+typedef struct {
+    uint32_t uptime_seconds;
+    uint32_t free_heap;
+    uint32_t min_free_heap;
+    int8_t wifi_rssi;
+    uint32_t button_presses;
+} mcp_system_sample_t;
+
+/**
+ * @brief Notification delivery callback
+ *
+ * @param client_id Subscribed connection
+ * @param message Serialized JSON-RPC notification (JSON text)
+ * @param message_len Message length
+ * @param user_ctx Context given with the callback
+ * @return ESP_OK if sent; ESP_ERR_NOT_FOUND drops the client's subscriptions
+ */
+typedef esp_err_t (*mcp_notify_cb_t)(uint32_t client_id,
+                                     const char* message,
+                                     size_t message_len,
+                                     void* user_ctx);
+
+/* Subscription */
+typedef struct {
+    uint32_t client_id;             /* 0 marks a free slot */
+    uint8_t topic;                  /* mcp_topic_t */
+    bool primed;                    /* A value has been delivered */
+    uint32_t min_interval_ms;
+    uint32_t min_delta;             /* Smallest change worth notifying */
+    int64_t last_value;
+    int64_t last_sent_us;
+} mcp_subscription_t;
+
+/* Subscription Table */
+typedef struct {
+    mcp_subscription_t entries[MCP_SUBSCRIPTION_MAX];
+    SemaphoreHandle_t lock;
+} mcp_subscriptions_t;
+
+/**
+ * @brief Create an empty subscription table
+ *
+ * @param subs Table to initialize
+ * @return ESP_OK on success, ESP_ERR_NO_MEM otherwise
+ */
+esp_err_t mcp_subscriptions_init(mcp_subscriptions_t* subs);
+
+/**
+ * @brief Free a subscription table
+ *
+ * @param subs Table to release
+ */
+void mcp_subscriptions_deinit(mcp_subscriptions_t* subs);
+
+/**
+ * @brief Look up a topic by URI
+ *
+ * @param uri Resource URI (not NUL-terminated)
+ * @param len URI length
+ * @return Topic, or -1 if the URI names no subscribable value
+ */
+int mcp_topic_from_uri(const char* uri, size_t len);
+
+/**
+ * @brief Get the URI of a topic
+ *
+ * @param topic Topic
+ * @return URI string
+ */
+const char* mcp_topic_uri(mcp_topic_t topic);
+
+/**
+ * @brief Get the value of a topic in a sample
+ *
+ * @param sample System statistics
+ * @param topic Topic
+ * @return Value, 0 for an unknown topic
+ */
+int64_t mcp_topic_value(const mcp_system_sample_t* sample, mcp_topic_t topic);
+
+/**
+ * @brief Subscribe a client to a topic, or update its existing subscription
+ *
+ * @param subs Table
+ * @param client_id Connection receiving the notifications (non-zero)
+ * @param topic Topic
+ * @param min_interval_ms Shortest time between two notifications
+ * @param min_delta Smallest change that triggers a notification
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the table is full
+ */
+esp_err_t mcp_subscriptions_add(mcp_subscriptions_t* subs, uint32_t client_id,
+                                mcp_topic_t topic, uint32_t min_interval_ms,
+                                uint32_t min_delta);
+
+/**
+ * @brief Remove a client's subscription to a topic
+ *
+ * @param subs Table
+ * @param client_id Connection
+ * @param topic Topic
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if it was not subscribed
+ */
+esp_err_t mcp_subscriptions_remove(mcp_subscriptions_t* subs, uint32_t client_id,
+                                   mcp_topic_t topic);
+
+/**
+ * @brief Remove every subscription of a client
+ *
+ * @param subs Table
+ * @param client_id Connection that went away
+ */
+void mcp_subscriptions_drop_client(mcp_subscriptions_t* subs, uint32_t client_id);
+
+/**
+ * @brief Deliver a sample to the subscriptions it concerns
+ *
+ * Notifications are sent from the calling task, outside the table lock.
+ *
+ * @param subs Table
+ * @param sample Current system statistics
+ * @param notify Delivery callback
+ * @param user_ctx Context passed to the callback
+ * @return Number of notifications sent
+ */
+uint32_t mcp_subscriptions_publish(mcp_subscriptions_t* subs,
+                                   const mcp_system_sample_t* sample,
+                                   mcp_notify_cb_t notify, void* user_ctx);
+
+#ifdef __cplusplus
+}
+#endif
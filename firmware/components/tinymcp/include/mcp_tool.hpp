@@ -0,0 +1,443 @@
+/**
+ * @file mcp_tool.hpp
+ * @brief Compile-time tool definitions for C++ firmware (C++17, header only)
+ *
+ * A tool is a struct that names itself, lists its arguments as typed fields
+ * of an argument struct, and handles the decoded arguments:
+ *
+ *     struct blink_tool {
+ *         struct args_t {
+ *             uint32_t times = 1;
+ *             bool fast = false;
+ *         };
+ *         static constexpr const char* name = "blink";
+ *         static constexpr const char* description = "Blink the status LED";
+ *         static constexpr auto fields = std::make_tuple(
+ *             mcp::required("times", &args_t::times),
+ *             mcp::optional("fast", &args_t::fast));
+ *         static esp_err_t run(const args_t& args, mcp_json_writer_t* out);
+ *     };
+ *
+ * From that declaration the templates generate, at compile time, what the
+ * C tools write by hand: the argument decoder behind mcp_tool_def_t's
+ * execute, the JSON Schema text of the arguments, and a name-sorted table
+ * of tool definitions that is checked for duplicate names and lives in
+ * flash. The handler only runs with every required field present and
+ * valid; otherwise the caller gets the usual error result.
+ *
+ * Field types: bool, int32_t, uint32_t, mcp::text<N> and enumerations
+ * declared with mcp::one_of(). A tool may also define
+ * `static constexpr uint32_t cache_ttl_ms` to make its results cacheable.
+ *
+ * The table is registered with the server like any other tool, so these
+ * tools get per-tool metrics, result caching and a tools/list entry.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <tuple>
+#include <type_traits>
+
+extern "C" {
+#include "mcp_server_simple.h"
+}
+
+namespace mcp {
+
+/* Fixed-size string argument, NUL-terminated, N bytes including the NUL */
+template <size_t N>
+struct text {
+    static_assert(N > 1, "text needs room for at least one character");
+    char value[N] = {};
+    
+    const char* c_str() const { return value; }
+};
+
+/* Argument of a tool: a JSON member decoded into a member of the argument struct */
+template <typename Args, typename T>
+struct field {
+    const char* name;
+    T Args::* member;
+    bool required;
+    const char* const* choices;     /* Accepted strings of an enumeration, else nullptr */
+    size_t choice_count;
+};
+
+/* Argument that must be present */
+template <typename Args, typename T>
+constexpr field<Args, T> required(const char* name, T Args::* member)
+{
+    return {name, member, true, nullptr, 0};
+}
+
+/* Argument that keeps the member's default when absent */
+template <typename Args, typename T>
+constexpr field<Args, T> optional(const char* name, T Args::* member)
+{
+    return {name, member, false, nullptr, 0};
+}
+
+/* String argument decoded into an enumeration: choices[i] becomes E(i) */
+template <typename Args, typename E, size_t N>
+constexpr field<Args, E> one_of(const char* name, E Args::* member,
+                                 const char* const (&choices)[N], bool is_required = true)
+{
+    static_assert(std::is_enum<E>::value, "one_of() decodes into an enumeration");
+    return {name, member, is_required, choices, N};
+}
+
+/* Start a success result: {"status":"success","message":...,"data":{ */
+inline void begin_result(mcp_json_writer_t* out, const char* message)
+{
+    mcp_json_writer_begin_object(out);
+    mcp_json_writer_add_string(out, "status", "success");
+    if (message) {
+        mcp_json_writer_add_string(out, "message", message);
+    }
+    mcp_json_writer_key(out, "data");
+    mcp_json_writer_begin_object(out);
+}
+
+/* Close a result opened with begin_result */
+inline esp_err_t end_result(mcp_json_writer_t* out)
+{
+    mcp_json_writer_end_object(out);
+    mcp_json_writer_end_object(out);
+    return out->overflow ? ESP_ERR_INVALID_SIZE : ESP_OK;
+}
+
+/* Write an error result without data */
+inline esp_err_t error_result(mcp_json_writer_t* out, const char* message)
+{
+    mcp_json_writer_begin_object(out);
+    mcp_json_writer_add_string(out, "status", "error");
+    mcp_json_writer_add_string(out, "message", message);
+    mcp_json_writer_end_object(out);
+    return out->overflow ? ESP_ERR_INVALID_SIZE : ESP_OK;
+}
+
+namespace detail {
+
+/* ---- Schema generation ---- */
+
+/* Sink that only counts, used to size the schema buffer */
+struct length_sink {
+    size_t size = 0;
+    
+    constexpr void put(char) { size++; }
+};
+
+/* Sink that fills the schema buffer */
+template <size_t N>
+struct buffer_sink {
+    std::array<char, N> data{};
+    size_t size = 0;
+    
+    constexpr void put(char c) { data[size++] = c; }
+};
+
+template <typename Sink>
+constexpr void put_str(Sink& sink, const char* str)
+{
+    while (*str) {
+        sink.put(*str++);
+    }
+}
+
+template <typename Sink>
+constexpr void put_uint(Sink& sink, size_t value)
+{
+    char digits[20] = {};
+    int count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (count) {
+        sink.put(digits[--count]);
+    }
+}
+
+template <typename T>
+struct is_text : std::false_type {};
+
+template <size_t N>
+struct is_text<text<N>> : std::true_type {};
+
+/* Schema of one property, e.g. "times":{"type":"integer","minimum":0} */
+template <typename Sink, typename Args, typename T>
+constexpr void write_property(Sink& sink, const field<Args, T>& f)
+{
+    sink.put('"');
+    put_str(sink, f.name);
+    put_str(sink, "\":{\"type\":");
+    if constexpr (std::is_same<T, bool>::value) {
+        put_str(sink, "\"boolean\"");
+    } else if constexpr (std::is_same<T, int32_t>::value) {
+        put_str(sink, "\"integer\"");
+    } else if constexpr (std::is_same<T, uint32_t>::value) {
+        put_str(sink, "\"integer\",\"minimum\":0");
+    } else if constexpr (is_text<T>::value) {
+        put_str(sink, "\"string\",\"maxLength\":");
+        put_uint(sink, sizeof(T::value) - 1);
+    } else if constexpr (std::is_enum<T>::value) {
+        put_str(sink, "\"string\",\"enum\":[");
+        for (size_t i = 0; i < f.choice_count; i++) {
+            if (i) {
+                sink.put(',');
+            }
+            sink.put('"');
+            put_str(sink, f.choices[i]);
+            sink.put('"');
+        }
+        sink.put(']');
+    } else {
+        static_assert(!sizeof(T), "unsupported tool argument type");
+    }
+    sink.put('}');
+}
+
+/* Whole argument schema, in the compact layout of mcp_tool_schemas.c */
+template <typename Tool, typename Sink>
+constexpr void write_schema(Sink& sink)
+{
+    put_str(sink, "{\"type\":\"object\",\"properties\":{");
+    bool first = true;
+    std::apply([&](const auto&... f) {
+        ((first ? (void)(first = false) : sink.put(','), write_property(sink, f)), ...);
+    }, Tool::fields);
+    sink.put('}');
+    
+    bool any_required = std::apply([](const auto&... f) { return (f.required || ...); }, Tool::fields);
+    if (any_required) {
+        put_str(sink, ",\"required\":[");
+        first = true;
+        std::apply([&](const auto&... f) {
+            ((f.required ? ((first ? (void)(first = false) : sink.put(',')),
+                            sink.put('"'), put_str(sink, f.name), sink.put('"'))
+                         : (void)0), ...);
+        }, Tool::fields);
+        sink.put(']');
+    }
+    sink.put('}');
+}
+
+template <typename Tool>
+struct schema_of {
+    static constexpr size_t length = [] {
+        length_sink sink;
+        write_schema<Tool>(sink);
+        return sink.size;
+    }();
+    
+    /* Zero-filled past the end, so the text is NUL-terminated */
+    static constexpr std::array<char, length + 1> text = [] {
+        buffer_sink<length + 1> sink;
+        write_schema<Tool>(sink);
+        return sink.data;
+    }();
+};
+
+/* ---- Argument decoding ---- */
+
+inline bool decode_value(const mcp_json_doc_t* doc, int tok, bool& value)
+{
+    return mcp_json_get_bool(doc, tok, &value) == ESP_OK;
+}
+
+inline bool decode_value(const mcp_json_doc_t* doc, int tok, int32_t& value)
+{
+    return mcp_json_get_int(doc, tok, &value) == ESP_OK;
+}
+
+inline bool decode_value(const mcp_json_doc_t* doc, int tok, uint32_t& value)
+{
+    return mcp_json_get_u32(doc, tok, &value) == ESP_OK;
+}
+
+template <size_t N>
+bool decode_value(const mcp_json_doc_t* doc, int tok, text<N>& value)
+{
+    return mcp_json_get_string(doc, tok, value.value, N) == ESP_OK;
+}
+
+/* Decode one field; false if it is required and missing, or malformed */
+template <typename Args, typename T>
+bool decode_field(const mcp_json_doc_t* doc, int args, const field<Args, T>& f, Args& out)
+{
+    int tok = mcp_json_find(doc, args, f.name);
+    if (tok < 0) {
+        return !f.required;
+    }
+    
+    if constexpr (std::is_enum<T>::value) {
+        for (size_t i = 0; i < f.choice_count; i++) {
+            if (mcp_json_eq(doc, tok, f.choices[i])) {
+                out.*f.member = static_cast<T>(i);
+                return true;
+            }
+        }
+        return false;
+    } else {
+        return decode_value(doc, tok, out.*f.member);
+    }
+}
+
+/* mcp_tool_def_t::execute of a tool: decode the arguments, then run it */
+template <typename Tool>
+esp_err_t execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out)
+{
+    if (!doc || !out) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    typename Tool::args_t decoded{};
+    const char* invalid = nullptr;
+    std::apply([&](const auto&... f) {
+        (void)((decode_field(doc, args, f, decoded) || ((invalid = f.name), false)) && ...);
+    }, Tool::fields);
+    
+    if (invalid) {
+        char message[64];
+        snprintf(message, sizeof(message), "Missing or invalid %s parameter", invalid);
+        return error_result(out, message);
+    }
+    return Tool::run(decoded, out);
+}
+
+/* ---- Tool table ---- */
+
+template <typename Tool, typename = void>
+struct cache_ttl {
+    static constexpr uint32_t value = 0;
+};
+
+template <typename Tool>
+struct cache_ttl<Tool, std::void_t<decltype(Tool::cache_ttl_ms)>> {
+    static constexpr uint32_t value = Tool::cache_ttl_ms;
+};
+
+constexpr int compare_names(const char* a, const char* b)
+{
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return static_cast<unsigned char>(*a) - static_cast<unsigned char>(*b);
+}
+
+/* Compare a NUL-terminated name with a length-delimited one */
+inline int compare_names(const char* a, const char* b, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (a[i] != b[i] || !a[i]) {
+            return static_cast<unsigned char>(a[i]) - static_cast<unsigned char>(b[i]);
+        }
+    }
+    return a[len] ? 1 : 0;
+}
+
+template <typename Tool>
+constexpr mcp_tool_def_t definition()
+{
+    mcp_tool_def_t def{};
+    def.name = Tool::name;
+    def.description = Tool::description;
+    def.type = MCP_TOOL_CUSTOM;
+    def.input_schema = schema_of<Tool>::text.data();
+    def.execute = &execute<Tool>;
+    def.cache_ttl_ms = cache_ttl<Tool>::value;
+    def.is_cacheable = nullptr;
+    return def;
+}
+
+template <size_t N>
+constexpr std::array<mcp_tool_def_t, N> sorted(std::array<mcp_tool_def_t, N> defs)
+{
+    for (size_t i = 1; i < N; i++) {
+        for (size_t j = i; j > 0 && compare_names(defs[j - 1].name, defs[j].name) > 0; j--) {
+            mcp_tool_def_t tmp = defs[j];
+            defs[j] = defs[j - 1];
+            defs[j - 1] = tmp;
+        }
+    }
+    return defs;
+}
+
+template <size_t N>
+constexpr bool unique_names(const std::array<mcp_tool_def_t, N>& defs)
+{
+    for (size_t i = 1; i < N; i++) {
+        if (compare_names(defs[i - 1].name, defs[i].name) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+/**
+ * @brief Constant table of tool definitions, sorted by name
+ *
+ * Built entirely at compile time; nothing is constructed at startup.
+ */
+template <typename... Tools>
+struct tool_table {
+    static constexpr size_t size = sizeof...(Tools);
+    
+    static constexpr std::array<mcp_tool_def_t, size> tools =
+        detail::sorted(std::array<mcp_tool_def_t, size>{{detail::definition<Tools>()...}});
+    
+    static_assert(size > 0, "a tool table needs at least one tool");
+    static_assert(detail::unique_names(tools), "two tools have the same name");
+    
+    /**
+     * @brief Find a tool by name with a binary search over the table
+     *
+     * @param name Tool name (not NUL-terminated)
+     * @param len Name length
+     * @return Tool definition, or nullptr if the table has no such tool
+     */
+    static const mcp_tool_def_t* find(const char* name, size_t len)
+    {
+        size_t lo = 0;
+        size_t hi = size;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            int cmp = detail::compare_names(tools[mid].name, name, len);
+            if (cmp == 0) {
+                return &tools[mid];
+            }
+            if (cmp < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return nullptr;
+    }
+    
+    /**
+     * @brief Register every tool of the table with a server
+     *
+     * @param server Server handle
+     * @return ESP_OK on success, or the first registration error
+     */
+    static esp_err_t register_all(mcp_server_handle_t server)
+    {
+        for (const mcp_tool_def_t& def : tools) {
+            esp_err_t ret = mcp_server_register_tool(server, &def);
+            if (ret != ESP_OK) {
+                return ret;
+            }
+        }
+        return ESP_OK;
+    }
+};
+
+} // namespace mcp
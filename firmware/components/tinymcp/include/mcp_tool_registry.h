@@ -0,0 +1,165 @@
+/**
+ * @file mcp_tool_registry.h
+ * @brief Read-mostly tool registry with RCU-style snapshots
+ *
+ * The registry publishes an immutable table of tool definitions, together
+ * with its name index and the serialized tools/list result. Request handlers
+ * read the current table without taking any lock: they load the table
+ * pointer and take a reference on the table, which they drop when done.
+ * Writers build a complete replacement table, swap it in with one atomic
+ * store and drop the registry's reference on the old one; whoever drops the
+ * last reference frees it. A writer never waits for readers to finish, so
+ * a tool may register others while it runs.
+ *
+ * Only the few instructions between loading the pointer and taking the
+ * reference are guarded, by a reader counter a writer waits to drain before
+ * dropping the old table. There are two such counters and each writer
+ * switches new readers to the other one, so a steady stream of readers
+ * cannot hold a writer up.
+ *
+ * A tool call does not keep the table while the tool runs: it copies the
+ * definition and pins the tool (mcp_tool_registry_pin), whose metrics live
+ * as long as a table or a call still uses them.
+ *
+ * Features:
+ * - Lock-free lookups on the request path
+ * - Growable: each table is sized to the tools it holds
+ * - Runtime registration and removal of tools
+ * - Per-tool latency metrics that survive table swaps
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "mcp_server_simple.h"
+#include "mcp_dispatch.h"
+#include "mcp_metrics.h"
+
+/* Per-tool state shared by every table holding the tool */
+typedef struct {
+    atomic_uint refs;               /* Tables holding the tool, plus calls pinning it */
+    mcp_metrics_t latency;
+} mcp_tool_metrics_t;
+
+/* Registered tool */
+typedef struct {
+    mcp_tool_def_t def;
+    mcp_tool_metrics_t* metrics;
+} mcp_tool_entry_t;
+
+/* Immutable snapshot of the registered tools */
+typedef struct {
+    atomic_uint refs;               /* The registry's reference plus one per reader */
+    uint32_t count;
+    mcp_dispatch_table_t index;     /* Tool name -> entry in tools[] */
+    char* tools_list;               /* Serialized tools/list result */
+    size_t tools_list_len;
+    char* tools_list_cbor;          /* The same result for CBOR sessions */
+    size_t tools_list_cbor_len;
+    mcp_tool_entry_t tools[];
+} mcp_tool_table_t;
+
+/* Tool Registry */
+typedef struct {
+    mcp_tool_table_t* _Atomic table;
+    atomic_uint pinning[2];         /* Readers between loading the table and referencing it */
+    atomic_uint phase;              /* Which pinning counter new readers use */
+    SemaphoreHandle_t write_lock;   /* Serializes writers */
+} mcp_tool_registry_t;
+
+/**
+ * @brief Create a registry holding an initial set of tools
+ *
+ * @param registry Registry to initialize
+ * @param tools Initial tool definitions (copied; strings are not)
+ * @param count Number of tools
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE on duplicate names,
+ *         ESP_ERR_NO_MEM otherwise
+ */
+esp_err_t mcp_tool_registry_init(mcp_tool_registry_t* registry,
+                                 const mcp_tool_def_t* tools, uint32_t count);
+
+/**
+ * @brief Free a registry (no readers may be active)
+ *
+ * @param registry Registry to release
+ */
+void mcp_tool_registry_deinit(mcp_tool_registry_t* registry);
+
+/**
+ * @brief Publish a table with one tool added
+ *
+ * @param registry Registry
+ * @param tool Tool definition (copied; strings must stay valid)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the name is taken
+ */
+esp_err_t mcp_tool_registry_add(mcp_tool_registry_t* registry, const mcp_tool_def_t* tool);
+
+/**
+ * @brief Publish a table with one tool removed
+ *
+ * Returns once no request can still be executing the removed tool, so it
+ * must not be called from that tool.
+ *
+ * @param registry Registry
+ * @param name Tool name
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no such tool exists
+ */
+esp_err_t mcp_tool_registry_remove(mcp_tool_registry_t* registry, const char* name);
+
+/**
+ * @brief Take a reference on the current table
+ *
+ * The table stays valid until mcp_tool_registry_release is called.
+ *
+ * @param registry Registry
+ * @return Current table
+ */
+const mcp_tool_table_t* mcp_tool_registry_acquire(mcp_tool_registry_t* registry);
+
+/**
+ * @brief Drop a reference taken by mcp_tool_registry_acquire
+ *
+ * @param registry Registry
+ * @param table Table returned by mcp_tool_registry_acquire
+ */
+void mcp_tool_registry_release(mcp_tool_registry_t* registry, const mcp_tool_table_t* table);
+
+/**
+ * @brief Keep a tool's metrics after releasing the table it was found in
+ *
+ * Call while holding the table. Removing the tool waits until every pin
+ * is dropped, so a copy of the definition stays usable meanwhile.
+ *
+ * @param entry Tool found in an acquired table
+ * @return The tool's metrics, to pass to mcp_tool_registry_unpin
+ */
+mcp_tool_metrics_t* mcp_tool_registry_pin(const mcp_tool_entry_t* entry);
+
+/**
+ * @brief Drop a pin taken by mcp_tool_registry_pin
+ *
+ * @param metrics Metrics returned by mcp_tool_registry_pin
+ */
+void mcp_tool_registry_unpin(mcp_tool_metrics_t* metrics);
+
+/**
+ * @brief Clear the metrics of every registered tool
+ *
+ * @param registry Registry
+ */
+void mcp_tool_registry_reset_metrics(mcp_tool_registry_t* registry);
+
+#ifdef __cplusplus
+}
+#endif
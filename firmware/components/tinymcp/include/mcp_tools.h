@@ -20,7 +20,10 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "esp_err.h"
+#include "mcp_json.h"
+#include "mcp_json_writer.h"
 
 /* Tool Name Definitions */
 #define MCP_TOOL_DISPLAY_NAME           "display_control"
@@ -34,6 +37,12 @@ extern "C" {
 #define MCP_TOOL_SYSTEM_DESCRIPTION     "Get system information and statistics"
 #define MCP_TOOL_STATUS_DESCRIPTION     "Get device health and operational status"
 
+/* Parameter Limits */
+#define MCP_DISPLAY_TEXT_MAX            128     /* Including the NUL terminator */
+#define MCP_DISPLAY_WIDTH               320
+#define MCP_DISPLAY_HEIGHT              172
+#define MCP_DISPLAY_BRIGHTNESS_MAX      100
+
 /* Display Tool Actions */
 typedef enum {
     MCP_DISPLAY_ACTION_SHOW_TEXT = 0,
@@ -104,7 +113,7 @@ typedef enum {
 /* Display Tool Parameters */
 typedef struct {
     mcp_display_action_t action;
-    const char* text;
+    char text[MCP_DISPLAY_TEXT_MAX];
     int x;
     int y;
     int width;
@@ -181,50 +190,71 @@ typedef struct {
 } mcp_status_result_t;
 
 /* Tool Schema JSON Strings */
+extern const char* MCP_TOOL_ECHO_SCHEMA;
 extern const char* MCP_TOOL_DISPLAY_SCHEMA;
 extern const char* MCP_TOOL_GPIO_SCHEMA;
 extern const char* MCP_TOOL_SYSTEM_SCHEMA;
 extern const char* MCP_TOOL_STATUS_SCHEMA;
 
 /**
- * @brief Parse display tool parameters from JSON
+ * @brief Decode display tool arguments into their parameter structure
  * 
- * @param params_json JSON parameters string
- * @param params Parsed parameters structure
- * @return ESP_OK on success, error code otherwise
+ * Arguments are read straight from the tokenized request; absent optional
+ * arguments take their defaults.
+ * 
+ * @param doc Tokenized request the arguments belong to
+ * @param args Index of the arguments object token, or -1 if absent
+ * @param params Parameters to fill
+ * @param invalid_param Set to the name of the offending argument on failure (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if an argument is missing or malformed
  */
-esp_err_t mcp_tool_display_parse_params(const char* params_json, 
-                                        mcp_display_params_t* params);
+esp_err_t mcp_tool_display_parse_params(const mcp_json_doc_t* doc, int args,
+                                        mcp_display_params_t* params, const char** invalid_param);
 
 /**
- * @brief Parse GPIO tool parameters from JSON
+ * @brief Decode GPIO tool arguments into their parameter structure
  * 
- * @param params_json JSON parameters string
- * @param params Parsed parameters structure
- * @return ESP_OK on success, error code otherwise
+ * Arguments are read straight from the tokenized request; absent optional
+ * arguments take their defaults.
+ * 
+ * @param doc Tokenized request the arguments belong to
+ * @param args Index of the arguments object token, or -1 if absent
+ * @param params Parameters to fill
+ * @param invalid_param Set to the name of the offending argument on failure (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if an argument is missing or malformed
  */
-esp_err_t mcp_tool_gpio_parse_params(const char* params_json, 
-                                     mcp_gpio_params_t* params);
+esp_err_t mcp_tool_gpio_parse_params(const mcp_json_doc_t* doc, int args,
+                                     mcp_gpio_params_t* params, const char** invalid_param);
 
 /**
- * @brief Parse system tool parameters from JSON
+ * @brief Decode system tool arguments into their parameter structure
  * 
- * @param params_json JSON parameters string
- * @param params Parsed parameters structure
- * @return ESP_OK on success, error code otherwise
+ * Arguments are read straight from the tokenized request; absent optional
+ * arguments take their defaults.
+ * 
+ * @param doc Tokenized request the arguments belong to
+ * @param args Index of the arguments object token, or -1 if absent
+ * @param params Parameters to fill
+ * @param invalid_param Set to the name of the offending argument on failure (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if an argument is missing or malformed
  */
-esp_err_t mcp_tool_system_parse_params(const char* params_json, 
-                                       mcp_system_params_t* params);
+esp_err_t mcp_tool_system_parse_params(const mcp_json_doc_t* doc, int args,
+                                       mcp_system_params_t* params, const char** invalid_param);
 
 /**
- * @brief Parse status tool parameters from JSON
+ * @brief Decode status tool arguments into their parameter structure
  * 
- * @param params_json JSON parameters string
- * @param params Parsed parameters structure
- * @return ESP_OK on success, error code otherwise
+ * Arguments are read straight from the tokenized request; absent optional
+ * arguments take their defaults.
+ * 
+ * @param doc Tokenized request the arguments belong to
+ * @param args Index of the arguments object token, or -1 if absent
+ * @param params Parameters to fill
+ * @param invalid_param Set to the name of the offending argument on failure (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if an argument is missing or malformed
  */
-esp_err_t mcp_tool_status_parse_params(const char* params_json, 
-                                       mcp_status_params_t* params);
+esp_err_t mcp_tool_status_parse_params(const mcp_json_doc_t* doc, int args,
+                                       mcp_status_params_t* params, const char** invalid_param);
 
 /**
  * @brief Format display tool result to JSON
@@ -278,33 +308,99 @@ esp_err_t mcp_tool_status_format_result(const mcp_status_result_t* result,
  * @brief Validate display tool parameters
  * 
  * @param params Parameters to validate
- * @return ESP_OK if valid, error code otherwise
+ * @param invalid_param Set to the name of the offending parameter on failure (may be NULL)
+ * @return ESP_OK if valid, ESP_ERR_INVALID_ARG for out-of-range values,
+ *         ESP_ERR_NOT_SUPPORTED for actions this firmware does not implement
  */
-esp_err_t mcp_tool_display_validate_params(const mcp_display_params_t* params);
+esp_err_t mcp_tool_display_validate_params(const mcp_display_params_t* params, const char** invalid_param);
 
 /**
  * @brief Validate GPIO tool parameters
  * 
  * @param params Parameters to validate
- * @return ESP_OK if valid, error code otherwise
+ * @param invalid_param Set to the name of the offending parameter on failure (may be NULL)
+ * @return ESP_OK if valid, ESP_ERR_INVALID_ARG for out-of-range values,
+ *         ESP_ERR_NOT_SUPPORTED for actions this firmware does not implement
  */
-esp_err_t mcp_tool_gpio_validate_params(const mcp_gpio_params_t* params);
+esp_err_t mcp_tool_gpio_validate_params(const mcp_gpio_params_t* params, const char** invalid_param);
 
 /**
  * @brief Validate system tool parameters
  * 
  * @param params Parameters to validate
- * @return ESP_OK if valid, error code otherwise
+ * @param invalid_param Set to the name of the offending parameter on failure (may be NULL)
+ * @return ESP_OK if valid, ESP_ERR_INVALID_ARG for out-of-range values,
+ *         ESP_ERR_NOT_SUPPORTED for actions this firmware does not implement
  */
-esp_err_t mcp_tool_system_validate_params(const mcp_system_params_t* params);
+esp_err_t mcp_tool_system_validate_params(const mcp_system_params_t* params, const char** invalid_param);
 
 /**
  * @brief Validate status tool parameters
  * 
  * @param params Parameters to validate
- * @return ESP_OK if valid, error code otherwise
+ * @param invalid_param Set to the name of the offending parameter on failure (may be NULL)
+ * @return ESP_OK if valid, ESP_ERR_INVALID_ARG for out-of-range values,
+ *         ESP_ERR_NOT_SUPPORTED for actions this firmware does not implement
+ */
+esp_err_t mcp_tool_status_validate_params(const mcp_status_params_t* params, const char** invalid_param);
+
+/**
+ * @brief Get the argument name of a display action
+ * 
+ * @param action Action
+ * @return Name as used in the tool arguments, "unknown" if out of range
+ */
+const char* mcp_tool_display_action_name(mcp_display_action_t action);
+
+/**
+ * @brief Get the argument name of a GPIO action
+ * 
+ * @param action Action
+ * @return Name as used in the tool arguments, "unknown" if out of range
+ */
+const char* mcp_tool_gpio_action_name(mcp_gpio_action_t action);
+
+/**
+ * @brief Get the argument name of a system action
+ * 
+ * @param action Action
+ * @return Name as used in the tool arguments, "unknown" if out of range
+ */
+const char* mcp_tool_system_action_name(mcp_system_action_t action);
+
+/**
+ * @brief Display tool entry point for decoded, validated parameters
+ * 
+ * @param params Parameters
+ * @param out Writer to append the result value to
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t mcp_tool_display_run(const mcp_display_params_t* params, mcp_json_writer_t* out);
+
+/**
+ * @brief GPIO tool entry point for decoded, validated parameters
+ * 
+ * @param params Parameters
+ * @param out Writer to append the result value to
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t mcp_tool_gpio_run(const mcp_gpio_params_t* params, mcp_json_writer_t* out);
+
+/**
+ * @brief System tool entry point for decoded, validated parameters
+ * 
+ * @param params Parameters
+ * @param out Writer to append the result value to
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t mcp_tool_system_run(const mcp_system_params_t* params, mcp_json_writer_t* out);
+
+/**
+ * @brief Get echo tool schema as JSON string
+ * 
+ * @return JSON schema string
  */
-esp_err_t mcp_tool_status_validate_params(const mcp_status_params_t* params);
+const char* mcp_tool_echo_get_schema(void);
 
 /**
  * @brief Get display tool schema as JSON string
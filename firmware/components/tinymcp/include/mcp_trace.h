@@ -0,0 +1,130 @@
+/**
+ * @file mcp_trace.h
+ * @brief Request lifecycle trace ring for the MCP server and transports
+ *
+ * Trace points along a request's path (accept, recv, submit, parse,
+ * dispatch, tool execution, serialization, send) append fixed-size records
+ * to a global ring. Emitting a record claims a slot with one atomic
+ * increment and fills it in place, so any task can emit without locks and
+ * the cost is a timer read plus a handful of stores. Each slot carries a
+ * sequence stamp that readers use to skip records that were overwritten or
+ * are still being written.
+ *
+ * The debug/trace_dump method pages the ring out as base64-encoded wire
+ * records; mcp_trace_to_chrome.py at the repository root turns a dump into
+ * Chrome trace / Perfetto JSON.
+ *
+ * Features:
+ * - Lock-free, allocation-free emission from any task
+ * - 16-byte little-endian wire records tagged with client and request id
+ * - Compiled out entirely with MCP_TRACE_ENABLED=0
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+
+/* Trace Configuration */
+#ifndef MCP_TRACE_ENABLED
+#define MCP_TRACE_ENABLED           1
+#endif
+#ifndef MCP_TRACE_CAPACITY
+#define MCP_TRACE_CAPACITY          256     /* Records, power of two */
+#endif
+#define MCP_TRACE_FORMAT_VERSION    1
+
+/* Trace events; begin/end pairs bracket a span, the others are instants */
+typedef enum {
+    MCP_TRACE_ACCEPT = 1,           /* Connection accepted (arg: client slot) */
+    MCP_TRACE_CLOSE,                /* Connection closed */
+    MCP_TRACE_RECV,                 /* Data received (arg: bytes) */
+    MCP_TRACE_SUBMIT,               /* Request queued (arg: queue depth) */
+    MCP_TRACE_PARSE_BEGIN,          /* Tokenizing a message (arg: bytes) */
+    MCP_TRACE_PARSE_END,            /* (arg: tokens, 0 on error) */
+    MCP_TRACE_DISPATCH_BEGIN,       /* Method handler (arg: method name hash) */
+    MCP_TRACE_DISPATCH_END,         /* (arg: response bytes so far) */
+    MCP_TRACE_TOOL_BEGIN,           /* Tool execute (arg: tool name hash) */
+    MCP_TRACE_TOOL_END,             /* (arg: esp_err_t) */
+    MCP_TRACE_SERIALIZE_BEGIN,      /* Closing the response envelope */
+    MCP_TRACE_SERIALIZE_END,        /* (arg: response bytes) */
+    MCP_TRACE_SEND_BEGIN,           /* Writing a response (arg: bytes) */
+    MCP_TRACE_SEND_END,             /* (arg: esp_err_t) */
+    MCP_TRACE_SHED,                 /* Request refused by admission control (arg: retry-after ms) */
+} mcp_trace_event_t;
+
+/* Trace record as stored in the ring and sent on the wire */
+typedef struct {
+    uint32_t timestamp_us;          /* Low 32 bits of esp_timer_get_time() */
+    uint32_t request_id;            /* Server message id, 0 if none yet */
+    uint32_t arg;                   /* Event specific */
+    uint16_t client_id;             /* Low 16 bits of the client id */
+    uint8_t event;                  /* mcp_trace_event_t */
+    uint8_t reserved;
+} mcp_trace_record_t;
+
+#if MCP_TRACE_ENABLED
+
+/**
+ * @brief Append a record to the trace ring
+ *
+ * @param event Event type
+ * @param client_id Client the event belongs to (0 if none)
+ * @param request_id Request the event belongs to (0 if none)
+ * @param arg Event specific argument
+ */
+void mcp_trace_emit(mcp_trace_event_t event, uint32_t client_id, uint32_t request_id, uint32_t arg);
+
+/**
+ * @brief Get the sequence number the next record will be written at
+ *
+ * @return Total number of records emitted so far
+ */
+uint32_t mcp_trace_head(void);
+
+/**
+ * @brief Copy records out of the ring
+ *
+ * Starts at sequence number 'cursor', or at the oldest record still in the
+ * ring if 'cursor' has already been overwritten, and stops at the newest
+ * completed record or after 'max' records.
+ *
+ * @param cursor First sequence number wanted
+ * @param out Output records
+ * @param max Capacity of 'out'
+ * @param next Receives the cursor to continue from
+ * @return Number of records copied
+ */
+uint32_t mcp_trace_read(uint32_t cursor, mcp_trace_record_t* out, uint32_t max, uint32_t* next);
+
+#else
+
+static inline void mcp_trace_emit(mcp_trace_event_t event, uint32_t client_id,
+                                  uint32_t request_id, uint32_t arg)
+{
+}
+
+static inline uint32_t mcp_trace_head(void)
+{
+    return 0;
+}
+
+static inline uint32_t mcp_trace_read(uint32_t cursor, mcp_trace_record_t* out,
+                                      uint32_t max, uint32_t* next)
+{
+    *next = cursor;
+    return 0;
+}
+
+#endif /* MCP_TRACE_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
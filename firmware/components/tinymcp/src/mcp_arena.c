@@ -0,0 +1,202 @@
+/**
+ * @file mcp_arena.c
+ * @brief Per-request bump-pointer arena allocator implementation
+ */
+
+#include "mcp_arena.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cJSON.h"
+
+static const char *TAG = "MCP_ARENA";
+
+/* Pools whose memory must not be passed to free() */
+#define MCP_ARENA_MAX_POOLS         2
+static mcp_arena_pool_t* s_pools[MCP_ARENA_MAX_POOLS];
+
+static inline size_t align_up(size_t size)
+{
+    return (size + (MCP_ARENA_ALIGN - 1)) & ~(size_t)(MCP_ARENA_ALIGN - 1);
+}
+
+/* Create a pool of equally sized arenas */
+esp_err_t mcp_arena_pool_init(mcp_arena_pool_t* pool, size_t arena_size, uint32_t arena_count)
+{
+    if (!pool || arena_count == 0 || arena_count > MCP_ARENA_POOL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(pool, 0, sizeof(*pool));
+    arena_size = align_up(arena_size);
+    
+    pool->block = heap_caps_malloc(arena_size * arena_count, MALLOC_CAP_8BIT);
+    if (!pool->block) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for %"PRIu32" arenas",
+                 (unsigned)(arena_size * arena_count), arena_count);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    pool->arena_size = arena_size;
+    pool->arena_count = arena_count;
+    atomic_init(&pool->busy_mask, 0);
+    
+    for (uint32_t i = 0; i < arena_count; i++) {
+        pool->arenas[i].base = pool->block + i * arena_size;
+        pool->arenas[i].size = arena_size;
+    }
+    
+    for (int i = 0; i < MCP_ARENA_MAX_POOLS; i++) {
+        if (!s_pools[i]) {
+            s_pools[i] = pool;
+            break;
+        }
+    }
+    
+    ESP_LOGI(TAG, "Arena pool ready: %"PRIu32" x %u bytes", arena_count, (unsigned)arena_size);
+    return ESP_OK;
+}
+
+/* Free the memory backing a pool */
+void mcp_arena_pool_deinit(mcp_arena_pool_t* pool)
+{
+    if (!pool) {
+        return;
+    }
+    
+    for (int i = 0; i < MCP_ARENA_MAX_POOLS; i++) {
+        if (s_pools[i] == pool) {
+            s_pools[i] = NULL;
+        }
+    }
+    
+    free(pool->block);
+    pool->block = NULL;
+    pool->arena_count = 0;
+}
+
+/* Acquire a free arena from the pool */
+mcp_arena_t* mcp_arena_pool_acquire(mcp_arena_pool_t* pool)
+{
+    unsigned int busy = atomic_load(&pool->busy_mask);
+    
+    for (;;) {
+        unsigned int free_bits = ~busy & ((pool->arena_count >= 32) ? ~0u : ((1u << pool->arena_count) - 1));
+        if (!free_bits) {
+            return NULL;
+        }
+        unsigned int bit = free_bits & (~free_bits + 1);
+        if (atomic_compare_exchange_weak(&pool->busy_mask, &busy, busy | bit)) {
+            return &pool->arenas[__builtin_ctz(bit)];
+        }
+    }
+}
+
+/* Reset an arena and return it to the pool */
+void mcp_arena_pool_release(mcp_arena_pool_t* pool, mcp_arena_t* arena)
+{
+    if (!arena) {
+        return;
+    }
+    
+    if (arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+    }
+    arena->used = 0;
+    arena->reset_count++;
+    
+    unsigned int bit = 1u << (uint32_t)(arena - pool->arenas);
+    atomic_fetch_and(&pool->busy_mask, ~bit);
+}
+
+/* Get statistics for one arena of a pool */
+esp_err_t mcp_arena_pool_get_stats(const mcp_arena_pool_t* pool, uint32_t index,
+                                   mcp_arena_stats_t* stats)
+{
+    if (!pool || !stats || index >= pool->arena_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    const mcp_arena_t* arena = &pool->arenas[index];
+    stats->size = arena->size;
+    stats->high_water = arena->high_water;
+    stats->fallback_count = arena->fallback_count;
+    stats->reset_count = arena->reset_count;
+    return ESP_OK;
+}
+
+/* Allocate from an arena without falling back to the heap */
+void* mcp_arena_alloc(mcp_arena_t* arena, size_t size)
+{
+    size = align_up(size ? size : 1);
+    if (size > arena->size - arena->used) {
+        return NULL;
+    }
+    
+    void* ptr = arena->base + arena->used;
+    arena->used += size;
+    return ptr;
+}
+
+/* Check whether a pointer was handed out by any registered arena pool */
+bool mcp_arena_owns(const void* ptr)
+{
+    const uint8_t* p = (const uint8_t*)ptr;
+    
+    for (int i = 0; i < MCP_ARENA_MAX_POOLS; i++) {
+        const mcp_arena_pool_t* pool = s_pools[i];
+        if (pool && p >= pool->block && p < pool->block + pool->arena_size * pool->arena_count) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Bind an arena to the calling task */
+void mcp_arena_bind(mcp_arena_t* arena)
+{
+    vTaskSetThreadLocalStoragePointer(NULL, MCP_ARENA_TLS_INDEX, arena);
+}
+
+/* Get the arena bound to the calling task */
+mcp_arena_t* mcp_arena_current(void)
+{
+    return (mcp_arena_t*)pvTaskGetThreadLocalStoragePointer(NULL, MCP_ARENA_TLS_INDEX);
+}
+
+/* Allocate request-scoped memory */
+void* mcp_arena_malloc(size_t size)
+{
+    mcp_arena_t* arena = mcp_arena_current();
+    if (arena) {
+        void* ptr = mcp_arena_alloc(arena, size);
+        if (ptr) {
+            return ptr;
+        }
+        arena->fallback_count++;
+    }
+    return malloc(size);
+}
+
+/* Free memory returned by mcp_arena_malloc */
+void mcp_arena_free(void* ptr)
+{
+    if (ptr && !mcp_arena_owns(ptr)) {
+        free(ptr);
+    }
+}
+
+/* Route cJSON allocations through the bound arena */
+void mcp_arena_install_cjson_hooks(void)
+{
+    cJSON_Hooks hooks = {
+        .malloc_fn = mcp_arena_malloc,
+        .free_fn = mcp_arena_free,
+    };
+    cJSON_InitHooks(&hooks);
+}
@@ -0,0 +1,344 @@
+/**
+ * @file mcp_cbor.c
+ * @brief CBOR framing and CBOR-to-JSON conversion
+ */
+
+#include "mcp_cbor.h"
+
+#include <string.h>
+#include <math.h>
+
+/* Major types (RFC 8949 section 3.1) */
+enum {
+    CBOR_UINT = 0,
+    CBOR_NEGINT,
+    CBOR_BYTES,
+    CBOR_TEXT,
+    CBOR_ARRAY,
+    CBOR_MAP,
+    CBOR_TAG,
+    CBOR_SIMPLE,
+};
+
+#define CBOR_INDEFINITE     31
+#define CBOR_BREAK          0xFF
+
+/* Outcome of reading an item */
+typedef enum {
+    READ_OK = 0,
+    READ_SHORT,                     /* Input ends inside the item */
+    READ_MALFORMED,
+    READ_DEPTH,
+    READ_UNSUPPORTED,
+} read_result_t;
+
+typedef struct {
+    const uint8_t* p;
+    const uint8_t* end;
+} cbor_reader_t;
+
+typedef struct {
+    uint8_t major;
+    uint8_t info;                   /* Additional information (low 5 bits) */
+    uint64_t value;                 /* Argument: length, count, integer or float bits */
+} cbor_head_t;
+
+/* Read an initial byte and its argument */
+static read_result_t read_head(cbor_reader_t* r, cbor_head_t* head)
+{
+    if (r->p >= r->end) {
+        return READ_SHORT;
+    }
+    
+    uint8_t initial = *r->p++;
+    head->major = initial >> 5;
+    head->info = initial & 0x1F;
+    head->value = head->info;
+    
+    if (head->info < 24) {
+        return READ_OK;
+    }
+    if (head->info == CBOR_INDEFINITE) {
+        /* Only strings, containers and the break code have an indefinite form */
+        bool allowed = (head->major >= CBOR_BYTES && head->major <= CBOR_MAP) ||
+                       head->major == CBOR_SIMPLE;
+        return allowed ? READ_OK : READ_MALFORMED;
+    }
+    if (head->info > 27) {
+        return READ_MALFORMED;
+    }
+    
+    size_t n = (size_t)1 << (head->info - 24);
+    if ((size_t)(r->end - r->p) < n) {
+        return READ_SHORT;
+    }
+    head->value = 0;
+    for (size_t i = 0; i < n; i++) {
+        head->value = (head->value << 8) | *r->p++;
+    }
+    return READ_OK;
+}
+
+static inline bool at_break(const cbor_reader_t* r)
+{
+    return r->p < r->end && *r->p == CBOR_BREAK;
+}
+
+/* Skip one complete item */
+static read_result_t skip_item(cbor_reader_t* r, int depth)
+{
+    if (depth > MCP_CBOR_MAX_DEPTH) {
+        return READ_DEPTH;
+    }
+    
+    cbor_head_t head;
+    read_result_t ret = read_head(r, &head);
+    if (ret != READ_OK) {
+        return ret;
+    }
+    
+    switch (head.major) {
+        case CBOR_UINT:
+        case CBOR_NEGINT:
+            return READ_OK;
+        
+        case CBOR_BYTES:
+        case CBOR_TEXT:
+            if (head.info == CBOR_INDEFINITE) {
+                /* Chunks are definite strings of the same type */
+                while (!at_break(r)) {
+                    if (r->p < r->end && (*r->p >> 5) != head.major) {
+                        return READ_MALFORMED;
+                    }
+                    ret = skip_item(r, depth + 1);
+                    if (ret != READ_OK) {
+                        return ret;
+                    }
+                }
+                if (r->p >= r->end) {
+                    return READ_SHORT;
+                }
+                r->p++;
+                return READ_OK;
+            }
+            if ((uint64_t)(r->end - r->p) < head.value) {
+                return READ_SHORT;
+            }
+            r->p += head.value;
+            return READ_OK;
+        
+        case CBOR_ARRAY:
+        case CBOR_MAP: {
+            uint64_t per_entry = (head.major == CBOR_MAP) ? 2 : 1;
+            if (head.info == CBOR_INDEFINITE) {
+                for (;;) {
+                    if (r->p >= r->end) {
+                        return READ_SHORT;
+                    }
+                    if (at_break(r)) {
+                        r->p++;
+                        return READ_OK;
+                    }
+                    for (uint64_t i = 0; i < per_entry; i++) {
+                        ret = skip_item(r, depth + 1);
+                        if (ret != READ_OK) {
+                            return ret;
+                        }
+                    }
+                }
+            }
+            for (uint64_t i = 0; i < head.value * per_entry; i++) {
+                ret = skip_item(r, depth + 1);
+                if (ret != READ_OK) {
+                    return ret;
+                }
+            }
+            return READ_OK;
+        }
+        
+        case CBOR_TAG:
+            return skip_item(r, depth + 1);
+        
+        default:
+            /* A break outside an indefinite-length item is malformed */
+            return head.info == CBOR_INDEFINITE ? READ_MALFORMED : READ_OK;
+    }
+}
+
+/* Measure the first data item in a buffer */
+int mcp_cbor_item_size(const uint8_t* data, size_t len)
+{
+    cbor_reader_t r = {
+        .p = data,
+        .end = data + len,
+    };
+    
+    switch (skip_item(&r, 0)) {
+        case READ_OK:
+            return (int)(r.p - data);
+        case READ_SHORT:
+            return 0;
+        case READ_DEPTH:
+            return MCP_CBOR_ERR_DEPTH;
+        default:
+            return MCP_CBOR_ERR_MALFORMED;
+    }
+}
+
+/* Decode an IEEE 754 half-precision float (RFC 8949 appendix D) */
+static double half_to_double(uint16_t half)
+{
+    int exponent = (half >> 10) & 0x1F;
+    int mantissa = half & 0x3FF;
+    double value;
+    
+    if (exponent == 0) {
+        value = ldexp(mantissa, -24);
+    } else if (exponent != 31) {
+        value = ldexp(mantissa + 1024, exponent - 25);
+    } else {
+        value = mantissa == 0 ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+/* Convert one item; the input is known to be well-formed and complete */
+static read_result_t convert_item(cbor_reader_t* r, mcp_json_writer_t* w, int depth)
+{
+    if (depth > MCP_CBOR_MAX_DEPTH) {
+        return READ_DEPTH;
+    }
+    
+    cbor_head_t head;
+    read_result_t ret = read_head(r, &head);
+    if (ret != READ_OK) {
+        return ret;
+    }
+    
+    switch (head.major) {
+        case CBOR_UINT:
+            mcp_json_writer_uint(w, head.value);
+            return READ_OK;
+        
+        case CBOR_NEGINT:
+            if (head.value <= (uint64_t)INT64_MAX) {
+                mcp_json_writer_int(w, -1 - (int64_t)head.value);
+            } else {
+                mcp_json_writer_double(w, -1.0 - (double)head.value);
+            }
+            return READ_OK;
+        
+        case CBOR_BYTES:
+        case CBOR_TEXT:
+            if (head.info == CBOR_INDEFINITE) {
+                return READ_UNSUPPORTED;
+            }
+            if ((uint64_t)(r->end - r->p) < head.value) {
+                return READ_SHORT;
+            }
+            if (head.major == CBOR_TEXT) {
+                mcp_json_writer_string_n(w, (const char*)r->p, head.value);
+            } else {
+                mcp_json_writer_base64(w, r->p, head.value);
+            }
+            r->p += head.value;
+            return READ_OK;
+        
+        case CBOR_ARRAY:
+        case CBOR_MAP: {
+            bool is_map = (head.major == CBOR_MAP);
+            bool indefinite = (head.info == CBOR_INDEFINITE);
+            if (is_map) {
+                mcp_json_writer_begin_object(w);
+            } else {
+                mcp_json_writer_begin_array(w);
+            }
+            
+            for (uint64_t i = 0; indefinite || i < head.value; i++) {
+                if (r->p >= r->end) {
+                    return READ_SHORT;
+                }
+                if (indefinite && at_break(r)) {
+                    r->p++;
+                    break;
+                }
+                if (is_map) {
+                    /* JSON object keys are strings */
+                    cbor_head_t key;
+                    ret = read_head(r, &key);
+                    if (ret != READ_OK) {
+                        return ret;
+                    }
+                    if (key.major != CBOR_TEXT || key.info == CBOR_INDEFINITE) {
+                        return READ_UNSUPPORTED;
+                    }
+                    if ((uint64_t)(r->end - r->p) < key.value) {
+                        return READ_SHORT;
+                    }
+                    mcp_json_writer_key_n(w, (const char*)r->p, key.value);
+                    r->p += key.value;
+                }
+                ret = convert_item(r, w, depth + 1);
+                if (ret != READ_OK) {
+                    return ret;
+                }
+            }
+            
+            if (is_map) {
+                mcp_json_writer_end_object(w);
+            } else {
+                mcp_json_writer_end_array(w);
+            }
+            return READ_OK;
+        }
+        
+        case CBOR_TAG:
+            /* Tags add semantics JSON cannot express; keep the tagged value */
+            return convert_item(r, w, depth + 1);
+        
+        default:
+            switch (head.info) {
+                case 20: mcp_json_writer_bool(w, false); return READ_OK;
+                case 21: mcp_json_writer_bool(w, true); return READ_OK;
+                case 25: mcp_json_writer_double(w, half_to_double((uint16_t)head.value)); return READ_OK;
+                case 26: {
+                    uint32_t bits = (uint32_t)head.value;
+                    float value;
+                    memcpy(&value, &bits, sizeof(value));
+                    mcp_json_writer_double(w, value);
+                    return READ_OK;
+                }
+                case 27: {
+                    uint64_t bits = head.value;
+                    double value;
+                    memcpy(&value, &bits, sizeof(value));
+                    mcp_json_writer_double(w, value);
+                    return READ_OK;
+                }
+                case CBOR_INDEFINITE:
+                    return READ_MALFORMED;
+                default:
+                    /* null, undefined and unassigned simple values */
+                    mcp_json_writer_null(w);
+                    return READ_OK;
+            }
+    }
+}
+
+/* Convert one CBOR data item to JSON */
+esp_err_t mcp_cbor_to_json(const uint8_t* data, size_t len, mcp_json_writer_t* out)
+{
+    cbor_reader_t r = {
+        .p = data,
+        .end = data + len,
+    };
+    
+    read_result_t ret = convert_item(&r, out, 0);
+    if (ret == READ_UNSUPPORTED) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (ret != READ_OK || r.p != r.end) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return mcp_json_writer_finish(out);
+}
@@ -0,0 +1,150 @@
+/**
+ * @file mcp_dispatch.c
+ * @brief Hashed name lookup implementation
+ */
+
+#include "mcp_dispatch.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include "esp_heap_caps.h"
+
+#define FNV_OFFSET_BASIS    2166136261u
+#define FNV_PRIME           16777619u
+
+/* Hash a name with 32-bit FNV-1a */
+uint32_t mcp_dispatch_hash(const char* name, size_t len)
+{
+    uint32_t hash = FNV_OFFSET_BASIS;
+    
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/* Create an empty dispatch table */
+esp_err_t mcp_dispatch_init(mcp_dispatch_table_t* table, uint32_t max_entries)
+{
+    if (!table) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    /* Keep the load factor at or below 1/2 so probe chains stay short */
+    uint32_t capacity = 4;
+    while (capacity < max_entries * 2) {
+        capacity <<= 1;
+    }
+    
+    table->entries = heap_caps_calloc(capacity, sizeof(mcp_dispatch_entry_t), MALLOC_CAP_DEFAULT);
+    if (!table->entries) {
+        table->capacity = 0;
+        table->count = 0;
+        return ESP_ERR_NO_MEM;
+    }
+    
+    table->capacity = capacity;
+    table->count = 0;
+    return ESP_OK;
+}
+
+/* Free a dispatch table */
+void mcp_dispatch_deinit(mcp_dispatch_table_t* table)
+{
+    if (!table) {
+        return;
+    }
+    
+    free(table->entries);
+    table->entries = NULL;
+    table->capacity = 0;
+    table->count = 0;
+}
+
+/* Remove all entries from a dispatch table */
+void mcp_dispatch_clear(mcp_dispatch_table_t* table)
+{
+    if (table && table->entries) {
+        memset(table->entries, 0, table->capacity * sizeof(mcp_dispatch_entry_t));
+        table->count = 0;
+    }
+}
+
+static mcp_dispatch_entry_t* find_slot(const mcp_dispatch_table_t* table, uint32_t hash,
+                                       const char* name, size_t len)
+{
+    uint32_t mask = table->capacity - 1;
+    
+    for (uint32_t i = hash & mask; ; i = (i + 1) & mask) {
+        mcp_dispatch_entry_t* entry = &table->entries[i];
+        if (entry->name_len == 0) {
+            return entry;
+        }
+        if (entry->hash == hash && entry->name_len == len && memcmp(entry->name, name, len) == 0) {
+            return entry;
+        }
+    }
+}
+
+/* Register a name */
+esp_err_t mcp_dispatch_insert(mcp_dispatch_table_t* table, const char* name, void* value)
+{
+    if (!table || !table->entries || !name) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    size_t len = strlen(name);
+    if (len == 0 || len > UINT16_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if ((table->count + 1) * 2 > table->capacity) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    uint32_t hash = mcp_dispatch_hash(name, len);
+    mcp_dispatch_entry_t* entry = find_slot(table, hash, name, len);
+    if (entry->name_len != 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    entry->hash = hash;
+    entry->name_len = (uint16_t)len;
+    entry->name = name;
+    entry->value = value;
+    table->count++;
+    return ESP_OK;
+}
+
+/* Look up a name given as a byte slice */
+void* mcp_dispatch_lookup(const mcp_dispatch_table_t* table, const char* name, size_t len)
+{
+    if (!table || !table->entries || !name || len == 0) {
+        return NULL;
+    }
+    
+    const mcp_dispatch_entry_t* entry = find_slot(table, mcp_dispatch_hash(name, len), name, len);
+    return entry->name_len ? entry->value : NULL;
+}
+
+/* Look up the name held by a JSON string token */
+void* mcp_dispatch_lookup_token(const mcp_dispatch_table_t* table,
+                                const mcp_json_doc_t* doc, int tok)
+{
+    if (mcp_json_type(doc, tok) != MCP_JSON_STRING) {
+        return NULL;
+    }
+    
+    /* Unescaped names are hashed in place; escaped ones are decoded first */
+    if (!(doc->tokens[tok].flags & MCP_JSON_FLAG_ESCAPED)) {
+        size_t len;
+        const char* name = mcp_json_raw(doc, tok, &len);
+        return mcp_dispatch_lookup(table, name, len);
+    }
+    
+    char name[MCP_DISPATCH_MAX_NAME_LEN + 1];
+    if (mcp_json_get_string(doc, tok, name, sizeof(name)) != ESP_OK) {
+        return NULL;
+    }
+    return mcp_dispatch_lookup(table, name, strlen(name));
+}
@@ -0,0 +1,560 @@
+/**
+ * @file mcp_json.c
+ * @brief Zero-allocation JSON tokenizer implementation
+ *
+ * Recursive-descent tokenizer bounded by MCP_JSON_MAX_DEPTH. Tokens store
+ * offsets into the caller's input, so nothing is copied or allocated.
+ */
+
+#include "mcp_json.h"
+
+#include <string.h>
+
+/* Tokenizer state */
+typedef struct {
+    const char* js;
+    size_t len;
+    size_t pos;
+    mcp_json_token_t* tokens;
+    unsigned int max_tokens;
+    unsigned int count;
+    int depth;
+} mcp_json_parser_t;
+
+static int parse_value(mcp_json_parser_t* p);
+
+static inline void skip_ws(mcp_json_parser_t* p)
+{
+    while (p->pos < p->len) {
+        char c = p->js[p->pos];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        p->pos++;
+    }
+}
+
+static inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool is_hex(char c)
+{
+    return is_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+static inline int hex_value(char c)
+{
+    if (is_digit(c)) {
+        return c - '0';
+    }
+    return (c | 0x20) - 'a' + 10;
+}
+
+/* Reserve a token slot (counting mode only advances the counter) */
+static int alloc_token(mcp_json_parser_t* p, mcp_json_type_t type, size_t start)
+{
+    if (p->tokens) {
+        if (p->count >= p->max_tokens) {
+            return MCP_JSON_ERR_NOMEM;
+        }
+        mcp_json_token_t* t = &p->tokens[p->count];
+        t->type = (uint8_t)type;
+        t->flags = 0;
+        t->size = 0;
+        t->skip = 1;
+        t->start = (uint16_t)start;
+        t->len = 0;
+    }
+    return (int)p->count++;
+}
+
+static inline void close_token(mcp_json_parser_t* p, int idx, size_t end)
+{
+    if (p->tokens) {
+        mcp_json_token_t* t = &p->tokens[idx];
+        t->len = (uint16_t)(end - t->start);
+        t->skip = (uint16_t)(p->count - (unsigned int)idx);
+    }
+}
+
+static int parse_string(mcp_json_parser_t* p)
+{
+    size_t start = ++p->pos;  /* skip opening quote */
+    uint8_t flags = 0;
+    
+    while (p->pos < p->len) {
+        char c = p->js[p->pos];
+        if (c == '"') {
+            int idx = alloc_token(p, MCP_JSON_STRING, start);
+            if (idx < 0) {
+                return idx;
+            }
+            close_token(p, idx, p->pos);
+            if (p->tokens) {
+                p->tokens[idx].flags = flags;
+            }
+            p->pos++;
+            return idx;
+        }
+        if ((unsigned char)c < 0x20) {
+            return MCP_JSON_ERR_INVALID;
+        }
+        if (c == '\\') {
+            flags |= MCP_JSON_FLAG_ESCAPED;
+            if (++p->pos >= p->len) {
+                return MCP_JSON_ERR_PARTIAL;
+            }
+            switch (p->js[p->pos]) {
+                case '"': case '\\': case '/': case 'b':
+                case 'f': case 'n': case 'r': case 't':
+                    break;
+                case 'u':
+                    for (int i = 0; i < 4; i++) {
+                        if (++p->pos >= p->len) {
+                            return MCP_JSON_ERR_PARTIAL;
+                        }
+                        if (!is_hex(p->js[p->pos])) {
+                            return MCP_JSON_ERR_INVALID;
+                        }
+                    }
+                    break;
+                default:
+                    return MCP_JSON_ERR_INVALID;
+            }
+        }
+        p->pos++;
+    }
+    return MCP_JSON_ERR_PARTIAL;
+}
+
+static int parse_number(mcp_json_parser_t* p)
+{
+    size_t start = p->pos;
+    
+    if (p->js[p->pos] == '-') {
+        p->pos++;
+    }
+    if (p->pos >= p->len) {
+        return MCP_JSON_ERR_PARTIAL;
+    }
+    if (p->js[p->pos] == '0') {
+        p->pos++;
+    } else if (is_digit(p->js[p->pos])) {
+        while (p->pos < p->len && is_digit(p->js[p->pos])) {
+            p->pos++;
+        }
+    } else {
+        return MCP_JSON_ERR_INVALID;
+    }
+    if (p->pos < p->len && p->js[p->pos] == '.') {
+        p->pos++;
+        if (p->pos >= p->len || !is_digit(p->js[p->pos])) {
+            return p->pos >= p->len ? MCP_JSON_ERR_PARTIAL : MCP_JSON_ERR_INVALID;
+        }
+        while (p->pos < p->len && is_digit(p->js[p->pos])) {
+            p->pos++;
+        }
+    }
+    if (p->pos < p->len && (p->js[p->pos] == 'e' || p->js[p->pos] == 'E')) {
+        p->pos++;
+        if (p->pos < p->len && (p->js[p->pos] == '+' || p->js[p->pos] == '-')) {
+            p->pos++;
+        }
+        if (p->pos >= p->len || !is_digit(p->js[p->pos])) {
+            return p->pos >= p->len ? MCP_JSON_ERR_PARTIAL : MCP_JSON_ERR_INVALID;
+        }
+        while (p->pos < p->len && is_digit(p->js[p->pos])) {
+            p->pos++;
+        }
+    }
+    
+    int idx = alloc_token(p, MCP_JSON_NUMBER, start);
+    if (idx >= 0) {
+        close_token(p, idx, p->pos);
+    }
+    return idx;
+}
+
+static int parse_literal(mcp_json_parser_t* p, const char* lit, mcp_json_type_t type)
+{
+    size_t lit_len = strlen(lit);
+    size_t avail = p->len - p->pos;
+    
+    if (memcmp(p->js + p->pos, lit, avail < lit_len ? avail : lit_len) != 0) {
+        return MCP_JSON_ERR_INVALID;
+    }
+    if (avail < lit_len) {
+        return MCP_JSON_ERR_PARTIAL;
+    }
+    
+    int idx = alloc_token(p, type, p->pos);
+    p->pos += lit_len;
+    if (idx >= 0) {
+        close_token(p, idx, p->pos);
+    }
+    return idx;
+}
+
+static int parse_container(mcp_json_parser_t* p, bool is_object)
+{
+    if (++p->depth > MCP_JSON_MAX_DEPTH) {
+        return MCP_JSON_ERR_DEPTH;
+    }
+    
+    const char close = is_object ? '}' : ']';
+    int idx = alloc_token(p, is_object ? MCP_JSON_OBJECT : MCP_JSON_ARRAY, p->pos);
+    if (idx < 0) {
+        return idx;
+    }
+    p->pos++;  /* skip opening bracket */
+    
+    uint16_t size = 0;
+    skip_ws(p);
+    if (p->pos < p->len && p->js[p->pos] == close) {
+        goto done;
+    }
+    
+    for (;;) {
+        skip_ws(p);
+        if (p->pos >= p->len) {
+            return MCP_JSON_ERR_PARTIAL;
+        }
+        
+        if (is_object) {
+            if (p->js[p->pos] != '"') {
+                return MCP_JSON_ERR_INVALID;
+            }
+            int key = parse_string(p);
+            if (key < 0) {
+                return key;
+            }
+            skip_ws(p);
+            if (p->pos >= p->len) {
+                return MCP_JSON_ERR_PARTIAL;
+            }
+            if (p->js[p->pos] != ':') {
+                return MCP_JSON_ERR_INVALID;
+            }
+            p->pos++;
+        }
+        
+        int value = parse_value(p);
+        if (value < 0) {
+            return value;
+        }
+        size++;
+        
+        skip_ws(p);
+        if (p->pos >= p->len) {
+            return MCP_JSON_ERR_PARTIAL;
+        }
+        if (p->js[p->pos] == ',') {
+            p->pos++;
+            continue;
+        }
+        if (p->js[p->pos] == close) {
+            break;
+        }
+        return MCP_JSON_ERR_INVALID;
+    }
+
+done:
+    p->pos++;  /* skip closing bracket */
+    close_token(p, idx, p->pos);
+    if (p->tokens) {
+        p->tokens[idx].size = size;
+    }
+    p->depth--;
+    return idx;
+}
+
+static int parse_value(mcp_json_parser_t* p)
+{
+    skip_ws(p);
+    if (p->pos >= p->len) {
+        return MCP_JSON_ERR_PARTIAL;
+    }
+    
+    switch (p->js[p->pos]) {
+        case '{':
+            return parse_container(p, true);
+        case '[':
+            return parse_container(p, false);
+        case '"':
+            return parse_string(p);
+        case 't':
+            return parse_literal(p, "true", MCP_JSON_TRUE);
+        case 'f':
+            return parse_literal(p, "false", MCP_JSON_FALSE);
+        case 'n':
+            return parse_literal(p, "null", MCP_JSON_NULL);
+        default:
+            if (p->js[p->pos] == '-' || is_digit(p->js[p->pos])) {
+                return parse_number(p);
+            }
+            return MCP_JSON_ERR_INVALID;
+    }
+}
+
+/* Tokenize a JSON value in place */
+int mcp_json_parse(const char* json, size_t len,
+                   mcp_json_token_t* tokens, unsigned int max_tokens)
+{
+    if (!json) {
+        return MCP_JSON_ERR_INVALID;
+    }
+    if (len > MCP_JSON_MAX_INPUT_SIZE) {
+        return MCP_JSON_ERR_TOO_LARGE;
+    }
+    
+    mcp_json_parser_t p = {
+        .js = json,
+        .len = len,
+        .pos = 0,
+        .tokens = tokens,
+        .max_tokens = max_tokens,
+        .count = 0,
+        .depth = 0,
+    };
+    
+    int ret = parse_value(&p);
+    if (ret < 0) {
+        return ret;
+    }
+    
+    skip_ws(&p);
+    if (p.pos != p.len) {
+        return MCP_JSON_ERR_INVALID;
+    }
+    
+    return (int)p.count;
+}
+
+/*
+ * Decode one (possibly escaped) character of a string token starting at *i.
+ * Writes up to 4 UTF-8 bytes into out and returns their count.
+ */
+static size_t decode_char(const char* s, size_t len, size_t* i, char out[4])
+{
+    char c = s[(*i)++];
+    if (c != '\\') {
+        out[0] = c;
+        return 1;
+    }
+    
+    c = s[(*i)++];
+    switch (c) {
+        case 'b': out[0] = '\b'; return 1;
+        case 'f': out[0] = '\f'; return 1;
+        case 'n': out[0] = '\n'; return 1;
+        case 'r': out[0] = '\r'; return 1;
+        case 't': out[0] = '\t'; return 1;
+        case 'u': break;
+        default:  out[0] = c; return 1;
+    }
+    
+    uint32_t cp = 0;
+    for (int k = 0; k < 4; k++) {
+        cp = (cp << 4) | (uint32_t)hex_value(s[(*i)++]);
+    }
+    
+    /* Combine UTF-16 surrogate pairs */
+    if (cp >= 0xD800 && cp <= 0xDBFF && *i + 6 <= len &&
+        s[*i] == '\\' && s[*i + 1] == 'u') {
+        uint32_t lo = 0;
+        for (int k = 0; k < 4; k++) {
+            lo = (lo << 4) | (uint32_t)hex_value(s[*i + 2 + k]);
+        }
+        if (lo >= 0xDC00 && lo <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+            *i += 6;
+        }
+    }
+    
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+/* Decode the escape sequences of raw string content */
+size_t mcp_json_unescape(const char* s, size_t len, char* out)
+{
+    size_t i = 0;
+    size_t j = 0;
+    while (i < len) {
+        char c[4];
+        size_t n = decode_char(s, len, &i, c);
+        if (out) {
+            memcpy(out + j, c, n);
+        }
+        j += n;
+    }
+    return j;
+}
+
+/* Compare a string token with a NUL-terminated string */
+bool mcp_json_eq(const mcp_json_doc_t* doc, int tok, const char* str)
+{
+    if (tok < 0 || doc->tokens[tok].type != MCP_JSON_STRING || !str) {
+        return false;
+    }
+    
+    const mcp_json_token_t* t = &doc->tokens[tok];
+    const char* s = doc->json + t->start;
+    
+    if (!(t->flags & MCP_JSON_FLAG_ESCAPED)) {
+        return strlen(str) == t->len && memcmp(s, str, t->len) == 0;
+    }
+    
+    size_t i = 0;
+    size_t j = 0;
+    while (i < t->len) {
+        char buf[4];
+        size_t n = decode_char(s, t->len, &i, buf);
+        if (strncmp(str + j, buf, n) != 0) {
+            return false;
+        }
+        j += n;
+    }
+    return str[j] == '\0';
+}
+
+/* Find an object member by key */
+int mcp_json_find(const mcp_json_doc_t* doc, int object, const char* key)
+{
+    if (object < 0 || doc->tokens[object].type != MCP_JSON_OBJECT) {
+        return -1;
+    }
+    
+    int tok = object + 1;
+    for (uint16_t i = 0; i < doc->tokens[object].size; i++) {
+        int value = tok + 1;
+        if (mcp_json_eq(doc, tok, key)) {
+            return value;
+        }
+        tok = mcp_json_next(doc, value);
+    }
+    return -1;
+}
+
+/* Copy a string token into a buffer, decoding escape sequences */
+esp_err_t mcp_json_get_string(const mcp_json_doc_t* doc, int tok, char* buf, size_t size)
+{
+    if (tok < 0 || doc->tokens[tok].type != MCP_JSON_STRING || !buf || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    const mcp_json_token_t* t = &doc->tokens[tok];
+    const char* s = doc->json + t->start;
+    
+    if (!(t->flags & MCP_JSON_FLAG_ESCAPED)) {
+        if (t->len >= size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(buf, s, t->len);
+        buf[t->len] = '\0';
+        return ESP_OK;
+    }
+    
+    size_t i = 0;
+    size_t j = 0;
+    while (i < t->len) {
+        char c[4];
+        size_t n = decode_char(s, t->len, &i, c);
+        if (j + n >= size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        memcpy(buf + j, c, n);
+        j += n;
+    }
+    buf[j] = '\0';
+    return ESP_OK;
+}
+
+/* Parse an integral number token without relying on NUL termination */
+static esp_err_t parse_integer(const mcp_json_doc_t* doc, int tok, int64_t min, int64_t max,
+                               int64_t* value)
+{
+    if (tok < 0 || doc->tokens[tok].type != MCP_JSON_NUMBER) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    const mcp_json_token_t* t = &doc->tokens[tok];
+    const char* s = doc->json + t->start;
+    size_t i = 0;
+    bool negative = false;
+    int64_t v = 0;
+    
+    if (s[0] == '-') {
+        negative = true;
+        i++;
+    }
+    for (; i < t->len; i++) {
+        if (!is_digit(s[i])) {
+            return ESP_ERR_INVALID_ARG;  /* fraction or exponent */
+        }
+        v = v * 10 + (s[i] - '0');
+        if (v > max + (negative ? 1 : 0)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+    if (negative) {
+        v = -v;
+    }
+    if (v < min || v > max) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    *value = v;
+    return ESP_OK;
+}
+
+/* Read an integer token */
+esp_err_t mcp_json_get_int(const mcp_json_doc_t* doc, int tok, int32_t* value)
+{
+    int64_t v;
+    esp_err_t ret = parse_integer(doc, tok, INT32_MIN, INT32_MAX, &v);
+    if (ret == ESP_OK) {
+        *value = (int32_t)v;
+    }
+    return ret;
+}
+
+/* Read an unsigned integer token */
+esp_err_t mcp_json_get_u32(const mcp_json_doc_t* doc, int tok, uint32_t* value)
+{
+    int64_t v;
+    esp_err_t ret = parse_integer(doc, tok, 0, UINT32_MAX, &v);
+    if (ret == ESP_OK) {
+        *value = (uint32_t)v;
+    }
+    return ret;
+}
+
+/* Read a boolean token */
+esp_err_t mcp_json_get_bool(const mcp_json_doc_t* doc, int tok, bool* value)
+{
+    mcp_json_type_t type = mcp_json_type(doc, tok);
+    if (type != MCP_JSON_TRUE && type != MCP_JSON_FALSE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *value = (type == MCP_JSON_TRUE);
+    return ESP_OK;
+}
@@ -0,0 +1,646 @@
+/**
+ * @file mcp_json_writer.c
+ * @brief Streaming JSON writer implementation
+ */
+
+#include "mcp_json_writer.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* CBOR major types and simple values (RFC 8949) */
+#define CBOR_UINT           0
+#define CBOR_NEGINT         1
+#define CBOR_TEXT           3
+#define CBOR_FALSE          0xF4
+#define CBOR_TRUE           0xF5
+#define CBOR_NULL           0xF6
+#define CBOR_FLOAT32        0xFA
+#define CBOR_FLOAT64        0xFB
+#define CBOR_MAP_INDEF      0xBF
+#define CBOR_ARRAY_INDEF    0x9F
+#define CBOR_BREAK          0xFF
+
+static inline void put(mcp_json_writer_t* w, const char* data, size_t len)
+{
+    if (w->overflow || w->len + len >= w->size) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+static inline void put_char(mcp_json_writer_t* w, char c)
+{
+    if (w->overflow || w->len + 1 >= w->size) {
+        w->overflow = true;
+        return;
+    }
+    w->buf[w->len++] = c;
+}
+
+static inline bool is_cbor(const mcp_json_writer_t* w)
+{
+    return w->format == MCP_WIRE_CBOR;
+}
+
+/* Write a CBOR initial byte with its argument in the shortest form */
+static void put_cbor_head(mcp_json_writer_t* w, uint8_t major, uint64_t value)
+{
+    uint8_t head[9];
+    size_t n;
+    
+    if (value < 24) {
+        head[0] = (uint8_t)((major << 5) | value);
+        n = 1;
+    } else if (value <= 0xFF) {
+        head[0] = (uint8_t)((major << 5) | 24);
+        n = 2;
+    } else if (value <= 0xFFFF) {
+        head[0] = (uint8_t)((major << 5) | 25);
+        n = 3;
+    } else if (value <= 0xFFFFFFFF) {
+        head[0] = (uint8_t)((major << 5) | 26);
+        n = 5;
+    } else {
+        head[0] = (uint8_t)((major << 5) | 27);
+        n = 9;
+    }
+    for (size_t i = 1; i < n; i++) {
+        head[i] = (uint8_t)(value >> (8 * (n - 1 - i)));
+    }
+    put(w, (const char*)head, n);
+}
+
+/* Emit a separator if needed before a key or a value */
+static void begin_value(mcp_json_writer_t* w)
+{
+    if (is_cbor(w)) {
+        return;
+    }
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    if (w->depth > 0) {
+        uint32_t bit = 1u << (w->depth - 1);
+        if (w->has_items & bit) {
+            put_char(w, ',');
+        }
+        w->has_items |= bit;
+    }
+}
+
+static void begin_container(mcp_json_writer_t* w, char open)
+{
+    begin_value(w);
+    if (is_cbor(w)) {
+        put_char(w, (char)(open == '{' ? CBOR_MAP_INDEF : CBOR_ARRAY_INDEF));
+    } else {
+        put_char(w, open);
+    }
+    if (w->depth >= MCP_JSON_WRITER_MAX_DEPTH) {
+        w->overflow = true;
+        return;
+    }
+    w->depth++;
+    w->has_items &= ~(1u << (w->depth - 1));
+}
+
+static void end_container(mcp_json_writer_t* w, char close)
+{
+    if (w->depth > 0) {
+        w->depth--;
+    }
+    put_char(w, is_cbor(w) ? (char)CBOR_BREAK : close);
+}
+
+/* Write raw JSON string content as a CBOR text string, decoding escapes */
+static void put_cbor_json_string(mcp_json_writer_t* w, const char* raw, size_t len, bool escaped)
+{
+    if (!escaped) {
+        put_cbor_head(w, CBOR_TEXT, len);
+        put(w, raw, len);
+        return;
+    }
+    
+    size_t decoded = mcp_json_unescape(raw, len, NULL);
+    put_cbor_head(w, CBOR_TEXT, decoded);
+    if (w->overflow || w->len + decoded >= w->size) {
+        w->overflow = true;
+        return;
+    }
+    w->len += mcp_json_unescape(raw, len, w->buf + w->len);
+}
+
+static void put_escaped(mcp_json_writer_t* w, const char* str, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t run = 0;
+    
+    put_char(w, '"');
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)str[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        
+        /* Flush the unescaped run before this character */
+        put(w, str + run, i - run);
+        run = i + 1;
+        
+        char esc[6] = { '\\', 0 };
+        switch (c) {
+            case '"':  esc[1] = '"';  put(w, esc, 2); break;
+            case '\\': esc[1] = '\\'; put(w, esc, 2); break;
+            case '\b': esc[1] = 'b';  put(w, esc, 2); break;
+            case '\f': esc[1] = 'f';  put(w, esc, 2); break;
+            case '\n': esc[1] = 'n';  put(w, esc, 2); break;
+            case '\r': esc[1] = 'r';  put(w, esc, 2); break;
+            case '\t': esc[1] = 't';  put(w, esc, 2); break;
+            default:
+                esc[1] = 'u';
+                esc[2] = '0';
+                esc[3] = '0';
+                esc[4] = hex[c >> 4];
+                esc[5] = hex[c & 0x0F];
+                put(w, esc, 6);
+                break;
+        }
+    }
+    put(w, str + run, len - run);
+    put_char(w, '"');
+}
+
+/* Initialize a writer over an output buffer */
+void mcp_json_writer_init(mcp_json_writer_t* w, char* buf, size_t size)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->size = size;
+    w->overflow = (buf == NULL || size == 0);
+}
+
+/* NUL-terminate the output and report overflow */
+esp_err_t mcp_json_writer_finish(mcp_json_writer_t* w)
+{
+    if (w->buf && w->size > 0) {
+        w->buf[w->len < w->size ? w->len : w->size - 1] = '\0';
+    }
+    return w->overflow ? ESP_ERR_INVALID_SIZE : ESP_OK;
+}
+
+void mcp_json_writer_begin_object(mcp_json_writer_t* w)
+{
+    begin_container(w, '{');
+}
+
+void mcp_json_writer_end_object(mcp_json_writer_t* w)
+{
+    end_container(w, '}');
+}
+
+void mcp_json_writer_begin_array(mcp_json_writer_t* w)
+{
+    begin_container(w, '[');
+}
+
+void mcp_json_writer_end_array(mcp_json_writer_t* w)
+{
+    end_container(w, ']');
+}
+
+void mcp_json_writer_key(mcp_json_writer_t* w, const char* key)
+{
+    mcp_json_writer_key_n(w, key, strlen(key));
+}
+
+void mcp_json_writer_key_n(mcp_json_writer_t* w, const char* key, size_t len)
+{
+    if (is_cbor(w)) {
+        put_cbor_head(w, CBOR_TEXT, len);
+        put(w, key, len);
+        return;
+    }
+    begin_value(w);
+    put_escaped(w, key, len);
+    put_char(w, ':');
+    w->after_key = true;
+}
+
+void mcp_json_writer_string(mcp_json_writer_t* w, const char* str)
+{
+    if (!str) {
+        mcp_json_writer_null(w);
+        return;
+    }
+    mcp_json_writer_string_n(w, str, strlen(str));
+}
+
+void mcp_json_writer_string_n(mcp_json_writer_t* w, const char* str, size_t len)
+{
+    if (is_cbor(w)) {
+        put_cbor_head(w, CBOR_TEXT, len);
+        put(w, str, len);
+        return;
+    }
+    begin_value(w);
+    put_escaped(w, str, len);
+}
+
+void mcp_json_writer_uint(mcp_json_writer_t* w, uint64_t value)
+{
+    char digits[20];
+    size_t n = 0;
+    
+    if (is_cbor(w)) {
+        put_cbor_head(w, CBOR_UINT, value);
+        return;
+    }
+    begin_value(w);
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    put(w, digits + sizeof(digits) - n, n);
+}
+
+void mcp_json_writer_int(mcp_json_writer_t* w, int64_t value)
+{
+    if (value < 0 && is_cbor(w)) {
+        put_cbor_head(w, CBOR_NEGINT, (uint64_t)(-(value + 1)));
+        return;
+    }
+    if (value < 0) {
+        begin_value(w);
+        put_char(w, '-');
+        /* The minus sign already accounted for the separator */
+        w->after_key = true;
+        mcp_json_writer_uint(w, (uint64_t)0 - (uint64_t)value);
+        return;
+    }
+    mcp_json_writer_uint(w, (uint64_t)value);
+}
+
+void mcp_json_writer_bool(mcp_json_writer_t* w, bool value)
+{
+    if (is_cbor(w)) {
+        put_char(w, (char)(value ? CBOR_TRUE : CBOR_FALSE));
+        return;
+    }
+    begin_value(w);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void mcp_json_writer_null(mcp_json_writer_t* w)
+{
+    if (is_cbor(w)) {
+        put_char(w, (char)CBOR_NULL);
+        return;
+    }
+    begin_value(w);
+    put(w, "null", 4);
+}
+
+void mcp_json_writer_double(mcp_json_writer_t* w, double value)
+{
+    if (is_cbor(w)) {
+        uint8_t out[9];
+        size_t n;
+        float single = (float)value;
+        if ((double)single == value) {
+            uint32_t bits;
+            memcpy(&bits, &single, sizeof(bits));
+            out[0] = CBOR_FLOAT32;
+            for (int i = 0; i < 4; i++) {
+                out[1 + i] = (uint8_t)(bits >> (24 - 8 * i));
+            }
+            n = 5;
+        } else {
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            out[0] = CBOR_FLOAT64;
+            for (int i = 0; i < 8; i++) {
+                out[1 + i] = (uint8_t)(bits >> (56 - 8 * i));
+            }
+            n = 9;
+        }
+        put(w, (const char*)out, n);
+        return;
+    }
+    
+    if (!isfinite(value)) {
+        mcp_json_writer_null(w);
+        return;
+    }
+    
+    /* Prefer the short form unless it loses precision */
+    char text[32];
+    int n = snprintf(text, sizeof(text), "%.15g", value);
+    if (strtod(text, NULL) != value) {
+        n = snprintf(text, sizeof(text), "%.17g", value);
+    }
+    begin_value(w);
+    put(w, text, (size_t)n);
+}
+
+/* Write a JSON number as a CBOR integer when it is one, as a float otherwise */
+static void put_cbor_json_number(mcp_json_writer_t* w, const char* s, size_t len)
+{
+    bool negative = len > 0 && s[0] == '-';
+    bool integral = len > (size_t)negative;
+    uint64_t magnitude = 0;
+    
+    for (size_t i = negative; i < len && integral; i++) {
+        if (s[i] < '0' || s[i] > '9' || magnitude > (UINT64_MAX - 9) / 10) {
+            integral = false;
+            break;
+        }
+        magnitude = magnitude * 10 + (uint64_t)(s[i] - '0');
+    }
+    
+    if (integral && (!negative || magnitude == 0)) {
+        mcp_json_writer_uint(w, magnitude);
+        return;
+    }
+    if (integral && magnitude <= (uint64_t)INT64_MAX + 1) {
+        put_cbor_head(w, CBOR_NEGINT, magnitude - 1);
+        return;
+    }
+    
+    char text[32];
+    if (len >= sizeof(text)) {
+        w->overflow = true;
+        return;
+    }
+    memcpy(text, s, len);
+    text[len] = '\0';
+    mcp_json_writer_double(w, strtod(text, NULL));
+}
+
+static inline const char* skip_space(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+/* Find the closing quote of a JSON string whose content starts at p */
+static const char* string_end(const char* p, const char* end, bool* escaped)
+{
+    *escaped = false;
+    while (p < end && *p != '"') {
+        if (*p == '\\') {
+            *escaped = true;
+            p++;
+        }
+        p++;
+    }
+    return p < end ? p : NULL;
+}
+
+/*
+ * Transcode one JSON value starting at p into CBOR.
+ * Returns the position after the value, or NULL on malformed input.
+ */
+static const char* transcode_value(mcp_json_writer_t* w, const char* p, const char* end)
+{
+    p = skip_space(p, end);
+    if (p >= end || w->overflow) {
+        return NULL;
+    }
+    
+    if (*p == '{' || *p == '[') {
+        bool is_object = (*p == '{');
+        char close = is_object ? '}' : ']';
+        begin_container(w, *p);
+        p = skip_space(p + 1, end);
+        if (p < end && *p == close) {
+            end_container(w, close);
+            return p + 1;
+        }
+        for (;;) {
+            if (is_object) {
+                bool escaped;
+                const char* key_end;
+                if (p >= end || *p != '"' || !(key_end = string_end(p + 1, end, &escaped))) {
+                    return NULL;
+                }
+                put_cbor_json_string(w, p + 1, key_end - p - 1, escaped);
+                p = skip_space(key_end + 1, end);
+                if (p >= end || *p != ':') {
+                    return NULL;
+                }
+                p++;
+            }
+            p = transcode_value(w, p, end);
+            if (!p) {
+                return NULL;
+            }
+            p = skip_space(p, end);
+            if (p < end && *p == ',') {
+                p = skip_space(p + 1, end);
+                continue;
+            }
+            if (p < end && *p == close) {
+                end_container(w, close);
+                return p + 1;
+            }
+            return NULL;
+        }
+    }
+    
+    if (*p == '"') {
+        bool escaped;
+        const char* str_end = string_end(p + 1, end, &escaped);
+        if (!str_end) {
+            return NULL;
+        }
+        put_cbor_json_string(w, p + 1, str_end - p - 1, escaped);
+        return str_end + 1;
+    }
+    
+    static const struct {
+        const char* text;
+        size_t len;
+        uint8_t value;
+    } literals[] = {
+        { "true", 4, CBOR_TRUE },
+        { "false", 5, CBOR_FALSE },
+        { "null", 4, CBOR_NULL },
+    };
+    for (size_t i = 0; i < sizeof(literals) / sizeof(literals[0]); i++) {
+        if ((size_t)(end - p) >= literals[i].len && memcmp(p, literals[i].text, literals[i].len) == 0) {
+            put_char(w, (char)literals[i].value);
+            return p + literals[i].len;
+        }
+    }
+    
+    const char* start = p;
+    while (p < end && ((*p >= '0' && *p <= '9') || (*p && strchr("+-.eE", *p)))) {
+        p++;
+    }
+    if (p == start) {
+        return NULL;
+    }
+    put_cbor_json_number(w, start, p - start);
+    return p;
+}
+
+void mcp_json_writer_raw(mcp_json_writer_t* w, const char* json, size_t len)
+{
+    if (is_cbor(w)) {
+        if (!transcode_value(w, json, json + len)) {
+            w->overflow = true;
+        }
+        return;
+    }
+    begin_value(w);
+    put(w, json, len);
+}
+
+void mcp_json_writer_encoded(mcp_json_writer_t* w, const void* data, size_t len)
+{
+    begin_value(w);
+    put(w, (const char*)data, len);
+}
+
+void mcp_json_writer_base64(mcp_json_writer_t* w, const void* data, size_t len)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const uint8_t* in = (const uint8_t*)data;
+    
+    begin_value(w);
+    if (is_cbor(w)) {
+        put_cbor_head(w, CBOR_TEXT, (len + 2) / 3 * 4);
+    } else {
+        put_char(w, '"');
+    }
+    if (w->overflow || w->len + (len + 2) / 3 * 4 >= w->size) {
+        w->overflow = true;
+        return;
+    }
+    
+    char* out = w->buf + w->len;
+    size_t i = 0;
+    for (; i + 2 < len; i += 3) {
+        uint32_t v = ((uint32_t)in[i] << 16) | ((uint32_t)in[i + 1] << 8) | in[i + 2];
+        *out++ = alphabet[(v >> 18) & 0x3F];
+        *out++ = alphabet[(v >> 12) & 0x3F];
+        *out++ = alphabet[(v >> 6) & 0x3F];
+        *out++ = alphabet[v & 0x3F];
+    }
+    if (i < len) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) {
+            v |= (uint32_t)in[i + 1] << 8;
+        }
+        *out++ = alphabet[(v >> 18) & 0x3F];
+        *out++ = alphabet[(v >> 12) & 0x3F];
+        *out++ = (i + 1 < len) ? alphabet[(v >> 6) & 0x3F] : '=';
+        *out++ = '=';
+    }
+    w->len = out - w->buf;
+    if (!is_cbor(w)) {
+        put_char(w, '"');
+    }
+}
+
+void mcp_json_writer_token(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int tok)
+{
+    if (tok < 0) {
+        mcp_json_writer_null(w);
+        return;
+    }
+    
+    size_t len;
+    const char* raw = mcp_json_raw(doc, tok, &len);
+    
+    if (is_cbor(w)) {
+        if (doc->tokens[tok].type == MCP_JSON_STRING) {
+            put_cbor_json_string(w, raw, len, doc->tokens[tok].flags & MCP_JSON_FLAG_ESCAPED);
+        } else {
+            mcp_json_writer_raw(w, raw, len);
+        }
+        return;
+    }
+    
+    begin_value(w);
+    if (doc->tokens[tok].type == MCP_JSON_STRING) {
+        put_char(w, '"');
+        put(w, raw, len);
+        put_char(w, '"');
+    } else {
+        put(w, raw, len);
+    }
+}
+
+/* Order two member key tokens by their raw bytes */
+static int compare_keys(const mcp_json_doc_t* doc, int a, int b)
+{
+    size_t a_len, b_len;
+    const char* a_raw = mcp_json_raw(doc, a, &a_len);
+    const char* b_raw = mcp_json_raw(doc, b, &b_len);
+    
+    int cmp = memcmp(a_raw, b_raw, a_len < b_len ? a_len : b_len);
+    if (cmp == 0) {
+        cmp = (a_len > b_len) - (a_len < b_len);
+    }
+    return cmp;
+}
+
+void mcp_json_writer_canonical(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int tok)
+{
+    mcp_json_type_t type = mcp_json_type(doc, tok);
+    uint16_t size = tok >= 0 ? doc->tokens[tok].size : 0;
+    
+    if (type == MCP_JSON_ARRAY) {
+        mcp_json_writer_begin_array(w);
+        int element = tok + 1;
+        for (uint16_t i = 0; i < size; i++) {
+            mcp_json_writer_canonical(w, doc, element);
+            element = mcp_json_next(doc, element);
+        }
+        mcp_json_writer_end_array(w);
+        return;
+    }
+    
+    if (type != MCP_JSON_OBJECT || size > MCP_JSON_CANONICAL_MAX_MEMBERS) {
+        mcp_json_writer_token(w, doc, tok);
+        return;
+    }
+    
+    /* Insertion sort of the member key tokens; objects here are small */
+    int keys[MCP_JSON_CANONICAL_MAX_MEMBERS];
+    int key = tok + 1;
+    for (uint16_t i = 0; i < size; i++) {
+        uint16_t j = i;
+        while (j > 0 && compare_keys(doc, keys[j - 1], key) > 0) {
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        keys[j] = key;
+        key = mcp_json_next(doc, key + 1);
+    }
+    
+    mcp_json_writer_begin_object(w);
+    for (uint16_t i = 0; i < size; i++) {
+        /* Key tokens are raw string bytes, already escaped */
+        mcp_json_writer_token(w, doc, keys[i]);
+        if (!is_cbor(w)) {
+            put_char(w, ':');
+            w->after_key = true;
+        }
+        mcp_json_writer_canonical(w, doc, keys[i] + 1);
+    }
+    mcp_json_writer_end_object(w);
+}
@@ -0,0 +1,134 @@
+/**
+ * @file mcp_metrics.c
+ * @brief Latency histogram implementation
+ */
+
+#include "mcp_metrics.h"
+
+#include <string.h>
+#include "esp_timer.h"
+
+static const char* s_phase_names[MCP_METRICS_PHASE_MAX] = {
+    "parse",
+    "execute",
+    "serialize",
+};
+
+/* Start timing a request */
+void mcp_timing_start(mcp_timing_t* timing)
+{
+    memset(timing, 0, sizeof(*timing));
+    timing->mark_us = esp_timer_get_time();
+}
+
+/* Charge the time since the last lap to a phase */
+void mcp_timing_lap(mcp_timing_t* timing, mcp_metrics_phase_t phase)
+{
+    int64_t now = esp_timer_get_time();
+    timing->phase_us[phase] += (uint32_t)(now - timing->mark_us);
+    timing->mark_us = now;
+}
+
+static inline uint32_t bucket_of(uint32_t us)
+{
+    uint32_t bucket = us ? 32 - __builtin_clz(us) : 0;
+    return bucket < MCP_METRICS_BUCKETS ? bucket : MCP_METRICS_BUCKETS - 1;
+}
+
+/* Largest latency that falls in a bucket */
+static inline uint32_t bucket_upper_us(uint32_t bucket)
+{
+    return bucket ? (uint32_t)((1ull << bucket) - 1) : 0;
+}
+
+/* Record one latency sample */
+void mcp_histogram_record(mcp_histogram_t* hist, uint32_t us)
+{
+    atomic_fetch_add(&hist->buckets[bucket_of(us)], 1);
+    
+    unsigned int max = atomic_load(&hist->max_us);
+    while (us > max && !atomic_compare_exchange_weak(&hist->max_us, &max, us)) {
+    }
+}
+
+/* Estimate count, percentiles and maximum of a histogram */
+void mcp_histogram_summarize(const mcp_histogram_t* hist, mcp_histogram_summary_t* summary)
+{
+    uint32_t counts[MCP_METRICS_BUCKETS];
+    uint32_t total = 0;
+    
+    for (int i = 0; i < MCP_METRICS_BUCKETS; i++) {
+        counts[i] = atomic_load(&hist->buckets[i]);
+        total += counts[i];
+    }
+    
+    memset(summary, 0, sizeof(*summary));
+    summary->count = total;
+    summary->max_us = atomic_load(&hist->max_us);
+    if (total == 0) {
+        return;
+    }
+    
+    /* Walk the cumulative distribution once for all three ranks */
+    const uint32_t percents[3] = { 50, 90, 99 };
+    uint32_t* outputs[3] = { &summary->p50_us, &summary->p90_us, &summary->p99_us };
+    uint32_t seen = 0;
+    int p = 0;
+    for (int i = 0; i < MCP_METRICS_BUCKETS && p < 3; i++) {
+        seen += counts[i];
+        while (p < 3 && (uint64_t)seen * 100 >= (uint64_t)total * percents[p]) {
+            uint32_t upper = bucket_upper_us(i);
+            *outputs[p++] = upper < summary->max_us ? upper : summary->max_us;
+        }
+    }
+}
+
+/* Record every phase of a timed request */
+void mcp_metrics_record(mcp_metrics_t* metrics, const mcp_timing_t* timing)
+{
+    for (int i = 0; i < MCP_METRICS_PHASE_MAX; i++) {
+        mcp_histogram_record(&metrics->phases[i], timing->phase_us[i]);
+    }
+}
+
+/* Clear all histograms */
+void mcp_metrics_reset(mcp_metrics_t* metrics)
+{
+    for (int i = 0; i < MCP_METRICS_PHASE_MAX; i++) {
+        mcp_histogram_t* hist = &metrics->phases[i];
+        for (int b = 0; b < MCP_METRICS_BUCKETS; b++) {
+            atomic_store(&hist->buckets[b], 0);
+        }
+        atomic_store(&hist->max_us, 0);
+    }
+}
+
+/* Write metrics under a key, skipping metrics without samples */
+void mcp_metrics_write(mcp_json_writer_t* w, const char* name, const mcp_metrics_t* metrics)
+{
+    mcp_histogram_summary_t summaries[MCP_METRICS_PHASE_MAX];
+    
+    /* Every request records all phases, so one count covers the entry */
+    mcp_histogram_summarize(&metrics->phases[0], &summaries[0]);
+    if (summaries[0].count == 0) {
+        return;
+    }
+    for (int i = 1; i < MCP_METRICS_PHASE_MAX; i++) {
+        mcp_histogram_summarize(&metrics->phases[i], &summaries[i]);
+    }
+    
+    mcp_json_writer_key(w, name);
+    mcp_json_writer_begin_object(w);
+    for (int i = 0; i < MCP_METRICS_PHASE_MAX; i++) {
+        const mcp_histogram_summary_t* s = &summaries[i];
+        mcp_json_writer_key(w, s_phase_names[i]);
+        mcp_json_writer_begin_array(w);
+        mcp_json_writer_uint(w, s->count);
+        mcp_json_writer_uint(w, s->p50_us);
+        mcp_json_writer_uint(w, s->p90_us);
+        mcp_json_writer_uint(w, s->p99_us);
+        mcp_json_writer_uint(w, s->max_us);
+        mcp_json_writer_end_array(w);
+    }
+    mcp_json_writer_end_object(w);
+}
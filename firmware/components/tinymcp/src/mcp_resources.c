@@ -0,0 +1,251 @@
+/**
+ * @file mcp_resources.c
+ * @brief Read-only resources served in chunks (resources/list, resources/read)
+ */
+
+#include "mcp_resources.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "freertos/task.h"
+#include "mcp_arena.h"
+
+static const char* TAG = "MCP_RES";
+
+/* Names of the system:// values, indexed by topic */
+static const struct {
+    const char* name;
+    const char* description;
+} s_topic_info[MCP_TOPIC_MAX] = {
+    { "Free heap",         "Free heap bytes" },
+    { "Minimum free heap", "Low-water mark of free heap bytes" },
+    { "Uptime",            "Seconds since boot" },
+    { "Wi-Fi RSSI",        "Signal strength in dBm, 0 while disconnected" },
+    { "Button presses",    "User button presses since boot" },
+};
+
+/* Append content bytes; only those inside the window are kept */
+void mcp_resource_chunk_write(mcp_resource_chunk_t* chunk, const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t start = chunk->pos;
+    uint32_t end = chunk->pos + len;
+    uint32_t window_end = chunk->offset + chunk->size;
+    chunk->pos = end;
+    
+    /* Overlap of [start, end) with the window */
+    uint32_t from = start > chunk->offset ? start : chunk->offset;
+    uint32_t to = end < window_end ? end : window_end;
+    if (from < to) {
+        memcpy(chunk->buf + (from - chunk->offset), bytes + (from - start), to - from);
+    }
+}
+
+/* Append formatted text */
+void mcp_resource_chunk_printf(mcp_resource_chunk_t* chunk, const char* format, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    
+    if (len > 0) {
+        mcp_resource_chunk_write(chunk, text, (size_t)len < sizeof(text) ? (size_t)len : sizeof(text) - 1);
+    }
+}
+
+/* system:// values: the decimal value from the latest sample */
+static esp_err_t read_system_value(const char* uri, mcp_resource_chunk_t* chunk, void* user_ctx)
+{
+    mcp_resources_t* resources = (mcp_resources_t*)user_ctx;
+    int topic = mcp_topic_from_uri(uri, strlen(uri));
+    if (topic < 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    xSemaphoreTake(resources->lock, portMAX_DELAY);
+    bool has_sample = resources->has_sample;
+    int64_t value = mcp_topic_value(&resources->sample, (mcp_topic_t)topic);
+    xSemaphoreGive(resources->lock);
+    
+    if (!has_sample) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    mcp_resource_chunk_printf(chunk, "%lld", (long long)value);
+    return ESP_OK;
+}
+
+#if configUSE_TRACE_FACILITY
+/* system://tasks: one line per task, ordered by task number so that
+ * consecutive chunks line up */
+static esp_err_t read_tasks(const char* uri, mcp_resource_chunk_t* chunk, void* user_ctx)
+{
+    static const char states[] = "RrBSD?";   /* Running, ready, blocked, suspended, deleted */
+    
+    UBaseType_t capacity = uxTaskGetNumberOfTasks() + 2;
+    TaskStatus_t* tasks = (TaskStatus_t*)mcp_arena_malloc(capacity * sizeof(TaskStatus_t));
+    if (!tasks) {
+        return ESP_ERR_NO_MEM;
+    }
+    UBaseType_t count = uxTaskGetSystemState(tasks, capacity, NULL);
+    
+    for (UBaseType_t i = 1; i < count; i++) {
+        TaskStatus_t task = tasks[i];
+        UBaseType_t j = i;
+        for (; j > 0 && tasks[j - 1].xTaskNumber > task.xTaskNumber; j--) {
+            tasks[j] = tasks[j - 1];
+        }
+        tasks[j] = task;
+    }
+    
+    mcp_resource_chunk_printf(chunk, "number\tname\tstate\tpriority\tstack_free\n");
+    for (UBaseType_t i = 0; i < count && !mcp_resource_chunk_full(chunk); i++) {
+        unsigned state = tasks[i].eCurrentState < sizeof(states) - 1 ? tasks[i].eCurrentState : sizeof(states) - 2;
+        mcp_resource_chunk_printf(chunk, "%u\t%s\t%c\t%u\t%" PRIu32 "\n",
+                                  (unsigned)tasks[i].xTaskNumber, tasks[i].pcTaskName, states[state],
+                                  (unsigned)tasks[i].uxCurrentPriority,
+                                  (uint32_t)tasks[i].usStackHighWaterMark);
+    }
+    
+    mcp_arena_free(tasks);
+    return ESP_OK;
+}
+#endif
+
+/* Create a resource table holding the built-in resources */
+esp_err_t mcp_resources_init(mcp_resources_t* resources)
+{
+    memset(resources, 0, sizeof(*resources));
+    resources->lock = xSemaphoreCreateMutex();
+    if (!resources->lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    for (int i = 0; i < MCP_TOPIC_MAX; i++) {
+        mcp_resource_def_t def = {
+            .uri = mcp_topic_uri((mcp_topic_t)i),
+            .name = s_topic_info[i].name,
+            .description = s_topic_info[i].description,
+            .mime_type = "text/plain",
+            .read = read_system_value,
+            .user_ctx = resources,
+        };
+        mcp_resources_add(resources, &def);
+    }
+
+#if configUSE_TRACE_FACILITY
+    mcp_resource_def_t tasks = {
+        .uri = "system://tasks",
+        .name = "Tasks",
+        .description = "FreeRTOS tasks: number, name, state, priority, free stack",
+        .mime_type = "text/tab-separated-values",
+        .read = read_tasks,
+    };
+    mcp_resources_add(resources, &tasks);
+#endif
+    return ESP_OK;
+}
+
+/* Free a resource table */
+void mcp_resources_deinit(mcp_resources_t* resources)
+{
+    if (resources->lock) {
+        vSemaphoreDelete(resources->lock);
+    }
+    memset(resources, 0, sizeof(*resources));
+}
+
+/* Add a resource */
+esp_err_t mcp_resources_add(mcp_resources_t* resources, const mcp_resource_def_t* def)
+{
+    if (!def || !def->uri || !def->name || !def->read) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(resources->lock, portMAX_DELAY);
+    for (uint32_t i = 0; i < resources->count; i++) {
+        if (strcmp(resources->entries[i].uri, def->uri) == 0) {
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
+    }
+    if (ret == ESP_OK && resources->count >= MCP_RESOURCE_MAX) {
+        ret = ESP_ERR_NO_MEM;
+    }
+    if (ret == ESP_OK) {
+        resources->entries[resources->count++] = *def;
+    }
+    xSemaphoreGive(resources->lock);
+    
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Cannot add resource %s: %s", def->uri, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+/* Copy the resource at a table position */
+bool mcp_resources_get(mcp_resources_t* resources, uint32_t index, mcp_resource_def_t* def)
+{
+    xSemaphoreTake(resources->lock, portMAX_DELAY);
+    bool found = index < resources->count;
+    if (found) {
+        *def = resources->entries[index];
+    }
+    xSemaphoreGive(resources->lock);
+    return found;
+}
+
+/* Copy a resource by URI */
+bool mcp_resources_find(mcp_resources_t* resources, const char* uri, size_t len,
+                        mcp_resource_def_t* def)
+{
+    bool found = false;
+    xSemaphoreTake(resources->lock, portMAX_DELAY);
+    for (uint32_t i = 0; i < resources->count; i++) {
+        const char* entry = resources->entries[i].uri;
+        if (strlen(entry) == len && memcmp(entry, uri, len) == 0) {
+            *def = resources->entries[i];
+            found = true;
+            break;
+        }
+    }
+    xSemaphoreGive(resources->lock);
+    return found;
+}
+
+/* Store the sample the system:// resources report */
+void mcp_resources_set_sample(mcp_resources_t* resources, const mcp_system_sample_t* sample)
+{
+    xSemaphoreTake(resources->lock, portMAX_DELAY);
+    resources->sample = *sample;
+    resources->has_sample = true;
+    xSemaphoreGive(resources->lock);
+}
+
+/* Read one chunk of a resource */
+esp_err_t mcp_resource_read(const mcp_resource_def_t* def, uint32_t offset,
+                            uint8_t* buf, size_t size, size_t* len, bool* eof)
+{
+    mcp_resource_chunk_t chunk = {
+        .buf = buf,
+        .size = size,
+        .offset = offset,
+        .pos = 0,
+    };
+    
+    esp_err_t ret = def->read(def->uri, &chunk, def->user_ctx);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    
+    uint32_t window_end = offset + size;
+    uint32_t end = chunk.pos < window_end ? chunk.pos : window_end;
+    *len = end > offset ? end - offset : 0;
+    *eof = chunk.pos <= window_end;
+    return ESP_OK;
+}
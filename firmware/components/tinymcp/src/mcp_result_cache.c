@@ -0,0 +1,210 @@
+/**
+ * @file mcp_result_cache.c
+ * @brief Single-flight TTL result cache implementation
+ */
+
+#include "mcp_result_cache.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include "esp_timer.h"
+#include "freertos/task.h"
+#include "mcp_dispatch.h"
+
+#define ALL_READY_BITS  ((EventBits_t)((1u << MCP_RESULT_CACHE_ENTRIES) - 1))
+
+/* Drop an entry's key and value (lock held) */
+static void entry_clear(mcp_result_cache_t* cache, mcp_cache_entry_t* entry)
+{
+    cache->bytes -= entry->key_len + entry->value_len;
+    free(entry->key);
+    free(entry->value);
+    memset(entry, 0, sizeof(*entry));
+}
+
+/* Least recently used entry that nobody is executing, or -1 (lock held) */
+static int find_victim(mcp_result_cache_t* cache, int keep)
+{
+    int victim = -1;
+    
+    for (int i = 0; i < MCP_RESULT_CACHE_ENTRIES; i++) {
+        mcp_cache_entry_t* entry = &cache->entries[i];
+        if (i == keep || !entry->key || entry->pending) {
+            continue;
+        }
+        if (victim < 0 || entry->last_used_us < cache->entries[victim].last_used_us) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+/* Evict until 'need' more bytes fit under the ceiling (lock held) */
+static bool make_room(mcp_result_cache_t* cache, size_t need, int keep)
+{
+    while (cache->bytes + need > cache->max_bytes) {
+        int victim = find_victim(cache, keep);
+        if (victim < 0) {
+            return false;
+        }
+        entry_clear(cache, &cache->entries[victim]);
+    }
+    return true;
+}
+
+/* Create an empty cache */
+esp_err_t mcp_result_cache_init(mcp_result_cache_t* cache, size_t max_bytes)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->max_bytes = max_bytes;
+    
+    cache->lock = xSemaphoreCreateMutex();
+    cache->ready = xEventGroupCreate();
+    if (!cache->lock || !cache->ready) {
+        mcp_result_cache_deinit(cache);
+        return ESP_ERR_NO_MEM;
+    }
+    xEventGroupSetBits(cache->ready, ALL_READY_BITS);
+    return ESP_OK;
+}
+
+/* Free a cache */
+void mcp_result_cache_deinit(mcp_result_cache_t* cache)
+{
+    for (int i = 0; i < MCP_RESULT_CACHE_ENTRIES; i++) {
+        free(cache->entries[i].key);
+        free(cache->entries[i].value);
+    }
+    if (cache->ready) {
+        vEventGroupDelete(cache->ready);
+    }
+    if (cache->lock) {
+        vSemaphoreDelete(cache->lock);
+    }
+    memset(cache, 0, sizeof(*cache));
+}
+
+/* Look up a call, joining or starting its flight */
+mcp_cache_result_t mcp_result_cache_begin(mcp_result_cache_t* cache,
+                                          const char* key, size_t key_len,
+                                          mcp_json_writer_t* w, int* slot)
+{
+    if (key_len > cache->max_bytes / 2) {
+        return MCP_CACHE_BYPASS;
+    }
+    
+    uint32_t hash = mcp_dispatch_hash(key, key_len);
+    TickType_t deadline = xTaskGetTickCount() + pdMS_TO_TICKS(MCP_RESULT_CACHE_WAIT_MS);
+    
+    for (;;) {
+        xSemaphoreTake(cache->lock, portMAX_DELAY);
+        int64_t now = esp_timer_get_time();
+        
+        int found = -1;
+        for (int i = 0; i < MCP_RESULT_CACHE_ENTRIES; i++) {
+            mcp_cache_entry_t* entry = &cache->entries[i];
+            if (entry->key && entry->hash == hash && entry->key_len == key_len &&
+                memcmp(entry->key, key, key_len) == 0) {
+                found = i;
+                break;
+            }
+        }
+        
+        if (found >= 0) {
+            mcp_cache_entry_t* entry = &cache->entries[found];
+            if (entry->pending) {
+                /* Another caller is executing this call; wait for its result */
+                xSemaphoreGive(cache->lock);
+                TickType_t remaining = deadline - xTaskGetTickCount();
+                if ((int32_t)remaining <= 0 ||
+                    !(xEventGroupWaitBits(cache->ready, 1u << found, pdFALSE, pdTRUE, remaining) &
+                      (1u << found))) {
+                    return MCP_CACHE_BYPASS;
+                }
+                continue;
+            }
+            if (now < entry->expires_us) {
+                /* Copy while locked; the entry may be evicted once released */
+                mcp_json_writer_encoded(w, entry->value, entry->value_len);
+                entry->last_used_us = now;
+                xSemaphoreGive(cache->lock);
+                return MCP_CACHE_HIT;
+            }
+            entry_clear(cache, entry);
+        }
+        
+        /* Start a flight in a free slot, or in the least recently used one */
+        int claim = -1;
+        for (int i = 0; i < MCP_RESULT_CACHE_ENTRIES && claim < 0; i++) {
+            if (!cache->entries[i].key) {
+                claim = i;
+            }
+        }
+        if (claim < 0) {
+            claim = find_victim(cache, -1);
+            if (claim >= 0) {
+                entry_clear(cache, &cache->entries[claim]);
+            }
+        }
+        
+        char* copy = NULL;
+        if (claim >= 0 && make_room(cache, key_len, claim)) {
+            copy = malloc(key_len);
+        }
+        if (!copy) {
+            xSemaphoreGive(cache->lock);
+            return MCP_CACHE_BYPASS;
+        }
+        
+        mcp_cache_entry_t* entry = &cache->entries[claim];
+        memcpy(copy, key, key_len);
+        entry->hash = hash;
+        entry->key = copy;
+        entry->key_len = key_len;
+        entry->last_used_us = now;
+        entry->pending = true;
+        cache->bytes += key_len;
+        xEventGroupClearBits(cache->ready, 1u << claim);
+        
+        xSemaphoreGive(cache->lock);
+        *slot = claim;
+        return MCP_CACHE_MISS;
+    }
+}
+
+/* Publish the result of a flight and wake its waiters */
+void mcp_result_cache_complete(mcp_result_cache_t* cache, int slot,
+                               const char* value, size_t value_len, uint32_t ttl_ms)
+{
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+    
+    mcp_cache_entry_t* entry = &cache->entries[slot];
+    entry->pending = false;
+    
+    char* copy = NULL;
+    if (value && value_len <= cache->max_bytes / 2 && make_room(cache, value_len, slot)) {
+        copy = malloc(value_len);
+    }
+    if (copy) {
+        memcpy(copy, value, value_len);
+        entry->value = copy;
+        entry->value_len = value_len;
+        entry->expires_us = esp_timer_get_time() + (int64_t)ttl_ms * 1000;
+        cache->bytes += value_len;
+    } else {
+        /* Failed or uncacheable: waiters find no entry and execute themselves */
+        entry_clear(cache, entry);
+    }
+    
+    xEventGroupSetBits(cache->ready, 1u << slot);
+    xSemaphoreGive(cache->lock);
+}
+
+/* Get the number of bytes held by the cache */
+size_t mcp_result_cache_bytes(mcp_result_cache_t* cache)
+{
+    xSemaphoreTake(cache->lock, portMAX_DELAY);
+    size_t bytes = cache->bytes;
+    xSemaphoreGive(cache->lock);
+    return bytes;
+}
@@ -7,22 +7,76 @@
  */
 
 #include "mcp_server_simple.h"
+#include "mcp_json.h"
+#include "mcp_json_writer.h"
+#include "mcp_arena.h"
+#include "mcp_dispatch.h"
+#include "mcp_tools.h"
+#include "mcp_tool_registry.h"
+#include "mcp_metrics.h"
+#include "mcp_trace.h"
+#include "mcp_result_cache.h"
+#include "mcp_cbor.h"
+#include "mcp_subscriptions.h"
+#include "mcp_resources.h"
 
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <stdatomic.h>
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_timer.h"
 #include "esp_heap_caps.h"
+#include "esp_cpu.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
-#include "cJSON.h"
+#include "freertos/queue.h"
 
 static const char *TAG = "MCP_SERVER";
 
+/* Longest message classified as urgent; a cancellation is far shorter */
+#define MCP_URGENT_MAX_SIZE         256
+#define MCP_URGENT_MAX_TOKENS       24
+
+/* JSON text first allotted to a CBOR message, as a multiple of its size;
+ * one that expands further is decoded again with the whole message limit */
+#define MCP_CBOR_JSON_EXPANSION     2
+
+/* Statistics counters, updated without locking from any task.
+ * Every update is bracketed by stats_begin/stats_end: readers retry while an
+ * update is in flight or the epoch moved, so a snapshot never shows half of
+ * a request (e.g. received counted but not its error). */
+typedef struct {
+    atomic_uint messages_received;
+    atomic_uint messages_sent;
+    atomic_uint requests_processed;
+    atomic_uint errors_count;
+    atomic_uint tools_executed;
+    atomic_uint cache_hits;
+    atomic_uint cache_misses;
+    atomic_uint notifications_sent;
+    atomic_uint requests_cancelled;
+    atomic_uint requests_expired;
+    atomic_uint work_saved_us;
+    atomic_uint queue_depth_max;
+    atomic_uint queue_rejected;
+    atomic_uint queue_wait_max_us;
+    atomic_uint queue_wait_samples;
+    _Atomic uint64_t queue_wait_total_us;
+    atomic_uint writers;                /* Updates in progress */
+    atomic_uint epoch;                  /* Bumped when an update completes */
+} mcp_server_counters_t;
+
+/* Cancellation of a request by its client, kept until the request runs */
+typedef struct {
+    uint32_t client_id;
+    uint32_t id_hash;                   /* mcp_id_hash() of the cancelled request id, 0 if free */
+    int64_t time_us;                    /* When the cancellation arrived */
+} mcp_cancel_entry_t;
+
 /* MCP Server Internal Structure */
 struct mcp_server_simple {
     /* Configuration */
@@ -33,32 +87,181 @@ struct mcp_server_simple {
     bool running;
     int64_t start_time;
     
-    /* Tasks */
-    TaskHandle_t server_task;
+    /* Worker pool */
+    TaskHandle_t workers[MCP_SERVER_MAX_WORKERS];
+    uint32_t worker_count;
+    uint32_t workers_running;
+    QueueHandle_t queue;                /* mcp_message_t* waiting for a worker */
     
     /* Synchronization */
     SemaphoreHandle_t mutex;
     
-    /* Tools */
-    mcp_tool_def_t tools[MCP_MAX_TOOLS];
-    uint32_t tool_count;
+    /* Tools (read without locking on the request path) */
+    mcp_tool_registry_t tools;
+    
+    /* Serialized results of cacheable tools */
+    mcp_result_cache_t cache;
+    
+    /* Client subscriptions and the transport delivering their notifications */
+    mcp_subscriptions_t subscriptions;
+    mcp_notify_cb_t notify;
+    void* notify_ctx;
+    
+    /* Resources readable in chunks */
+    mcp_resources_t resources;
+    
+    /* Recent cancellations (under mutex); the epoch counts them */
+    mcp_cancel_entry_t cancels[MCP_CANCEL_SLOTS];
+    uint32_t cancel_next;
+    atomic_uint cancel_epoch;
+    
+    /* Method dispatch index */
+    mcp_dispatch_table_t method_index;
+    
+    /* Latency metrics, one entry per s_methods[] slot */
+    mcp_metrics_t* method_metrics;
+    int64_t metrics_window_start;
     
     /* Statistics */
-    mcp_server_stats_t stats;
+    mcp_server_counters_t counters;
+    
+    /* Per-request arenas */
+    mcp_arena_pool_t arenas;
     
     /* Message handling */
-    uint32_t next_message_id;
+    atomic_uint next_message_id;
 };
 
+static inline void stats_begin(struct mcp_server_simple* server)
+{
+    atomic_fetch_add(&server->counters.writers, 1);
+}
+
+static inline void stats_end(struct mcp_server_simple* server)
+{
+    atomic_fetch_add(&server->counters.epoch, 1);
+    atomic_fetch_sub(&server->counters.writers, 1);
+}
+
+/* Raise a high-water mark */
+static inline void stats_max(atomic_uint* counter, uint32_t value)
+{
+    unsigned int current = atomic_load(counter);
+    while (value > current && !atomic_compare_exchange_weak(counter, &current, value)) {
+    }
+}
+
+/* State of the request being handled */
+typedef struct {
+    struct mcp_server_simple* server;
+    uint32_t client_id;                 /* Originating client, 0 for direct calls */
+    uint32_t request_id;                /* Server message id, tags trace records */
+    mcp_wire_format_t format;           /* Encoding of the request and its response */
+    mcp_wire_format_t next_format;      /* Encoding of later messages, set by initialize */
+    uint32_t decode_us;                 /* CBOR decoding time, charged to parsing */
+    mcp_timing_t timing;                /* Phase times for the latency metrics */
+    int reject_code;                    /* Non-zero: answer every request with this error */
+    const char* reject_message;
+    uint32_t retry_after_ms;            /* Hint returned with a rejection */
+    int64_t received_us;                /* When the message reached the server */
+    int64_t default_deadline_us;        /* Deadline of requests not setting one, 0 for none */
+    int64_t deadline_us;                /* Deadline of the request being dispatched */
+    uint32_t id_hash;                   /* mcp_id_hash() of its id, 0 for notifications */
+    uint32_t received_epoch;            /* Server cancel_epoch when the message arrived */
+    uint32_t cancel_epoch;              /* Cancellations already checked against */
+    bool cancelled;
+} mcp_request_ctx_t;
+
 /* Forward declarations */
 static void mcp_server_task_function(void* arg);
-static esp_err_t mcp_handle_request(struct mcp_server_simple* server, 
-                                   const char* request_json, 
-                                   char* response_json, 
-                                   size_t response_size);
+static esp_err_t mcp_process_message(struct mcp_server_simple* server,
+                                     const char* input, size_t input_len,
+                                     char* output_buffer, size_t output_size,
+                                     size_t* output_len, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_write_error(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int id,
+                                 int code, const char* message);
+static esp_err_t mcp_write_rejection(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int id,
+                                     const mcp_request_ctx_t* ctx);
 static esp_err_t mcp_register_builtin_tools(struct mcp_server_simple* server);
-static esp_err_t mcp_send_response(uint32_t id, const char* result_json, 
-                                  const char* error_msg, char* output, size_t output_size);
+static esp_err_t mcp_build_method_index(struct mcp_server_simple* server);
+
+/* JSON-RPC method handler. Time not charged to a phase with
+ * mcp_timing_lap() is counted as serialization when the handler returns. */
+typedef esp_err_t (*mcp_method_handler_t)(struct mcp_server_simple* server,
+                                          const mcp_json_doc_t* doc, int id, int params,
+                                          mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+
+typedef struct {
+    const char* name;
+    mcp_method_handler_t handler;
+} mcp_method_def_t;
+
+static esp_err_t mcp_handle_message(struct mcp_server_simple* server,
+                                   const char* json, size_t len,
+                                   mcp_json_writer_t* w, uint32_t* handled,
+                                   mcp_request_ctx_t* ctx);
+static esp_err_t mcp_handle_cbor_message(struct mcp_server_simple* server,
+                                         const uint8_t* data, size_t len,
+                                         mcp_json_writer_t* w, uint32_t* handled,
+                                         mcp_request_ctx_t* ctx);
+static void mcp_handle_request(struct mcp_server_simple* server,
+                               const mcp_json_doc_t* doc, int root,
+                               uint32_t parse_us, mcp_json_writer_t* w,
+                               mcp_request_ctx_t* ctx);
+
+static esp_err_t mcp_method_initialize(struct mcp_server_simple* server,
+                                       const mcp_json_doc_t* doc, int id, int params,
+                                       mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_initialized(struct mcp_server_simple* server,
+                                        const mcp_json_doc_t* doc, int id, int params,
+                                        mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_cancelled(struct mcp_server_simple* server,
+                                      const mcp_json_doc_t* doc, int id, int params,
+                                      mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_ping(struct mcp_server_simple* server,
+                                  const mcp_json_doc_t* doc, int id, int params,
+                                  mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_tools_list(struct mcp_server_simple* server,
+                                       const mcp_json_doc_t* doc, int id, int params,
+                                       mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_tools_call(struct mcp_server_simple* server,
+                                       const mcp_json_doc_t* doc, int id, int params,
+                                       mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_server_metrics(struct mcp_server_simple* server,
+                                           const mcp_json_doc_t* doc, int id, int params,
+                                           mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_trace_dump(struct mcp_server_simple* server,
+                                       const mcp_json_doc_t* doc, int id, int params,
+                                       mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_subscribe(struct mcp_server_simple* server,
+                                      const mcp_json_doc_t* doc, int id, int params,
+                                      mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_unsubscribe(struct mcp_server_simple* server,
+                                        const mcp_json_doc_t* doc, int id, int params,
+                                        mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_resources_list(struct mcp_server_simple* server,
+                                           const mcp_json_doc_t* doc, int id, int params,
+                                           mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+static esp_err_t mcp_method_resources_read(struct mcp_server_simple* server,
+                                           const mcp_json_doc_t* doc, int id, int params,
+                                           mcp_json_writer_t* w, mcp_request_ctx_t* ctx);
+
+/* Supported JSON-RPC methods */
+static const mcp_method_def_t s_methods[] = {
+    { "initialize",     mcp_method_initialize },
+    { "notifications/initialized", mcp_method_initialized },
+    { "notifications/cancelled",   mcp_method_cancelled },
+    { "ping",           mcp_method_ping },
+    { "tools/list",     mcp_method_tools_list },
+    { "tools/call",     mcp_method_tools_call },
+    { "resources/subscribe",   mcp_method_subscribe },
+    { "resources/unsubscribe", mcp_method_unsubscribe },
+    { "resources/list", mcp_method_resources_list },
+    { "resources/read", mcp_method_resources_read },
+    { "server/metrics", mcp_method_server_metrics },
+    { "debug/trace_dump", mcp_method_trace_dump },
+};
+#define MCP_METHOD_COUNT    (sizeof(s_methods) / sizeof(s_methods[0]))
 
 /* Get default MCP server configuration */
 esp_err_t mcp_server_get_default_config(mcp_server_config_t* config)
@@ -75,6 +278,12 @@ esp_err_t mcp_server_get_default_config(mcp_server_config_t* config)
     config->task_stack_size = MCP_SERVER_TASK_STACK_SIZE;
     config->task_priority = MCP_SERVER_TASK_PRIORITY;
     config->max_message_size = MCP_MAX_MESSAGE_SIZE;
+    config->arena_size = MCP_ARENA_SIZE;
+    config->arena_count = MCP_ARENA_POOL_SIZE;
+    config->worker_count = MCP_SERVER_WORKER_COUNT;
+    config->queue_length = MCP_SERVER_QUEUE_LENGTH;
+    config->cache_max_bytes = MCP_RESULT_CACHE_MAX_BYTES;
+    config->request_timeout_ms = MCP_RESPONSE_TIMEOUT_MS;
     config->enable_echo_tool = true;
     config->enable_display_tool = true;
     config->enable_gpio_tool = true;
@@ -113,19 +322,81 @@ esp_err_t mcp_server_init(const mcp_server_config_t* config,
         return ESP_ERR_NO_MEM;
     }
     
-    /* Register built-in tools */
-    esp_err_t ret = mcp_register_builtin_tools(server);
+    /* Create the request queue feeding the worker pool */
+    server->worker_count = config->worker_count;
+    if (server->worker_count == 0) {
+        server->worker_count = 1;
+    } else if (server->worker_count > MCP_SERVER_MAX_WORKERS) {
+        server->worker_count = MCP_SERVER_MAX_WORKERS;
+    }
+    server->queue = xQueueCreate(config->queue_length ? config->queue_length : 1, sizeof(mcp_message_t*));
+    if (!server->queue) {
+        ESP_LOGE(TAG, "Failed to create request queue");
+        vSemaphoreDelete(server->mutex);
+        free(server);
+        return ESP_ERR_NO_MEM;
+    }
+    
+    /* Create request arenas and route cJSON allocations through them */
+    esp_err_t ret = mcp_arena_pool_init(&server->arenas, config->arena_size, config->arena_count);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create request arenas: %s", esp_err_to_name(ret));
+        vQueueDelete(server->queue);
+        vSemaphoreDelete(server->mutex);
+        free(server);
+        return ret;
+    }
+    mcp_arena_install_cjson_hooks();
+    
+    /* Index methods by name, register built-in tools and create the result
+     * cache, subscription table and resource table; step names the one
+     * that failed */
+    const char *step = "index methods";
+    ret = mcp_build_method_index(server);
+    if (ret == ESP_OK) {
+        step = "register built-in tools";
+        ret = mcp_register_builtin_tools(server);
+    }
+    if (ret == ESP_OK) {
+        step = "create result cache";
+        ret = mcp_result_cache_init(&server->cache, config->cache_max_bytes);
+        if (ret != ESP_OK) {
+            mcp_tool_registry_deinit(&server->tools);
+        }
+    }
+    if (ret == ESP_OK) {
+        step = "create subscription table";
+        ret = mcp_subscriptions_init(&server->subscriptions);
+        if (ret != ESP_OK) {
+            mcp_result_cache_deinit(&server->cache);
+            mcp_tool_registry_deinit(&server->tools);
+        }
+    }
+    if (ret == ESP_OK) {
+        step = "create resource table";
+        ret = mcp_resources_init(&server->resources);
+        if (ret != ESP_OK) {
+            mcp_subscriptions_deinit(&server->subscriptions);
+            mcp_result_cache_deinit(&server->cache);
+            mcp_tool_registry_deinit(&server->tools);
+        }
+    }
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to register built-in tools: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to %s: %s", step, esp_err_to_name(ret));
+        free(server->method_metrics);
+        mcp_dispatch_deinit(&server->method_index);
+        mcp_arena_pool_deinit(&server->arenas);
+        vQueueDelete(server->queue);
         vSemaphoreDelete(server->mutex);
         free(server);
         return ret;
     }
     
     /* Initialize statistics */
-    memset(&server->stats, 0, sizeof(mcp_server_stats_t));
+    memset(&server->counters, 0, sizeof(mcp_server_counters_t));
     server->start_time = esp_timer_get_time();
-    server->next_message_id = 1;
+    server->metrics_window_start = server->start_time;
+    atomic_init(&server->next_message_id, 1);
     
     server->initialized = true;
     *server_handle = server;
@@ -155,20 +426,36 @@ esp_err_t mcp_server_start(mcp_server_handle_t server_handle)
     
     ESP_LOGI(TAG, "Starting simple MCP server");
     
-    /* Create server task */
-    BaseType_t task_ret = xTaskCreate(mcp_server_task_function, 
-                                     "mcp_server", 
-                                     server->config.task_stack_size / sizeof(StackType_t),
-                                     server, 
-                                     server->config.task_priority, 
-                                     &server->server_task);
-    if (task_ret != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create server task");
-        return ESP_ERR_NO_MEM;
+    /* Create worker tasks */
+    server->running = true;
+    for (uint32_t i = 0; i < server->worker_count; i++) {
+        char task_name[16];
+        snprintf(task_name, sizeof(task_name), "mcp_worker_%"PRIu32, i);
+        
+        if (xSemaphoreTake(server->mutex, portMAX_DELAY) == pdTRUE) {
+            server->workers_running++;
+            xSemaphoreGive(server->mutex);
+        }
+        
+        BaseType_t task_ret = xTaskCreate(mcp_server_task_function, 
+                                         task_name, 
+                                         server->config.task_stack_size / sizeof(StackType_t),
+                                         server, 
+                                         server->config.task_priority, 
+                                         &server->workers[i]);
+        if (task_ret != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create worker task %"PRIu32, i);
+            if (xSemaphoreTake(server->mutex, portMAX_DELAY) == pdTRUE) {
+                server->workers_running--;
+                xSemaphoreGive(server->mutex);
+            }
+            server->workers[i] = NULL;
+            mcp_server_stop(server);
+            return ESP_ERR_NO_MEM;
+        }
     }
     
-    server->running = true;
-    ESP_LOGI(TAG, "Simple MCP server started successfully");
+    ESP_LOGI(TAG, "Simple MCP server started successfully (%"PRIu32" workers)", server->worker_count);
     ESP_LOGI(TAG, "Available tools: echo, display_control, gpio_control, system_info");
     
     return ESP_OK;
@@ -192,11 +479,28 @@ esp_err_t mcp_server_stop(mcp_server_handle_t server_handle)
     
     server->running = false;
     
-    /* Delete task */
-    if (server->server_task) {
-        vTaskDelete(server->server_task);
-        server->server_task = NULL;
+    /* Wake every worker with a NULL envelope; queued requests ahead of it
+     * complete with ESP_ERR_INVALID_STATE */
+    for (uint32_t i = 0; i < server->worker_count; i++) {
+        if (server->workers[i]) {
+            mcp_message_t* stop = NULL;
+            xQueueSend(server->queue, &stop, pdMS_TO_TICKS(100));
+        }
+    }
+    
+    /* Wait for the workers to exit */
+    for (int wait = 0; wait < 100; wait++) {
+        uint32_t running = 1;
+        if (xSemaphoreTake(server->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            running = server->workers_running;
+            xSemaphoreGive(server->mutex);
+        }
+        if (running == 0) {
+            break;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
     }
+    memset(server->workers, 0, sizeof(server->workers));
     
     ESP_LOGI(TAG, "Simple MCP server stopped");
     return ESP_OK;
@@ -218,11 +522,32 @@ esp_err_t mcp_server_deinit(mcp_server_handle_t server_handle)
     
     ESP_LOGI(TAG, "Deinitializing simple MCP server");
     
+    /* Complete anything still queued, then release the queue */
+    mcp_message_t* msg;
+    char empty[1] = "";
+    while (xQueueReceive(server->queue, &msg, 0) == pdTRUE) {
+        if (msg) {
+            msg->on_complete(msg, empty, 0, ESP_ERR_INVALID_STATE);
+            free(msg);
+        }
+    }
+    vQueueDelete(server->queue);
+    
     /* Cleanup synchronization objects */
     if (server->mutex) {
         vSemaphoreDelete(server->mutex);
     }
     
+    /* Release the tool registry, result cache, subscriptions, method index,
+     * metrics and request arenas */
+    mcp_tool_registry_deinit(&server->tools);
+    mcp_result_cache_deinit(&server->cache);
+    mcp_subscriptions_deinit(&server->subscriptions);
+    mcp_resources_deinit(&server->resources);
+    mcp_dispatch_deinit(&server->method_index);
+    free(server->method_metrics);
+    mcp_arena_pool_deinit(&server->arenas);
+    
     /* Free server structure */
     free(server);
     
@@ -239,15 +564,73 @@ esp_err_t mcp_server_get_stats(mcp_server_handle_t server_handle,
     }
     
     struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    mcp_server_counters_t* c = &server->counters;
     
-    if (xSemaphoreTake(server->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        memcpy(stats, &server->stats, sizeof(mcp_server_stats_t));
-        stats->uptime_ms = (esp_timer_get_time() - server->start_time) / 1000;
-        xSemaphoreGive(server->mutex);
-        return ESP_OK;
+    /* Copy the counters between two quiescent points with the same epoch */
+    uint64_t wait_total_us;
+    uint32_t wait_samples;
+    for (uint32_t attempt = 0; ; attempt++) {
+        unsigned int epoch = atomic_load(&c->epoch);
+        if (atomic_load(&c->writers) == 0) {
+            memset(stats, 0, sizeof(mcp_server_stats_t));
+            stats->messages_received = atomic_load(&c->messages_received);
+            stats->messages_sent = atomic_load(&c->messages_sent);
+            stats->requests_processed = atomic_load(&c->requests_processed);
+            stats->errors_count = atomic_load(&c->errors_count);
+            stats->tools_executed = atomic_load(&c->tools_executed);
+            stats->cache_hits = atomic_load(&c->cache_hits);
+            stats->cache_misses = atomic_load(&c->cache_misses);
+            stats->notifications_sent = atomic_load(&c->notifications_sent);
+            stats->requests_cancelled = atomic_load(&c->requests_cancelled);
+            stats->requests_expired = atomic_load(&c->requests_expired);
+            stats->work_saved_us = atomic_load(&c->work_saved_us);
+            stats->queue_depth_max = atomic_load(&c->queue_depth_max);
+            stats->queue_rejected = atomic_load(&c->queue_rejected);
+            stats->queue_wait_max_us = atomic_load(&c->queue_wait_max_us);
+            wait_samples = atomic_load(&c->queue_wait_samples);
+            wait_total_us = atomic_load(&c->queue_wait_total_us);
+            if (atomic_load(&c->writers) == 0 && atomic_load(&c->epoch) == epoch) {
+                break;
+            }
+        }
+        if (attempt >= 8) {
+            /* Let the updating tasks run instead of spinning against them */
+            vTaskDelay(1);
+        }
+    }
+    
+    stats->uptime_ms = (esp_timer_get_time() - server->start_time) / 1000;
+    stats->queue_depth = uxQueueMessagesWaiting(server->queue);
+    stats->queue_wait_avg_us = wait_samples ? (uint32_t)(wait_total_us / wait_samples) : 0;
+    stats->cache_bytes = mcp_result_cache_bytes(&server->cache);
+    
+    /* Aggregate arena usage */
+    stats->arena_high_water = 0;
+    stats->arena_fallbacks = 0;
+    for (uint32_t i = 0; i < server->arenas.arena_count; i++) {
+        mcp_arena_stats_t arena_stats;
+        if (mcp_arena_pool_get_stats(&server->arenas, i, &arena_stats) == ESP_OK) {
+            if (arena_stats.high_water > stats->arena_high_water) {
+                stats->arena_high_water = arena_stats.high_water;
+            }
+            stats->arena_fallbacks += arena_stats.fallback_count;
+        }
+    }
+    
+    return ESP_OK;
+}
+
+/* Get statistics for one request arena */
+esp_err_t mcp_server_get_arena_stats(mcp_server_handle_t server_handle,
+                                     uint32_t index,
+                                     mcp_arena_stats_t* stats)
+{
+    if (!server_handle || !stats) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    return ESP_ERR_TIMEOUT;
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    return mcp_arena_pool_get_stats(&server->arenas, index, stats);
 }
 
 /* Check if server is running */
@@ -261,6 +644,30 @@ bool mcp_server_is_running(mcp_server_handle_t server_handle)
     return server->running;
 }
 
+/* Default deadline of a message received at the given time */
+static int64_t mcp_default_deadline(struct mcp_server_simple* server, int64_t received_us)
+{
+    uint32_t timeout_ms = server->config.request_timeout_ms;
+    return timeout_ms ? received_us + (int64_t)timeout_ms * 1000 : 0;
+}
+
+/* Check whether a message contains a string, without parsing it */
+static bool mcp_mentions(const char* data, size_t len, const char* needle)
+{
+    size_t needle_len = strlen(needle);
+    const char* end = data + len;
+    for (const char* p = data; (size_t)(end - p) >= needle_len; p++) {
+        p = memchr(p, needle[0], (end - p) - needle_len + 1);
+        if (!p) {
+            return false;
+        }
+        if (memcmp(p, needle, needle_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /* Process a single line of input */
 esp_err_t mcp_server_process_line(mcp_server_handle_t server_handle,
                                   const char* input_line,
@@ -272,235 +679,1572 @@ esp_err_t mcp_server_process_line(mcp_server_handle_t server_handle,
     }
     
     struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
-    
+    int64_t now = esp_timer_get_time();
+    mcp_request_ctx_t ctx = {
+        .server = server,
+        .request_id = atomic_fetch_add(&server->next_message_id, 1),
+        .received_us = now,
+        .default_deadline_us = mcp_default_deadline(server, now),
+        .received_epoch = atomic_load(&server->cancel_epoch),
+    };
+    size_t output_len;
+    return mcp_process_message(server, input_line, strlen(input_line),
+                               output_buffer, output_size, &output_len, &ctx);
+}
+
+/* Handle one message on behalf of a client, in the encoding given by the context */
+static esp_err_t mcp_process_message(struct mcp_server_simple* server,
+                                     const char* input, size_t input_len,
+                                     char* output_buffer, size_t output_size,
+                                     size_t* output_len, mcp_request_ctx_t* ctx)
+{
+    *output_len = 0;
     if (!server->running) {
         return ESP_ERR_INVALID_STATE;
     }
     
-    ESP_LOGD(TAG, "Processing line: %s", input_line);
+    if (ctx->format == MCP_WIRE_JSON) {
+        ESP_LOGD(TAG, "Processing line: %.*s", (int)input_len, input);
+    } else {
+        ESP_LOGD(TAG, "Processing CBOR message of %u bytes", (unsigned)input_len);
+    }
     
-    /* Update statistics */
-    if (xSemaphoreTake(server->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        server->stats.messages_received++;
-        xSemaphoreGive(server->mutex);
+    mcp_json_writer_t writer;
+    mcp_json_writer_init(&writer, output_buffer, output_size);
+    mcp_json_writer_set_format(&writer, ctx->format);
+    
+    /* Bound the message (single request or whole batch) before tokenizing it */
+    if (input_len > server->config.max_message_size) {
+        ESP_LOGW(TAG, "Message of %u bytes exceeds limit", (unsigned)input_len);
+        stats_begin(server);
+        atomic_fetch_add(&server->counters.messages_received, 1);
+        atomic_fetch_add(&server->counters.errors_count, 1);
+        stats_end(server);
+        esp_err_t ret = mcp_write_error(&writer, NULL, -1, MCP_ERROR_INVALID_REQUEST, "Message too large");
+        *output_len = mcp_json_writer_length(&writer);
+        return ret;
+    }
+    
+    /* Bind a request arena; if all are busy, allocations fall back to the heap */
+    mcp_arena_t* arena = mcp_arena_pool_acquire(&server->arenas);
+    mcp_arena_bind(arena);
+    
+    /* Handle the message, serializing the response straight into the output buffer */
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+    uint32_t handled = 0;
+    esp_err_t ret;
+    if (ctx->format == MCP_WIRE_CBOR) {
+        ret = mcp_handle_cbor_message(server, (const uint8_t*)input, input_len,
+                                      &writer, &handled, ctx);
+    } else {
+        ret = mcp_handle_message(server, input, input_len, &writer, &handled, ctx);
+    }
+    
+    /* Everything allocated for the message is released at once */
+    mcp_arena_bind(NULL);
+    mcp_arena_pool_release(&server->arenas, arena);
+    
+    /* A truncated response would corrupt the stream; report the failure instead */
+    if (writer.overflow) {
+        mcp_json_writer_init(&writer, output_buffer, output_size);
+        mcp_json_writer_set_format(&writer, ctx->format);
+        if (ctx->reject_code) {
+            mcp_write_rejection(&writer, NULL, -1, ctx);
+        } else {
+            mcp_write_error(&writer, NULL, -1, MCP_ERROR_INTERNAL, "Response too large");
+        }
     }
+    *output_len = mcp_json_writer_length(&writer);
     
-    /* Handle the request */
-    esp_err_t ret = mcp_handle_request(server, input_line, output_buffer, output_size);
+    ESP_LOGD(TAG, "Response: %u bytes, %"PRIu32" requests, %"PRIu32" cycles",
+             (unsigned)mcp_json_writer_length(&writer), handled,
+             esp_cpu_get_cycle_count() - start_cycles);
     
+    /* Account for the whole message in one update */
+    stats_begin(server);
+    atomic_fetch_add(&server->counters.messages_received, 1);
     if (ret == ESP_OK) {
-        if (xSemaphoreTake(server->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            server->stats.messages_sent++;
-            server->stats.requests_processed++;
-            xSemaphoreGive(server->mutex);
+        if (mcp_json_writer_length(&writer) > 0) {
+            atomic_fetch_add(&server->counters.messages_sent, 1);
         }
-    } else {
-        if (xSemaphoreTake(server->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            server->stats.errors_count++;
-            xSemaphoreGive(server->mutex);
+        if (!ctx->reject_code) {
+            atomic_fetch_add(&server->counters.requests_processed, handled);
         }
+    } else {
+        atomic_fetch_add(&server->counters.errors_count, 1);
     }
+    stats_end(server);
     
     return ret;
 }
 
-/* Register built-in tools */
-static esp_err_t mcp_register_builtin_tools(struct mcp_server_simple* server)
+/* Answer a message without executing it */
+esp_err_t mcp_server_reject(mcp_server_handle_t server_handle,
+                            uint32_t client_id,
+                            const char* request,
+                            size_t request_len,
+                            mcp_wire_format_t format,
+                            int code,
+                            const char* message,
+                            uint32_t retry_after_ms,
+                            char* output_buffer,
+                            size_t output_size,
+                            size_t* output_len)
 {
-    server->tool_count = 0;
-    
-    /* Register echo tool */
-    if (server->config.enable_echo_tool) {
-        mcp_tool_def_t* tool = &server->tools[server->tool_count++];
-        tool->name = "echo";
-        tool->description = "Echo back the input parameters";
-        tool->type = MCP_TOOL_ECHO;
-        tool->execute = mcp_tool_echo_execute;
+    if (!server_handle || !request || !message || !output_buffer || output_size == 0 || !output_len) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    /* Register display tool */
-    if (server->config.enable_display_tool) {
-        mcp_tool_def_t* tool = &server->tools[server->tool_count++];
-        tool->name = "display_control";
-        tool->description = "Control ST7789 display";
-        tool->type = MCP_TOOL_DISPLAY;
-        tool->execute = mcp_tool_display_execute;
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    mcp_request_ctx_t ctx = {
+        .server = server,
+        .client_id = client_id,
+        .request_id = atomic_fetch_add(&server->next_message_id, 1),
+        .format = format,
+        .next_format = format,
+        .reject_code = code,
+        .reject_message = message,
+        .retry_after_ms = retry_after_ms,
+    };
+    return mcp_process_message(server, request, request_len,
+                               output_buffer, output_size, output_len, &ctx);
+}
+
+/* Check whether a message must not wait behind queued requests */
+bool mcp_server_is_urgent(const char* request, size_t request_len, mcp_wire_format_t format)
+{
+    /* Most messages are ruled out without parsing them */
+    if (!request || request_len > MCP_URGENT_MAX_SIZE ||
+        !mcp_mentions(request, request_len, "notifications/cancelled")) {
+        return false;
     }
     
-    /* Register GPIO tool */
-    if (server->config.enable_gpio_tool) {
-        mcp_tool_def_t* tool = &server->tools[server->tool_count++];
-        tool->name = "gpio_control";
-        tool->description = "Control GPIO pins";
-        tool->type = MCP_TOOL_GPIO;
-        tool->execute = mcp_tool_gpio_execute;
+    /* Floats may grow when a CBOR item is written as JSON */
+    char json[2 * MCP_URGENT_MAX_SIZE];
+    if (format == MCP_WIRE_CBOR) {
+        mcp_json_writer_t decoded;
+        mcp_json_writer_init(&decoded, json, sizeof(json));
+        if (mcp_cbor_to_json((const uint8_t*)request, request_len, &decoded) != ESP_OK) {
+            return false;
+        }
+        request = json;
+        request_len = mcp_json_writer_length(&decoded);
     }
     
-    /* Register system tool */
-    if (server->config.enable_system_tool) {
-        mcp_tool_def_t* tool = &server->tools[server->tool_count++];
-        tool->name = "system_info";
-        tool->description = "Get system information";
-        tool->type = MCP_TOOL_SYSTEM;
-        tool->execute = mcp_tool_system_execute;
+    /* Only a notification (no id) whose method token is the cancellation
+     * jumps the queue, not a request that merely mentions it */
+    mcp_json_token_t tokens[MCP_URGENT_MAX_TOKENS];
+    int count = mcp_json_parse(request, request_len, tokens, MCP_URGENT_MAX_TOKENS);
+    if (count <= 0 || tokens[0].type != MCP_JSON_OBJECT) {
+        return false;
     }
-    
-    ESP_LOGI(TAG, "Registered %"PRIu32" built-in tools", server->tool_count);
-    return ESP_OK;
+    mcp_json_doc_t doc = { request, tokens, count };
+    return mcp_json_find(&doc, 0, "id") < 0 &&
+           mcp_json_eq(&doc, mcp_json_find(&doc, 0, "method"), "notifications/cancelled");
 }
 
-/* Server main task */
-static void mcp_server_task_function(void* arg)
+/* Queue a request, copied into its envelope unless borrowed */
+static esp_err_t mcp_submit_message(mcp_server_handle_t server_handle,
+                                    uint32_t client_id,
+                                    const char* request,
+                                    size_t request_len,
+                                    mcp_wire_format_t format,
+                                    mcp_completion_cb_t on_complete,
+                                    void* user_ctx,
+                                    bool borrowed)
 {
-    struct mcp_server_simple* server = (struct mcp_server_simple*)arg;
+    if (!server_handle || !request || !on_complete) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    ESP_LOGI(TAG, "Simple MCP server task started");
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
     
-    while (server->running) {
-        /* Simple task that just updates statistics */
-        if (xSemaphoreTake(server->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            server->stats.uptime_ms = (esp_timer_get_time() - server->start_time) / 1000;
-            xSemaphoreGive(server->mutex);
-        }
-        
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    if (!server->running) {
+        return ESP_ERR_INVALID_STATE;
     }
     
-    ESP_LOGI(TAG, "Simple MCP server task stopped");
-    vTaskDelete(NULL);
+    if (request_len > server->config.max_message_size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    /* Envelope and a copied request share one allocation */
+    mcp_message_t* msg = malloc(sizeof(mcp_message_t) + (borrowed ? 0 : request_len + 1));
+    if (!msg) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    msg->type = MCP_MSG_REQUEST;
+    msg->client_id = client_id;
+    msg->on_complete = on_complete;
+    msg->user_ctx = user_ctx;
+    msg->format = format;
+    msg->next_format = format;
+    msg->request_len = request_len;
+    if (borrowed) {
+        msg->request = request;
+    } else {
+        memcpy(msg->storage, request, request_len);
+        msg->storage[request_len] = '\0';
+        msg->request = msg->storage;
+    }
+    msg->enqueue_time_us = esp_timer_get_time();
+    msg->deadline_us = mcp_default_deadline(server, msg->enqueue_time_us);
+    msg->cancel_epoch = atomic_load(&server->cancel_epoch);
+    
+    msg->id = atomic_fetch_add(&server->next_message_id, 1);
+    
+    /* A cancellation must overtake the queued request it cancels */
+    msg->urgent = mcp_server_is_urgent(request, request_len, format);
+    BaseType_t queued = msg->urgent ? xQueueSendToFront(server->queue, &msg, 0)
+                                    : xQueueSend(server->queue, &msg, 0);
+    if (queued != pdTRUE) {
+        free(msg);
+        stats_begin(server);
+        atomic_fetch_add(&server->counters.queue_rejected, 1);
+        stats_end(server);
+        return ESP_ERR_TIMEOUT;
+    }
+    
+    uint32_t depth = uxQueueMessagesWaiting(server->queue);
+    mcp_trace_emit(MCP_TRACE_SUBMIT, client_id, msg->id, depth);
+    
+    stats_begin(server);
+    stats_max(&server->counters.queue_depth_max, depth);
+    stats_end(server);
+    
+    return ESP_OK;
+}
+
+/* Queue a request for asynchronous execution */
+esp_err_t mcp_server_submit(mcp_server_handle_t server_handle,
+                            uint32_t client_id,
+                            const char* request,
+                            size_t request_len,
+                            mcp_wire_format_t format,
+                            mcp_completion_cb_t on_complete,
+                            void* user_ctx)
+{
+    return mcp_submit_message(server_handle, client_id, request, request_len,
+                              format, on_complete, user_ctx, false);
+}
+
+/* Queue a request the worker reads from the caller's buffer */
+esp_err_t mcp_server_submit_borrowed(mcp_server_handle_t server_handle,
+                                     uint32_t client_id,
+                                     const char* request,
+                                     size_t request_len,
+                                     mcp_wire_format_t format,
+                                     mcp_completion_cb_t on_complete,
+                                     void* user_ctx)
+{
+    return mcp_submit_message(server_handle, client_id, request, request_len,
+                              format, on_complete, user_ctx, true);
 }
 
-/* Handle incoming request */
-static esp_err_t mcp_handle_request(struct mcp_server_simple* server, 
-                                   const char* request_json, 
-                                   char* response_json, 
-                                   size_t response_size)
+/* Get the number of requests waiting for a worker */
+uint32_t mcp_server_get_queue_depth(mcp_server_handle_t server_handle)
 {
-    cJSON* json = cJSON_Parse(request_json);
-    if (!json) {
-        ESP_LOGE(TAG, "Failed to parse JSON request");
-        return mcp_send_response(0, NULL, "Parse error", response_json, response_size);
+    if (!server_handle) {
+        return 0;
     }
     
-    cJSON* method = cJSON_GetObjectItem(json, "method");
-    cJSON* id = cJSON_GetObjectItem(json, "id");
-    cJSON* params = cJSON_GetObjectItem(json, "params");
-    
-    if (!method || !cJSON_IsString(method)) {
-        cJSON_Delete(json);
-        return mcp_send_response(0, NULL, "Missing method", response_json, response_size);
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    return server->queue ? uxQueueMessagesWaiting(server->queue) : 0;
+}
+
+/* Start a new latency metrics window */
+esp_err_t mcp_server_reset_metrics(mcp_server_handle_t server_handle)
+{
+    if (!server_handle) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    const char* method_str = cJSON_GetStringValue(method);
-    uint32_t request_id = id ? (uint32_t)cJSON_GetNumberValue(id) : 0;
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    for (size_t i = 0; i < MCP_METHOD_COUNT; i++) {
+        mcp_metrics_reset(&server->method_metrics[i]);
+    }
+    mcp_tool_registry_reset_metrics(&server->tools);
+    server->metrics_window_start = esp_timer_get_time();
+    return ESP_OK;
+}
+
+/* Register a tool at runtime */
+esp_err_t mcp_server_register_tool(mcp_server_handle_t server_handle,
+                                   const mcp_tool_def_t* tool)
+{
+    if (!server_handle || !tool) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    ESP_LOGI(TAG, "Handling method: %s, id: %"PRIu32, method_str, request_id);
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    esp_err_t ret = mcp_tool_registry_add(&server->tools, tool);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Registered tool: %s", tool->name);
+    }
+    return ret;
+}
+
+/* Remove a tool at runtime */
+esp_err_t mcp_server_unregister_tool(mcp_server_handle_t server_handle,
+                                     const char* name)
+{
+    if (!server_handle || !name) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    /* Handle different methods */
-    if (strcmp(method_str, "tools/list") == 0) {
-        /* List available tools */
-        cJSON* tools_array = cJSON_CreateArray();
-        for (uint32_t i = 0; i < server->tool_count; i++) {
-            cJSON* tool_obj = cJSON_CreateObject();
-            cJSON_AddStringToObject(tool_obj, "name", server->tools[i].name);
-            cJSON_AddStringToObject(tool_obj, "description", server->tools[i].description);
-            cJSON_AddItemToArray(tools_array, tool_obj);
-        }
-        
-        cJSON* result = cJSON_CreateObject();
-        cJSON_AddItemToObject(result, "tools", tools_array);
-        
-        char* result_str = cJSON_Print(result);
-        esp_err_t ret = mcp_send_response(request_id, result_str, NULL, response_json, response_size);
-        
-        free(result_str);
-        cJSON_Delete(result);
-        cJSON_Delete(json);
-        return ret;
-        
-    } else if (strcmp(method_str, "tools/call") == 0) {
-        /* Call tool */
-        cJSON* name = cJSON_GetObjectItem(params, "name");
-        cJSON* arguments = cJSON_GetObjectItem(params, "arguments");
-        
-        if (!name || !cJSON_IsString(name)) {
-            cJSON_Delete(json);
-            return mcp_send_response(request_id, NULL, "Missing tool name", response_json, response_size);
-        }
-        
-        const char* tool_name = cJSON_GetStringValue(name);
-        char* args_str = arguments ? cJSON_Print(arguments) : strdup("{}");
-        
-        /* Find and execute tool */
-        bool tool_found = false;
-        for (uint32_t i = 0; i < server->tool_count; i++) {
-            if (strcmp(server->tools[i].name, tool_name) == 0) {
-                char result_buffer[512];
-                esp_err_t ret = server->tools[i].execute(args_str, result_buffer, sizeof(result_buffer));
-                
-                if (ret == ESP_OK) {
-                    esp_err_t send_ret = mcp_send_response(request_id, result_buffer, NULL, response_json, response_size);
-                    if (xSemaphoreTake(server->mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                        server->stats.tools_executed++;
-                        xSemaphoreGive(server->mutex);
-                    }
-                    free(args_str);
-                    cJSON_Delete(json);
-                    return send_ret;
-                } else {
-                    free(args_str);
-                    cJSON_Delete(json);
-                    return mcp_send_response(request_id, NULL, "Tool execution failed", response_json, response_size);
-                }
-            }
-        }
-        
-        free(args_str);
-        cJSON_Delete(json);
-        return mcp_send_response(request_id, NULL, "Tool not found", response_json, response_size);
-        
-    } else {
-        /* Unknown method */
-        cJSON_Delete(json);
-        return mcp_send_response(request_id, NULL, "Unknown method", response_json, response_size);
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    esp_err_t ret = mcp_tool_registry_remove(&server->tools, name);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Unregistered tool: %s", name);
     }
+    return ret;
 }
 
-/* Send response */
-static esp_err_t mcp_send_response(uint32_t id, const char* result_json, 
-                                  const char* error_msg, char* output, size_t output_size)
+/* Set the function delivering subscription notifications */
+esp_err_t mcp_server_set_notify_handler(mcp_server_handle_t server_handle,
+                                        mcp_notify_cb_t notify,
+                                        void* user_ctx)
 {
-    cJSON* response = cJSON_CreateObject();
-    cJSON_AddStringToObject(response, "jsonrpc", "2.0");
-    cJSON_AddNumberToObject(response, "id", id);
+    if (!server_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
     
-    if (error_msg) {
-        cJSON* error = cJSON_CreateObject();
-        cJSON_AddNumberToObject(error, "code", -32000);
-        cJSON_AddStringToObject(error, "message", error_msg);
-        cJSON_AddItemToObject(response, "error", error);
-    } else if (result_json) {
-        cJSON* result = cJSON_Parse(result_json);
-        if (result) {
-            cJSON_AddItemToObject(response, "result", result);
-        } else {
-            cJSON_AddStringToObject(response, "result", result_json);
-        }
-    } else {
-        cJSON_AddNullToObject(response, "result");
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    if (xSemaphoreTake(server->mutex, portMAX_DELAY) == pdTRUE) {
+        server->notify = notify;
+        server->notify_ctx = user_ctx;
+        xSemaphoreGive(server->mutex);
+    }
+    return ESP_OK;
+}
+
+/* Publish a system statistics sample to subscribers */
+esp_err_t mcp_server_publish_sample(mcp_server_handle_t server_handle,
+                                    const mcp_system_sample_t* sample)
+{
+    if (!server_handle || !sample) {
+        return ESP_ERR_INVALID_ARG;
     }
     
-    char* response_str = cJSON_Print(response);
-    if (response_str) {
-        if (strlen(response_str) < output_size) {
-            strcpy(output, response_str);
-            free(response_str);
-            cJSON_Delete(response);
-            return ESP_OK;
-        }
-        free(response_str);
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    if (!server->running) {
+        return ESP_ERR_INVALID_STATE;
     }
     
-    cJSON_Delete(response);
-    return ESP_ERR_INVALID_SIZE;
-}
\ No newline at end of file
+    mcp_resources_set_sample(&server->resources, sample);
+    
+    mcp_notify_cb_t notify = NULL;
+    void* notify_ctx = NULL;
+    if (xSemaphoreTake(server->mutex, portMAX_DELAY) == pdTRUE) {
+        notify = server->notify;
+        notify_ctx = server->notify_ctx;
+        xSemaphoreGive(server->mutex);
+    }
+    if (!notify) {
+        return ESP_OK;
+    }
+    
+    uint32_t sent = mcp_subscriptions_publish(&server->subscriptions, sample, notify, notify_ctx);
+    if (sent > 0) {
+        stats_begin(server);
+        atomic_fetch_add(&server->counters.notifications_sent, sent);
+        stats_end(server);
+    }
+    return ESP_OK;
+}
+
+/* Add a resource readable with resources/read */
+esp_err_t mcp_server_register_resource(mcp_server_handle_t server_handle,
+                                       const mcp_resource_def_t* resource)
+{
+    if (!server_handle || !resource) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    esp_err_t ret = mcp_resources_add(&server->resources, resource);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Registered resource: %s", resource->uri);
+    }
+    return ret;
+}
+
+/* Forget the subscriptions of a closed connection */
+esp_err_t mcp_server_client_closed(mcp_server_handle_t server_handle,
+                                   uint32_t client_id)
+{
+    if (!server_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    struct mcp_server_simple* server = (struct mcp_server_simple*)server_handle;
+    mcp_subscriptions_drop_client(&server->subscriptions, client_id);
+    return ESP_OK;
+}
+
+/* Register built-in tools */
+static esp_err_t mcp_register_builtin_tools(struct mcp_server_simple* server)
+{
+    mcp_tool_def_t tools[MCP_TOOL_MAX] = {0};
+    uint32_t tool_count = 0;
+    
+    /* Register echo tool */
+    if (server->config.enable_echo_tool) {
+        mcp_tool_def_t* tool = &tools[tool_count++];
+        tool->name = "echo";
+        tool->description = "Echo back the input parameters";
+        tool->type = MCP_TOOL_ECHO;
+        tool->input_schema = MCP_TOOL_ECHO_SCHEMA;
+        tool->execute = mcp_tool_echo_execute;
+    }
+    
+    /* Register display tool */
+    if (server->config.enable_display_tool) {
+        mcp_tool_def_t* tool = &tools[tool_count++];
+        tool->name = "display_control";
+        tool->description = "Control ST7789 display";
+        tool->type = MCP_TOOL_DISPLAY;
+        tool->input_schema = MCP_TOOL_DISPLAY_SCHEMA;
+        tool->execute = mcp_tool_display_execute;
+    }
+    
+    /* Register GPIO tool */
+    if (server->config.enable_gpio_tool) {
+        mcp_tool_def_t* tool = &tools[tool_count++];
+        tool->name = "gpio_control";
+        tool->description = "Control GPIO pins";
+        tool->type = MCP_TOOL_GPIO;
+        tool->input_schema = MCP_TOOL_GPIO_SCHEMA;
+        tool->execute = mcp_tool_gpio_execute;
+    }
+    
+    /* Register system tool */
+    if (server->config.enable_system_tool) {
+        mcp_tool_def_t* tool = &tools[tool_count++];
+        tool->name = "system_info";
+        tool->description = "Get system information";
+        tool->type = MCP_TOOL_SYSTEM;
+        tool->input_schema = MCP_TOOL_SYSTEM_SCHEMA;
+        tool->execute = mcp_tool_system_execute;
+        tool->cache_ttl_ms = 1000;
+        tool->is_cacheable = mcp_tool_system_cacheable;
+    }
+    
+    /* Publish them as the registry's first table */
+    esp_err_t ret = mcp_tool_registry_init(&server->tools, tools, tool_count);
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Registered %"PRIu32" built-in tools", tool_count);
+    }
+    return ret;
+}
+
+/* Build the name index used to dispatch methods */
+static esp_err_t mcp_build_method_index(struct mcp_server_simple* server)
+{
+    server->method_metrics = calloc(MCP_METHOD_COUNT, sizeof(mcp_metrics_t));
+    if (!server->method_metrics) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    esp_err_t ret = mcp_dispatch_init(&server->method_index, MCP_METHOD_COUNT);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    for (size_t i = 0; i < MCP_METHOD_COUNT; i++) {
+        ret = mcp_dispatch_insert(&server->method_index, s_methods[i].name, (void*)&s_methods[i]);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    
+    return ESP_OK;
+}
+
+/* Worker task: execute queued requests and hand back their responses */
+static void mcp_server_task_function(void* arg)
+{
+    struct mcp_server_simple* server = (struct mcp_server_simple*)arg;
+    size_t response_size = server->config.max_message_size;
+    char* response = malloc(response_size + 1);     /* Spare byte for the transport's delimiter */
+    
+    ESP_LOGI(TAG, "MCP worker task started");
+    
+    while (response) {
+        mcp_message_t* msg = NULL;
+        if (xQueueReceive(server->queue, &msg, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (!msg) {
+            break;
+        }
+        
+        uint32_t wait_us = (uint32_t)(esp_timer_get_time() - msg->enqueue_time_us);
+        stats_begin(server);
+        atomic_fetch_add(&server->counters.queue_wait_total_us, wait_us);
+        atomic_fetch_add(&server->counters.queue_wait_samples, 1);
+        stats_max(&server->counters.queue_wait_max_us, wait_us);
+        stats_end(server);
+        
+        mcp_request_ctx_t ctx = {
+            .server = server,
+            .client_id = msg->client_id,
+            .request_id = msg->id,
+            .format = msg->format,
+            .next_format = msg->format,
+            .received_us = msg->enqueue_time_us,
+            .default_deadline_us = msg->deadline_us,
+            .received_epoch = msg->cancel_epoch,
+        };
+        size_t response_len;
+        esp_err_t ret = mcp_process_message(server, msg->request, msg->request_len,
+                                            response, response_size, &response_len, &ctx);
+        msg->next_format = ctx.next_format;
+        msg->on_complete(msg, response, response_len, ret);
+        free(msg);
+    }
+    
+    if (!response) {
+        ESP_LOGE(TAG, "Failed to allocate worker response buffer");
+    }
+    free(response);
+    
+    if (xSemaphoreTake(server->mutex, portMAX_DELAY) == pdTRUE) {
+        server->workers_running--;
+        xSemaphoreGive(server->mutex);
+    }
+    
+    ESP_LOGI(TAG, "MCP worker task stopped");
+    vTaskDelete(NULL);
+}
+
+/* Write the JSON-RPC envelope prefix: {"jsonrpc":"2.0","id":<id> */
+static void mcp_write_envelope(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int id)
+{
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_string(w, "jsonrpc", "2.0");
+    mcp_json_writer_key(w, "id");
+    mcp_json_writer_token(w, doc, id);
+}
+
+/* Write a complete JSON-RPC error response */
+static esp_err_t mcp_write_error(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int id,
+                                 int code, const char* message)
+{
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "error");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_int(w, "code", code);
+    mcp_json_writer_add_string(w, "message", message);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    return mcp_json_writer_finish(w);
+}
+
+/* Write the error refusing a request, with a hint of when to retry */
+static esp_err_t mcp_write_rejection(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int id,
+                                     const mcp_request_ctx_t* ctx)
+{
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "error");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_int(w, "code", ctx->reject_code);
+    mcp_json_writer_add_string(w, "message", ctx->reject_message);
+    mcp_json_writer_key(w, "data");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_uint(w, "retryAfterMs", ctx->retry_after_ms);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    return mcp_json_writer_finish(w);
+}
+
+/* Write an empty successful result */
+static esp_err_t mcp_write_empty_result(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int id)
+{
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "result");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    return mcp_json_writer_finish(w);
+}
+
+/* Tokenize a message and handle the single request or batch it contains */
+static esp_err_t mcp_handle_message(struct mcp_server_simple* server,
+                                   const char* json, size_t len,
+                                   mcp_json_writer_t* w, uint32_t* handled,
+                                   mcp_request_ctx_t* ctx)
+{
+    int64_t parse_start = esp_timer_get_time();
+    mcp_trace_emit(MCP_TRACE_PARSE_BEGIN, ctx->client_id, ctx->request_id, len);
+    
+    /* Most messages fit the default token budget; size larger batches exactly */
+    int capacity = MCP_JSON_MAX_TOKENS;
+    mcp_json_token_t* tokens = mcp_arena_malloc(capacity * sizeof(mcp_json_token_t));
+    if (!tokens) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    int count = mcp_json_parse(json, len, tokens, capacity);
+    if (count == MCP_JSON_ERR_NOMEM) {
+        mcp_arena_free(tokens);
+        tokens = NULL;
+        count = mcp_json_parse(json, len, NULL, 0);
+        if (count > 0) {
+            capacity = count;
+            tokens = mcp_arena_malloc(capacity * sizeof(mcp_json_token_t));
+            if (!tokens) {
+                return ESP_ERR_NO_MEM;
+            }
+            count = mcp_json_parse(json, len, tokens, capacity);
+        }
+    }
+    
+    mcp_trace_emit(MCP_TRACE_PARSE_END, ctx->client_id, ctx->request_id, count > 0 ? count : 0);
+    
+    if (count < 0) {
+        ESP_LOGE(TAG, "Failed to parse JSON request (%d)", count);
+        mcp_arena_free(tokens);
+        return mcp_write_error(w, NULL, -1, MCP_ERROR_PARSE, "Parse error");
+    }
+    
+    mcp_json_doc_t doc = {
+        .json = json,
+        .tokens = tokens,
+        .count = count,
+    };
+    uint32_t parse_us = (uint32_t)(esp_timer_get_time() - parse_start) + ctx->decode_us;
+    
+    if (mcp_json_type(&doc, 0) != MCP_JSON_ARRAY) {
+        mcp_handle_request(server, &doc, 0, parse_us, w, ctx);
+        *handled = 1;
+        mcp_arena_free(tokens);
+        return mcp_json_writer_finish(w);
+    }
+    
+    /* Batch: an empty array is a single invalid request */
+    if (tokens[0].size == 0) {
+        mcp_arena_free(tokens);
+        return mcp_write_error(w, NULL, -1, MCP_ERROR_INVALID_REQUEST, "Invalid Request");
+    }
+    
+    /* Stream one response per request into the array, skipping notifications */
+    mcp_json_writer_t empty = *w;
+    mcp_json_writer_begin_array(w);
+    size_t array_start = mcp_json_writer_length(w);
+    
+    /* Batch elements share the cost of tokenizing the message */
+    parse_us /= tokens[0].size;
+    
+    int tok = 1;
+    for (uint16_t i = 0; i < tokens[0].size; i++) {
+        mcp_json_writer_t checkpoint = *w;
+        mcp_handle_request(server, &doc, tok, parse_us, w, ctx);
+        
+        if (w->overflow) {
+            *w = checkpoint;
+            int id = mcp_json_type(&doc, tok) == MCP_JSON_OBJECT ? mcp_json_find(&doc, tok, "id") : -1;
+            mcp_write_error(w, &doc, id, MCP_ERROR_INTERNAL, "Response too large");
+        }
+        
+        (*handled)++;
+        tok = mcp_json_next(&doc, tok);
+    }
+    
+    mcp_arena_free(tokens);
+    
+    /* A batch of notifications produces no output at all */
+    if (mcp_json_writer_length(w) == array_start) {
+        *w = empty;
+        return mcp_json_writer_finish(w);
+    }
+    
+    mcp_json_writer_end_array(w);
+    return mcp_json_writer_finish(w);
+}
+
+/* Convert a CBOR message to JSON text and handle it like any other message */
+static esp_err_t mcp_handle_cbor_message(struct mcp_server_simple* server,
+                                         const uint8_t* data, size_t len,
+                                         mcp_json_writer_t* w, uint32_t* handled,
+                                         mcp_request_ctx_t* ctx)
+{
+    int64_t decode_start = esp_timer_get_time();
+    
+    /* The JSON form of a message is bounded like the message itself. Most
+     * are not much longer than their CBOR, so the text is sized from the
+     * input to fit the request arena, and only sized to the bound when
+     * that overflows. */
+    size_t limit = server->config.max_message_size + 1;
+    size_t size = MCP_CBOR_JSON_EXPANSION * len + 1;
+    if (size > limit) {
+        size = limit;
+    }
+    char* json;
+    mcp_json_writer_t decoded;
+    esp_err_t ret;
+    for (;;) {
+        json = mcp_arena_malloc(size);
+        if (!json) {
+            return ESP_ERR_NO_MEM;
+        }
+        mcp_json_writer_init(&decoded, json, size);
+        ret = mcp_cbor_to_json(data, len, &decoded);
+        if (ret != ESP_ERR_INVALID_SIZE || size == limit) {
+            break;
+        }
+        mcp_arena_free(json);
+        size = limit;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to decode CBOR request (%s)", esp_err_to_name(ret));
+        mcp_arena_free(json);
+        if (ret == ESP_ERR_INVALID_SIZE) {
+            return mcp_write_error(w, NULL, -1, MCP_ERROR_INVALID_REQUEST, "Message too large");
+        }
+        return mcp_write_error(w, NULL, -1, MCP_ERROR_PARSE, "Parse error");
+    }
+    ctx->decode_us = (uint32_t)(esp_timer_get_time() - decode_start);
+    
+    ret = mcp_handle_message(server, json, mcp_json_writer_length(&decoded), w, handled, ctx);
+    mcp_arena_free(json);
+    return ret;
+}
+
+/* Hash a request id as written on the wire; never 0 so 0 can mean "no id" */
+static uint32_t mcp_id_hash(const mcp_json_doc_t* doc, int id)
+{
+    size_t len;
+    const char* raw = mcp_json_raw(doc, id, &len);
+    uint32_t hash = mcp_dispatch_hash(raw, len);
+    return hash ? hash : 1;
+}
+
+/* Remember that a client cancelled one of its requests */
+static void mcp_cancel_record(struct mcp_server_simple* server, uint32_t client_id, uint32_t id_hash)
+{
+    xSemaphoreTake(server->mutex, portMAX_DELAY);
+    mcp_cancel_entry_t* entry = &server->cancels[server->cancel_next++ % MCP_CANCEL_SLOTS];
+    entry->client_id = client_id;
+    entry->id_hash = id_hash;
+    entry->time_us = esp_timer_get_time();
+    xSemaphoreGive(server->mutex);
+    
+    atomic_fetch_add(&server->cancel_epoch, 1);
+}
+
+/* Check whether the request in the context was cancelled. Only
+ * cancellations newer than the context's epoch are looked up, so the
+ * common case costs one atomic load. */
+static bool mcp_cancel_check(struct mcp_server_simple* server, mcp_request_ctx_t* ctx)
+{
+    uint32_t epoch = atomic_load(&server->cancel_epoch);
+    if (ctx->cancelled || ctx->id_hash == 0 || epoch == ctx->cancel_epoch) {
+        return ctx->cancelled;
+    }
+    ctx->cancel_epoch = epoch;
+    
+    xSemaphoreTake(server->mutex, portMAX_DELAY);
+    for (int i = 0; i < MCP_CANCEL_SLOTS; i++) {
+        mcp_cancel_entry_t* entry = &server->cancels[i];
+        /* An id cancelled before this request arrived belongs to an earlier request */
+        if (entry->id_hash == ctx->id_hash && entry->client_id == ctx->client_id &&
+            entry->time_us >= ctx->received_us) {
+            memset(entry, 0, sizeof(*entry));
+            ctx->cancelled = true;
+            break;
+        }
+    }
+    xSemaphoreGive(server->mutex);
+    return ctx->cancelled;
+}
+
+/* Deadline of a request: the server default, which params._meta.timeoutMs
+ * (relative to arrival) may shorten */
+static int64_t mcp_request_deadline(const mcp_json_doc_t* doc, int params,
+                                    const mcp_request_ctx_t* ctx)
+{
+    uint32_t timeout_ms;
+    int meta = mcp_json_find(doc, params, "_meta");
+    if (mcp_json_get_u32(doc, mcp_json_find(doc, meta, "timeoutMs"), &timeout_ms) != ESP_OK) {
+        return ctx->default_deadline_us;
+    }
+    
+    int64_t deadline = ctx->received_us + (int64_t)timeout_ms * 1000;
+    if (ctx->default_deadline_us && ctx->default_deadline_us < deadline) {
+        return ctx->default_deadline_us;
+    }
+    return deadline;
+}
+
+/* Drop a request that was cancelled or whose deadline passed while it waited */
+static bool mcp_drop_request(struct mcp_server_simple* server, const mcp_method_def_t* def,
+                             const mcp_json_doc_t* doc, int id,
+                             mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    bool cancelled = mcp_cancel_check(server, ctx);
+    bool expired = !cancelled && ctx->deadline_us && esp_timer_get_time() >= ctx->deadline_us;
+    if (!cancelled && !expired) {
+        return false;
+    }
+    
+    /* What was saved is what the method usually takes to execute */
+    mcp_histogram_summary_t typical;
+    mcp_histogram_summarize(&server->method_metrics[def - s_methods].phases[MCP_METRICS_EXECUTE],
+                            &typical);
+    
+    stats_begin(server);
+    atomic_fetch_add(cancelled ? &server->counters.requests_cancelled
+                               : &server->counters.requests_expired, 1);
+    atomic_fetch_add(&server->counters.work_saved_us, typical.p50_us);
+    stats_end(server);
+    
+    ESP_LOGD(TAG, "Dropped %s request of client %"PRIu32" (%s)", def->name, ctx->client_id,
+             cancelled ? "cancelled" : "expired");
+    
+    /* A cancelled request gets no response (MCP cancellation) */
+    if (expired) {
+        mcp_write_error(w, doc, id, MCP_ERROR_TIMEOUT, "Request timed out");
+    }
+    return true;
+}
+
+/* Check whether the request being handled should stop */
+bool mcp_request_should_stop(void)
+{
+    mcp_request_ctx_t* ctx = pvTaskGetThreadLocalStoragePointer(NULL, MCP_REQUEST_TLS_INDEX);
+    if (!ctx) {
+        return false;
+    }
+    if (ctx->deadline_us && esp_timer_get_time() >= ctx->deadline_us) {
+        return true;
+    }
+    return mcp_cancel_check(ctx->server, ctx);
+}
+
+/* Get the time left before the deadline of the request being handled */
+int32_t mcp_request_remaining_ms(void)
+{
+    mcp_request_ctx_t* ctx = pvTaskGetThreadLocalStoragePointer(NULL, MCP_REQUEST_TLS_INDEX);
+    if (!ctx || !ctx->deadline_us) {
+        return INT32_MAX;
+    }
+    
+    int64_t remaining_ms = (ctx->deadline_us - esp_timer_get_time()) / 1000;
+    return remaining_ms < INT32_MIN ? INT32_MIN : (int32_t)remaining_ms;
+}
+
+/* Handle one request object, appending its response (if any) to the writer */
+static void mcp_handle_request(struct mcp_server_simple* server,
+                               const mcp_json_doc_t* doc, int root,
+                               uint32_t parse_us, mcp_json_writer_t* w,
+                               mcp_request_ctx_t* ctx)
+{
+    mcp_timing_t* timing = &ctx->timing;
+    mcp_timing_start(timing);
+    timing->phase_us[MCP_METRICS_PARSE] = parse_us;
+    
+    if (mcp_json_type(doc, root) != MCP_JSON_OBJECT) {
+        mcp_write_error(w, NULL, -1, MCP_ERROR_INVALID_REQUEST, "Invalid Request");
+        return;
+    }
+    
+    int jsonrpc = mcp_json_find(doc, root, "jsonrpc");
+    int method = mcp_json_find(doc, root, "method");
+    int id = mcp_json_find(doc, root, "id");
+    int params = mcp_json_find(doc, root, "params");
+    
+    if (jsonrpc >= 0 && !mcp_json_eq(doc, jsonrpc, "2.0")) {
+        mcp_write_error(w, doc, id, MCP_ERROR_INVALID_REQUEST, "Invalid Request");
+        return;
+    }
+    
+    if (mcp_json_type(doc, method) != MCP_JSON_STRING) {
+        mcp_write_error(w, doc, id, MCP_ERROR_INVALID_REQUEST, "Missing method");
+        return;
+    }
+    
+    /* Refused requests are answered without being executed */
+    if (ctx->reject_code) {
+        if (id >= 0) {
+            mcp_write_rejection(w, doc, id, ctx);
+        }
+        return;
+    }
+    
+    size_t method_len;
+    size_t id_len = 4;
+    const char* method_str = mcp_json_raw(doc, method, &method_len);
+    const char* id_str = id >= 0 ? mcp_json_raw(doc, id, &id_len) : "null";
+    
+    ESP_LOGI(TAG, "Handling method: %.*s, id: %.*s", (int)method_len, method_str, (int)id_len, id_str);
+    
+    /* Notifications (no id) are executed but never answered */
+    mcp_json_writer_t checkpoint = *w;
+    
+    ctx->deadline_us = mcp_request_deadline(doc, params, ctx);
+    ctx->id_hash = id >= 0 ? mcp_id_hash(doc, id) : 0;
+    ctx->cancel_epoch = ctx->received_epoch;
+    ctx->cancelled = false;
+    
+    /* Dispatch through the method index */
+    const mcp_method_def_t* def = mcp_dispatch_lookup_token(&server->method_index, doc, method);
+    if (!def) {
+        mcp_write_error(w, doc, id, MCP_ERROR_METHOD_NOT_FOUND, "Unknown method");
+    } else if (!mcp_drop_request(server, def, doc, id, w, ctx)) {
+        mcp_timing_lap(timing, MCP_METRICS_PARSE);
+        mcp_trace_emit(MCP_TRACE_DISPATCH_BEGIN, ctx->client_id, ctx->request_id,
+                       mcp_dispatch_hash(def->name, strlen(def->name)));
+        
+        /* Tools reach the deadline and cancellation state through the task */
+        vTaskSetThreadLocalStoragePointer(NULL, MCP_REQUEST_TLS_INDEX, ctx);
+        def->handler(server, doc, id, params, w, ctx);
+        vTaskSetThreadLocalStoragePointer(NULL, MCP_REQUEST_TLS_INDEX, NULL);
+        
+        mcp_trace_emit(MCP_TRACE_DISPATCH_END, ctx->client_id, ctx->request_id,
+                       mcp_json_writer_length(w));
+        mcp_timing_lap(timing, MCP_METRICS_SERIALIZE);
+        mcp_metrics_record(&server->method_metrics[def - s_methods], timing);
+    }
+    
+    /* Nobody is waiting for the response to a request cancelled while it ran */
+    if (id < 0 || mcp_cancel_check(server, ctx)) {
+        *w = checkpoint;
+    }
+}
+
+/* initialize: report capabilities and negotiate the session encoding. The
+ * client lists the encodings it accepts in order of preference under
+ * capabilities.experimental.encoding.accept; the first one this server
+ * speaks applies to every message after this response. */
+static esp_err_t mcp_method_initialize(struct mcp_server_simple* server,
+                                       const mcp_json_doc_t* doc, int id, int params,
+                                       mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    int capabilities = mcp_json_find(doc, params, "capabilities");
+    int experimental = mcp_json_find(doc, capabilities, "experimental");
+    int encoding = mcp_json_find(doc, experimental, "encoding");
+    int accept = mcp_json_find(doc, encoding, "accept");
+    
+    mcp_wire_format_t format = MCP_WIRE_JSON;
+    if (mcp_json_type(doc, accept) == MCP_JSON_ARRAY) {
+        int tok = accept + 1;
+        for (uint16_t i = 0; i < doc->tokens[accept].size; i++) {
+            if (mcp_json_eq(doc, tok, "cbor")) {
+                format = MCP_WIRE_CBOR;
+                break;
+            }
+            if (mcp_json_eq(doc, tok, "json")) {
+                break;
+            }
+            tok = mcp_json_next(doc, tok);
+        }
+    }
+    
+    int client_info = mcp_json_find(doc, params, "clientInfo");
+    int client_name = mcp_json_find(doc, client_info, "name");
+    size_t name_len = 7;
+    const char* name = client_name >= 0 ? mcp_json_raw(doc, client_name, &name_len) : "unknown";
+    ESP_LOGI(TAG, "Client %"PRIu32" (%.*s) initialized, encoding %s", ctx->client_id,
+             (int)name_len, name, format == MCP_WIRE_CBOR ? "cbor" : "json");
+    mcp_timing_lap(&ctx->timing, MCP_METRICS_EXECUTE);
+    
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "result");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_string(w, "protocolVersion", server->config.protocol_version);
+    
+    mcp_json_writer_key(w, "capabilities");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_key(w, "tools");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_bool(w, "listChanged", false);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_key(w, "resources");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_bool(w, "subscribe", server->notify != NULL);
+    mcp_json_writer_add_bool(w, "listChanged", false);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_key(w, "experimental");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_key(w, "encoding");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_key(w, "supported");
+    mcp_json_writer_begin_array(w);
+    mcp_json_writer_string(w, "json");
+    mcp_json_writer_string(w, "cbor");
+    mcp_json_writer_end_array(w);
+    mcp_json_writer_add_string(w, "selected", format == MCP_WIRE_CBOR ? "cbor" : "json");
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    
+    mcp_json_writer_key(w, "serverInfo");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_string(w, "name", server->config.server_name);
+    mcp_json_writer_add_string(w, "version", server->config.server_version);
+    mcp_json_writer_end_object(w);
+    
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    
+    /* The response itself still goes out in the encoding of the request */
+    ctx->next_format = format;
+    return mcp_json_writer_finish(w);
+}
+
+/* notifications/initialized: the client finished initialization */
+static esp_err_t mcp_method_initialized(struct mcp_server_simple* server,
+                                        const mcp_json_doc_t* doc, int id, int params,
+                                        mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    ESP_LOGD(TAG, "Client %"PRIu32" ready", ctx->client_id);
+    
+    /* Sent as a request by mistake: acknowledge with an empty result */
+    return mcp_write_empty_result(w, doc, id);
+}
+
+/* notifications/cancelled: the client no longer wants params.requestId.
+ * A queued request is dropped before it runs; a running one can notice
+ * through mcp_request_should_stop() and its response is discarded. */
+static esp_err_t mcp_method_cancelled(struct mcp_server_simple* server,
+                                      const mcp_json_doc_t* doc, int id, int params,
+                                      mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    int request_id = mcp_json_find(doc, params, "requestId");
+    if (request_id >= 0) {
+        mcp_cancel_record(server, ctx->client_id, mcp_id_hash(doc, request_id));
+    }
+    
+    /* Sent as a request by mistake: acknowledge with an empty result */
+    return mcp_write_empty_result(w, doc, id);
+}
+
+/* ping: liveness check */
+static esp_err_t mcp_method_ping(struct mcp_server_simple* server,
+                                 const mcp_json_doc_t* doc, int id, int params,
+                                 mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_add_string(w, "result", "pong");
+    mcp_json_writer_end_object(w);
+    return mcp_json_writer_finish(w);
+}
+
+/* tools/list: copy the cached list of available tools */
+static esp_err_t mcp_method_tools_list(struct mcp_server_simple* server,
+                                       const mcp_json_doc_t* doc, int id, int params,
+                                       mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    const mcp_tool_table_t* table = mcp_tool_registry_acquire(&server->tools);
+    mcp_timing_lap(&ctx->timing, MCP_METRICS_EXECUTE);
+    
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "result");
+    if (mcp_json_writer_format(w) == MCP_WIRE_CBOR) {
+        mcp_json_writer_encoded(w, table->tools_list_cbor, table->tools_list_cbor_len);
+    } else {
+        mcp_json_writer_encoded(w, table->tools_list, table->tools_list_len);
+    }
+    mcp_json_writer_end_object(w);
+    
+    mcp_tool_registry_release(&server->tools, table);
+    return mcp_json_writer_finish(w);
+}
+
+/* Build the result cache key of a call: tool name, NUL, response encoding,
+ * canonical arguments. Returns 0 if the call is not cacheable or the key does
+ * not fit. */
+static size_t mcp_build_cache_key(const mcp_tool_def_t* tool, const mcp_json_doc_t* doc,
+                                  int arguments, mcp_wire_format_t format,
+                                  char* buf, size_t size)
+{
+    if (!buf || tool->cache_ttl_ms == 0 ||
+        (tool->is_cacheable && !tool->is_cacheable(doc, arguments))) {
+        return 0;
+    }
+    
+    mcp_json_writer_t key;
+    mcp_json_writer_init(&key, buf, size);
+    mcp_json_writer_raw(&key, tool->name, strlen(tool->name) + 1);
+    mcp_json_writer_uint(&key, format);
+    mcp_json_writer_canonical(&key, doc, arguments);
+    return key.overflow ? 0 : mcp_json_writer_length(&key);
+}
+
+/* tools/call: find and execute a tool, letting it write its result in place */
+static esp_err_t mcp_method_tools_call(struct mcp_server_simple* server,
+                                       const mcp_json_doc_t* doc, int id, int params,
+                                       mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    /* The tool's own metrics cover only its share of the request */
+    mcp_timing_t tool_timing;
+    mcp_timing_start(&tool_timing);
+    
+    int name = mcp_json_find(doc, params, "name");
+    int arguments = mcp_json_find(doc, params, "arguments");
+    
+    if (mcp_json_type(doc, name) != MCP_JSON_STRING) {
+        return mcp_write_error(w, doc, id, MCP_ERROR_INVALID_PARAMS, "Missing tool name");
+    }
+    
+    /* The table is held only for the lookup. The copied definition stays
+     * usable while the tool is pinned: unregistering it waits for the pin. */
+    const mcp_tool_table_t* table = mcp_tool_registry_acquire(&server->tools);
+    const mcp_tool_entry_t* entry = mcp_dispatch_lookup_token(&table->index, doc, name);
+    if (!entry) {
+        mcp_tool_registry_release(&server->tools, table);
+        return mcp_write_error(w, doc, id, MCP_ERROR_INVALID_PARAMS, "Tool not found");
+    }
+    const mcp_tool_def_t tool = entry->def;
+    mcp_tool_metrics_t* metrics = mcp_tool_registry_pin(entry);
+    mcp_tool_registry_release(&server->tools, table);
+    
+    char* key = tool.cache_ttl_ms ? mcp_arena_malloc(MCP_RESULT_CACHE_KEY_MAX) : NULL;
+    size_t key_len = mcp_build_cache_key(&tool, doc, arguments, mcp_json_writer_format(w),
+                                         key, MCP_RESULT_CACHE_KEY_MAX);
+    mcp_timing_lap(&tool_timing, MCP_METRICS_PARSE);
+    
+    mcp_json_writer_t checkpoint = *w;
+    
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "result");
+    mcp_timing_lap(&tool_timing, MCP_METRICS_SERIALIZE);
+    
+    /* A hit copies the cached result; a miss makes this call the one that
+     * executes while identical concurrent calls wait for it */
+    mcp_cache_result_t cached = MCP_CACHE_BYPASS;
+    int slot = -1;
+    if (key_len > 0) {
+        cached = mcp_result_cache_begin(&server->cache, key, key_len, w, &slot);
+    }
+    mcp_arena_free(key);
+    
+    /* Tools stream their result, so its serialization counts as execution */
+    esp_err_t ret = ESP_OK;
+    if (cached != MCP_CACHE_HIT) {
+        size_t result_start = mcp_json_writer_length(w);
+        mcp_trace_emit(MCP_TRACE_TOOL_BEGIN, ctx->client_id, ctx->request_id,
+                       mcp_dispatch_hash(tool.name, strlen(tool.name)));
+        ret = tool.execute(doc, arguments, w);
+        mcp_trace_emit(MCP_TRACE_TOOL_END, ctx->client_id, ctx->request_id, (uint32_t)ret);
+        
+        if (cached == MCP_CACHE_MISS) {
+            bool ok = (ret == ESP_OK && !w->overflow);
+            mcp_result_cache_complete(&server->cache, slot, ok ? w->buf + result_start : NULL,
+                                      mcp_json_writer_length(w) - result_start,
+                                      tool.cache_ttl_ms);
+        }
+    }
+    if (cached != MCP_CACHE_BYPASS) {
+        stats_begin(server);
+        atomic_fetch_add(cached == MCP_CACHE_HIT ? &server->counters.cache_hits
+                                                 : &server->counters.cache_misses, 1);
+        stats_end(server);
+    }
+    mcp_timing_lap(&tool_timing, MCP_METRICS_EXECUTE);
+    mcp_trace_emit(MCP_TRACE_SERIALIZE_BEGIN, ctx->client_id, ctx->request_id, 0);
+    
+    if (ret != ESP_OK || w->overflow) {
+        *w = checkpoint;
+        ret = mcp_write_error(w, doc, id, MCP_ERROR_TOOL_FAILED,
+                              ret == ESP_OK ? "Response too large" : "Tool execution failed");
+    } else {
+        mcp_json_writer_end_object(w);
+        if (cached != MCP_CACHE_HIT) {
+            stats_begin(server);
+            atomic_fetch_add(&server->counters.tools_executed, 1);
+            stats_end(server);
+        }
+        ret = mcp_json_writer_finish(w);
+    }
+    mcp_trace_emit(MCP_TRACE_SERIALIZE_END, ctx->client_id, ctx->request_id,
+                   mcp_json_writer_length(w));
+    mcp_timing_lap(&tool_timing, MCP_METRICS_SERIALIZE);
+    
+    /* Fold the tool's phases into the request's */
+    mcp_metrics_record(&metrics->latency, &tool_timing);
+    mcp_tool_registry_unpin(metrics);
+    ctx->timing.mark_us = tool_timing.mark_us;
+    for (int i = 0; i < MCP_METRICS_PHASE_MAX; i++) {
+        ctx->timing.phase_us[i] += tool_timing.phase_us[i];
+    }
+    return ret;
+}
+
+/* server/metrics: latency percentiles per method and tool since the last reset */
+static esp_err_t mcp_method_server_metrics(struct mcp_server_simple* server,
+                                           const mcp_json_doc_t* doc, int id, int params,
+                                           mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    bool reset = false;
+    mcp_json_get_bool(doc, mcp_json_find(doc, params, "reset"), &reset);
+    
+    mcp_json_writer_t checkpoint = *w;
+    
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "result");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_uint(w, "window_ms",
+                             (esp_timer_get_time() - server->metrics_window_start) / 1000);
+    
+    /* Work avoided by dropping requests nobody was waiting for anymore */
+    mcp_server_stats_t stats;
+    mcp_server_get_stats(server, &stats);
+    mcp_json_writer_key(w, "dropped");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_uint(w, "cancelled", stats.requests_cancelled);
+    mcp_json_writer_add_uint(w, "expired", stats.requests_expired);
+    mcp_json_writer_add_uint(w, "work_saved_us", stats.work_saved_us);
+    mcp_json_writer_end_object(w);
+    
+    mcp_json_writer_key(w, "fields");
+    static const char fields[] = "[\"count\",\"p50_us\",\"p90_us\",\"p99_us\",\"max_us\"]";
+    mcp_json_writer_raw(w, fields, sizeof(fields) - 1);
+    
+    mcp_json_writer_key(w, "methods");
+    mcp_json_writer_begin_object(w);
+    for (size_t i = 0; i < MCP_METHOD_COUNT; i++) {
+        mcp_metrics_write(w, s_methods[i].name, &server->method_metrics[i]);
+    }
+    mcp_json_writer_end_object(w);
+    
+    mcp_json_writer_key(w, "tools");
+    mcp_json_writer_begin_object(w);
+    const mcp_tool_table_t* table = mcp_tool_registry_acquire(&server->tools);
+    for (uint32_t i = 0; i < table->count; i++) {
+        mcp_metrics_write(w, table->tools[i].def.name, &table->tools[i].metrics->latency);
+    }
+    mcp_tool_registry_release(&server->tools, table);
+    mcp_json_writer_end_object(w);
+    
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    
+    if (w->overflow) {
+        *w = checkpoint;
+        return mcp_write_error(w, doc, id, MCP_ERROR_INTERNAL, "Response too large");
+    }
+    
+    if (reset) {
+        mcp_server_reset_metrics(server);
+    }
+    return mcp_json_writer_finish(w);
+}
+
+/* Write {"<hash>":"<name>",...} so trace consumers can label dispatch/tool spans */
+static void mcp_write_trace_names(struct mcp_server_simple* server, mcp_json_writer_t* w)
+{
+    char key[11];
+    
+    mcp_json_writer_begin_object(w);
+    for (size_t i = 0; i < MCP_METHOD_COUNT; i++) {
+        snprintf(key, sizeof(key), "%"PRIu32, mcp_dispatch_hash(s_methods[i].name, strlen(s_methods[i].name)));
+        mcp_json_writer_add_string(w, key, s_methods[i].name);
+    }
+    const mcp_tool_table_t* table = mcp_tool_registry_acquire(&server->tools);
+    for (uint32_t i = 0; i < table->count; i++) {
+        const char* name = table->tools[i].def.name;
+        snprintf(key, sizeof(key), "%"PRIu32, mcp_dispatch_hash(name, strlen(name)));
+        mcp_json_writer_add_string(w, key, name);
+    }
+    mcp_tool_registry_release(&server->tools, table);
+    mcp_json_writer_end_object(w);
+}
+
+/* debug/trace_dump: page trace records out as base64 wire records */
+static esp_err_t mcp_method_trace_dump(struct mcp_server_simple* server,
+                                       const mcp_json_doc_t* doc, int id, int params,
+                                       mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    uint32_t head = mcp_trace_head();
+    uint32_t cursor = head > MCP_TRACE_CAPACITY ? head - MCP_TRACE_CAPACITY : 0;
+    uint32_t max = MCP_TRACE_CAPACITY;
+    bool names = false;
+    mcp_json_get_u32(doc, mcp_json_find(doc, params, "cursor"), &cursor);
+    mcp_json_get_u32(doc, mcp_json_find(doc, params, "max"), &max);
+    mcp_json_get_bool(doc, mcp_json_find(doc, params, "names"), &names);
+    
+    mcp_json_writer_t checkpoint = *w;
+    
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "result");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_uint(w, "version", MCP_TRACE_FORMAT_VERSION);
+    mcp_json_writer_add_uint(w, "record_size", sizeof(mcp_trace_record_t));
+    mcp_json_writer_add_uint(w, "head", head);
+    if (names) {
+        mcp_json_writer_key(w, "names");
+        mcp_write_trace_names(server, w);
+    }
+    
+    /* Fill what is left of the response, keeping room for the closing fields */
+    size_t room = mcp_json_writer_remaining(w);
+    room = room > 96 ? (room - 96) / 4 * 3 : 0;
+    if (max > room / sizeof(mcp_trace_record_t)) {
+        max = room / sizeof(mcp_trace_record_t);
+    }
+    
+    mcp_trace_record_t* records = max ? mcp_arena_malloc(max * sizeof(mcp_trace_record_t)) : NULL;
+    uint32_t next = cursor;
+    uint32_t count = records ? mcp_trace_read(cursor, records, max, &next) : 0;
+    
+    mcp_json_writer_key(w, "data");
+    mcp_json_writer_base64(w, records, count * sizeof(mcp_trace_record_t));
+    mcp_arena_free(records);
+    mcp_json_writer_add_uint(w, "next", next);
+    mcp_json_writer_add_bool(w, "more", next != head);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    
+    if (w->overflow) {
+        *w = checkpoint;
+        return mcp_write_error(w, doc, id, MCP_ERROR_INTERNAL, "Response too large");
+    }
+    return mcp_json_writer_finish(w);
+}
+
+/* Resolve the uri parameter of a subscription request, writing an error if
+ * the request cannot be served. Returns the topic, or -1 on error. */
+static int mcp_subscription_topic(struct mcp_server_simple* server,
+                                  const mcp_json_doc_t* doc, int id, int params,
+                                  mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    if (ctx->client_id == 0 || !server->notify) {
+        mcp_write_error(w, doc, id, MCP_ERROR_INVALID_REQUEST, "Subscriptions need a connection");
+        return -1;
+    }
+    
+    int uri = mcp_json_find(doc, params, "uri");
+    if (mcp_json_type(doc, uri) != MCP_JSON_STRING) {
+        mcp_write_error(w, doc, id, MCP_ERROR_INVALID_PARAMS, "Missing uri");
+        return -1;
+    }
+    
+    size_t uri_len;
+    const char* uri_str = mcp_json_raw(doc, uri, &uri_len);
+    int topic = mcp_topic_from_uri(uri_str, uri_len);
+    if (topic < 0) {
+        mcp_write_error(w, doc, id, MCP_ERROR_INVALID_PARAMS, "Unknown resource");
+    }
+    return topic;
+}
+
+/* resources/subscribe: push changes of a system value to this connection.
+ * Optional minIntervalMs bounds the notification rate and minDelta ignores
+ * smaller changes. */
+static esp_err_t mcp_method_subscribe(struct mcp_server_simple* server,
+                                      const mcp_json_doc_t* doc, int id, int params,
+                                      mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    int topic = mcp_subscription_topic(server, doc, id, params, w, ctx);
+    if (topic < 0) {
+        return mcp_json_writer_finish(w);
+    }
+    
+    uint32_t min_interval_ms = MCP_SUBSCRIPTION_DEFAULT_INTERVAL_MS;
+    uint32_t min_delta = 0;
+    mcp_json_get_u32(doc, mcp_json_find(doc, params, "minIntervalMs"), &min_interval_ms);
+    mcp_json_get_u32(doc, mcp_json_find(doc, params, "minDelta"), &min_delta);
+    
+    esp_err_t ret = mcp_subscriptions_add(&server->subscriptions, ctx->client_id,
+                                          (mcp_topic_t)topic, min_interval_ms, min_delta);
+    mcp_timing_lap(&ctx->timing, MCP_METRICS_EXECUTE);
+    if (ret != ESP_OK) {
+        return mcp_write_error(w, doc, id, MCP_ERROR_INTERNAL, "Too many subscriptions");
+    }
+    
+    ESP_LOGI(TAG, "Client %"PRIu32" subscribed to %s every %"PRIu32" ms", ctx->client_id,
+             mcp_topic_uri((mcp_topic_t)topic), min_interval_ms);
+    return mcp_write_empty_result(w, doc, id);
+}
+
+/* resources/unsubscribe: stop pushing a system value to this connection */
+static esp_err_t mcp_method_unsubscribe(struct mcp_server_simple* server,
+                                        const mcp_json_doc_t* doc, int id, int params,
+                                        mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    int topic = mcp_subscription_topic(server, doc, id, params, w, ctx);
+    if (topic < 0) {
+        return mcp_json_writer_finish(w);
+    }
+    
+    esp_err_t ret = mcp_subscriptions_remove(&server->subscriptions, ctx->client_id,
+                                             (mcp_topic_t)topic);
+    mcp_timing_lap(&ctx->timing, MCP_METRICS_EXECUTE);
+    if (ret != ESP_OK) {
+        return mcp_write_error(w, doc, id, MCP_ERROR_INVALID_PARAMS, "Not subscribed");
+    }
+    return mcp_write_empty_result(w, doc, id);
+}
+
+/* resources/list: the resources readable with resources/read */
+static esp_err_t mcp_method_resources_list(struct mcp_server_simple* server,
+                                           const mcp_json_doc_t* doc, int id, int params,
+                                           mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "result");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_key(w, "resources");
+    mcp_json_writer_begin_array(w);
+    
+    mcp_resource_def_t def;
+    for (uint32_t i = 0; mcp_resources_get(&server->resources, i, &def); i++) {
+        mcp_json_writer_begin_object(w);
+        mcp_json_writer_add_string(w, "uri", def.uri);
+        mcp_json_writer_add_string(w, "name", def.name);
+        if (def.description) {
+            mcp_json_writer_add_string(w, "description", def.description);
+        }
+        mcp_json_writer_add_string(w, "mimeType", def.mime_type ? def.mime_type : "text/plain");
+        mcp_json_writer_end_object(w);
+    }
+    
+    mcp_json_writer_end_array(w);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    return mcp_json_writer_finish(w);
+}
+
+/* Decode a resources/read cursor: the decimal content offset of the next chunk */
+static bool mcp_parse_cursor(const mcp_json_doc_t* doc, int tok, uint32_t* offset)
+{
+    char text[12];
+    if (mcp_json_get_string(doc, tok, text, sizeof(text)) != ESP_OK ||
+        text[0] < '0' || text[0] > '9') {
+        return false;
+    }
+    
+    char* end;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (*end != '\0' || value > UINT32_MAX) {
+        return false;
+    }
+    *offset = (uint32_t)value;
+    return true;
+}
+
+/* Shorten a text chunk so that it does not end inside a UTF-8 sequence */
+static size_t mcp_utf8_boundary(const uint8_t* text, size_t len)
+{
+    size_t i = len;
+    while (i > 0 && len - i < 3 && (text[i - 1] & 0xC0) == 0x80) {
+        i--;
+    }
+    if (i == 0) {
+        return len;
+    }
+    
+    /* text[i - 1] leads the last sequence; drop it if incomplete */
+    uint8_t lead = text[i - 1];
+    size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    if (len - (i - 1) >= need || i == 1) {
+        return len;
+    }
+    return i - 1;
+}
+
+/* Write a resources/read response carrying one chunk */
+static esp_err_t mcp_write_resource_chunk(mcp_json_writer_t* w, const mcp_json_doc_t* doc, int id,
+                                          const mcp_resource_def_t* def, uint32_t offset,
+                                          const uint8_t* data, size_t len, bool eof)
+{
+    mcp_write_envelope(w, doc, id);
+    mcp_json_writer_key(w, "result");
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_key(w, "contents");
+    mcp_json_writer_begin_array(w);
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_string(w, "uri", def->uri);
+    mcp_json_writer_add_string(w, "mimeType", def->mime_type ? def->mime_type : "text/plain");
+    if (def->binary) {
+        mcp_json_writer_key(w, "blob");
+        mcp_json_writer_base64(w, data, len);
+    } else {
+        mcp_json_writer_key(w, "text");
+        mcp_json_writer_string_n(w, (const char*)data, len);
+    }
+    mcp_json_writer_add_uint(w, "offset", offset);
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_array(w);
+    if (!eof) {
+        char cursor[12];
+        snprintf(cursor, sizeof(cursor), "%"PRIu32, offset + (uint32_t)len);
+        mcp_json_writer_add_string(w, "nextCursor", cursor);
+    }
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    return mcp_json_writer_finish(w);
+}
+
+/* resources/read: one chunk of a resource. The cursor of the previous
+ * chunk continues the read; maxBytes caps the chunk size. A chunk is
+ * shortened further until the response fits the output buffer; if not
+ * even one byte (or character) fits, the read fails rather than return
+ * an empty chunk that would not advance the cursor. */
+static esp_err_t mcp_method_resources_read(struct mcp_server_simple* server,
+                                           const mcp_json_doc_t* doc, int id, int params,
+                                           mcp_json_writer_t* w, mcp_request_ctx_t* ctx)
+{
+    int uri = mcp_json_find(doc, params, "uri");
+    if (mcp_json_type(doc, uri) != MCP_JSON_STRING) {
+        return mcp_write_error(w, doc, id, MCP_ERROR_INVALID_PARAMS, "Missing uri");
+    }
+    
+    size_t uri_len;
+    const char* uri_str = mcp_json_raw(doc, uri, &uri_len);
+    mcp_resource_def_t def;
+    if (!mcp_resources_find(&server->resources, uri_str, uri_len, &def)) {
+        return mcp_write_error(w, doc, id, MCP_ERROR_INVALID_PARAMS, "Unknown resource");
+    }
+    
+    uint32_t offset = 0;
+    int cursor = mcp_json_find(doc, params, "cursor");
+    if (cursor >= 0 && !mcp_parse_cursor(doc, cursor, &offset)) {
+        return mcp_write_error(w, doc, id, MCP_ERROR_INVALID_PARAMS, "Invalid cursor");
+    }
+    
+    uint32_t max_bytes = MCP_RESOURCE_CHUNK_MAX;
+    mcp_json_get_u32(doc, mcp_json_find(doc, params, "maxBytes"), &max_bytes);
+    if (max_bytes == 0 || max_bytes > MCP_RESOURCE_CHUNK_MAX) {
+        max_bytes = MCP_RESOURCE_CHUNK_MAX;
+    }
+    
+    /* Too large for the worker's stack */
+    uint8_t* chunk = mcp_arena_malloc(max_bytes);
+    if (!chunk) {
+        return mcp_write_error(w, doc, id, MCP_ERROR_INTERNAL, "Out of memory");
+    }
+    
+    size_t len = 0;
+    bool eof = false;
+    esp_err_t ret = mcp_resource_read(&def, offset, chunk, max_bytes, &len, &eof);
+    mcp_timing_lap(&ctx->timing, MCP_METRICS_EXECUTE);
+    if (ret != ESP_OK) {
+        mcp_arena_free(chunk);
+        ESP_LOGW(TAG, "Reading %s failed: %s", def.uri, esp_err_to_name(ret));
+        return mcp_write_error(w, doc, id, MCP_ERROR_INTERNAL, "Resource read failed");
+    }
+    
+    if (!def.binary && !eof) {
+        len = mcp_utf8_boundary(chunk, len);
+    }
+    mcp_json_writer_t start = *w;
+    ret = mcp_write_resource_chunk(w, doc, id, &def, offset, chunk, len, eof);
+    while (ret == ESP_ERR_INVALID_SIZE) {
+        *w = start;
+        len /= 2;
+        eof = false;
+        if (!def.binary) {
+            len = mcp_utf8_boundary(chunk, len);
+        }
+        if (len == 0) {
+            ret = mcp_write_error(w, doc, id, MCP_ERROR_INTERNAL, "Response too large");
+            break;
+        }
+        ret = mcp_write_resource_chunk(w, doc, id, &def, offset, chunk, len, eof);
+    }
+    mcp_arena_free(chunk);
+    return ret;
+}
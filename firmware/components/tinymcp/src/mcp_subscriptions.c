@@ -0,0 +1,210 @@
+/**
+ * @file mcp_subscriptions.c
+ * @brief Client subscriptions to system values pushed as notifications
+ */
+
+#include "mcp_subscriptions.h"
+
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mcp_json_writer.h"
+
+static const char* TAG = "MCP_SUBS";
+
+static const char* s_topic_uris[MCP_TOPIC_MAX] = {
+    "system://heap",
+    "system://heap/min",
+    "system://uptime",
+    "system://wifi/rssi",
+    "system://button/presses",
+};
+
+/* Notification waiting to be sent once the table is unlocked */
+typedef struct {
+    uint32_t client_id;
+    uint8_t topic;
+    int64_t value;
+} pending_notification_t;
+
+/* Value of a topic in a sample */
+int64_t mcp_topic_value(const mcp_system_sample_t* sample, mcp_topic_t topic)
+{
+    switch (topic) {
+        case MCP_TOPIC_HEAP:     return sample->free_heap;
+        case MCP_TOPIC_HEAP_MIN: return sample->min_free_heap;
+        case MCP_TOPIC_UPTIME:   return sample->uptime_seconds;
+        case MCP_TOPIC_RSSI:     return sample->wifi_rssi;
+        case MCP_TOPIC_BUTTONS:  return sample->button_presses;
+        default:                 return 0;
+    }
+}
+
+/* Create an empty subscription table */
+esp_err_t mcp_subscriptions_init(mcp_subscriptions_t* subs)
+{
+    memset(subs, 0, sizeof(*subs));
+    subs->lock = xSemaphoreCreateMutex();
+    return subs->lock ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+/* Free a subscription table */
+void mcp_subscriptions_deinit(mcp_subscriptions_t* subs)
+{
+    if (subs->lock) {
+        vSemaphoreDelete(subs->lock);
+    }
+    memset(subs, 0, sizeof(*subs));
+}
+
+/* Look up a topic by URI */
+int mcp_topic_from_uri(const char* uri, size_t len)
+{
+    for (int i = 0; i < MCP_TOPIC_MAX; i++) {
+        if (strlen(s_topic_uris[i]) == len && memcmp(s_topic_uris[i], uri, len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/* Get the URI of a topic */
+const char* mcp_topic_uri(mcp_topic_t topic)
+{
+    return topic < MCP_TOPIC_MAX ? s_topic_uris[topic] : "";
+}
+
+/* Subscribe a client to a topic, or update its existing subscription */
+esp_err_t mcp_subscriptions_add(mcp_subscriptions_t* subs, uint32_t client_id,
+                                mcp_topic_t topic, uint32_t min_interval_ms,
+                                uint32_t min_delta)
+{
+    xSemaphoreTake(subs->lock, portMAX_DELAY);
+    
+    mcp_subscription_t* slot = NULL;
+    for (int i = 0; i < MCP_SUBSCRIPTION_MAX; i++) {
+        mcp_subscription_t* entry = &subs->entries[i];
+        if (entry->client_id == client_id && entry->topic == topic) {
+            slot = entry;
+            break;
+        }
+        if (!slot && entry->client_id == 0) {
+            slot = entry;
+        }
+    }
+    
+    if (slot) {
+        /* A renewed subscription gets the current value again */
+        slot->client_id = client_id;
+        slot->topic = (uint8_t)topic;
+        slot->primed = false;
+        slot->min_interval_ms = min_interval_ms;
+        slot->min_delta = min_delta;
+    }
+    
+    xSemaphoreGive(subs->lock);
+    return slot ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+/* Remove a client's subscription to a topic */
+esp_err_t mcp_subscriptions_remove(mcp_subscriptions_t* subs, uint32_t client_id,
+                                   mcp_topic_t topic)
+{
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    
+    xSemaphoreTake(subs->lock, portMAX_DELAY);
+    for (int i = 0; i < MCP_SUBSCRIPTION_MAX; i++) {
+        mcp_subscription_t* entry = &subs->entries[i];
+        if (entry->client_id == client_id && entry->topic == topic) {
+            memset(entry, 0, sizeof(*entry));
+            ret = ESP_OK;
+            break;
+        }
+    }
+    xSemaphoreGive(subs->lock);
+    return ret;
+}
+
+/* Remove every subscription of a client */
+void mcp_subscriptions_drop_client(mcp_subscriptions_t* subs, uint32_t client_id)
+{
+    if (client_id == 0) {
+        return;
+    }
+    
+    xSemaphoreTake(subs->lock, portMAX_DELAY);
+    for (int i = 0; i < MCP_SUBSCRIPTION_MAX; i++) {
+        if (subs->entries[i].client_id == client_id) {
+            memset(&subs->entries[i], 0, sizeof(subs->entries[i]));
+        }
+    }
+    xSemaphoreGive(subs->lock);
+}
+
+/* Deliver a sample to the subscriptions it concerns */
+uint32_t mcp_subscriptions_publish(mcp_subscriptions_t* subs,
+                                   const mcp_system_sample_t* sample,
+                                   mcp_notify_cb_t notify, void* user_ctx)
+{
+    pending_notification_t pending[MCP_SUBSCRIPTION_MAX];
+    int count = 0;
+    int64_t now = esp_timer_get_time();
+    
+    /* Decide what is due while locked; send after releasing the lock */
+    xSemaphoreTake(subs->lock, portMAX_DELAY);
+    for (int i = 0; i < MCP_SUBSCRIPTION_MAX; i++) {
+        mcp_subscription_t* entry = &subs->entries[i];
+        if (entry->client_id == 0) {
+            continue;
+        }
+        
+        int64_t value = mcp_topic_value(sample, (mcp_topic_t)entry->topic);
+        int64_t delta = value > entry->last_value ? value - entry->last_value : entry->last_value - value;
+        bool due = !entry->primed ||
+                   (delta != 0 && delta >= entry->min_delta &&
+                    now - entry->last_sent_us >= (int64_t)entry->min_interval_ms * 1000);
+        if (!due) {
+            continue;
+        }
+        
+        entry->primed = true;
+        entry->last_value = value;
+        entry->last_sent_us = now;
+        pending[count].client_id = entry->client_id;
+        pending[count].topic = entry->topic;
+        pending[count].value = value;
+        count++;
+    }
+    xSemaphoreGive(subs->lock);
+    
+    uint32_t sent = 0;
+    char message[MCP_SUBSCRIPTION_NOTIFY_MAX];
+    for (int i = 0; i < count; i++) {
+        mcp_json_writer_t w;
+        mcp_json_writer_init(&w, message, sizeof(message));
+        mcp_json_writer_begin_object(&w);
+        mcp_json_writer_add_string(&w, "jsonrpc", "2.0");
+        mcp_json_writer_add_string(&w, "method", "notifications/resources/updated");
+        mcp_json_writer_key(&w, "params");
+        mcp_json_writer_begin_object(&w);
+        mcp_json_writer_add_string(&w, "uri", s_topic_uris[pending[i].topic]);
+        mcp_json_writer_add_int(&w, "value", pending[i].value);
+        mcp_json_writer_add_uint(&w, "uptime_s", sample->uptime_seconds);
+        mcp_json_writer_end_object(&w);
+        mcp_json_writer_end_object(&w);
+        if (mcp_json_writer_finish(&w) != ESP_OK) {
+            continue;
+        }
+        
+        esp_err_t ret = notify(pending[i].client_id, message, mcp_json_writer_length(&w), user_ctx);
+        if (ret == ESP_OK) {
+            sent++;
+        } else if (ret == ESP_ERR_NOT_FOUND) {
+            /* The connection is gone; stop publishing to it */
+            ESP_LOGD(TAG, "Dropping subscriptions of closed client %lu",
+                     (unsigned long)pending[i].client_id);
+            mcp_subscriptions_drop_client(subs, pending[i].client_id);
+        }
+    }
+    return sent;
+}
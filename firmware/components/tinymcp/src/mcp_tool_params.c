@@ -0,0 +1,467 @@
+/**
+ * @file mcp_tool_params.c
+ * @brief Typed parameters and results of the built-in MCP tools
+ *
+ * Tool arguments are decoded once, from the tokens of the request, into
+ * the parameter structures of mcp_tools.h. Tools then work on plain C
+ * values instead of looking arguments up by name.
+ */
+
+#include "mcp_tools.h"
+
+#include <string.h>
+#include "esp_log.h"
+
+static const char* TAG = "MCP_PARAMS";
+
+/* Action names, indexed by the action enums */
+static const char* s_display_actions[MCP_DISPLAY_ACTION_MAX] = {
+    "show_text", "clear", "set_brightness", "draw_rect", "draw_pixel", "get_info", "refresh",
+};
+
+static const char* s_gpio_actions[MCP_GPIO_ACTION_MAX] = {
+    "set_led", "read_button", "get_status", "set_pin", "read_pin", "config_pin",
+};
+
+static const char* s_system_actions[MCP_SYSTEM_ACTION_MAX] = {
+    "get_info", "get_stats", "get_memory", "get_tasks", "restart", "factory_reset",
+};
+
+static const char* s_status_actions[MCP_STATUS_ACTION_MAX] = {
+    "get_health", "get_sensors", "get_connections", "run_diagnostics",
+};
+
+/* Record the offending parameter and fail */
+static esp_err_t invalid(const char** invalid_param, const char* name)
+{
+    if (invalid_param) {
+        *invalid_param = name;
+    }
+    ESP_LOGD(TAG, "Invalid parameter: %s", name);
+    return ESP_ERR_INVALID_ARG;
+}
+
+/* Decode the action argument; default_action < 0 makes it required */
+static esp_err_t parse_action(const mcp_json_doc_t* doc, int args,
+                              const char* const* names, int count,
+                              int default_action, int* action)
+{
+    int tok = mcp_json_find(doc, args, "action");
+    if (tok < 0) {
+        *action = default_action;
+        return default_action < 0 ? ESP_ERR_INVALID_ARG : ESP_OK;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        if (mcp_json_eq(doc, tok, names[i])) {
+            *action = i;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+/* Optional arguments: absent leaves the default, present must be well-formed */
+static bool parse_bool(const mcp_json_doc_t* doc, int args, const char* key, bool* value)
+{
+    int tok = mcp_json_find(doc, args, key);
+    return tok < 0 || mcp_json_get_bool(doc, tok, value) == ESP_OK;
+}
+
+static bool parse_int(const mcp_json_doc_t* doc, int args, const char* key, int* value)
+{
+    int tok = mcp_json_find(doc, args, key);
+    if (tok < 0) {
+        return true;
+    }
+    
+    int32_t v;
+    if (mcp_json_get_int(doc, tok, &v) != ESP_OK) {
+        return false;
+    }
+    *value = (int)v;
+    return true;
+}
+
+static bool parse_color(const mcp_json_doc_t* doc, int args, const char* key,
+                        mcp_display_color_t* color)
+{
+    int tok = mcp_json_find(doc, args, key);
+    if (tok < 0) {
+        return true;
+    }
+    
+    uint32_t v;
+    if (mcp_json_get_u32(doc, tok, &v) != ESP_OK || v > 0xFFFF) {
+        return false;
+    }
+    *color = (mcp_display_color_t)v;
+    return true;
+}
+
+/* Name of an action, "unknown" if out of range */
+static const char* action_name(const char* const* names, int count, int action)
+{
+    return action >= 0 && action < count ? names[action] : "unknown";
+}
+
+const char* mcp_tool_display_action_name(mcp_display_action_t action)
+{
+    return action_name(s_display_actions, MCP_DISPLAY_ACTION_MAX, action);
+}
+
+const char* mcp_tool_gpio_action_name(mcp_gpio_action_t action)
+{
+    return action_name(s_gpio_actions, MCP_GPIO_ACTION_MAX, action);
+}
+
+const char* mcp_tool_system_action_name(mcp_system_action_t action)
+{
+    return action_name(s_system_actions, MCP_SYSTEM_ACTION_MAX, action);
+}
+
+/* Decode display tool arguments into their parameter structure */
+esp_err_t mcp_tool_display_parse_params(const mcp_json_doc_t* doc, int args,
+                                        mcp_display_params_t* params, const char** invalid_param)
+{
+    if (!doc || !params) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(params, 0, sizeof(*params));
+    params->color = MCP_COLOR_WHITE;
+    params->bg_color = MCP_COLOR_BLACK;
+    params->brightness = MCP_DISPLAY_BRIGHTNESS_MAX;
+    
+    int action;
+    if (parse_action(doc, args, s_display_actions, MCP_DISPLAY_ACTION_MAX, -1, &action) != ESP_OK) {
+        return invalid(invalid_param, "action");
+    }
+    params->action = (mcp_display_action_t)action;
+    
+    int text = mcp_json_find(doc, args, "text");
+    if (text >= 0 || params->action == MCP_DISPLAY_ACTION_SHOW_TEXT) {
+        if (mcp_json_get_string(doc, text, params->text, sizeof(params->text)) != ESP_OK) {
+            return invalid(invalid_param, "text");
+        }
+    }
+    
+    if (!parse_int(doc, args, "x", &params->x)) {
+        return invalid(invalid_param, "x");
+    }
+    if (!parse_int(doc, args, "y", &params->y)) {
+        return invalid(invalid_param, "y");
+    }
+    if (!parse_int(doc, args, "width", &params->width)) {
+        return invalid(invalid_param, "width");
+    }
+    if (!parse_int(doc, args, "height", &params->height)) {
+        return invalid(invalid_param, "height");
+    }
+    if (!parse_color(doc, args, "color", &params->color)) {
+        return invalid(invalid_param, "color");
+    }
+    if (!parse_color(doc, args, "bg_color", &params->bg_color)) {
+        return invalid(invalid_param, "bg_color");
+    }
+    if (!parse_int(doc, args, "brightness", &params->brightness)) {
+        return invalid(invalid_param, "brightness");
+    }
+    return ESP_OK;
+}
+
+/* Decode GPIO tool arguments into their parameter structure */
+esp_err_t mcp_tool_gpio_parse_params(const mcp_json_doc_t* doc, int args,
+                                     mcp_gpio_params_t* params, const char** invalid_param)
+{
+    if (!doc || !params) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(params, 0, sizeof(*params));
+    params->pin = MCP_GPIO_LED;
+    
+    int action;
+    if (parse_action(doc, args, s_gpio_actions, MCP_GPIO_ACTION_MAX, -1, &action) != ESP_OK) {
+        return invalid(invalid_param, "action");
+    }
+    params->action = (mcp_gpio_action_t)action;
+    
+    /* set_led needs the state; elsewhere it is optional */
+    int state = mcp_json_find(doc, args, "state");
+    if (state >= 0 || params->action == MCP_GPIO_ACTION_SET_LED) {
+        if (mcp_json_get_bool(doc, state, &params->state) != ESP_OK) {
+            return invalid(invalid_param, "state");
+        }
+    }
+    
+    int pin = (int)params->pin;
+    if (!parse_int(doc, args, "pin", &pin)) {
+        return invalid(invalid_param, "pin");
+    }
+    params->pin = (mcp_gpio_pin_t)pin;
+    
+    if (!parse_int(doc, args, "mode", &params->mode)) {
+        return invalid(invalid_param, "mode");
+    }
+    if (!parse_int(doc, args, "pull_mode", &params->pull_mode)) {
+        return invalid(invalid_param, "pull_mode");
+    }
+    return ESP_OK;
+}
+
+/* Decode system tool arguments into their parameter structure */
+esp_err_t mcp_tool_system_parse_params(const mcp_json_doc_t* doc, int args,
+                                       mcp_system_params_t* params, const char** invalid_param)
+{
+    if (!doc || !params) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(params, 0, sizeof(*params));
+    
+    int action;
+    if (parse_action(doc, args, s_system_actions, MCP_SYSTEM_ACTION_MAX,
+                     MCP_SYSTEM_ACTION_GET_INFO, &action) != ESP_OK) {
+        return invalid(invalid_param, "action");
+    }
+    params->action = (mcp_system_action_t)action;
+    
+    if (!parse_bool(doc, args, "include_tasks", &params->include_tasks)) {
+        return invalid(invalid_param, "include_tasks");
+    }
+    if (!parse_bool(doc, args, "include_memory", &params->include_memory)) {
+        return invalid(invalid_param, "include_memory");
+    }
+    if (!parse_bool(doc, args, "force_restart", &params->force_restart)) {
+        return invalid(invalid_param, "force_restart");
+    }
+    return ESP_OK;
+}
+
+/* Decode status tool arguments into their parameter structure */
+esp_err_t mcp_tool_status_parse_params(const mcp_json_doc_t* doc, int args,
+                                       mcp_status_params_t* params, const char** invalid_param)
+{
+    if (!doc || !params) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    memset(params, 0, sizeof(*params));
+    
+    int action;
+    if (parse_action(doc, args, s_status_actions, MCP_STATUS_ACTION_MAX, -1, &action) != ESP_OK) {
+        return invalid(invalid_param, "action");
+    }
+    params->action = (mcp_status_action_t)action;
+    
+    if (!parse_bool(doc, args, "include_sensors", &params->include_sensors)) {
+        return invalid(invalid_param, "include_sensors");
+    }
+    if (!parse_bool(doc, args, "run_full_diagnostics", &params->run_full_diagnostics)) {
+        return invalid(invalid_param, "run_full_diagnostics");
+    }
+    return ESP_OK;
+}
+
+/* Validate display tool parameters */
+esp_err_t mcp_tool_display_validate_params(const mcp_display_params_t* params, const char** invalid_param)
+{
+    if (!params) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    switch (params->action) {
+        case MCP_DISPLAY_ACTION_SHOW_TEXT:
+        case MCP_DISPLAY_ACTION_CLEAR:
+        case MCP_DISPLAY_ACTION_GET_INFO:
+            break;
+        default:
+            if (invalid_param) {
+                *invalid_param = "action";
+            }
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    if (params->x < 0 || params->x >= MCP_DISPLAY_WIDTH) {
+        return invalid(invalid_param, "x");
+    }
+    if (params->y < 0 || params->y >= MCP_DISPLAY_HEIGHT) {
+        return invalid(invalid_param, "y");
+    }
+    if (params->width < 0 || params->width > MCP_DISPLAY_WIDTH - params->x) {
+        return invalid(invalid_param, "width");
+    }
+    if (params->height < 0 || params->height > MCP_DISPLAY_HEIGHT - params->y) {
+        return invalid(invalid_param, "height");
+    }
+    if (params->brightness < 0 || params->brightness > MCP_DISPLAY_BRIGHTNESS_MAX) {
+        return invalid(invalid_param, "brightness");
+    }
+    return ESP_OK;
+}
+
+/* Validate GPIO tool parameters */
+esp_err_t mcp_tool_gpio_validate_params(const mcp_gpio_params_t* params, const char** invalid_param)
+{
+    if (!params) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    switch (params->action) {
+        case MCP_GPIO_ACTION_SET_LED:
+        case MCP_GPIO_ACTION_READ_BUTTON:
+        case MCP_GPIO_ACTION_GET_STATUS:
+            break;
+        default:
+            if (invalid_param) {
+                *invalid_param = "action";
+            }
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    /* Only the LED and the button are exposed; the display pins are off limits */
+    if (params->pin != MCP_GPIO_LED && params->pin != MCP_GPIO_BUTTON) {
+        return invalid(invalid_param, "pin");
+    }
+    return ESP_OK;
+}
+
+/* Validate system tool parameters */
+esp_err_t mcp_tool_system_validate_params(const mcp_system_params_t* params, const char** invalid_param)
+{
+    if (!params) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    switch (params->action) {
+        case MCP_SYSTEM_ACTION_GET_INFO:
+        case MCP_SYSTEM_ACTION_GET_STATS:
+        case MCP_SYSTEM_ACTION_RESTART:
+            return ESP_OK;
+        default:
+            if (invalid_param) {
+                *invalid_param = "action";
+            }
+            return ESP_ERR_NOT_SUPPORTED;
+    }
+}
+
+/* Validate status tool parameters */
+esp_err_t mcp_tool_status_validate_params(const mcp_status_params_t* params, const char** invalid_param)
+{
+    if (!params) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    if ((unsigned)params->action >= MCP_STATUS_ACTION_MAX) {
+        return invalid(invalid_param, "action");
+    }
+    return ESP_OK;
+}
+
+/* Result formatting: {"status":..,"message":..,"data":{..}} into a buffer */
+static void begin_result(mcp_json_writer_t* w, char* buf, size_t size,
+                         bool success, const char* message)
+{
+    mcp_json_writer_init(w, buf, size);
+    mcp_json_writer_begin_object(w);
+    mcp_json_writer_add_string(w, "status", success ? "success" : "error");
+    if (message) {
+        mcp_json_writer_add_string(w, "message", message);
+    }
+    mcp_json_writer_key(w, "data");
+    mcp_json_writer_begin_object(w);
+}
+
+static esp_err_t end_result(mcp_json_writer_t* w)
+{
+    mcp_json_writer_end_object(w);
+    mcp_json_writer_end_object(w);
+    return mcp_json_writer_finish(w);
+}
+
+/* Format display tool result to JSON */
+esp_err_t mcp_tool_display_format_result(const mcp_display_result_t* result,
+                                         char* result_json,
+                                         size_t result_size)
+{
+    if (!result || !result_json) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    mcp_json_writer_t w;
+    begin_result(&w, result_json, result_size, result->success, result->message);
+    mcp_json_writer_add_int(&w, "width", result->display_width);
+    mcp_json_writer_add_int(&w, "height", result->display_height);
+    mcp_json_writer_add_int(&w, "brightness", result->brightness);
+    mcp_json_writer_add_bool(&w, "backlight_on", result->backlight_on);
+    return end_result(&w);
+}
+
+/* Format GPIO tool result to JSON */
+esp_err_t mcp_tool_gpio_format_result(const mcp_gpio_result_t* result,
+                                      char* result_json,
+                                      size_t result_size)
+{
+    if (!result || !result_json) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    mcp_json_writer_t w;
+    begin_result(&w, result_json, result_size, result->success, result->message);
+    mcp_json_writer_add_bool(&w, "pin_state", result->pin_state);
+    mcp_json_writer_add_int(&w, "pin_value", result->pin_value);
+    mcp_json_writer_add_bool(&w, "button_pressed", result->button_pressed);
+    mcp_json_writer_add_uint(&w, "button_count", result->button_count);
+    return end_result(&w);
+}
+
+/* Format system tool result to JSON */
+esp_err_t mcp_tool_system_format_result(const mcp_system_result_t* result,
+                                        char* result_json,
+                                        size_t result_size)
+{
+    if (!result || !result_json) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    mcp_json_writer_t w;
+    begin_result(&w, result_json, result_size, result->success, result->message);
+    if (result->chip_model) {
+        mcp_json_writer_add_string(&w, "chip_model", result->chip_model);
+    }
+    if (result->idf_version) {
+        mcp_json_writer_add_string(&w, "idf_version", result->idf_version);
+    }
+    mcp_json_writer_add_uint(&w, "free_heap", result->free_heap);
+    mcp_json_writer_add_uint(&w, "min_free_heap", result->min_free_heap);
+    mcp_json_writer_add_uint(&w, "uptime_ms", result->uptime_ms);
+    mcp_json_writer_add_uint(&w, "reset_reason", result->reset_reason);
+    mcp_json_writer_key(&w, "cpu_freq_mhz");
+    mcp_json_writer_double(&w, result->cpu_freq_mhz);
+    return end_result(&w);
+}
+
+/* Format status tool result to JSON */
+esp_err_t mcp_tool_status_format_result(const mcp_status_result_t* result,
+                                        char* result_json,
+                                        size_t result_size)
+{
+    if (!result || !result_json) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    mcp_json_writer_t w;
+    begin_result(&w, result_json, result_size, result->success, result->message);
+    if (result->health_status) {
+        mcp_json_writer_add_string(&w, "health", result->health_status);
+    }
+    mcp_json_writer_key(&w, "temperature");
+    mcp_json_writer_double(&w, result->temperature);
+    mcp_json_writer_add_uint(&w, "error_count", result->error_count);
+    mcp_json_writer_add_bool(&w, "display_ok", result->display_ok);
+    mcp_json_writer_add_bool(&w, "gpio_ok", result->gpio_ok);
+    mcp_json_writer_add_bool(&w, "memory_ok", result->memory_ok);
+    return end_result(&w);
+}
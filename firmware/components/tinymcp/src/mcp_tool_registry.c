@@ -0,0 +1,304 @@
+/**
+ * @file mcp_tool_registry.c
+ * @brief Read-mostly tool registry implementation
+ */
+
+#include "mcp_tool_registry.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "freertos/task.h"
+#include "mcp_json_writer.h"
+
+static const char *TAG = "MCP_TOOLS";
+
+/* Serialize the tools/list result for a table in one encoding */
+static esp_err_t build_tools_list(mcp_tool_table_t* table, mcp_wire_format_t format,
+                                  char** out, size_t* out_len)
+{
+    size_t size = 512;
+    
+    for (;;) {
+        char* buf = malloc(size);
+        if (!buf) {
+            return ESP_ERR_NO_MEM;
+        }
+        
+        mcp_json_writer_t w;
+        mcp_json_writer_init(&w, buf, size);
+        mcp_json_writer_set_format(&w, format);
+        mcp_json_writer_begin_object(&w);
+        mcp_json_writer_key(&w, "tools");
+        mcp_json_writer_begin_array(&w);
+        for (uint32_t i = 0; i < table->count; i++) {
+            const mcp_tool_def_t* tool = &table->tools[i].def;
+            mcp_json_writer_begin_object(&w);
+            mcp_json_writer_add_string(&w, "name", tool->name);
+            mcp_json_writer_add_string(&w, "description", tool->description);
+            mcp_json_writer_key(&w, "inputSchema");
+            if (tool->input_schema) {
+                mcp_json_writer_raw(&w, tool->input_schema, strlen(tool->input_schema));
+            } else {
+                mcp_json_writer_raw(&w, "{\"type\":\"object\"}", 17);
+            }
+            mcp_json_writer_end_object(&w);
+        }
+        mcp_json_writer_end_array(&w);
+        mcp_json_writer_end_object(&w);
+        
+        if (mcp_json_writer_finish(&w) == ESP_OK) {
+            *out = buf;
+            *out_len = mcp_json_writer_length(&w);
+            return ESP_OK;
+        }
+        
+        free(buf);
+        size *= 2;
+    }
+}
+
+static void table_free(mcp_tool_table_t* table)
+{
+    if (table) {
+        for (uint32_t i = 0; i < table->count; i++) {
+            if (table->tools[i].metrics) {
+                mcp_tool_registry_unpin(table->tools[i].metrics);
+            }
+        }
+        mcp_dispatch_deinit(&table->index);
+        free(table->tools_list);
+        free(table->tools_list_cbor);
+        free(table);
+    }
+}
+
+/* Drop a reference to a table, freeing it with the last one */
+static void table_release(mcp_tool_table_t* table)
+{
+    if (atomic_fetch_sub(&table->refs, 1) == 1) {
+        table_free(table);
+    }
+}
+
+/* Build a complete table: the tools of 'base' except 'skip', followed by
+ * 'defs', plus the name index and tools/list cache. Carried-over tools keep
+ * their metrics, referenced by this table too; new tools get fresh ones.
+ * The caller holds the table's only reference. */
+static esp_err_t table_create(const mcp_tool_table_t* base, const char* skip,
+                              const mcp_tool_def_t* defs, uint32_t def_count,
+                              mcp_tool_table_t** out)
+{
+    uint32_t capacity = (base ? base->count : 0) + def_count;
+    mcp_tool_table_t* table = calloc(1, sizeof(mcp_tool_table_t) + capacity * sizeof(mcp_tool_entry_t));
+    if (!table) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    atomic_init(&table->refs, 1);
+    for (uint32_t i = 0; base && i < base->count; i++) {
+        if (skip && strcmp(base->tools[i].def.name, skip) == 0) {
+            continue;
+        }
+        table->tools[table->count] = base->tools[i];
+        mcp_tool_registry_pin(&table->tools[table->count++]);
+    }
+    
+    esp_err_t ret = ESP_OK;
+    for (uint32_t i = 0; i < def_count; i++) {
+        mcp_tool_entry_t* entry = &table->tools[table->count++];
+        entry->def = defs[i];
+        entry->metrics = calloc(1, sizeof(mcp_tool_metrics_t));
+        if (!entry->metrics) {
+            ret = ESP_ERR_NO_MEM;
+            continue;
+        }
+        atomic_init(&entry->metrics->refs, 1);
+    }
+    
+    if (ret == ESP_OK) {
+        ret = mcp_dispatch_init(&table->index, table->count);
+    }
+    for (uint32_t i = 0; ret == ESP_OK && i < table->count; i++) {
+        ret = mcp_dispatch_insert(&table->index, table->tools[i].def.name, &table->tools[i]);
+        if (ret == ESP_ERR_INVALID_STATE) {
+            ESP_LOGE(TAG, "Duplicate tool name: %s", table->tools[i].def.name);
+        }
+    }
+    if (ret == ESP_OK) {
+        ret = build_tools_list(table, MCP_WIRE_JSON, &table->tools_list, &table->tools_list_len);
+    }
+    if (ret == ESP_OK) {
+        ret = build_tools_list(table, MCP_WIRE_CBOR, &table->tools_list_cbor,
+                               &table->tools_list_cbor_len);
+    }
+    if (ret != ESP_OK) {
+        table_free(table);
+        return ret;
+    }
+    
+    *out = table;
+    return ESP_OK;
+}
+
+/* Swap in a new table and drop the registry's reference on the old one */
+static void publish(mcp_tool_registry_t* registry, mcp_tool_table_t* table)
+{
+    mcp_tool_table_t* old = atomic_exchange(&registry->table, table);
+    
+    /* A reader counts itself as pinning before loading the pointer, so
+     * once the old phase drains after the exchange, every reader of the old
+     * table holds a reference on it. Readers arriving meanwhile use the
+     * other phase and load the new table. */
+    unsigned phase = atomic_fetch_xor(&registry->phase, 1) & 1;
+    while (atomic_load(&registry->pinning[phase]) != 0) {
+        vTaskDelay(1);
+    }
+    
+    if (old) {
+        table_release(old);
+    }
+    ESP_LOGI(TAG, "Published %"PRIu32" tools (tools/list %u bytes, %u as CBOR)",
+             table->count, (unsigned)table->tools_list_len, (unsigned)table->tools_list_cbor_len);
+}
+
+/* Create a registry holding an initial set of tools */
+esp_err_t mcp_tool_registry_init(mcp_tool_registry_t* registry,
+                                 const mcp_tool_def_t* tools, uint32_t count)
+{
+    if (!registry || (count && !tools)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    atomic_init(&registry->pinning[0], 0);
+    atomic_init(&registry->pinning[1], 0);
+    atomic_init(&registry->phase, 0);
+    atomic_init(&registry->table, NULL);
+    
+    registry->write_lock = xSemaphoreCreateMutex();
+    if (!registry->write_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    mcp_tool_table_t* table;
+    esp_err_t ret = table_create(NULL, NULL, tools, count, &table);
+    if (ret != ESP_OK) {
+        vSemaphoreDelete(registry->write_lock);
+        registry->write_lock = NULL;
+        return ret;
+    }
+    
+    publish(registry, table);
+    return ESP_OK;
+}
+
+/* Free a registry */
+void mcp_tool_registry_deinit(mcp_tool_registry_t* registry)
+{
+    if (!registry) {
+        return;
+    }
+    
+    mcp_tool_table_t* table = atomic_exchange(&registry->table, NULL);
+    table_free(table);
+    if (registry->write_lock) {
+        vSemaphoreDelete(registry->write_lock);
+        registry->write_lock = NULL;
+    }
+}
+
+/* Publish a table with one tool added */
+esp_err_t mcp_tool_registry_add(mcp_tool_registry_t* registry, const mcp_tool_def_t* tool)
+{
+    if (!registry || !tool || !tool->name || !tool->execute) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(registry->write_lock, portMAX_DELAY);
+    
+    /* Writers are serialized, so the current table cannot change under us */
+    const mcp_tool_table_t* current = atomic_load(&registry->table);
+    mcp_tool_table_t* table;
+    esp_err_t ret = table_create(current, NULL, tool, 1, &table);
+    if (ret == ESP_OK) {
+        publish(registry, table);
+    }
+    
+    xSemaphoreGive(registry->write_lock);
+    return ret;
+}
+
+/* Publish a table with one tool removed */
+esp_err_t mcp_tool_registry_remove(mcp_tool_registry_t* registry, const char* name)
+{
+    if (!registry || !name) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(registry->write_lock, portMAX_DELAY);
+    
+    const mcp_tool_table_t* current = atomic_load(&registry->table);
+    const mcp_tool_entry_t* entry = mcp_dispatch_lookup(&current->index, name, strlen(name));
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    if (entry) {
+        mcp_tool_metrics_t* metrics = mcp_tool_registry_pin(entry);
+        mcp_tool_table_t* table;
+        ret = table_create(current, name, NULL, 0, &table);
+        if (ret == ESP_OK) {
+            publish(registry, table);
+            
+            /* Older tables still in use and running calls hold the rest of
+             * the references; the last call ends before the last table goes */
+            while (atomic_load(&metrics->refs) > 1) {
+                vTaskDelay(1);
+            }
+        }
+        mcp_tool_registry_unpin(metrics);
+    }
+    
+    xSemaphoreGive(registry->write_lock);
+    return ret;
+}
+
+/* Take a reference on the current table */
+const mcp_tool_table_t* mcp_tool_registry_acquire(mcp_tool_registry_t* registry)
+{
+    unsigned phase = atomic_load(&registry->phase) & 1;
+    atomic_fetch_add(&registry->pinning[phase], 1);
+    mcp_tool_table_t* table = atomic_load(&registry->table);
+    atomic_fetch_add(&table->refs, 1);
+    atomic_fetch_sub(&registry->pinning[phase], 1);
+    return table;
+}
+
+/* Drop a reference taken by mcp_tool_registry_acquire */
+void mcp_tool_registry_release(mcp_tool_registry_t* registry, const mcp_tool_table_t* table)
+{
+    table_release((mcp_tool_table_t*)table);
+}
+
+/* Keep a tool's metrics after releasing the table it was found in */
+mcp_tool_metrics_t* mcp_tool_registry_pin(const mcp_tool_entry_t* entry)
+{
+    atomic_fetch_add(&entry->metrics->refs, 1);
+    return entry->metrics;
+}
+
+/* Drop a pin taken by mcp_tool_registry_pin */
+void mcp_tool_registry_unpin(mcp_tool_metrics_t* metrics)
+{
+    if (atomic_fetch_sub(&metrics->refs, 1) == 1) {
+        free(metrics);
+    }
+}
+
+/* Clear the metrics of every registered tool */
+void mcp_tool_registry_reset_metrics(mcp_tool_registry_t* registry)
+{
+    const mcp_tool_table_t* table = mcp_tool_registry_acquire(registry);
+    for (uint32_t i = 0; i < table->count; i++) {
+        mcp_metrics_reset(&table->tools[i].metrics->latency);
+    }
+    mcp_tool_registry_release(registry, table);
+}
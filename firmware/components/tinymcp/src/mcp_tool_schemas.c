@@ -0,0 +1,75 @@
+/**
+ * @file mcp_tool_schemas.c
+ * @brief JSON Schemas describing the arguments of the built-in MCP tools
+ *
+ * The schemas are compact JSON literals kept in flash and are emitted
+ * verbatim as each tool's inputSchema in the tools/list response.
+ */
+
+#include "mcp_tools.h"
+
+const char* MCP_TOOL_ECHO_SCHEMA =
+    "{\"type\":\"object\","
+    "\"description\":\"Any arguments; they are echoed back\","
+    "\"additionalProperties\":true}";
+
+const char* MCP_TOOL_DISPLAY_SCHEMA =
+    "{\"type\":\"object\","
+    "\"properties\":{"
+        "\"action\":{\"type\":\"string\",\"enum\":[\"show_text\",\"clear\",\"get_info\"]},"
+        "\"text\":{\"type\":\"string\",\"maxLength\":127,\"description\":\"Text for show_text\"}"
+    "},"
+    "\"required\":[\"action\"]}";
+
+const char* MCP_TOOL_GPIO_SCHEMA =
+    "{\"type\":\"object\","
+    "\"properties\":{"
+        "\"action\":{\"type\":\"string\",\"enum\":[\"set_led\",\"read_button\",\"get_status\"]},"
+        "\"state\":{\"type\":\"boolean\",\"description\":\"LED state for set_led\"}"
+    "},"
+    "\"required\":[\"action\"]}";
+
+const char* MCP_TOOL_SYSTEM_SCHEMA =
+    "{\"type\":\"object\","
+    "\"properties\":{"
+        "\"action\":{\"type\":\"string\",\"enum\":[\"get_info\",\"get_stats\",\"restart\"],\"default\":\"get_info\"}"
+    "}}";
+
+const char* MCP_TOOL_STATUS_SCHEMA =
+    "{\"type\":\"object\","
+    "\"properties\":{"
+        "\"action\":{\"type\":\"string\",\"enum\":[\"get_health\",\"get_sensors\",\"get_connections\",\"run_diagnostics\"]},"
+        "\"include_sensors\":{\"type\":\"boolean\"},"
+        "\"run_full_diagnostics\":{\"type\":\"boolean\"}"
+    "},"
+    "\"required\":[\"action\"]}";
+
+/* Get echo tool schema as JSON string */
+const char* mcp_tool_echo_get_schema(void)
+{
+    return MCP_TOOL_ECHO_SCHEMA;
+}
+
+/* Get display tool schema as JSON string */
+const char* mcp_tool_display_get_schema(void)
+{
+    return MCP_TOOL_DISPLAY_SCHEMA;
+}
+
+/* Get GPIO tool schema as JSON string */
+const char* mcp_tool_gpio_get_schema(void)
+{
+    return MCP_TOOL_GPIO_SCHEMA;
+}
+
+/* Get system tool schema as JSON string */
+const char* mcp_tool_system_get_schema(void)
+{
+    return MCP_TOOL_SYSTEM_SCHEMA;
+}
+
+/* Get status tool schema as JSON string */
+const char* mcp_tool_status_get_schema(void)
+{
+    return MCP_TOOL_STATUS_SCHEMA;
+}
@@ -1,12 +1,15 @@
 /**
  * @file mcp_tools_simple.c
  * @brief Simple MCP Tools Implementation for ESP32-C6
- * 
+ *
  * This file implements the basic MCP tools for ESP32-C6,
  * providing echo, display, GPIO, and system functionality.
  */
 
 #include "mcp_server_simple.h"
+#include "mcp_tools.h"
+#include "mcp_json.h"
+#include "mcp_json_writer.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -20,7 +23,6 @@
 #include "esp_heap_caps.h"
 #include "esp_idf_version.h"
 #include "driver/gpio.h"
-#include "cJSON.h"
 
 static const char *TAG = "MCP_TOOLS";
 
@@ -28,283 +30,288 @@ static const char *TAG = "MCP_TOOLS";
 extern void* get_display_handle(void);
 extern uint32_t get_button_press_count(void);
 
-/* Helper function to create JSON result */
-static esp_err_t create_json_result(const char* status, const char* message, 
-                                   cJSON* data, char* result_json, size_t result_size)
+/* Helper function to open a result object: {"status":..,"message":..,"data":{ */
+static void begin_json_result(mcp_json_writer_t* out, const char* status, const char* message)
 {
-    cJSON* result = cJSON_CreateObject();
-    if (!result) {
-        return ESP_ERR_NO_MEM;
-    }
-    
-    cJSON_AddStringToObject(result, "status", status ? status : "success");
+    mcp_json_writer_begin_object(out);
+    mcp_json_writer_add_string(out, "status", status ? status : "success");
     if (message) {
-        cJSON_AddStringToObject(result, "message", message);
-    }
-    if (data) {
-        cJSON_AddItemToObject(result, "data", data);
-    }
-    
-    char* result_str = cJSON_Print(result);
-    if (!result_str) {
-        cJSON_Delete(result);
-        return ESP_ERR_NO_MEM;
+        mcp_json_writer_add_string(out, "message", message);
     }
-    
-    if (strlen(result_str) >= result_size) {
-        free(result_str);
-        cJSON_Delete(result);
-        return ESP_ERR_INVALID_SIZE;
-    }
-    
-    strcpy(result_json, result_str);
-    free(result_str);
-    cJSON_Delete(result);
-    
-    return ESP_OK;
+    mcp_json_writer_key(out, "data");
+    mcp_json_writer_begin_object(out);
+}
+
+/* Helper function to close a result object opened with begin_json_result */
+static esp_err_t end_json_result(mcp_json_writer_t* out)
+{
+    mcp_json_writer_end_object(out);
+    mcp_json_writer_end_object(out);
+    return out->overflow ? ESP_ERR_INVALID_SIZE : ESP_OK;
+}
+
+/* Helper function to write an error result without data */
+static esp_err_t write_json_error(mcp_json_writer_t* out, const char* message)
+{
+    mcp_json_writer_begin_object(out);
+    mcp_json_writer_add_string(out, "status", "error");
+    mcp_json_writer_add_string(out, "message", message);
+    mcp_json_writer_end_object(out);
+    return out->overflow ? ESP_ERR_INVALID_SIZE : ESP_OK;
 }
 
 /* Echo tool implementation */
-esp_err_t mcp_tool_echo_execute(const char* params_json, char* result_json, size_t result_size)
+esp_err_t mcp_tool_echo_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out)
 {
-    if (!params_json || !result_json || result_size == 0) {
+    if (!doc || !out) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    ESP_LOGI(TAG, "Echo tool called with: %s", params_json);
-    
-    /* Parse parameters */
-    cJSON* params = cJSON_Parse(params_json);
-    if (!params) {
-        return create_json_result("error", "Invalid JSON parameters", NULL, result_json, result_size);
+    /* Echo back the raw argument text */
+    size_t args_len = 2;
+    const char* args_str = "{}";
+    if (args >= 0) {
+        args_str = mcp_json_raw(doc, args, &args_len);
     }
     
-    /* Echo back the parameters */
-    cJSON* data = cJSON_CreateObject();
-    cJSON_AddStringToObject(data, "echo", params_json);
-    cJSON_AddStringToObject(data, "timestamp", "current_time");
-    
-    esp_err_t ret = create_json_result("success", "Echo successful", data, result_json, result_size);
+    ESP_LOGI(TAG, "Echo tool called with: %.*s", (int)args_len, args_str);
     
-    cJSON_Delete(params);
-    return ret;
+    begin_json_result(out, "success", "Echo successful");
+    mcp_json_writer_key(out, "echo");
+    mcp_json_writer_string_n(out, args_str, args_len);
+    mcp_json_writer_add_string(out, "timestamp", "current_time");
+    return end_json_result(out);
 }
 
-/* Display tool implementation */
-esp_err_t mcp_tool_display_execute(const char* params_json, char* result_json, size_t result_size)
+/* Helper function to answer arguments rejected by a tool's parser or validator */
+static esp_err_t write_param_error(mcp_json_writer_t* out, esp_err_t err, const char* param)
 {
-    if (!params_json || !result_json || result_size == 0) {
+    char message[64];
+    if (err == ESP_ERR_NOT_SUPPORTED) {
+        snprintf(message, sizeof(message), "Unsupported %s", param ? param : "action");
+    } else {
+        snprintf(message, sizeof(message), "Missing or invalid %s parameter", param ? param : "");
+    }
+    return write_json_error(out, message);
+}
+
+/* Display tool: decode the arguments once, then run on the typed parameters */
+esp_err_t mcp_tool_display_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out)
+{
+    if (!doc || !out) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    ESP_LOGI(TAG, "Display tool called with: %s", params_json);
-    
-    /* Parse parameters */
-    cJSON* params = cJSON_Parse(params_json);
-    if (!params) {
-        return create_json_result("error", "Invalid JSON parameters", NULL, result_json, result_size);
+    mcp_display_params_t params;
+    const char* param = NULL;
+    esp_err_t ret = mcp_tool_display_parse_params(doc, args, &params, &param);
+    if (ret == ESP_OK) {
+        ret = mcp_tool_display_validate_params(&params, &param);
     }
-    
-    cJSON* action = cJSON_GetObjectItem(params, "action");
-    if (!action || !cJSON_IsString(action)) {
-        cJSON_Delete(params);
-        return create_json_result("error", "Missing or invalid action parameter", NULL, result_json, result_size);
+    if (ret != ESP_OK) {
+        return write_param_error(out, ret, param);
     }
-    
-    const char* action_str = cJSON_GetStringValue(action);
+    return mcp_tool_display_run(&params, out);
+}
+
+/* Display tool implementation */
+esp_err_t mcp_tool_display_run(const mcp_display_params_t* params, mcp_json_writer_t* out)
+{
+    const char* action_str = mcp_tool_display_action_name(params->action);
+    ESP_LOGI(TAG, "Display tool called with action: %s", action_str);
     
     /* Check if display is available */
     void* display_handle = get_display_handle();
     bool display_available = (display_handle != NULL);
     
-    cJSON* data = cJSON_CreateObject();
-    cJSON_AddBoolToObject(data, "display_available", display_available);
-    cJSON_AddStringToObject(data, "action_requested", action_str);
-    
-    if (strcmp(action_str, "get_info") == 0) {
-        cJSON_AddNumberToObject(data, "width", 320);
-        cJSON_AddNumberToObject(data, "height", 172);
-        cJSON_AddStringToObject(data, "type", "ST7789");
-        cJSON_AddBoolToObject(data, "initialized", display_available);
-    } else if (strcmp(action_str, "show_text") == 0) {
-        cJSON* text = cJSON_GetObjectItem(params, "text");
-        if (text && cJSON_IsString(text)) {
-            const char* text_str = cJSON_GetStringValue(text);
-            cJSON_AddStringToObject(data, "text_to_show", text_str);
+    begin_json_result(out, "success", "Display tool executed");
+    mcp_json_writer_add_bool(out, "display_available", display_available);
+    mcp_json_writer_add_string(out, "action_requested", action_str);
+    
+    switch (params->action) {
+        case MCP_DISPLAY_ACTION_GET_INFO:
+            mcp_json_writer_add_int(out, "width", MCP_DISPLAY_WIDTH);
+            mcp_json_writer_add_int(out, "height", MCP_DISPLAY_HEIGHT);
+            mcp_json_writer_add_string(out, "type", "ST7789");
+            mcp_json_writer_add_bool(out, "initialized", display_available);
+            break;
+        case MCP_DISPLAY_ACTION_SHOW_TEXT:
+            mcp_json_writer_add_string(out, "text_to_show", params->text);
             if (display_available) {
                 /* Here we would call the actual display function */
-                ESP_LOGI(TAG, "Would display text: %s", text_str);
-                cJSON_AddStringToObject(data, "result", "Text displayed successfully");
+                ESP_LOGI(TAG, "Would display text: %s", params->text);
+                mcp_json_writer_add_string(out, "result", "Text displayed successfully");
             } else {
-                cJSON_AddStringToObject(data, "result", "Display not available");
+                mcp_json_writer_add_string(out, "result", "Display not available");
             }
-        } else {
-            cJSON_Delete(data);
-            cJSON_Delete(params);
-            return create_json_result("error", "Missing text parameter", NULL, result_json, result_size);
-        }
-    } else if (strcmp(action_str, "clear") == 0) {
-        if (display_available) {
-            ESP_LOGI(TAG, "Would clear display");
-            cJSON_AddStringToObject(data, "result", "Display cleared successfully");
-        } else {
-            cJSON_AddStringToObject(data, "result", "Display not available");
-        }
-    } else {
-        cJSON_AddStringToObject(data, "result", "Unknown action");
+            break;
+        case MCP_DISPLAY_ACTION_CLEAR:
+            if (display_available) {
+                ESP_LOGI(TAG, "Would clear display");
+                mcp_json_writer_add_string(out, "result", "Display cleared successfully");
+            } else {
+                mcp_json_writer_add_string(out, "result", "Display not available");
+            }
+            break;
+        default:
+            mcp_json_writer_add_string(out, "result", "Unknown action");
+            break;
     }
     
-    esp_err_t ret = create_json_result("success", "Display tool executed", data, result_json, result_size);
-    
-    cJSON_Delete(params);
-    return ret;
+    return end_json_result(out);
 }
 
-/* GPIO tool implementation */
-esp_err_t mcp_tool_gpio_execute(const char* params_json, char* result_json, size_t result_size)
+/* GPIO tool: decode the arguments once, then run on the typed parameters */
+esp_err_t mcp_tool_gpio_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out)
 {
-    if (!params_json || !result_json || result_size == 0) {
+    if (!doc || !out) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    ESP_LOGI(TAG, "GPIO tool called with: %s", params_json);
-    
-    /* Parse parameters */
-    cJSON* params = cJSON_Parse(params_json);
-    if (!params) {
-        return create_json_result("error", "Invalid JSON parameters", NULL, result_json, result_size);
+    mcp_gpio_params_t params;
+    const char* param = NULL;
+    esp_err_t ret = mcp_tool_gpio_parse_params(doc, args, &params, &param);
+    if (ret == ESP_OK) {
+        ret = mcp_tool_gpio_validate_params(&params, &param);
     }
-    
-    cJSON* action = cJSON_GetObjectItem(params, "action");
-    if (!action || !cJSON_IsString(action)) {
-        cJSON_Delete(params);
-        return create_json_result("error", "Missing or invalid action parameter", NULL, result_json, result_size);
+    if (ret != ESP_OK) {
+        return write_param_error(out, ret, param);
     }
+    return mcp_tool_gpio_run(&params, out);
+}
+
+/* GPIO tool implementation */
+esp_err_t mcp_tool_gpio_run(const mcp_gpio_params_t* params, mcp_json_writer_t* out)
+{
+    const char* action_str = mcp_tool_gpio_action_name(params->action);
+    ESP_LOGI(TAG, "GPIO tool called with action: %s", action_str);
     
-    const char* action_str = cJSON_GetStringValue(action);
-    
-    cJSON* data = cJSON_CreateObject();
-    cJSON_AddStringToObject(data, "action_requested", action_str);
+    begin_json_result(out, "success", "GPIO tool executed");
+    mcp_json_writer_add_string(out, "action_requested", action_str);
     
-    if (strcmp(action_str, "set_led") == 0) {
-        cJSON* state = cJSON_GetObjectItem(params, "state");
-        if (state && cJSON_IsBool(state)) {
-            bool led_state = cJSON_IsTrue(state);
-            
+    switch (params->action) {
+        case MCP_GPIO_ACTION_SET_LED: {
             /* Set LED state */
-            gpio_set_level(GPIO_NUM_8, led_state ? 1 : 0);
+            gpio_set_level(GPIO_NUM_8, params->state ? 1 : 0);
             
-            cJSON_AddBoolToObject(data, "led_state", led_state);
-            cJSON_AddStringToObject(data, "result", "LED state updated");
-            ESP_LOGI(TAG, "LED set to %s", led_state ? "ON" : "OFF");
-        } else {
-            cJSON_Delete(data);
-            cJSON_Delete(params);
-            return create_json_result("error", "Missing or invalid state parameter", NULL, result_json, result_size);
+            mcp_json_writer_add_bool(out, "led_state", params->state);
+            mcp_json_writer_add_string(out, "result", "LED state updated");
+            ESP_LOGI(TAG, "LED set to %s", params->state ? "ON" : "OFF");
+            break;
         }
-    } else if (strcmp(action_str, "read_button") == 0) {
-        /* Read button state */
-        int button_level = gpio_get_level(GPIO_NUM_9);
-        bool button_pressed = (button_level == 0); // Active low
-        uint32_t button_count = get_button_press_count();
-        
-        cJSON_AddBoolToObject(data, "button_pressed", button_pressed);
-        cJSON_AddNumberToObject(data, "button_count", button_count);
-        cJSON_AddNumberToObject(data, "button_level", button_level);
-        
-        ESP_LOGI(TAG, "Button state: %s, count: %"PRIu32, 
-                button_pressed ? "PRESSED" : "RELEASED", button_count);
-    } else if (strcmp(action_str, "get_status") == 0) {
-        /* Get GPIO status */
-        int led_level = gpio_get_level(GPIO_NUM_8);
-        int button_level = gpio_get_level(GPIO_NUM_9);
-        uint32_t button_count = get_button_press_count();
-        
-        cJSON_AddBoolToObject(data, "led_on", led_level == 1);
-        cJSON_AddBoolToObject(data, "button_pressed", button_level == 0);
-        cJSON_AddNumberToObject(data, "button_count", button_count);
-        
-        ESP_LOGI(TAG, "GPIO status - LED: %s, Button: %s", 
-                led_level ? "ON" : "OFF", button_level ? "RELEASED" : "PRESSED");
-    } else {
-        cJSON_AddStringToObject(data, "result", "Unknown action");
+        case MCP_GPIO_ACTION_READ_BUTTON: {
+            /* Read button state */
+            int button_level = gpio_get_level(GPIO_NUM_9);
+            bool button_pressed = (button_level == 0); // Active low
+            uint32_t button_count = get_button_press_count();
+            
+            mcp_json_writer_add_bool(out, "button_pressed", button_pressed);
+            mcp_json_writer_add_uint(out, "button_count", button_count);
+            mcp_json_writer_add_int(out, "button_level", button_level);
+            
+            ESP_LOGI(TAG, "Button state: %s, count: %"PRIu32,
+                    button_pressed ? "PRESSED" : "RELEASED", button_count);
+            break;
+        }
+        case MCP_GPIO_ACTION_GET_STATUS: {
+            /* Get GPIO status */
+            int led_level = gpio_get_level(GPIO_NUM_8);
+            int button_level = gpio_get_level(GPIO_NUM_9);
+            uint32_t button_count = get_button_press_count();
+            
+            mcp_json_writer_add_bool(out, "led_on", led_level == 1);
+            mcp_json_writer_add_bool(out, "button_pressed", button_level == 0);
+            mcp_json_writer_add_uint(out, "button_count", button_count);
+            
+            ESP_LOGI(TAG, "GPIO status - LED: %s, Button: %s",
+                    led_level ? "ON" : "OFF", button_level ? "RELEASED" : "PRESSED");
+            break;
+        }
+        default:
+            mcp_json_writer_add_string(out, "result", "Unknown action");
+            break;
     }
     
-    esp_err_t ret = create_json_result("success", "GPIO tool executed", data, result_json, result_size);
-    
-    cJSON_Delete(params);
-    return ret;
+    return end_json_result(out);
 }
 
-/* System tool implementation */
-esp_err_t mcp_tool_system_execute(const char* params_json, char* result_json, size_t result_size)
+/* System tool: decode the arguments once, then run on the typed parameters */
+esp_err_t mcp_tool_system_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out)
 {
-    if (!params_json || !result_json || result_size == 0) {
+    if (!doc || !out) {
         return ESP_ERR_INVALID_ARG;
     }
     
-    ESP_LOGI(TAG, "System tool called with: %s", params_json);
-    
-    /* Parse parameters */
-    cJSON* params = cJSON_Parse(params_json);
-    if (!params) {
-        return create_json_result("error", "Invalid JSON parameters", NULL, result_json, result_size);
+    mcp_system_params_t params;
+    const char* param = NULL;
+    esp_err_t ret = mcp_tool_system_parse_params(doc, args, &params, &param);
+    if (ret == ESP_OK) {
+        ret = mcp_tool_system_validate_params(&params, &param);
     }
-    
-    cJSON* action = cJSON_GetObjectItem(params, "action");
-    const char* action_str = "get_info"; // Default action
-    
-    if (action && cJSON_IsString(action)) {
-        action_str = cJSON_GetStringValue(action);
+    if (ret != ESP_OK) {
+        return write_param_error(out, ret, param);
     }
+    return mcp_tool_system_run(&params, out);
+}
+
+/* System tool implementation */
+esp_err_t mcp_tool_system_run(const mcp_system_params_t* params, mcp_json_writer_t* out)
+{
+    const char* action_str = mcp_tool_system_action_name(params->action);
+    ESP_LOGI(TAG, "System tool called with action: %s", action_str);
     
-    cJSON* data = cJSON_CreateObject();
-    cJSON_AddStringToObject(data, "action_requested", action_str);
+    begin_json_result(out, "success", "System tool executed");
+    mcp_json_writer_add_string(out, "action_requested", action_str);
     
-    if (strcmp(action_str, "get_info") == 0 || strcmp(action_str, "get_stats") == 0) {
+    if (params->action == MCP_SYSTEM_ACTION_GET_INFO || params->action == MCP_SYSTEM_ACTION_GET_STATS) {
         /* Get chip information */
         esp_chip_info_t chip_info;
         esp_chip_info(&chip_info);
         
         /* Basic system info */
-        cJSON_AddStringToObject(data, "chip_model", "ESP32-C6");
-        cJSON_AddNumberToObject(data, "chip_revision", chip_info.revision);
-        cJSON_AddNumberToObject(data, "cores", chip_info.cores);
-        cJSON_AddStringToObject(data, "idf_version", IDF_VER);
+        mcp_json_writer_add_string(out, "chip_model", "ESP32-C6");
+        mcp_json_writer_add_uint(out, "chip_revision", chip_info.revision);
+        mcp_json_writer_add_uint(out, "cores", chip_info.cores);
+        mcp_json_writer_add_string(out, "idf_version", IDF_VER);
         
         /* Memory info */
-        cJSON_AddNumberToObject(data, "free_heap", esp_get_free_heap_size());
-        cJSON_AddNumberToObject(data, "min_free_heap", esp_get_minimum_free_heap_size());
+        mcp_json_writer_add_uint(out, "free_heap", esp_get_free_heap_size());
+        mcp_json_writer_add_uint(out, "min_free_heap", esp_get_minimum_free_heap_size());
         
         /* System stats */
-        cJSON_AddNumberToObject(data, "uptime_ms", esp_timer_get_time() / 1000);
-        cJSON_AddNumberToObject(data, "reset_reason", esp_reset_reason());
+        mcp_json_writer_add_int(out, "uptime_ms", esp_timer_get_time() / 1000);
+        mcp_json_writer_add_int(out, "reset_reason", esp_reset_reason());
         
         /* Features */
-        cJSON* features = cJSON_CreateArray();
+        mcp_json_writer_key(out, "features");
+        mcp_json_writer_begin_array(out);
         if (chip_info.features & CHIP_FEATURE_WIFI_BGN) {
-            cJSON_AddItemToArray(features, cJSON_CreateString("WiFi"));
+            mcp_json_writer_string(out, "WiFi");
         }
         if (chip_info.features & CHIP_FEATURE_BLE) {
-            cJSON_AddItemToArray(features, cJSON_CreateString("BLE"));
+            mcp_json_writer_string(out, "BLE");
         }
         if (chip_info.features & CHIP_FEATURE_IEEE802154) {
-            cJSON_AddItemToArray(features, cJSON_CreateString("802.15.4"));
+            mcp_json_writer_string(out, "802.15.4");
         }
-        cJSON_AddItemToObject(data, "features", features);
+        mcp_json_writer_end_array(out);
         
-        ESP_LOGI(TAG, "System info - Heap: %"PRIu32" bytes, Uptime: %lld ms", 
+        ESP_LOGI(TAG, "System info - Heap: %"PRIu32" bytes, Uptime: %lld ms",
                 esp_get_free_heap_size(), esp_timer_get_time() / 1000);
-                
-    } else if (strcmp(action_str, "restart") == 0) {
-        cJSON_AddStringToObject(data, "result", "Restart command received (not executed in demo)");
+    
+    } else if (params->action == MCP_SYSTEM_ACTION_RESTART) {
+        mcp_json_writer_add_string(out, "result", "Restart command received (not executed in demo)");
         ESP_LOGW(TAG, "Restart requested (would restart if force flag was set)");
     } else {
-        cJSON_AddStringToObject(data, "result", "Unknown action");
+        mcp_json_writer_add_string(out, "result", "Unknown action");
     }
     
-    esp_err_t ret = create_json_result("success", "System tool executed", data, result_json, result_size);
-    
-    cJSON_Delete(params);
-    return ret;
-}
\ No newline at end of file
+    return end_json_result(out);
+}
+
+/* Only the read-only system actions may be served from the cache */
+bool mcp_tool_system_cacheable(const mcp_json_doc_t* doc, int args)
+{
+    int action = mcp_json_find(doc, args, "action");
+    return action < 0 || mcp_json_eq(doc, action, "get_info") || mcp_json_eq(doc, action, "get_stats");
+}
@@ -0,0 +1,89 @@
+/**
+ * @file mcp_trace.c
+ * @brief Request lifecycle trace ring implementation
+ */
+
+#include "mcp_trace.h"
+
+#if MCP_TRACE_ENABLED
+
+#include <string.h>
+#include "esp_timer.h"
+
+#define TRACE_MASK  (MCP_TRACE_CAPACITY - 1)
+
+_Static_assert((MCP_TRACE_CAPACITY & TRACE_MASK) == 0, "MCP_TRACE_CAPACITY must be a power of two");
+_Static_assert(sizeof(mcp_trace_record_t) == 16, "trace wire record must stay 16 bytes");
+
+/* Ring slot: 'seq' is the record's sequence number + 1 once complete, 0 while
+ * it is being written */
+typedef struct {
+    atomic_uint seq;
+    mcp_trace_record_t record;
+} trace_slot_t;
+
+static trace_slot_t s_ring[MCP_TRACE_CAPACITY];
+static atomic_uint s_head;
+
+/* Append a record to the trace ring */
+void mcp_trace_emit(mcp_trace_event_t event, uint32_t client_id, uint32_t request_id, uint32_t arg)
+{
+    uint32_t n = atomic_fetch_add_explicit(&s_head, 1, memory_order_relaxed);
+    trace_slot_t* slot = &s_ring[n & TRACE_MASK];
+    
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    
+    slot->record.timestamp_us = (uint32_t)esp_timer_get_time();
+    slot->record.request_id = request_id;
+    slot->record.arg = arg;
+    slot->record.client_id = (uint16_t)client_id;
+    slot->record.event = (uint8_t)event;
+    slot->record.reserved = 0;
+    
+    atomic_store_explicit(&slot->seq, n + 1, memory_order_release);
+}
+
+/* Get the sequence number the next record will be written at */
+uint32_t mcp_trace_head(void)
+{
+    return atomic_load(&s_head);
+}
+
+/* Copy records out of the ring */
+uint32_t mcp_trace_read(uint32_t cursor, mcp_trace_record_t* out, uint32_t max, uint32_t* next)
+{
+    uint32_t head = atomic_load(&s_head);
+    uint32_t copied = 0;
+    
+    /* Records older than one lap have been overwritten; a cursor ahead of
+     * the head is stale too */
+    if (head - cursor > MCP_TRACE_CAPACITY) {
+        cursor = head > MCP_TRACE_CAPACITY ? head - MCP_TRACE_CAPACITY : 0;
+    }
+    
+    while (cursor != head && copied < max) {
+        trace_slot_t* slot = &s_ring[cursor & TRACE_MASK];
+        
+        uint32_t before = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (before == 0 || (int32_t)(before - (cursor + 1)) < 0) {
+            /* Claimed but not written yet; resume here next time */
+            break;
+        }
+        
+        mcp_trace_record_t record = slot->record;
+        atomic_thread_fence(memory_order_acquire);
+        uint32_t after = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+        
+        /* Anything else means a newer lap overwrote the slot meanwhile */
+        if (before == cursor + 1 && after == before) {
+            out[copied++] = record;
+        }
+        cursor++;
+    }
+    
+    *next = cursor;
+    return copied;
+}
+
+#endif /* MCP_TRACE_ENABLED */
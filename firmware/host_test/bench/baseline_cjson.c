@@ -0,0 +1,317 @@
+/**
+ * @file baseline_cjson.c
+ * @brief The cJSON request path the server used before the tokenizer and writer
+ */
+
+#include "baseline_cjson.h"
+
+#ifdef MCP_HOST_HAVE_CJSON
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "driver/gpio.h"
+#include "esp_chip_info.h"
+#include "esp_idf_version.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#define BASELINE_RESULT_SIZE        512
+
+typedef esp_err_t (*baseline_tool_fn)(const char* params_json, char* result_json, size_t result_size);
+
+static esp_err_t create_json_result(const char* status, const char* message,
+                                    cJSON* data, char* result_json, size_t result_size)
+{
+    cJSON* result = cJSON_CreateObject();
+    if (!result) {
+        return ESP_ERR_NO_MEM;
+    }
+    
+    cJSON_AddStringToObject(result, "status", status ? status : "success");
+    if (message) {
+        cJSON_AddStringToObject(result, "message", message);
+    }
+    if (data) {
+        cJSON_AddItemToObject(result, "data", data);
+    }
+    
+    char* result_str = cJSON_Print(result);
+    if (!result_str) {
+        cJSON_Delete(result);
+        return ESP_ERR_NO_MEM;
+    }
+    if (strlen(result_str) >= result_size) {
+        free(result_str);
+        cJSON_Delete(result);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    
+    strcpy(result_json, result_str);
+    free(result_str);
+    cJSON_Delete(result);
+    return ESP_OK;
+}
+
+static esp_err_t echo_execute(const char* params_json, char* result_json, size_t result_size)
+{
+    cJSON* params = cJSON_Parse(params_json);
+    if (!params) {
+        return create_json_result("error", "Invalid JSON parameters", NULL, result_json, result_size);
+    }
+    
+    cJSON* data = cJSON_CreateObject();
+    cJSON_AddStringToObject(data, "echo", params_json);
+    cJSON_AddStringToObject(data, "timestamp", "current_time");
+    
+    esp_err_t ret = create_json_result("success", "Echo successful", data, result_json, result_size);
+    cJSON_Delete(params);
+    return ret;
+}
+
+static esp_err_t display_execute(const char* params_json, char* result_json, size_t result_size)
+{
+    cJSON* params = cJSON_Parse(params_json);
+    if (!params) {
+        return create_json_result("error", "Invalid JSON parameters", NULL, result_json, result_size);
+    }
+    
+    cJSON* action = cJSON_GetObjectItem(params, "action");
+    if (!action || !cJSON_IsString(action)) {
+        cJSON_Delete(params);
+        return create_json_result("error", "Missing or invalid action parameter", NULL, result_json, result_size);
+    }
+    const char* action_str = cJSON_GetStringValue(action);
+    
+    cJSON* data = cJSON_CreateObject();
+    cJSON_AddBoolToObject(data, "display_available", false);
+    cJSON_AddStringToObject(data, "action_requested", action_str);
+    
+    if (strcmp(action_str, "show_text") == 0) {
+        cJSON* text = cJSON_GetObjectItem(params, "text");
+        if (!text || !cJSON_IsString(text)) {
+            cJSON_Delete(data);
+            cJSON_Delete(params);
+            return create_json_result("error", "Missing text parameter", NULL, result_json, result_size);
+        }
+        cJSON_AddStringToObject(data, "text_to_show", cJSON_GetStringValue(text));
+        cJSON_AddStringToObject(data, "result", "Display not available");
+    } else {
+        cJSON_AddStringToObject(data, "result", "Unknown action");
+    }
+    
+    esp_err_t ret = create_json_result("success", "Display tool executed", data, result_json, result_size);
+    cJSON_Delete(params);
+    return ret;
+}
+
+static esp_err_t gpio_execute(const char* params_json, char* result_json, size_t result_size)
+{
+    cJSON* params = cJSON_Parse(params_json);
+    if (!params) {
+        return create_json_result("error", "Invalid JSON parameters", NULL, result_json, result_size);
+    }
+    
+    cJSON* action = cJSON_GetObjectItem(params, "action");
+    if (!action || !cJSON_IsString(action)) {
+        cJSON_Delete(params);
+        return create_json_result("error", "Missing or invalid action parameter", NULL, result_json, result_size);
+    }
+    const char* action_str = cJSON_GetStringValue(action);
+    
+    cJSON* data = cJSON_CreateObject();
+    cJSON_AddStringToObject(data, "action_requested", action_str);
+    
+    if (strcmp(action_str, "set_led") == 0) {
+        cJSON* state = cJSON_GetObjectItem(params, "state");
+        if (!state || !cJSON_IsBool(state)) {
+            cJSON_Delete(data);
+            cJSON_Delete(params);
+            return create_json_result("error", "Missing or invalid state parameter", NULL, result_json, result_size);
+        }
+        bool led_state = cJSON_IsTrue(state);
+        gpio_set_level(GPIO_NUM_8, led_state ? 1 : 0);
+        cJSON_AddBoolToObject(data, "led_state", led_state);
+        cJSON_AddStringToObject(data, "result", "LED state updated");
+    } else {
+        cJSON_AddStringToObject(data, "result", "Unknown action");
+    }
+    
+    esp_err_t ret = create_json_result("success", "GPIO tool executed", data, result_json, result_size);
+    cJSON_Delete(params);
+    return ret;
+}
+
+static esp_err_t system_execute(const char* params_json, char* result_json, size_t result_size)
+{
+    cJSON* params = cJSON_Parse(params_json);
+    if (!params) {
+        return create_json_result("error", "Invalid JSON parameters", NULL, result_json, result_size);
+    }
+    
+    cJSON* action = cJSON_GetObjectItem(params, "action");
+    const char* action_str = "get_info";
+    if (action && cJSON_IsString(action)) {
+        action_str = cJSON_GetStringValue(action);
+    }
+    
+    cJSON* data = cJSON_CreateObject();
+    cJSON_AddStringToObject(data, "action_requested", action_str);
+    
+    esp_chip_info_t chip_info;
+    esp_chip_info(&chip_info);
+    cJSON_AddStringToObject(data, "chip_model", "ESP32-C6");
+    cJSON_AddNumberToObject(data, "chip_revision", chip_info.revision);
+    cJSON_AddNumberToObject(data, "cores", chip_info.cores);
+    cJSON_AddStringToObject(data, "idf_version", IDF_VER);
+    cJSON_AddNumberToObject(data, "free_heap", esp_get_free_heap_size());
+    cJSON_AddNumberToObject(data, "min_free_heap", esp_get_minimum_free_heap_size());
+    cJSON_AddNumberToObject(data, "uptime_ms", (double)(esp_timer_get_time() / 1000));
+    cJSON_AddNumberToObject(data, "reset_reason", esp_reset_reason());
+    
+    cJSON* features = cJSON_CreateArray();
+    if (chip_info.features & CHIP_FEATURE_WIFI_BGN) {
+        cJSON_AddItemToArray(features, cJSON_CreateString("WiFi"));
+    }
+    if (chip_info.features & CHIP_FEATURE_BLE) {
+        cJSON_AddItemToArray(features, cJSON_CreateString("BLE"));
+    }
+    if (chip_info.features & CHIP_FEATURE_IEEE802154) {
+        cJSON_AddItemToArray(features, cJSON_CreateString("802.15.4"));
+    }
+    cJSON_AddItemToObject(data, "features", features);
+    
+    esp_err_t ret = create_json_result("success", "System tool executed", data, result_json, result_size);
+    cJSON_Delete(params);
+    return ret;
+}
+
+static const struct {
+    const char* name;
+    baseline_tool_fn execute;
+} s_tools[] = {
+    { "echo", echo_execute },
+    { "display_control", display_execute },
+    { "gpio_control", gpio_execute },
+    { "system_info", system_execute },
+};
+
+static esp_err_t send_response(uint32_t id, const char* result_json, const char* error_msg,
+                               char* output, size_t output_size)
+{
+    cJSON* response = cJSON_CreateObject();
+    cJSON_AddStringToObject(response, "jsonrpc", "2.0");
+    cJSON_AddNumberToObject(response, "id", id);
+    
+    if (error_msg) {
+        cJSON* error = cJSON_CreateObject();
+        cJSON_AddNumberToObject(error, "code", -32000);
+        cJSON_AddStringToObject(error, "message", error_msg);
+        cJSON_AddItemToObject(response, "error", error);
+    } else if (result_json) {
+        cJSON* result = cJSON_Parse(result_json);
+        if (result) {
+            cJSON_AddItemToObject(response, "result", result);
+        } else {
+            cJSON_AddStringToObject(response, "result", result_json);
+        }
+    } else {
+        cJSON_AddNullToObject(response, "result");
+    }
+    
+    char* response_str = cJSON_Print(response);
+    esp_err_t ret = ESP_ERR_INVALID_SIZE;
+    if (response_str) {
+        if (strlen(response_str) < output_size) {
+            strcpy(output, response_str);
+            ret = ESP_OK;
+        }
+        free(response_str);
+    }
+    cJSON_Delete(response);
+    return ret;
+}
+
+bool baseline_parse_request(const char* request)
+{
+    cJSON* json = cJSON_Parse(request);
+    if (!json) {
+        return false;
+    }
+    
+    cJSON* method = cJSON_GetObjectItem(json, "method");
+    cJSON* id = cJSON_GetObjectItem(json, "id");
+    cJSON* params = cJSON_GetObjectItem(json, "params");
+    bool ok = method && cJSON_IsString(method) && id;
+    
+    if (ok && strcmp(cJSON_GetStringValue(method), "tools/call") == 0) {
+        cJSON* name = cJSON_GetObjectItem(params, "name");
+        cJSON* arguments = cJSON_GetObjectItem(params, "arguments");
+        ok = name && cJSON_IsString(name);
+        
+        /* The tool received its arguments as text and parsed them again */
+        char* args_str = arguments ? cJSON_Print(arguments) : strdup("{}");
+        cJSON* args = cJSON_Parse(args_str);
+        ok = ok && args;
+        cJSON_Delete(args);
+        free(args_str);
+    }
+    
+    cJSON_Delete(json);
+    return ok;
+}
+
+esp_err_t baseline_process_line(const char* request, char* output, size_t output_size)
+{
+    cJSON* json = cJSON_Parse(request);
+    if (!json) {
+        return send_response(0, NULL, "Parse error", output, output_size);
+    }
+    
+    cJSON* method = cJSON_GetObjectItem(json, "method");
+    cJSON* id = cJSON_GetObjectItem(json, "id");
+    cJSON* params = cJSON_GetObjectItem(json, "params");
+    if (!method || !cJSON_IsString(method)) {
+        cJSON_Delete(json);
+        return send_response(0, NULL, "Invalid method", output, output_size);
+    }
+    uint32_t request_id = id ? (uint32_t)cJSON_GetNumberValue(id) : 0;
+    
+    if (strcmp(cJSON_GetStringValue(method), "tools/call") != 0) {
+        cJSON_Delete(json);
+        return send_response(request_id, NULL, "Unknown method", output, output_size);
+    }
+    
+    cJSON* name = cJSON_GetObjectItem(params, "name");
+    cJSON* arguments = cJSON_GetObjectItem(params, "arguments");
+    if (!name || !cJSON_IsString(name)) {
+        cJSON_Delete(json);
+        return send_response(request_id, NULL, "Missing tool name", output, output_size);
+    }
+    
+    const char* tool_name = cJSON_GetStringValue(name);
+    char* args_str = arguments ? cJSON_Print(arguments) : strdup("{}");
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    
+    for (size_t i = 0; i < sizeof(s_tools) / sizeof(s_tools[0]); i++) {
+        if (strcmp(s_tools[i].name, tool_name) == 0) {
+            char result_buffer[BASELINE_RESULT_SIZE];
+            if (s_tools[i].execute(args_str, result_buffer, sizeof(result_buffer)) == ESP_OK) {
+                ret = send_response(request_id, result_buffer, NULL, output, output_size);
+            } else {
+                ret = send_response(request_id, NULL, "Tool execution failed", output, output_size);
+            }
+            break;
+        }
+    }
+    if (ret == ESP_ERR_NOT_FOUND) {
+        ret = send_response(request_id, NULL, "Tool not found", output, output_size);
+    }
+    
+    free(args_str);
+    cJSON_Delete(json);
+    return ret;
+}
+
+#endif /* MCP_HOST_HAVE_CJSON */
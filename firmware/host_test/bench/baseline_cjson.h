@@ -0,0 +1,28 @@
+/**
+ * @file baseline_cjson.h
+ * @brief The cJSON request path the server used before the tokenizer and writer
+ * 
+ * A copy of the original mcp_handle_request / mcp_send_response and
+ * built-in tools, reduced to tools/call and the actions the payloads use.
+ * It is the baseline of the parser and serializer benchmarks and is only
+ * built when cJSON is available (MCP_HOST_HAVE_CJSON).
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+/**
+ * Request side only: cJSON_Parse, envelope lookups, cJSON_Print of the
+ * arguments and the tool's cJSON_Parse of them, then the frees.
+ */
+bool baseline_parse_request(const char* request);
+
+/**
+ * Whole tools/call: the request side, the tool building its result with
+ * cJSON and printing it, and the response envelope re-parsing the result
+ * and pretty-printing everything.
+ */
+esp_err_t baseline_process_line(const char* request, char* output, size_t output_size);
@@ -0,0 +1,144 @@
+/**
+ * @file bench_cbor.c
+ * @brief Per-tool request decoding and result encoding, JSON vs CBOR
+ *
+ * For each tools/call payload of mcp_tcp_client.py, reports the bytes and
+ * the CPU cycles per call of:
+ *   decode json  mcp_json_parse of the request line
+ *   decode cbor  the CBOR session path: mcp_cbor_to_json of the request
+ *                item into a scratch buffer, then mcp_json_parse of that
+ *   encode json  the tool writing its result with a JSON writer
+ *   encode cbor  the same tool writing it with a CBOR writer
+ * Byte counts are the request size for decoding and the result size for
+ * encoding. Cycles come from esp_cpu_get_cycle_count(), the TSC on x86
+ * hosts.
+ *
+ * Usage: bench_cbor [--quick]
+ */
+
+#include <string.h>
+#include "esp_cpu.h"
+#include "mcp_cbor.h"
+#include "mcp_json.h"
+#include "mcp_server_simple.h"
+#include "host_test.h"
+#include "bench_payloads.h"
+
+#define BENCH_TOKENS                64
+#define BENCH_ITEM_SIZE             1024
+#define BENCH_RESULT_SIZE           4096
+
+typedef esp_err_t (*tool_fn)(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out);
+
+typedef struct {
+    const char* name;
+    tool_fn execute;
+} bench_tool_t;
+
+static const bench_tool_t s_tools[] = {
+    { "echo", mcp_tool_echo_execute },
+    { "system_info", mcp_tool_system_execute },
+    { "display_control", mcp_tool_display_execute },
+    { "gpio_control", mcp_tool_gpio_execute },
+};
+
+#define BENCH_TOOL_COUNT            (sizeof(s_tools) / sizeof(s_tools[0]))
+
+static volatile int s_sink;
+
+static tool_fn find_tool(const char* name)
+{
+    for (size_t i = 0; i < BENCH_TOOL_COUNT; i++) {
+        if (strcmp(s_tools[i].name, name) == 0) {
+            return s_tools[i].execute;
+        }
+    }
+    return NULL;
+}
+
+static void report(const char* payload, const char* path, size_t bytes, uint64_t cycles, unsigned iterations)
+{
+    printf("%-16s %-12s %8zu %14.0f\n", payload, path, bytes, (double)cycles / iterations);
+}
+
+static void bench_decode(const bench_payload_t* payload, unsigned iterations)
+{
+    const char* request = payload->request;
+    size_t request_len = strlen(request);
+    mcp_json_token_t tokens[BENCH_TOKENS];
+    
+    uint64_t cycles = 0;
+    for (unsigned i = 0; i < iterations; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        s_sink += mcp_json_parse(request, request_len, tokens, BENCH_TOKENS);
+        cycles += (uint32_t)(esp_cpu_get_cycle_count() - start);
+    }
+    report(payload->name, "decode json", request_len, cycles, iterations);
+    
+    /* The request as a CBOR client sends it */
+    uint8_t item[BENCH_ITEM_SIZE];
+    mcp_json_writer_t w;
+    mcp_json_writer_init(&w, (char*)item, sizeof(item));
+    mcp_json_writer_set_format(&w, MCP_WIRE_CBOR);
+    mcp_json_writer_raw(&w, request, request_len);
+    HOST_CHECK(mcp_json_writer_finish(&w) == ESP_OK);
+    size_t item_len = mcp_json_writer_length(&w);
+    
+    char json[MCP_MAX_MESSAGE_SIZE + 1];
+    cycles = 0;
+    for (unsigned i = 0; i < iterations; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        mcp_json_writer_t decoded;
+        mcp_json_writer_init(&decoded, json, sizeof(json));
+        HOST_CHECK(mcp_cbor_to_json(item, item_len, &decoded) == ESP_OK);
+        s_sink += mcp_json_parse(json, mcp_json_writer_length(&decoded), tokens, BENCH_TOKENS);
+        cycles += (uint32_t)(esp_cpu_get_cycle_count() - start);
+    }
+    report(payload->name, "decode cbor", item_len, cycles, iterations);
+}
+
+static void bench_encode(const bench_payload_t* payload, mcp_wire_format_t format, unsigned iterations)
+{
+    const char* request = payload->request;
+    mcp_json_token_t tokens[BENCH_TOKENS];
+    int count = mcp_json_parse(request, strlen(request), tokens, BENCH_TOKENS);
+    HOST_CHECK(count > 0);
+    mcp_json_doc_t doc = { request, tokens, count };
+    int params = mcp_json_find(&doc, 0, "params");
+    int args = mcp_json_find(&doc, params, "arguments");
+    
+    char name[32];
+    HOST_CHECK(mcp_json_get_string(&doc, mcp_json_find(&doc, params, "name"), name, sizeof(name)) == ESP_OK);
+    tool_fn execute = find_tool(name);
+    HOST_CHECK(execute != NULL);
+    
+    static char result[BENCH_RESULT_SIZE];
+    size_t result_len = 0;
+    uint64_t cycles = 0;
+    for (unsigned i = 0; i < iterations; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        mcp_json_writer_t w;
+        mcp_json_writer_init(&w, result, sizeof(result));
+        mcp_json_writer_set_format(&w, format);
+        HOST_CHECK(execute(&doc, args, &w) == ESP_OK);
+        HOST_CHECK(mcp_json_writer_finish(&w) == ESP_OK);
+        cycles += (uint32_t)(esp_cpu_get_cycle_count() - start);
+        result_len = mcp_json_writer_length(&w);
+    }
+    report(payload->name, format == MCP_WIRE_CBOR ? "encode cbor" : "encode json",
+           result_len, cycles, iterations);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned iterations = host_quick_run(argc, argv) ? 1000 : 100000;
+    
+    printf("%-16s %-12s %8s %14s\n", "payload", "path", "bytes", "cycles/call");
+    for (size_t i = 0; i < BENCH_PAYLOAD_COUNT; i++) {
+        const bench_payload_t* payload = &s_bench_payloads[i];
+        bench_decode(payload, iterations);
+        bench_encode(payload, MCP_WIRE_JSON, iterations);
+        bench_encode(payload, MCP_WIRE_CBOR, iterations);
+    }
+    return 0;
+}
@@ -0,0 +1,202 @@
+/**
+ * @file bench_counters.c
+ * @brief Statistics counters: atomics vs the former mutex, 4 concurrent clients
+ *
+ * Four threads stand in for four TCP clients and account for requests at
+ * the same time:
+ *   counters  only the statistics updates of one tools/call request:
+ *             mutex    the former code, three xSemaphoreTake(100 ms) on the
+ *                      server mutex (received, sent/processed, tools_executed);
+ *                      a timed-out take dropped the count
+ *             atomic   one stats_begin/stats_end bracket around the adds, as
+ *                      mcp_server_process_line does now
+ *   requests  whole mcp_server_process_line calls (ping and an echo
+ *             tools/call), as they run now and with the former three mutex
+ *             updates added back around each call
+ * Times are nanoseconds per request per thread (wall time / requests per
+ * thread). Every run checks that no count was lost.
+ *
+ * Usage: bench_counters [--quick]
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "mcp_server_simple.h"
+#include "host_test.h"
+
+#define THREADS                     4
+
+/* The former counters, guarded by the server mutex */
+typedef struct {
+    uint32_t messages_received;
+    uint32_t messages_sent;
+    uint32_t requests_processed;
+    uint32_t tools_executed;
+    uint32_t dropped;               /* Takes that timed out */
+} mutex_counters_t;
+
+/* The current counters (mcp_server_counters_t) */
+typedef struct {
+    atomic_uint messages_received;
+    atomic_uint messages_sent;
+    atomic_uint requests_processed;
+    atomic_uint tools_executed;
+    atomic_uint writers;
+    atomic_uint epoch;
+} atomic_counters_t;
+
+typedef enum {
+    MODE_MUTEX,
+    MODE_ATOMIC,
+    MODE_REQUEST,
+    MODE_REQUEST_MUTEX,
+} bench_mode_t;
+
+static const char* const s_requests[] = {
+    "{\"jsonrpc\":\"2.0\",\"method\":\"ping\",\"id\":1}",
+    "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"id\":2,\"params\":{\"name\":\"echo\","
+    "\"arguments\":{\"message\":\"TCP test message\"}}}",
+};
+
+static bench_mode_t s_mode;
+static unsigned s_iterations;
+static SemaphoreHandle_t s_mutex;
+static mutex_counters_t s_mutex_counters;
+static atomic_counters_t s_atomic_counters;
+static mcp_server_handle_t s_server;
+static pthread_barrier_t s_barrier;
+
+static void count_mutex(bool tool_call)
+{
+    const TickType_t timeout = pdMS_TO_TICKS(100);
+    
+    if (xSemaphoreTake(s_mutex, timeout) == pdTRUE) {
+        s_mutex_counters.messages_received++;
+        xSemaphoreGive(s_mutex);
+    } else {
+        s_mutex_counters.dropped++;
+    }
+    if (tool_call) {
+        if (xSemaphoreTake(s_mutex, timeout) == pdTRUE) {
+            s_mutex_counters.tools_executed++;
+            xSemaphoreGive(s_mutex);
+        } else {
+            s_mutex_counters.dropped++;
+        }
+    }
+    if (xSemaphoreTake(s_mutex, timeout) == pdTRUE) {
+        s_mutex_counters.messages_sent++;
+        s_mutex_counters.requests_processed++;
+        xSemaphoreGive(s_mutex);
+    } else {
+        s_mutex_counters.dropped++;
+    }
+}
+
+static void count_atomic(bool tool_call)
+{
+    atomic_counters_t* counters = &s_atomic_counters;
+    atomic_fetch_add(&counters->writers, 1);
+    atomic_fetch_add(&counters->messages_received, 1);
+    if (tool_call) {
+        atomic_fetch_add(&counters->tools_executed, 1);
+    }
+    atomic_fetch_add(&counters->messages_sent, 1);
+    atomic_fetch_add(&counters->requests_processed, 1);
+    atomic_fetch_add(&counters->epoch, 1);
+    atomic_fetch_sub(&counters->writers, 1);
+}
+
+static void* client_thread(void* arg)
+{
+    static char outputs[THREADS][MCP_MAX_MESSAGE_SIZE];
+    char* output = outputs[(uintptr_t)arg];
+    
+    pthread_barrier_wait(&s_barrier);
+    for (unsigned i = 0; i < s_iterations; i++) {
+        bool tool_call = i & 1;
+        switch (s_mode) {
+            case MODE_MUTEX:
+                count_mutex(tool_call);
+                break;
+            case MODE_ATOMIC:
+                count_atomic(tool_call);
+                break;
+            case MODE_REQUEST_MUTEX:
+                count_mutex(tool_call);
+                /* fall through */
+            case MODE_REQUEST:
+                HOST_CHECK(mcp_server_process_line(s_server, s_requests[tool_call], output,
+                                                   MCP_MAX_MESSAGE_SIZE) == ESP_OK);
+                break;
+        }
+    }
+    return NULL;
+}
+
+/* Run all threads in the given mode; returns ns per request per thread */
+static double run(bench_mode_t mode)
+{
+    pthread_t threads[THREADS];
+    
+    s_mode = mode;
+    pthread_barrier_init(&s_barrier, NULL, THREADS + 1);
+    for (uintptr_t i = 0; i < THREADS; i++) {
+        pthread_create(&threads[i], NULL, client_thread, (void*)i);
+    }
+    int64_t start = esp_timer_get_time();
+    pthread_barrier_wait(&s_barrier);
+    for (unsigned i = 0; i < THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    pthread_barrier_destroy(&s_barrier);
+    return elapsed * 1000.0 / s_iterations;
+}
+
+int main(int argc, char** argv)
+{
+    s_iterations = host_quick_run(argc, argv) ? 20000 : 1000000;
+    const uint32_t total = THREADS * s_iterations;
+    
+    s_mutex = xSemaphoreCreateMutex();
+    HOST_CHECK(s_mutex != NULL);
+    
+    mcp_server_config_t config;
+    mcp_server_get_default_config(&config);
+    HOST_CHECK(mcp_server_init(&config, &s_server) == ESP_OK);
+    HOST_CHECK(mcp_server_start(s_server) == ESP_OK);
+    
+    printf("%-10s %12s %12s   (ns per request, %d threads)\n", "", "mutex", "atomic", THREADS);
+    
+    double mutex_ns = run(MODE_MUTEX);
+    double atomic_ns = run(MODE_ATOMIC);
+    printf("%-10s %12.1f %12.1f\n", "counters", mutex_ns, atomic_ns);
+    
+    HOST_CHECK(s_mutex_counters.dropped == 0);
+    HOST_CHECK(s_mutex_counters.messages_received == total);
+    HOST_CHECK(atomic_load(&s_atomic_counters.messages_received) == total);
+    HOST_CHECK(atomic_load(&s_atomic_counters.tools_executed) == total / 2);
+    
+    double request_mutex_ns = run(MODE_REQUEST_MUTEX);
+    double request_ns = run(MODE_REQUEST);
+    printf("%-10s %12.1f %12.1f\n", "requests", request_mutex_ns, request_ns);
+    
+    /* Nothing was lost under contention */
+    mcp_server_stats_t stats;
+    HOST_CHECK(mcp_server_get_stats(s_server, &stats) == ESP_OK);
+    HOST_CHECK(stats.messages_received == 2 * total);
+    HOST_CHECK(stats.messages_sent == 2 * total);
+    HOST_CHECK(stats.requests_processed == 2 * total);
+    HOST_CHECK(stats.tools_executed == total);
+    HOST_CHECK(stats.errors_count == 0);
+    
+    mcp_server_stop(s_server);
+    mcp_server_deinit(s_server);
+    vSemaphoreDelete(s_mutex);
+    return 0;
+}
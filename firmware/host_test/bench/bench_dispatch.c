@@ -0,0 +1,166 @@
+/**
+ * @file bench_dispatch.c
+ * @brief Name dispatch: hashed index vs the former strcmp scans
+ * 
+ * Looks up every registered name in turn, as tools/call does with the name
+ * token of a tokenized request, with 8, 64 and 256 tools registered:
+ *   strcmp    the former linear scan over the tool array (names unescaped
+ *             to C strings first, as cJSON had done)
+ *   index     mcp_dispatch_lookup_token on the table's name index
+ *   registry  mcp_tool_registry_acquire + lookup + release, the whole
+ *             per-request cost
+ * The same is done for the JSON-RPC method names (strcmp chain vs index).
+ * Times are nanoseconds per lookup.
+ * 
+ * Usage: bench_dispatch [--quick]
+ */
+
+#include <string.h>
+#include "esp_timer.h"
+#include "mcp_dispatch.h"
+#include "mcp_json.h"
+#include "mcp_tool_registry.h"
+#include "host_test.h"
+
+#define MAX_NAMES                   256
+#define NAME_SIZE                   32
+
+typedef struct {
+    unsigned count;
+    char names[MAX_NAMES][NAME_SIZE];
+    char requests[MAX_NAMES][NAME_SIZE + 16];
+    mcp_json_token_t tokens[MAX_NAMES][4];
+    mcp_json_doc_t docs[MAX_NAMES];
+} name_set_t;
+
+static const char* const s_methods[] = {
+    "initialize", "notifications/initialized", "notifications/cancelled", "ping",
+    "tools/list", "tools/call", "resources/subscribe", "resources/unsubscribe",
+    "resources/list", "resources/read", "server/metrics", "debug/trace_dump",
+};
+
+#define METHOD_COUNT                (sizeof(s_methods) / sizeof(s_methods[0]))
+
+static volatile uintptr_t s_sink;
+static name_set_t s_set;
+
+/* Tokenize {"name":"<name>"} for every name; the value is token 2 */
+static void prepare(name_set_t* set)
+{
+    for (unsigned i = 0; i < set->count; i++) {
+        int len = snprintf(set->requests[i], sizeof(set->requests[i]), "{\"name\":\"%s\"}", set->names[i]);
+        int count = mcp_json_parse(set->requests[i], (size_t)len, set->tokens[i], 4);
+        HOST_CHECK(count == 3);
+        set->docs[i] = (mcp_json_doc_t){ set->requests[i], set->tokens[i], count };
+    }
+}
+
+static const char* scan_strcmp(const name_set_t* set, const mcp_json_doc_t* doc)
+{
+    char name[MCP_DISPATCH_MAX_NAME_LEN + 1];
+    if (mcp_json_get_string(doc, 2, name, sizeof(name)) != ESP_OK) {
+        return NULL;
+    }
+    for (unsigned i = 0; i < set->count; i++) {
+        if (strcmp(set->names[i], name) == 0) {
+            return set->names[i];
+        }
+    }
+    return NULL;
+}
+
+static double time_strcmp(const name_set_t* set, unsigned iterations)
+{
+    int64_t start = esp_timer_get_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        const char* found = scan_strcmp(set, &set->docs[i % set->count]);
+        s_sink += (uintptr_t)found;
+    }
+    return (esp_timer_get_time() - start) * 1000.0 / iterations;
+}
+
+static double time_index(const name_set_t* set, const mcp_dispatch_table_t* index, unsigned iterations)
+{
+    int64_t start = esp_timer_get_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        s_sink += (uintptr_t)mcp_dispatch_lookup_token(index, &set->docs[i % set->count], 2);
+    }
+    return (esp_timer_get_time() - start) * 1000.0 / iterations;
+}
+
+static double time_registry(const name_set_t* set, mcp_tool_registry_t* registry, unsigned iterations)
+{
+    int64_t start = esp_timer_get_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        const mcp_tool_table_t* table = mcp_tool_registry_acquire(registry);
+        s_sink += (uintptr_t)mcp_dispatch_lookup_token(&table->index, &set->docs[i % set->count], 2);
+        mcp_tool_registry_release(registry, table);
+    }
+    return (esp_timer_get_time() - start) * 1000.0 / iterations;
+}
+
+static esp_err_t noop_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out)
+{
+    return ESP_OK;
+}
+
+static void bench_tools(unsigned count, unsigned iterations)
+{
+    static const char* const kinds[] = { "sensor", "gpio", "display", "system", "relay", "adc", "pwm", "i2c" };
+    static mcp_tool_def_t defs[MAX_NAMES];
+    
+    s_set.count = count;
+    for (unsigned i = 0; i < count; i++) {
+        snprintf(s_set.names[i], NAME_SIZE, "%s_control_%u", kinds[i % 8], i);
+        defs[i] = (mcp_tool_def_t){
+            .name = s_set.names[i],
+            .description = "benchmark tool",
+            .type = MCP_TOOL_CUSTOM,
+            .execute = noop_execute,
+        };
+    }
+    prepare(&s_set);
+    
+    mcp_tool_registry_t registry;
+    HOST_CHECK(mcp_tool_registry_init(&registry, defs, count) == ESP_OK);
+    const mcp_tool_table_t* table = mcp_tool_registry_acquire(&registry);
+    for (unsigned i = 0; i < count; i++) {
+        HOST_CHECK(mcp_dispatch_lookup_token(&table->index, &s_set.docs[i], 2) == &table->tools[i]);
+    }
+    
+    printf("%-10s %6u %10.1f %10.1f %10.1f\n", "tools", count,
+           time_strcmp(&s_set, iterations), time_index(&s_set, &table->index, iterations),
+           time_registry(&s_set, &registry, iterations));
+    
+    mcp_tool_registry_release(&registry, table);
+    mcp_tool_registry_deinit(&registry);
+}
+
+static void bench_methods(unsigned iterations)
+{
+    mcp_dispatch_table_t index;
+    HOST_CHECK(mcp_dispatch_init(&index, METHOD_COUNT) == ESP_OK);
+    
+    s_set.count = METHOD_COUNT;
+    for (unsigned i = 0; i < METHOD_COUNT; i++) {
+        snprintf(s_set.names[i], NAME_SIZE, "%s", s_methods[i]);
+        HOST_CHECK(mcp_dispatch_insert(&index, s_methods[i], (void*)s_methods[i]) == ESP_OK);
+    }
+    prepare(&s_set);
+    
+    printf("%-10s %6u %10.1f %10.1f %10s\n", "methods", (unsigned)METHOD_COUNT,
+           time_strcmp(&s_set, iterations), time_index(&s_set, &index, iterations), "-");
+    mcp_dispatch_deinit(&index);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned iterations = host_quick_run(argc, argv) ? 20000 : 5000000;
+    
+    printf("%-10s %6s %10s %10s %10s   (ns per lookup)\n", "names", "count", "strcmp", "index", "registry");
+    bench_methods(iterations);
+    bench_tools(8, iterations);
+    bench_tools(64, iterations);
+    bench_tools(256, iterations);
+    return 0;
+}
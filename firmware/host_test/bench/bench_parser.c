@@ -0,0 +1,108 @@
+/**
+ * @file bench_parser.c
+ * @brief Request parsing: in-place tokenizer vs the former cJSON path
+ * 
+ * For each tools/call payload of mcp_tcp_client.py, measures requests per
+ * second and the peak heap of:
+ *   tokenizer  mcp_json_parse into a stack token array, then the envelope
+ *              and tool lookups mcp_handle_request does (method, id, params,
+ *              name, arguments)
+ *   cjson      the former path: cJSON_Parse, the same lookups, cJSON_Print
+ *              of the arguments and the tool parsing them back
+ *   server     the whole request through mcp_server_process_line, for scale
+ * 
+ * Usage: bench_parser [--quick]
+ */
+
+#include <string.h>
+#include "esp_timer.h"
+#include "mcp_json.h"
+#include "mcp_server_simple.h"
+#include "host_test.h"
+#include "baseline_cjson.h"
+#include "bench_payloads.h"
+
+#define BENCH_TOKENS                64
+#define BENCH_RESPONSE_SIZE         4096
+
+typedef bool (*bench_fn)(const char* request);
+
+static mcp_server_handle_t s_server;
+
+static bool parse_tokenizer(const char* request)
+{
+    mcp_json_token_t tokens[BENCH_TOKENS];
+    int count = mcp_json_parse(request, strlen(request), tokens, BENCH_TOKENS);
+    if (count < 0) {
+        return false;
+    }
+    
+    mcp_json_doc_t doc = { request, tokens, count };
+    int method = mcp_json_find(&doc, 0, "method");
+    int id = mcp_json_find(&doc, 0, "id");
+    int params = mcp_json_find(&doc, 0, "params");
+    if (method < 0 || id < 0 || !mcp_json_eq(&doc, method, "tools/call")) {
+        return false;
+    }
+    return mcp_json_find(&doc, params, "name") >= 0 && mcp_json_find(&doc, params, "arguments") >= 0;
+}
+
+#ifdef MCP_HOST_HAVE_CJSON
+static bool parse_cjson(const char* request)
+{
+    return baseline_parse_request(request);
+}
+#endif
+
+static bool process_server(const char* request)
+{
+    static char response[BENCH_RESPONSE_SIZE];
+    return mcp_server_process_line(s_server, request, response, sizeof(response)) == ESP_OK;
+}
+
+static void run(const char* path, const bench_payload_t* payload, bench_fn fn, unsigned iterations)
+{
+    host_heap_stats_t before, after;
+    host_heap_get_stats(&before);
+    host_heap_reset_peak();
+    
+    int64_t start = esp_timer_get_time();
+    for (unsigned i = 0; i < iterations; i++) {
+        HOST_CHECK(fn(payload->request));
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    
+    host_heap_get_stats(&after);
+    printf("%-16s %-10s %12.0f %10zu %12.1f\n", payload->name, path,
+           iterations * 1e6 / (double)(elapsed > 0 ? elapsed : 1),
+           after.peak_bytes - before.live_bytes,
+           (double)(after.allocations - before.allocations) / iterations);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned iterations = host_quick_run(argc, argv) ? 2000 : 200000;
+    
+    mcp_server_config_t config;
+    mcp_server_get_default_config(&config);
+    config.cache_max_bytes = 0;
+    HOST_CHECK(mcp_server_init(&config, &s_server) == ESP_OK);
+    HOST_CHECK(mcp_server_start(s_server) == ESP_OK);
+    
+    printf("%-16s %-10s %12s %10s %12s\n", "payload", "path", "req/s", "peak heap", "allocs/req");
+    for (size_t i = 0; i < BENCH_PAYLOAD_COUNT; i++) {
+        const bench_payload_t* payload = &s_bench_payloads[i];
+        run("tokenizer", payload, parse_tokenizer, iterations);
+#ifdef MCP_HOST_HAVE_CJSON
+        run("cjson", payload, parse_cjson, iterations);
+#endif
+        run("server", payload, process_server, iterations / 10);
+    }
+#ifndef MCP_HOST_HAVE_CJSON
+    printf("cjson rows skipped: configure with -DMCP_HOST_CJSON_DIR=<dir with cJSON.c>\n");
+#endif
+    
+    mcp_server_stop(s_server);
+    mcp_server_deinit(s_server);
+    return 0;
+}
@@ -0,0 +1,32 @@
+/**
+ * @file bench_payloads.h
+ * @brief The tools/call requests mcp_tcp_client.py sends, byte for byte
+ * 
+ * json.dumps() output with its default ", " and ": " separators.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+typedef struct {
+    const char* name;
+    const char* request;
+} bench_payload_t;
+
+static const bench_payload_t s_bench_payloads[] = {
+    { "echo",
+      "{\"jsonrpc\": \"2.0\", \"method\": \"tools/call\", \"id\": 2, \"params\": {\"name\": \"echo\", "
+      "\"arguments\": {\"message\": \"TCP test message\"}}}" },
+    { "system_info",
+      "{\"jsonrpc\": \"2.0\", \"method\": \"tools/call\", \"id\": 3, \"params\": {\"name\": \"system_info\", "
+      "\"arguments\": {}}}" },
+    { "display_control",
+      "{\"jsonrpc\": \"2.0\", \"method\": \"tools/call\", \"id\": 4, \"params\": {\"name\": \"display_control\", "
+      "\"arguments\": {\"action\": \"show_text\", \"text\": \"TCP MCP Test\", \"x\": 10, \"y\": 50}}}" },
+    { "gpio_control",
+      "{\"jsonrpc\": \"2.0\", \"method\": \"tools/call\", \"id\": 5, \"params\": {\"name\": \"gpio_control\", "
+      "\"arguments\": {\"action\": \"set_led\", \"state\": true}}}" },
+};
+
+#define BENCH_PAYLOAD_COUNT         (sizeof(s_bench_payloads) / sizeof(s_bench_payloads[0]))
@@ -0,0 +1,104 @@
+/**
+ * @file bench_reactor.c
+ * @brief The select() reactor at 4, 8 and 16 connected clients
+ *
+ * For each client count, starts the server and transport with max_clients
+ * set to it, connects that many clients and has each one run ping round
+ * trips back to back from its own thread. Reports:
+ *   req/s        round trips per second over all clients
+ *   stack        stack reserved by the server's tasks while the clients
+ *                are connected (host_task_stack_bytes): the reactor and
+ *                the workers, whatever the client count
+ *   heap/client  heap held per connection once all are connected
+ *   peak heap    peak heap of the run above what the idle server held
+ *
+ * Usage: bench_reactor [--quick]
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "host_client.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define MAX_CLIENTS                 16
+#define RESPONSE_TIMEOUT_MS         5000
+
+typedef struct {
+    host_client_t client;
+    unsigned requests;
+} client_run_t;
+
+static client_run_t s_runs[MAX_CLIENTS];
+
+static void* client_thread(void* arg)
+{
+    client_run_t* run = arg;
+    char line[256];
+    for (unsigned i = 0; i < run->requests; i++) {
+        HOST_CHECK(host_client_send_line(&run->client, "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"ping\"}", i));
+        HOST_CHECK(host_client_read_line(&run->client, line, sizeof(line), RESPONSE_TIMEOUT_MS) > 0);
+    }
+    return NULL;
+}
+
+static void run(int clients, unsigned requests)
+{
+    mcp_server_config_t server_config;
+    mcp_tcp_transport_config_t transport_config;
+    host_server_default_config(&server_config, &transport_config);
+    transport_config.max_clients = clients;
+    
+    host_heap_stats_t idle, connected, after;
+    host_server_t host;
+    HOST_CHECK(host_server_start(&host, &server_config, &transport_config));
+    host_heap_get_stats(&idle);
+    host_heap_reset_peak();
+    
+    for (int i = 0; i < clients; i++) {
+        s_runs[i].requests = requests;
+        HOST_CHECK(host_client_connect(&s_runs[i].client, host.port));
+    }
+    
+    /* Every connection is set up once one round trip on it completed */
+    char line[256];
+    for (int i = 0; i < clients; i++) {
+        HOST_CHECK(host_client_send_line(&s_runs[i].client, "{\"jsonrpc\":\"2.0\",\"id\":0,\"method\":\"ping\"}"));
+        HOST_CHECK(host_client_read_line(&s_runs[i].client, line, sizeof(line), RESPONSE_TIMEOUT_MS) > 0);
+    }
+    host_heap_get_stats(&connected);
+    long stack_bytes = host_task_stack_bytes;
+    
+    pthread_t threads[MAX_CLIENTS];
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < clients; i++) {
+        pthread_create(&threads[i], NULL, client_thread, &s_runs[i]);
+    }
+    for (int i = 0; i < clients; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    int64_t elapsed = esp_timer_get_time() - start;
+    host_heap_get_stats(&after);
+    
+    printf("%7d %12.0f %10ld %12zu %10zu\n", clients,
+           (double)clients * requests * 1e6 / (double)(elapsed > 0 ? elapsed : 1),
+           stack_bytes, (connected.live_bytes - idle.live_bytes) / clients,
+           after.peak_bytes - idle.live_bytes);
+    
+    for (int i = 0; i < clients; i++) {
+        host_client_close(&s_runs[i].client);
+    }
+    host_server_stop(&host);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned requests = host_quick_run(argc, argv) ? 200 : 5000;
+    
+    printf("%7s %12s %10s %12s %10s\n", "clients", "req/s", "stack", "heap/client", "peak heap");
+    for (int clients = 4; clients <= MAX_CLIENTS; clients *= 2) {
+        run(clients, requests);
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file bench_writer.c
+ * @brief Response serialization: streaming writer vs the former cJSON round trip
+ * 
+ * For each tools/call payload of mcp_tcp_client.py, reports the bytes a
+ * response puts on the wire (plus its newline) and the CPU cycles per call:
+ *   writer  mcp_server_process_line: the envelope and the tool result are
+ *           written once, compactly, into the output buffer
+ *   cjson   the former path: the tool prints its cJSON result, the envelope
+ *           parses it back and pretty-prints the whole response
+ * Cycles come from esp_cpu_get_cycle_count(), the TSC on x86 hosts.
+ * 
+ * Usage: bench_writer [--quick]
+ */
+
+#include <string.h>
+#include "esp_cpu.h"
+#include "mcp_server_simple.h"
+#include "host_test.h"
+#include "baseline_cjson.h"
+#include "bench_payloads.h"
+
+#define BENCH_RESPONSE_SIZE         4096
+
+typedef esp_err_t (*bench_fn)(const char* request, char* output, size_t output_size);
+
+static mcp_server_handle_t s_server;
+
+static esp_err_t process_writer(const char* request, char* output, size_t output_size)
+{
+    return mcp_server_process_line(s_server, request, output, output_size);
+}
+
+static void run(const char* path, const bench_payload_t* payload, bench_fn fn, unsigned iterations)
+{
+    static char response[BENCH_RESPONSE_SIZE];
+    uint64_t cycles = 0;
+    
+    for (unsigned i = 0; i < iterations; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        esp_err_t ret = fn(payload->request, response, sizeof(response));
+        cycles += (uint32_t)(esp_cpu_get_cycle_count() - start);
+        HOST_CHECK(ret == ESP_OK);
+    }
+    
+    /* Every response of this payload has the same length */
+    printf("%-16s %-8s %10zu %14.0f\n", payload->name, path,
+           strlen(response) + 1, (double)cycles / iterations);
+}
+
+int main(int argc, char** argv)
+{
+    unsigned iterations = host_quick_run(argc, argv) ? 1000 : 100000;
+    
+    mcp_server_config_t config;
+    mcp_server_get_default_config(&config);
+    config.cache_max_bytes = 0;
+    HOST_CHECK(mcp_server_init(&config, &s_server) == ESP_OK);
+    HOST_CHECK(mcp_server_start(s_server) == ESP_OK);
+    
+    printf("%-16s %-8s %10s %14s\n", "payload", "path", "wire bytes", "cycles/call");
+    for (size_t i = 0; i < BENCH_PAYLOAD_COUNT; i++) {
+        run("writer", &s_bench_payloads[i], process_writer, iterations);
+#ifdef MCP_HOST_HAVE_CJSON
+        run("cjson", &s_bench_payloads[i], baseline_process_line, iterations);
+#endif
+    }
+#ifndef MCP_HOST_HAVE_CJSON
+    printf("cjson rows skipped: configure with -DMCP_HOST_CJSON_DIR=<dir with cJSON.c>\n");
+#endif
+    
+    mcp_server_stop(s_server);
+    mcp_server_deinit(s_server);
+    return 0;
+}
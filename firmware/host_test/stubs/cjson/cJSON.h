@@ -0,0 +1,18 @@
+/**
+ * @file cJSON.h
+ * @brief Declarations the components need when real cJSON is not available
+ * 
+ * Only mcp_arena_install_cjson_hooks() refers to cJSON; without cJSON
+ * sources (MCP_HOST_CJSON_DIR) cjson_hooks.c provides a no-op for it.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+typedef struct cJSON_Hooks {
+    void* (*malloc_fn)(size_t size);
+    void (*free_fn)(void* ptr);
+} cJSON_Hooks;
+
+void cJSON_InitHooks(cJSON_Hooks* hooks);
@@ -0,0 +1,11 @@
+/**
+ * @file cjson_hooks.c
+ * @brief No-op cJSON_InitHooks for host builds without cJSON
+ */
+
+#include "cJSON.h"
+
+void cJSON_InitHooks(cJSON_Hooks* hooks)
+{
+    (void)hooks;
+}
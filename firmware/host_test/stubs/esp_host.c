@@ -0,0 +1,169 @@
+/**
+ * @file esp_host.c
+ * @brief ESP-IDF system services and firmware hooks for host builds
+ * 
+ * The heap figures model a device heap of HOST_HEAP_SIZE bytes from which
+ * the live allocations of the process are taken (host_heap.c), so free-heap
+ * based shedding and the system:// values behave as on the device.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_system.h"
+#include "esp_chip_info.h"
+#include "driver/gpio.h"
+#include "host_test.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef HOST_HEAP_SIZE
+#define HOST_HEAP_SIZE              (320 * 1024)
+#endif
+
+int host_sndbuf;
+int host_log_quiet;
+
+static uint32_t s_gpio_levels;
+static size_t s_min_free = HOST_HEAP_SIZE;
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+        case ESP_OK:                    return "ESP_OK";
+        case ESP_FAIL:                  return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:  return "ESP_ERR_INVALID_RESPONSE";
+        default:                        return "UNKNOWN ERROR";
+    }
+}
+
+/* ---- Heap ---- */
+
+void* heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+size_t heap_caps_get_free_size(uint32_t caps)
+{
+    (void)caps;
+    host_heap_stats_t stats;
+    host_heap_get_stats(&stats);
+    
+    size_t used = stats.live_bytes < HOST_HEAP_SIZE ? stats.live_bytes : HOST_HEAP_SIZE;
+    size_t free_size = HOST_HEAP_SIZE - used;
+    if (free_size < s_min_free) {
+        s_min_free = free_size;
+    }
+    return free_size;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    return heap_caps_get_free_size(caps);
+}
+
+uint32_t esp_get_free_heap_size(void)
+{
+    return (uint32_t)heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    return (uint32_t)s_min_free;
+}
+
+/* ---- Time ---- */
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+uint32_t esp_cpu_get_cycle_count(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    /* No portable cycle counter: count at the ESP32-C6's 160 MHz */
+    return (uint32_t)(esp_timer_get_time() * 160);
+#endif
+}
+
+/* ---- System ---- */
+
+int esp_reset_reason(void)
+{
+    return 1;   /* ESP_RST_POWERON */
+}
+
+void esp_restart(void)
+{
+    fprintf(stderr, "esp_restart() called\n");
+    abort();
+}
+
+void esp_chip_info(esp_chip_info_t* info)
+{
+    memset(info, 0, sizeof(*info));
+    info->model = 13;   /* CHIP_ESP32C6 */
+    info->cores = 1;
+    info->features = CHIP_FEATURE_WIFI_BGN | CHIP_FEATURE_BLE | CHIP_FEATURE_IEEE802154;
+}
+
+int gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (level) {
+        s_gpio_levels |= 1u << gpio_num;
+    } else {
+        s_gpio_levels &= ~(1u << gpio_num);
+    }
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio_num)
+{
+    if (gpio_num < 0 || gpio_num >= GPIO_NUM_MAX) {
+        return 0;
+    }
+    return (s_gpio_levels >> gpio_num) & 1;
+}
+
+/* ---- Firmware hooks (main/firmware.cpp on the device) ---- */
+
+void* get_display_handle(void)
+{
+    return NULL;
+}
+
+uint32_t get_button_press_count(void)
+{
+    return 0;
+}
@@ -0,0 +1,448 @@
+/**
+ * @file freertos_host.c
+ * @brief FreeRTOS primitives emulated with pthreads for host builds
+ * 
+ * Only the behaviour the components rely on is reproduced: bounded waits
+ * in ticks (1 ms), copying queues, counting semaphores, event groups,
+ * task-local storage and self-deleting tasks. Scheduling, priorities and
+ * stack limits are the host's.
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#include "freertos/event_groups.h"
+#include "host_test.h"
+
+#define HOST_TLS_SLOTS              4
+#define HOST_TASK_LIST_MAX          16
+
+_Atomic long host_task_stack_bytes;
+
+static _Atomic unsigned s_task_count;
+static __thread long s_task_stack;
+static __thread void* s_tls[HOST_TLS_SLOTS];
+
+/* Absolute CLOCK_REALTIME deadline for a wait of ticks milliseconds */
+static void deadline_after(struct timespec* ts, TickType_t ticks)
+{
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += ticks / 1000;
+    ts->tv_nsec += (long)(ticks % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/* Wait on cond; false once ticks have passed (0: do not wait) */
+static bool wait_cond(pthread_cond_t* cond, pthread_mutex_t* mutex,
+                      TickType_t ticks, const struct timespec* deadline)
+{
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(cond, mutex);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, mutex, deadline) != ETIMEDOUT;
+}
+
+/* ---- Semaphores ---- */
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    UBaseType_t count;
+    UBaseType_t max_count;
+} host_sem_t;
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    host_sem_t* sem = calloc(1, sizeof(*sem));
+    if (!sem) {
+        return NULL;
+    }
+    pthread_mutex_init(&sem->mutex, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = initial_count;
+    sem->max_count = max_count;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t handle, TickType_t ticks_to_wait)
+{
+    host_sem_t* sem = handle;
+    struct timespec deadline;
+    deadline_after(&deadline, ticks_to_wait);
+    
+    pthread_mutex_lock(&sem->mutex);
+    while (sem->count == 0) {
+        if (!wait_cond(&sem->cond, &sem->mutex, ticks_to_wait, &deadline)) {
+            pthread_mutex_unlock(&sem->mutex);
+            return pdFALSE;
+        }
+    }
+    sem->count--;
+    pthread_mutex_unlock(&sem->mutex);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t handle)
+{
+    host_sem_t* sem = handle;
+    BaseType_t ret = pdFALSE;
+    
+    pthread_mutex_lock(&sem->mutex);
+    if (sem->count < sem->max_count) {
+        sem->count++;
+        pthread_cond_signal(&sem->cond);
+        ret = pdTRUE;
+    }
+    pthread_mutex_unlock(&sem->mutex);
+    return ret;
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t handle)
+{
+    host_sem_t* sem = handle;
+    pthread_mutex_lock(&sem->mutex);
+    UBaseType_t count = sem->count;
+    pthread_mutex_unlock(&sem->mutex);
+    return count;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t handle)
+{
+    host_sem_t* sem = handle;
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->mutex);
+    free(sem);
+}
+
+/* ---- Queues ---- */
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;            /* Broadcast on every send and receive */
+    uint8_t* items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+} host_queue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    host_queue_t* queue = calloc(1, sizeof(*queue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->items = malloc((size_t)length * item_size);
+    if (!queue->items) {
+        free(queue);
+        return NULL;
+    }
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+static BaseType_t queue_send(QueueHandle_t handle, const void* item, TickType_t ticks_to_wait, bool front)
+{
+    host_queue_t* queue = handle;
+    struct timespec deadline;
+    deadline_after(&deadline, ticks_to_wait);
+    
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == queue->length) {
+        if (!wait_cond(&queue->cond, &queue->mutex, ticks_to_wait, &deadline)) {
+            pthread_mutex_unlock(&queue->mutex);
+            return pdFALSE;
+        }
+    }
+    UBaseType_t slot;
+    if (front) {
+        queue->head = (queue->head + queue->length - 1) % queue->length;
+        slot = queue->head;
+    } else {
+        slot = (queue->head + queue->count) % queue->length;
+    }
+    memcpy(queue->items + (size_t)slot * queue->item_size, item, queue->item_size);
+    queue->count++;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait)
+{
+    return queue_send(queue, item, ticks_to_wait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t queue, const void* item, TickType_t ticks_to_wait)
+{
+    return queue_send(queue, item, ticks_to_wait, true);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t handle, void* item, TickType_t ticks_to_wait)
+{
+    host_queue_t* queue = handle;
+    struct timespec deadline;
+    deadline_after(&deadline, ticks_to_wait);
+    
+    pthread_mutex_lock(&queue->mutex);
+    while (queue->count == 0) {
+        if (!wait_cond(&queue->cond, &queue->mutex, ticks_to_wait, &deadline)) {
+            pthread_mutex_unlock(&queue->mutex);
+            return pdFALSE;
+        }
+    }
+    memcpy(item, queue->items + (size_t)queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->mutex);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t handle)
+{
+    host_queue_t* queue = handle;
+    pthread_mutex_lock(&queue->mutex);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+    return count;
+}
+
+void vQueueDelete(QueueHandle_t handle)
+{
+    host_queue_t* queue = handle;
+    pthread_cond_destroy(&queue->cond);
+    pthread_mutex_destroy(&queue->mutex);
+    free(queue->items);
+    free(queue);
+}
+
+/* ---- Event groups ---- */
+
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    EventBits_t bits;
+} host_event_group_t;
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    host_event_group_t* group = calloc(1, sizeof(*group));
+    if (!group) {
+        return NULL;
+    }
+    pthread_mutex_init(&group->mutex, NULL);
+    pthread_cond_init(&group->cond, NULL);
+    return group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t handle, EventBits_t bits)
+{
+    host_event_group_t* group = handle;
+    pthread_mutex_lock(&group->mutex);
+    group->bits |= bits;
+    EventBits_t result = group->bits;
+    pthread_cond_broadcast(&group->cond);
+    pthread_mutex_unlock(&group->mutex);
+    return result;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t handle, EventBits_t bits)
+{
+    host_event_group_t* group = handle;
+    pthread_mutex_lock(&group->mutex);
+    EventBits_t result = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->mutex);
+    return result;
+}
+
+static bool bits_satisfied(EventBits_t value, EventBits_t bits, BaseType_t wait_for_all)
+{
+    return wait_for_all ? (value & bits) == bits : (value & bits) != 0;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t handle, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks_to_wait)
+{
+    host_event_group_t* group = handle;
+    struct timespec deadline;
+    deadline_after(&deadline, ticks_to_wait);
+    
+    pthread_mutex_lock(&group->mutex);
+    while (!bits_satisfied(group->bits, bits, wait_for_all)) {
+        if (!wait_cond(&group->cond, &group->mutex, ticks_to_wait, &deadline)) {
+            break;
+        }
+    }
+    EventBits_t result = group->bits;
+    if (clear_on_exit && bits_satisfied(result, bits, wait_for_all)) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->mutex);
+    return result;
+}
+
+void vEventGroupDelete(EventGroupHandle_t handle)
+{
+    host_event_group_t* group = handle;
+    pthread_cond_destroy(&group->cond);
+    pthread_mutex_destroy(&group->mutex);
+    free(group);
+}
+
+/* ---- Tasks ---- */
+
+typedef struct {
+    TaskFunction_t function;
+    void* arg;
+    long stack_bytes;
+} host_task_start_t;
+
+static void task_exit(void)
+{
+    host_task_stack_bytes -= s_task_stack;
+    s_task_count--;
+}
+
+static void* task_trampoline(void* p)
+{
+    host_task_start_t start = *(host_task_start_t*)p;
+    free(p);
+    
+    s_task_stack = start.stack_bytes;
+    start.function(start.arg);
+    task_exit();
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t stack_depth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle)
+{
+    (void)name;
+    (void)priority;
+    
+    host_task_start_t* start = malloc(sizeof(*start));
+    if (!start) {
+        return pdFAIL;
+    }
+    start->function = function;
+    start->arg = arg;
+    start->stack_bytes = (long)stack_depth * (long)sizeof(StackType_t);
+    host_task_stack_bytes += start->stack_bytes;
+    s_task_count++;
+    
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, task_trampoline, start) != 0) {
+        host_task_stack_bytes -= start->stack_bytes;
+        s_task_count--;
+        free(start);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    if (handle) {
+        *handle = (TaskHandle_t)thread;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    /* The components only ever delete themselves */
+    if (!task) {
+        task_exit();
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    usleep((useconds_t)ticks * 1000);
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return (TaskHandle_t)pthread_self();
+}
+
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index)
+{
+    (void)task;
+    return index < HOST_TLS_SLOTS ? s_tls[index] : NULL;
+}
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void* value)
+{
+    (void)task;
+    if (index < HOST_TLS_SLOTS) {
+        s_tls[index] = value;
+    }
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    return s_task_count;
+}
+
+/* Pthreads cannot be enumerated; report the created tasks as anonymous entries */
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* tasks, UBaseType_t count, uint32_t* total_run_time)
+{
+    static char names[HOST_TASK_LIST_MAX][configMAX_TASK_NAME_LEN];
+    UBaseType_t n = s_task_count;
+    if (n > count) {
+        n = count;
+    }
+    if (n > HOST_TASK_LIST_MAX) {
+        n = HOST_TASK_LIST_MAX;
+    }
+    
+    for (UBaseType_t i = 0; i < n; i++) {
+        snprintf(names[i], sizeof(names[i]), "task_%u", (unsigned)(i + 1));
+        memset(&tasks[i], 0, sizeof(tasks[i]));
+        tasks[i].pcTaskName = names[i];
+        tasks[i].xTaskNumber = i + 1;
+        tasks[i].eCurrentState = eBlocked;
+    }
+    if (total_run_time) {
+        *total_run_time = 0;
+    }
+    return n;
+}
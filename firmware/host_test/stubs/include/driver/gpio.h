@@ -0,0 +1,18 @@
+/**
+ * @file gpio.h
+ * @brief Host stand-in for the GPIO driver (levels are remembered, not driven)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+    GPIO_NUM_0 = 0,
+    GPIO_NUM_8 = 8,
+    GPIO_NUM_9 = 9,
+    GPIO_NUM_MAX = 31
+} gpio_num_t;
+
+int gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+int gpio_get_level(gpio_num_t gpio_num);
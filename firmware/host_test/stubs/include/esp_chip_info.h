@@ -0,0 +1,21 @@
+/**
+ * @file esp_chip_info.h
+ * @brief Host stand-in for chip information
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define CHIP_FEATURE_WIFI_BGN       (1 << 0)
+#define CHIP_FEATURE_BLE            (1 << 1)
+#define CHIP_FEATURE_IEEE802154     (1 << 2)
+
+typedef struct {
+    int model;
+    uint32_t features;
+    uint16_t revision;
+    uint8_t cores;
+} esp_chip_info_t;
+
+void esp_chip_info(esp_chip_info_t* info);
@@ -0,0 +1,6 @@
+/**
+ * @file esp_event.h
+ * @brief Host stand-in (nothing used on the host)
+ */
+
+#pragma once
@@ -0,0 +1,17 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host stand-in for the capability-based heap API
+ */
+
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_DEFAULT          0
+#define MALLOC_CAP_8BIT             0
+
+void* heap_caps_malloc(size_t size, uint32_t caps);
+void* heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+size_t heap_caps_get_free_size(uint32_t caps);
+size_t heap_caps_get_largest_free_block(uint32_t caps);
@@ -0,0 +1,8 @@
+/**
+ * @file esp_idf_version.h
+ * @brief Host stand-in for the IDF version string
+ */
+
+#pragma once
+
+#define IDF_VER                     "host"
@@ -0,0 +1,36 @@
+/**
+ * @file esp_log.h
+ * @brief Host stand-in for ESP-IDF logging
+ * 
+ * Errors and warnings go to stderr unless a test that provokes them sets
+ * host_log_quiet; info and debug output is compiled out unless
+ * HOST_LOG_VERBOSE is defined, so benchmarks are not timing printf.
+ */
+
+#pragma once
+
+#include <stdio.h>
+
+extern int host_log_quiet;
+
+#define HOST_LOG(level, tag, fmt, ...) \
+    fprintf(stderr, level " (%s) " fmt "\n", tag, ##__VA_ARGS__)
+
+#define HOST_LOG_ON(level, tag, fmt, ...) \
+    do { if (!host_log_quiet) { HOST_LOG(level, tag, fmt, ##__VA_ARGS__); } } while (0)
+
+#define ESP_LOGE(tag, fmt, ...)     HOST_LOG_ON("E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...)     HOST_LOG_ON("W", tag, fmt, ##__VA_ARGS__)
+
+#ifdef HOST_LOG_VERBOSE
+#define ESP_LOGI(tag, fmt, ...)     HOST_LOG("I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)     HOST_LOG("D", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...)     HOST_LOG("V", tag, fmt, ##__VA_ARGS__)
+#else
+/* Arguments stay referenced, as with a compiled-out level on the device */
+#define HOST_LOG_OFF(tag, fmt, ...) \
+    do { if (0) { HOST_LOG("", tag, fmt, ##__VA_ARGS__); } } while (0)
+#define ESP_LOGI(tag, fmt, ...)     HOST_LOG_OFF(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...)     HOST_LOG_OFF(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGV(tag, fmt, ...)     HOST_LOG_OFF(tag, fmt, ##__VA_ARGS__)
+#endif
@@ -0,0 +1,14 @@
+/**
+ * @file esp_system.h
+ * @brief Host stand-in for the ESP-IDF system API
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+int esp_reset_reason(void);
+void esp_restart(void);
@@ -0,0 +1,28 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS base types (1 tick = 1 ms)
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "esp_heap_caps.h"
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdTRUE                      1
+#define pdFALSE                     0
+#define pdPASS                      1
+#define pdFAIL                      0
+#define portMAX_DELAY               0xffffffffu
+#define portTICK_PERIOD_MS          1
+#define pdMS_TO_TICKS(ms)           ((TickType_t)(ms))
+#define configMAX_TASK_NAME_LEN     16
+
+#ifndef configUSE_TRACE_FACILITY
+#define configUSE_TRACE_FACILITY    1
+#endif
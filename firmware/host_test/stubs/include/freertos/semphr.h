@@ -0,0 +1,21 @@
+/**
+ * @file semphr.h
+ * @brief Host stand-in for FreeRTOS semaphores (pthread mutex + condition)
+ * 
+ * Mutexes are binary semaphores here: no priority inheritance and no
+ * recursion, which the components do not rely on.
+ */
+
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks_to_wait);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
@@ -0,0 +1,8 @@
+/**
+ * @file netdb.h
+ * @brief Host stand-in: lwIP's netdb maps onto the POSIX one
+ */
+
+#pragma once
+
+#include <netdb.h>
@@ -0,0 +1,32 @@
+/**
+ * @file sockets.h
+ * @brief Host stand-in: lwIP's BSD socket API maps onto the POSIX one
+ * 
+ * Loopback sockets buffer far more than lwIP's TCP_SND_BUF, so a slow
+ * reader would never fill them. Accepted sockets get a send buffer of
+ * host_sndbuf bytes when it is set (host_test.h), as on the device.
+ */
+
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+extern int host_sndbuf;
+
+static inline int host_accept(int fd, struct sockaddr* addr, socklen_t* addr_len)
+{
+    int sock = accept(fd, addr, addr_len);
+    if (sock >= 0 && host_sndbuf > 0) {
+        setsockopt(sock, SOL_SOCKET, SO_SNDBUF, &host_sndbuf, sizeof(host_sndbuf));
+    }
+    return sock;
+}
+
+#define accept(fd, addr, addr_len) host_accept(fd, addr, addr_len)
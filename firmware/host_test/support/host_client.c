@@ -0,0 +1,169 @@
+/**
+ * @file host_client.c
+ * @brief Blocking line-oriented TCP client for the transport tests
+ */
+
+#define _GNU_SOURCE
+
+#include "host_client.h"
+#include "mcp_cbor.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define HOST_CONNECT_ATTEMPTS       50
+#define HOST_CONNECT_RETRY_US       20000
+
+int host_client_rcvbuf;
+
+bool host_client_connect(host_client_t* client, uint16_t port)
+{
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+    };
+    
+    client->len = 0;
+    for (int attempt = 0; attempt < HOST_CONNECT_ATTEMPTS; attempt++) {
+        client->sock = socket(AF_INET, SOCK_STREAM, 0);
+        if (client->sock < 0) {
+            return false;
+        }
+        if (host_client_rcvbuf > 0) {
+            setsockopt(client->sock, SOL_SOCKET, SO_RCVBUF, &host_client_rcvbuf,
+                       sizeof(host_client_rcvbuf));
+        }
+        if (connect(client->sock, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            setsockopt(client->sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return true;
+        }
+        close(client->sock);
+        usleep(HOST_CONNECT_RETRY_US);
+    }
+    client->sock = -1;
+    return false;
+}
+
+bool host_client_send(host_client_t* client, const char* data, size_t len)
+{
+    while (len > 0) {
+        ssize_t sent = send(client->sock, data, len, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        len -= (size_t)sent;
+    }
+    return true;
+}
+
+bool host_client_send_line(host_client_t* client, const char* fmt, ...)
+{
+    char line[8192];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line) - 1, fmt, args);
+    va_end(args);
+    
+    if (len < 0 || len >= (int)sizeof(line) - 1) {
+        return false;
+    }
+    line[len++] = '\n';
+    return host_client_send(client, line, (size_t)len);
+}
+
+/* Wait for data; false on timeout, error or end of stream */
+static bool receive_more(host_client_t* client, int timeout_ms)
+{
+    if (client->len == sizeof(client->buffer)) {
+        return false;
+    }
+    
+    struct pollfd pfd = { .fd = client->sock, .events = POLLIN };
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return false;
+    }
+    ssize_t received = recv(client->sock, client->buffer + client->len,
+                            sizeof(client->buffer) - client->len, 0);
+    if (received <= 0) {
+        return false;
+    }
+    client->len += (size_t)received;
+    return true;
+}
+
+int host_client_read_line(host_client_t* client, char* line, size_t size, int timeout_ms)
+{
+    for (;;) {
+        char* newline = memchr(client->buffer, '\n', client->len);
+        if (newline) {
+            size_t len = (size_t)(newline - client->buffer);
+            size_t copy = len < size - 1 ? len : size - 1;
+            memcpy(line, client->buffer, copy);
+            line[copy] = '\0';
+            
+            client->len -= len + 1;
+            memmove(client->buffer, newline + 1, client->len);
+            return (int)copy;
+        }
+        if (!receive_more(client, timeout_ms)) {
+            return -1;
+        }
+    }
+}
+
+int host_client_read_item(host_client_t* client, uint8_t* item, size_t size, int timeout_ms)
+{
+    for (;;) {
+        int len = mcp_cbor_item_size((const uint8_t*)client->buffer, client->len);
+        if (len < 0 || (size_t)len > size) {
+            return -1;
+        }
+        if (len > 0) {
+            memcpy(item, client->buffer, (size_t)len);
+            client->len -= (size_t)len;
+            memmove(client->buffer, client->buffer + len, client->len);
+            return len;
+        }
+        if (!receive_more(client, timeout_ms)) {
+            return -1;
+        }
+    }
+}
+
+bool host_client_wait_closed(host_client_t* client, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = client->sock, .events = POLLIN };
+    char scratch[4096];
+    
+    for (;;) {
+        if (poll(&pfd, 1, timeout_ms) <= 0) {
+            return false;
+        }
+        ssize_t received = recv(client->sock, scratch, sizeof(scratch), 0);
+        if (received <= 0) {
+            return true;
+        }
+    }
+}
+
+void host_client_close(host_client_t* client)
+{
+    if (client->sock >= 0) {
+        close(client->sock);
+        client->sock = -1;
+    }
+}
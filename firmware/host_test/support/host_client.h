@@ -0,0 +1,58 @@
+/**
+ * @file host_client.h
+ * @brief Blocking line-oriented TCP client for the transport tests
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HOST_CLIENT_BUFFER_SIZE     (64 * 1024)
+
+typedef struct {
+    int sock;
+    size_t len;                     /* Bytes received but not yet returned */
+    char buffer[HOST_CLIENT_BUFFER_SIZE];
+} host_client_t;
+
+/* SO_RCVBUF of the connections made from now on, 0 for the host default */
+extern int host_client_rcvbuf;
+
+/* Connect to 127.0.0.1:port; retries while the server is starting */
+bool host_client_connect(host_client_t* client, uint16_t port);
+
+/* Send all bytes */
+bool host_client_send(host_client_t* client, const char* data, size_t len);
+
+/* Format a line and send it with its newline */
+bool host_client_send_line(host_client_t* client, const char* fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+/**
+ * Receive the next line without its newline (NUL-terminated). Returns its
+ * length, -1 on timeout or when the server closed the connection. A line
+ * longer than size is truncated.
+ */
+int host_client_read_line(host_client_t* client, char* line, size_t size, int timeout_ms);
+
+/**
+ * Receive the next item of a CBOR session. Returns its size, -1 on timeout,
+ * when the server closed the connection, or when the item is malformed or
+ * longer than size.
+ */
+int host_client_read_item(host_client_t* client, uint8_t* item, size_t size, int timeout_ms);
+
+/* True once the server has closed the connection (waits up to timeout_ms) */
+bool host_client_wait_closed(host_client_t* client, int timeout_ms);
+
+void host_client_close(host_client_t* client);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file host_heap.c
+ * @brief Live and peak heap accounting for host builds
+ * 
+ * Every target linking mcp_host is linked with --wrap for malloc, calloc,
+ * realloc and free, so allocations made by the components, cJSON and the
+ * tests are counted. Sizes are the allocator's usable sizes, the same
+ * granularity the device heap reports.
+ */
+
+#define _GNU_SOURCE
+
+#include <malloc.h>
+#include <stdatomic.h>
+#include "host_test.h"
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void __real_free(void* ptr);
+
+static atomic_long s_live;
+static atomic_long s_peak;
+static atomic_ullong s_allocations;
+
+static void heap_add(void* ptr)
+{
+    long size = (long)malloc_usable_size(ptr);
+    long live = atomic_fetch_add(&s_live, size) + size;
+    long peak = atomic_load(&s_peak);
+    while (live > peak && !atomic_compare_exchange_weak(&s_peak, &peak, live)) {
+        /* peak was reloaded; retry */
+    }
+    atomic_fetch_add(&s_allocations, 1);
+}
+
+static void heap_sub(void* ptr)
+{
+    atomic_fetch_sub(&s_live, (long)malloc_usable_size(ptr));
+}
+
+void* __wrap_malloc(size_t size)
+{
+    void* ptr = __real_malloc(size);
+    if (ptr) {
+        heap_add(ptr);
+    }
+    return ptr;
+}
+
+void* __wrap_calloc(size_t n, size_t size)
+{
+    void* ptr = __real_calloc(n, size);
+    if (ptr) {
+        heap_add(ptr);
+    }
+    return ptr;
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    size_t old_size = ptr ? malloc_usable_size(ptr) : 0;
+    void* result = __real_realloc(ptr, size);
+    if (result) {
+        atomic_fetch_sub(&s_live, (long)old_size);
+        heap_add(result);
+    } else if (size == 0) {
+        atomic_fetch_sub(&s_live, (long)old_size);
+    }
+    return result;
+}
+
+void __wrap_free(void* ptr)
+{
+    if (ptr) {
+        heap_sub(ptr);
+        __real_free(ptr);
+    }
+}
+
+void host_heap_get_stats(host_heap_stats_t* stats)
+{
+    long live = atomic_load(&s_live);
+    long peak = atomic_load(&s_peak);
+    stats->live_bytes = live > 0 ? (size_t)live : 0;
+    stats->peak_bytes = peak > 0 ? (size_t)peak : 0;
+    stats->allocations = atomic_load(&s_allocations);
+}
+
+void host_heap_reset_peak(void)
+{
+    atomic_store(&s_peak, atomic_load(&s_live));
+}
@@ -0,0 +1,95 @@
+/**
+ * @file host_server.c
+ * @brief MCP server plus TCP transport on a loopback port, for the tests
+ */
+
+#include "host_server.h"
+
+#include <signal.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_test.h"
+
+#define HOST_PORT_BASE              20000
+#define HOST_PORT_RANGE             20000
+#define HOST_TAG_SIZE               64
+
+static esp_err_t delay_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out)
+{
+    int32_t ms = 0;
+    char tag[HOST_TAG_SIZE] = "";
+    mcp_json_get_int(doc, mcp_json_find(doc, args, "ms"), &ms);
+    mcp_json_get_string(doc, mcp_json_find(doc, args, "tag"), tag, sizeof(tag));
+    
+    int32_t steps = 0;
+    while (steps < ms && !mcp_request_should_stop()) {
+        vTaskDelay(1);
+        steps++;
+    }
+    
+    mcp_json_writer_begin_object(out);
+    mcp_json_writer_add_string(out, "tag", tag);
+    mcp_json_writer_add_int(out, "steps", steps);
+    mcp_json_writer_end_object(out);
+    return ESP_OK;
+}
+
+const mcp_tool_def_t host_delay_tool = {
+    .name = "delay",
+    .description = "Sleep for a number of milliseconds (host tests)",
+    .type = MCP_TOOL_CUSTOM,
+    .input_schema = "{\"type\":\"object\",\"properties\":{\"ms\":{\"type\":\"integer\"},"
+                    "\"tag\":{\"type\":\"string\"}}}",
+    .execute = delay_execute,
+};
+
+void host_server_default_config(mcp_server_config_t* server_config,
+                                mcp_tcp_transport_config_t* transport_config)
+{
+    mcp_server_get_default_config(server_config);
+    
+    mcp_tcp_transport_config_t defaults = MCP_TCP_TRANSPORT_CONFIG_DEFAULT();
+    *transport_config = defaults;
+    transport_config->server_port = (uint16_t)(HOST_PORT_BASE + getpid() % HOST_PORT_RANGE);
+    transport_config->rate_limit_rps = 0;
+    transport_config->shed_queue_depth = 0;
+    transport_config->shed_free_heap = 0;
+}
+
+bool host_server_start(host_server_t* host,
+                       const mcp_server_config_t* server_config,
+                       const mcp_tcp_transport_config_t* transport_config)
+{
+    /* Writes to a reset peer must fail with EPIPE, as lwIP's do */
+    signal(SIGPIPE, SIG_IGN);
+    
+    host->port = transport_config->server_port;
+    if (mcp_server_init(server_config, &host->server) != ESP_OK) {
+        return false;
+    }
+    if (mcp_server_register_tool(host->server, &host_delay_tool) != ESP_OK ||
+        mcp_server_start(host->server) != ESP_OK) {
+        mcp_server_deinit(host->server);
+        return false;
+    }
+    if (mcp_tcp_transport_init(transport_config, &host->transport) != ESP_OK) {
+        mcp_server_stop(host->server);
+        mcp_server_deinit(host->server);
+        return false;
+    }
+    mcp_tcp_transport_set_mcp_server(host->transport, host->server);
+    if (mcp_tcp_transport_start(host->transport) != ESP_OK) {
+        host_server_stop(host);
+        return false;
+    }
+    return true;
+}
+
+void host_server_stop(host_server_t* host)
+{
+    mcp_tcp_transport_stop(host->transport);
+    mcp_tcp_transport_deinit(host->transport);
+    mcp_server_stop(host->server);
+    mcp_server_deinit(host->server);
+}
@@ -0,0 +1,46 @@
+/**
+ * @file host_server.h
+ * @brief MCP server plus TCP transport on a loopback port, for the tests
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "mcp_server_simple.h"
+#include "mcp_tcp_transport.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    mcp_server_handle_t server;
+    mcp_tcp_transport_handle_t transport;
+    uint16_t port;
+} host_server_t;
+
+/**
+ * Defaults of both components, with admission control off (the tests send
+ * faster than a client is allowed to) and a port unique to the process.
+ */
+void host_server_default_config(mcp_server_config_t* server_config,
+                                mcp_tcp_transport_config_t* transport_config);
+
+/* Start the server and the transport; the delay tool is registered */
+bool host_server_start(host_server_t* host,
+                       const mcp_server_config_t* server_config,
+                       const mcp_tcp_transport_config_t* transport_config);
+
+void host_server_stop(host_server_t* host);
+
+/**
+ * "delay" tool: sleeps for arguments.ms milliseconds in 1 ms steps, stopping
+ * early once mcp_request_should_stop(), and returns
+ * {"tag":<arguments.tag>,"steps":<ms slept>}.
+ */
+extern const mcp_tool_def_t host_delay_tool;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,60 @@
+/**
+ * @file host_test.h
+ * @brief Helpers shared by the host tests and benchmarks
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Fail the test with the location and expression */
+#define HOST_CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+/* Heap accounting of the process (malloc and friends are wrapped at link time) */
+typedef struct {
+    size_t live_bytes;              /* Bytes currently allocated */
+    size_t peak_bytes;              /* Highest live_bytes since the last reset */
+    uint64_t allocations;           /* malloc/calloc/realloc calls that allocated */
+} host_heap_stats_t;
+
+void host_heap_get_stats(host_heap_stats_t* stats);
+
+/* Start a new peak measurement from the current live bytes */
+void host_heap_reset_peak(void);
+
+/* Stack bytes requested by the tasks currently running (freertos_host.c) */
+extern _Atomic long host_task_stack_bytes;
+
+/* SO_SNDBUF for accepted sockets, 0 for the host default (lwip/sockets.h) */
+extern int host_sndbuf;
+
+/* Set to silence the errors and warnings a test provokes on purpose (esp_log.h) */
+extern int host_log_quiet;
+
+/* True when the benchmark should run its short smoke-test variant */
+static inline bool host_quick_run(int argc, char** argv)
+{
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] == '-' && argv[i][1] == '-' && argv[i][2] == 'q') {
+            return true;
+        }
+    }
+    return getenv("MCP_HOST_QUICK") != NULL;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,181 @@
+/**
+ * @file test_arena_fragmentation.c
+ * @brief 100k mixed requests must not fragment or leak heap
+ * 
+ * Four client threads submit a mix of methods, tool calls, errors, batches
+ * and notifications to the worker pool, two requests in flight each, like
+ * pipelined TCP clients. After a warm-up, the heap is sampled; after the
+ * run it must not have grown, gained free holes, or kept any allocation.
+ * 
+ * All threads share glibc's main arena (M_ARENA_MAX 1), so mallinfo2()
+ * describes the whole heap the way the single device heap would be.
+ */
+
+#define _GNU_SOURCE
+
+#include <malloc.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "mcp_server_simple.h"
+#include "host_test.h"
+
+#define CLIENTS                     4
+#define PIPELINE_DEPTH              2
+#define TOTAL_REQUESTS              100000
+#define WARMUP_REQUESTS             10000
+#define MAX_HEAP_GROWTH             (64 * 1024)
+#define MAX_HOLE_GROWTH             (16 * 1024)
+#define MAX_LIVE_GROWTH             256
+
+typedef struct {
+    const char* request;
+    bool answered;                  /* Gets a response (not a notification) */
+} mixed_request_t;
+
+static const mixed_request_t s_mix[] = {
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"tools/list\",\"id\":1}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"id\":2,\"params\":{\"name\":\"echo\","
+      "\"arguments\":{\"message\":\"TCP test message\"}}}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"id\":3,\"params\":{\"name\":\"system_info\","
+      "\"arguments\":{}}}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"id\":4,\"params\":{\"name\":\"display_control\","
+      "\"arguments\":{\"action\":\"show_text\",\"text\":\"TCP MCP Test\",\"x\":10,\"y\":50}}}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"id\":5,\"params\":{\"name\":\"gpio_control\","
+      "\"arguments\":{\"action\":\"set_led\",\"state\":true}}}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"initialize\",\"id\":6,\"params\":{\"protocolVersion\":\"2024-11-05\","
+      "\"capabilities\":{},\"clientInfo\":{\"name\":\"host\",\"version\":\"1\"}}}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"server/metrics\",\"id\":7}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"resources/list\",\"id\":8}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"resources/read\",\"id\":9,\"params\":{\"uri\":\"system://heap\"}}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"no/such/method\",\"id\":10}", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"id\":11,\"params\":{\"name\":\"no_such_tool\"}}", true },
+    { "{bad json", true },
+    { "[{\"jsonrpc\":\"2.0\",\"method\":\"ping\",\"id\":12},"
+      "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"id\":13,\"params\":{\"name\":\"echo\","
+      "\"arguments\":{\"message\":\"batched\"}}}]", true },
+    { "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/initialized\"}", false },
+};
+
+#define MIX_COUNT                   (sizeof(s_mix) / sizeof(s_mix[0]))
+
+typedef struct {
+    unsigned index;
+    unsigned requests;
+    SemaphoreHandle_t slots;        /* Free pipeline slots */
+} client_t;
+
+static mcp_server_handle_t s_server;
+static atomic_uint s_bad_responses;
+
+static void on_complete(const mcp_message_t* msg, char* response, size_t response_len, esp_err_t status)
+{
+    client_t* client = msg->user_ctx;
+    const mixed_request_t* sent = NULL;
+    for (size_t i = 0; i < MIX_COUNT; i++) {
+        if (strlen(s_mix[i].request) == msg->request_len &&
+            memcmp(s_mix[i].request, msg->request, msg->request_len) == 0) {
+            sent = &s_mix[i];
+        }
+    }
+    if (!sent || (response_len > 0) != sent->answered) {
+        atomic_fetch_add(&s_bad_responses, 1);
+    }
+    xSemaphoreGive(client->slots);
+}
+
+static void* client_thread(void* arg)
+{
+    client_t* client = arg;
+    for (unsigned i = 0; i < client->requests; i++) {
+        const char* request = s_mix[(i + client->index) % MIX_COUNT].request;
+        xSemaphoreTake(client->slots, portMAX_DELAY);
+        while (mcp_server_submit(s_server, client->index, request, strlen(request), MCP_WIRE_JSON,
+                                 on_complete, client) == ESP_ERR_TIMEOUT) {
+            vTaskDelay(1);
+        }
+    }
+    
+    /* Wait for the last responses */
+    for (unsigned i = 0; i < PIPELINE_DEPTH; i++) {
+        xSemaphoreTake(client->slots, portMAX_DELAY);
+    }
+    for (unsigned i = 0; i < PIPELINE_DEPTH; i++) {
+        xSemaphoreGive(client->slots);
+    }
+    return NULL;
+}
+
+static void run_clients(unsigned total)
+{
+    pthread_t threads[CLIENTS];
+    static client_t clients[CLIENTS];
+    
+    for (unsigned i = 0; i < CLIENTS; i++) {
+        clients[i].index = i;
+        clients[i].requests = total / CLIENTS;
+        if (!clients[i].slots) {
+            clients[i].slots = xSemaphoreCreateCounting(PIPELINE_DEPTH, PIPELINE_DEPTH);
+        }
+        pthread_create(&threads[i], NULL, client_thread, &clients[i]);
+    }
+    for (unsigned i = 0; i < CLIENTS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+static size_t heap_holes(const struct mallinfo2* info)
+{
+    /* Free bytes inside the heap, excluding the releasable top chunk */
+    return info->fordblks - info->keepcost;
+}
+
+int main(void)
+{
+    mallopt(M_ARENA_MAX, 1);
+    host_log_quiet = 1;     /* The mix includes parse and lookup errors */
+    
+    mcp_server_config_t config;
+    mcp_server_get_default_config(&config);
+    config.worker_count = 2;
+    HOST_CHECK(mcp_server_init(&config, &s_server) == ESP_OK);
+    HOST_CHECK(mcp_server_start(s_server) == ESP_OK);
+    
+    mcp_system_sample_t sample = { .uptime_seconds = 1, .free_heap = 200000, .min_free_heap = 180000 };
+    HOST_CHECK(mcp_server_publish_sample(s_server, &sample) == ESP_OK);
+    
+    run_clients(WARMUP_REQUESTS);
+    
+    host_heap_stats_t live_before, live_after;
+    host_heap_get_stats(&live_before);
+    struct mallinfo2 before = mallinfo2();
+    
+    run_clients(TOTAL_REQUESTS);
+    
+    host_heap_get_stats(&live_after);
+    struct mallinfo2 after = mallinfo2();
+    
+    mcp_server_stats_t stats;
+    HOST_CHECK(mcp_server_get_stats(s_server, &stats) == ESP_OK);
+    mcp_arena_stats_t arena;
+    HOST_CHECK(mcp_server_get_arena_stats(s_server, 0, &arena) == ESP_OK);
+    
+    printf("requests      %u (+%u warm-up), %u arena fallbacks, arena high water %u bytes\n",
+           TOTAL_REQUESTS, WARMUP_REQUESTS, stats.arena_fallbacks, (unsigned)arena.high_water);
+    printf("heap size     %zu -> %zu bytes\n", before.arena, after.arena);
+    printf("heap holes    %zu -> %zu bytes\n", heap_holes(&before), heap_holes(&after));
+    printf("live bytes    %zu -> %zu\n", live_before.live_bytes, live_after.live_bytes);
+    
+    HOST_CHECK(atomic_load(&s_bad_responses) == 0);
+    HOST_CHECK(after.arena <= before.arena + MAX_HEAP_GROWTH);
+    HOST_CHECK(heap_holes(&after) <= heap_holes(&before) + MAX_HOLE_GROWTH);
+    HOST_CHECK(live_after.live_bytes <= live_before.live_bytes + MAX_LIVE_GROWTH);
+    
+    mcp_server_stop(s_server);
+    mcp_server_deinit(s_server);
+    printf("test_arena_fragmentation: OK\n");
+    return 0;
+}
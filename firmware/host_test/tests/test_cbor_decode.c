@@ -0,0 +1,137 @@
+/**
+ * @file test_cbor_decode.c
+ * @brief CBOR requests decode into the request arena and still fit when large
+ *
+ * A client negotiates CBOR and sends small requests, which must decode
+ * without a heap fallback of the request arena. Then an echo whose JSON
+ * form is several times its CBOR size (control characters each become a
+ * \u escape) must still be answered, and one whose JSON form exceeds the
+ * message limit must be refused as too large.
+ */
+
+#include <string.h>
+#include "mcp_cbor.h"
+#include "mcp_json.h"
+#include "host_client.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define EXPANDING_CHARS             300     /* JSON about 6x the CBOR, under the limit */
+#define OVERSIZED_CHARS             1000    /* JSON over MCP_MAX_MESSAGE_SIZE */
+#define RESPONSE_TIMEOUT_MS         5000
+#define TOKENS                      64
+
+static host_client_t s_client;
+static char s_json[8 * 1024];
+static uint8_t s_item[4 * 1024];
+static char s_text[16 * 1024];
+
+static uint32_t arena_fallbacks(const host_server_t* host, uint32_t arena_count)
+{
+    uint32_t fallbacks = 0;
+    for (uint32_t i = 0; i < arena_count; i++) {
+        mcp_arena_stats_t stats;
+        HOST_CHECK(mcp_server_get_arena_stats(host->server, i, &stats) == ESP_OK);
+        fallbacks += stats.fallback_count;
+    }
+    return fallbacks;
+}
+
+/* Send a JSON request as a CBOR item */
+static void send_cbor(const char* json)
+{
+    mcp_json_writer_t w;
+    mcp_json_writer_init(&w, (char*)s_item, sizeof(s_item));
+    mcp_json_writer_set_format(&w, MCP_WIRE_CBOR);
+    mcp_json_writer_raw(&w, json, strlen(json));
+    HOST_CHECK(mcp_json_writer_finish(&w) == ESP_OK);
+    HOST_CHECK(host_client_send(&s_client, (const char*)s_item, mcp_json_writer_length(&w)));
+}
+
+/* An echo of count U+0001 characters */
+static void send_echo(unsigned id, unsigned count)
+{
+    int len = snprintf(s_json, sizeof(s_json),
+                       "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/call\",\"params\":"
+                       "{\"name\":\"echo\",\"arguments\":{\"message\":\"", id);
+    for (unsigned i = 0; i < count; i++) {
+        HOST_CHECK(len + 6 < (int)sizeof(s_json));
+        memcpy(s_json + len, "\\u0001", 6);
+        len += 6;
+    }
+    snprintf(s_json + len, sizeof(s_json) - len, "\"}}}");
+    send_cbor(s_json);
+}
+
+/* Receive the next response and return its JSON form, tokenized */
+static void read_response(mcp_json_doc_t* doc, mcp_json_token_t* tokens)
+{
+    int len = host_client_read_item(&s_client, s_item, sizeof(s_item), RESPONSE_TIMEOUT_MS);
+    HOST_CHECK(len > 0);
+    mcp_json_writer_t w;
+    mcp_json_writer_init(&w, s_text, sizeof(s_text));
+    HOST_CHECK(mcp_cbor_to_json(s_item, (size_t)len, &w) == ESP_OK);
+    int count = mcp_json_parse(s_text, mcp_json_writer_length(&w), tokens, TOKENS);
+    HOST_CHECK(count > 0);
+    *doc = (mcp_json_doc_t){ s_text, tokens, count };
+}
+
+static void check_result(unsigned id)
+{
+    mcp_json_token_t tokens[TOKENS];
+    mcp_json_doc_t doc;
+    read_response(&doc, tokens);
+    uint32_t value;
+    HOST_CHECK(mcp_json_get_u32(&doc, mcp_json_find(&doc, 0, "id"), &value) == ESP_OK && value == id);
+    HOST_CHECK(mcp_json_find(&doc, 0, "result") >= 0);
+}
+
+int main(void)
+{
+    mcp_server_config_t server_config;
+    mcp_tcp_transport_config_t transport_config;
+    host_server_default_config(&server_config, &transport_config);
+    server_config.cache_max_bytes = 0;
+    host_log_quiet = 1;     /* The oversized request is logged */
+    
+    host_server_t host;
+    HOST_CHECK(host_server_start(&host, &server_config, &transport_config));
+    HOST_CHECK(host_client_connect(&s_client, host.port));
+    
+    /* The initialize response is the last JSON line */
+    HOST_CHECK(host_client_send_line(&s_client,
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"initialize\",\"params\":{\"capabilities\":"
+        "{\"experimental\":{\"encoding\":{\"accept\":[\"cbor\"]}}}}}"));
+    char line[1024];
+    HOST_CHECK(host_client_read_line(&s_client, line, sizeof(line), RESPONSE_TIMEOUT_MS) > 0);
+    HOST_CHECK(strstr(line, "\"selected\":\"cbor\"") != NULL);
+    
+    /* Small requests decode inside the arena */
+    uint32_t fallbacks = arena_fallbacks(&host, server_config.arena_count);
+    send_cbor("{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"ping\"}");
+    check_result(2);
+    send_cbor("{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"tools/call\",\"params\":"
+              "{\"name\":\"echo\",\"arguments\":{\"message\":\"hello\"}}}");
+    check_result(3);
+    uint32_t small_fallbacks = arena_fallbacks(&host, server_config.arena_count) - fallbacks;
+    
+    /* A request expanding well past its CBOR size is decoded at full size */
+    send_echo(4, EXPANDING_CHARS);
+    check_result(4);
+    
+    /* One whose JSON form is over the limit is refused */
+    send_echo(5, OVERSIZED_CHARS);
+    mcp_json_token_t tokens[TOKENS];
+    mcp_json_doc_t doc;
+    read_response(&doc, tokens);
+    HOST_CHECK(mcp_json_type(&doc, mcp_json_find(&doc, 0, "id")) == MCP_JSON_NULL);
+    HOST_CHECK(strstr(s_text, "Message too large") != NULL);
+    
+    printf("%u arena fallbacks for small CBOR requests\n", (unsigned)small_fallbacks);
+    HOST_CHECK(small_fallbacks == 0);
+    
+    host_client_close(&s_client);
+    host_server_stop(&host);
+    printf("test_cbor_decode: OK\n");
+    return 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file test_flood.c
+ * @brief Well-behaved clients keep their latency while another floods
+ *
+ * With the transport's default admission settings (rate_limit_rps,
+ * rate_limit_burst, shed_queue_depth, shed_free_heap), one client sends
+ * tool calls back to back as fast as the socket takes them while the
+ * others each send one call every CALL_INTERVAL_MS, well inside the rate
+ * limit. The flooder must be rate limited, the others never refused, and
+ * the p99 of their round trips must stay under P99_LIMIT_MS.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "esp_timer.h"
+#include "host_client.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define CLIENTS                     3       /* With the flooder, the default max_clients */
+#define CALLS                       30
+#define CALL_INTERVAL_MS            100
+#define CALL_MS                     1
+#define FLOOD_CALL_MS               20
+#define P99_LIMIT_MS                100
+#define RESPONSE_TIMEOUT_MS         5000
+#define FLOOD_READ_TIMEOUT_MS       100
+
+typedef struct {
+    uint16_t port;
+    host_client_t client;
+    int64_t latency_us[CALLS];
+} client_run_t;
+
+typedef struct {
+    uint16_t port;
+    host_client_t client;
+    atomic_bool stop;
+    unsigned sent;
+    unsigned results;
+    unsigned rate_limited;
+} flood_run_t;
+
+/* One call at a time, paced well inside the rate limit */
+static void* client_thread(void* arg)
+{
+    client_run_t* run = arg;
+    host_client_t* client = &run->client;
+    HOST_CHECK(host_client_connect(client, run->port));
+    
+    for (unsigned i = 0; i < CALLS; i++) {
+        int64_t start = esp_timer_get_time();
+        HOST_CHECK(host_client_send_line(client,
+            "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/call\",\"params\":{\"name\":\"delay\","
+            "\"arguments\":{\"ms\":%d,\"tag\":\"call\"}}}", i, CALL_MS));
+        char line[512];
+        HOST_CHECK(host_client_read_line(client, line, sizeof(line), RESPONSE_TIMEOUT_MS) > 0);
+        run->latency_us[i] = esp_timer_get_time() - start;
+        HOST_CHECK(strstr(line, "\"result\"") != NULL);
+        usleep(CALL_INTERVAL_MS * 1000);
+    }
+    
+    host_client_close(client);
+    return NULL;
+}
+
+/* Drain the flooder's answers so its own output never holds it back */
+static void* flood_reader_thread(void* arg)
+{
+    flood_run_t* run = arg;
+    char line[512];
+    for (;;) {
+        int len = host_client_read_line(&run->client, line, sizeof(line), FLOOD_READ_TIMEOUT_MS);
+        if (len < 0) {
+            if (atomic_load(&run->stop)) {
+                return NULL;
+            }
+            continue;
+        }
+        if (strstr(line, "\"result\"")) {
+            run->results++;
+        } else if (strstr(line, "Rate limit exceeded")) {
+            run->rate_limited++;
+        }
+    }
+}
+
+static int compare_latency(const void* a, const void* b)
+{
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+int main(void)
+{
+    mcp_server_config_t server_config;
+    mcp_tcp_transport_config_t transport_config;
+    host_server_default_config(&server_config, &transport_config);
+    
+    /* host_server_default_config() turns admission control off */
+    mcp_tcp_transport_config_t defaults = MCP_TCP_TRANSPORT_CONFIG_DEFAULT();
+    transport_config.rate_limit_rps = defaults.rate_limit_rps;
+    transport_config.rate_limit_burst = defaults.rate_limit_burst;
+    transport_config.shed_queue_depth = defaults.shed_queue_depth;
+    transport_config.shed_free_heap = defaults.shed_free_heap;
+    HOST_CHECK(CLIENTS + 1 <= transport_config.max_clients);
+    host_log_quiet = 1;     /* Every refused request is logged */
+    
+    host_server_t host;
+    HOST_CHECK(host_server_start(&host, &server_config, &transport_config));
+    
+    static flood_run_t flood;
+    flood.port = host.port;
+    HOST_CHECK(host_client_connect(&flood.client, flood.port));
+    pthread_t reader;
+    pthread_create(&reader, NULL, flood_reader_thread, &flood);
+    
+    static client_run_t runs[CLIENTS];
+    pthread_t threads[CLIENTS];
+    for (int i = 0; i < CLIENTS; i++) {
+        runs[i].port = host.port;
+        pthread_create(&threads[i], NULL, client_thread, &runs[i]);
+    }
+    
+    /* Flood until the well-behaved clients are done */
+    int64_t deadline = esp_timer_get_time() + (int64_t)CALLS * CALL_INTERVAL_MS * 1000;
+    while (esp_timer_get_time() < deadline) {
+        HOST_CHECK(host_client_send_line(&flood.client,
+            "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/call\",\"params\":{\"name\":\"delay\","
+            "\"arguments\":{\"ms\":%d,\"tag\":\"flood\"}}}", flood.sent, FLOOD_CALL_MS));
+        flood.sent++;
+    }
+    for (int i = 0; i < CLIENTS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    atomic_store(&flood.stop, true);
+    pthread_join(reader, NULL);
+    
+    static int64_t latency_us[CLIENTS * CALLS];
+    for (int i = 0; i < CLIENTS; i++) {
+        memcpy(&latency_us[i * CALLS], runs[i].latency_us, sizeof(runs[i].latency_us));
+    }
+    qsort(latency_us, CLIENTS * CALLS, sizeof(latency_us[0]), compare_latency);
+    int64_t p50 = latency_us[CLIENTS * CALLS / 2];
+    int64_t p99 = latency_us[CLIENTS * CALLS * 99 / 100];
+    
+    mcp_tcp_transport_stats_t stats;
+    HOST_CHECK(mcp_tcp_transport_get_stats(host.transport, &stats) == ESP_OK);
+    printf("%d clients: p50 %.1f ms, p99 %.1f ms, max %.1f ms\n", CLIENTS,
+           p50 / 1000.0, p99 / 1000.0, latency_us[CLIENTS * CALLS - 1] / 1000.0);
+    printf("flooder: %u sent, %u answered, %u rate limited; %u shed in all\n",
+           flood.sent, flood.results, flood.rate_limited, (unsigned)stats.requests_shed);
+    
+    HOST_CHECK(flood.rate_limited > 0);
+    HOST_CHECK(p99 < P99_LIMIT_MS * 1000LL);
+    
+    host_client_close(&flood.client);
+    host_server_stop(&host);
+    printf("test_flood: OK\n");
+    return 0;
+}
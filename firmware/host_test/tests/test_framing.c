@@ -0,0 +1,175 @@
+/**
+ * @file test_framing.c
+ * @brief Requests are framed the same however the stream is split
+ *
+ * One stream of pings (padded to varied lengths, some ending in CRLF,
+ * with empty lines between) is sent byte by byte, in a single write and
+ * in seeded random pieces. It also holds a line of exactly the longest
+ * length the receive buffer frames, right after a request that pins the
+ * buffer, and lines one byte and several buffers too long, each followed
+ * by a valid request. Every request must be answered once, and each
+ * oversized line with exactly one "Message too large" error.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include "mcp_json.h"
+#include "host_client.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define SEED                        22
+#define SHORT_REQUESTS              40
+#define MAX_PADDING                 300
+#define STREAM_SIZE                 (32 * 1024)
+#define RESPONSE_TIMEOUT_MS         5000
+#define BYTE_GAP_US                 20      /* Lets the reactor read single bytes */
+#define TOKENS                      32
+
+typedef enum {
+    SPLIT_BYTES,
+    SPLIT_WHOLE,
+    SPLIT_RANDOM,
+} split_t;
+
+typedef struct {
+    char data[STREAM_SIZE];
+    size_t len;
+    unsigned requests;              /* Ids 1..requests */
+    unsigned oversized;             /* Lines answered with a null-id error */
+} stream_t;
+
+static const char* const s_split_names[] = { "bytes", "whole", "random" };
+static stream_t s_stream;
+static host_client_t s_client;
+
+/* Append a ping whose line is len bytes long, delimiter excluded */
+static void add_ping(stream_t* stream, size_t len, bool crlf)
+{
+    char head[64];
+    int head_len = snprintf(head, sizeof(head), "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"ping\"",
+                            ++stream->requests);
+    size_t delimiter = crlf ? 2 : 1;
+    HOST_CHECK(len >= (size_t)head_len + 1 && stream->len + len + delimiter <= STREAM_SIZE);
+    
+    char* out = stream->data + stream->len;
+    memcpy(out, head, head_len);
+    memset(out + head_len, ' ', len - head_len - 1);
+    out[len - 1] = '}';
+    memcpy(out + len, crlf ? "\r\n" : "\n", delimiter);
+    stream->len += len + delimiter;
+}
+
+/* Append a line of len bytes that is not framed; it is still valid JSON */
+static void add_oversized(stream_t* stream, size_t len)
+{
+    HOST_CHECK(stream->len + len + 1 <= STREAM_SIZE);
+    char* out = stream->data + stream->len;
+    out[0] = '"';
+    memset(out + 1, 'x', len - 2);
+    out[len - 1] = '"';
+    out[len] = '\n';
+    stream->len += len + 1;
+    stream->oversized++;
+}
+
+static void build_stream(stream_t* stream, size_t buffer_size)
+{
+    memset(stream, 0, sizeof(*stream));
+    srand(SEED);
+    for (unsigned i = 0; i < SHORT_REQUESTS; i++) {
+        add_ping(stream, 48 + rand() % MAX_PADDING, i % 5 == 0);
+        if (i % 7 == 0) {
+            stream->data[stream->len++] = '\n';
+        }
+    }
+    
+    /* The longest line framed: the whole buffer, delimiter included */
+    add_ping(stream, 64, false);
+    add_ping(stream, buffer_size - 1, false);
+    
+    /* One byte too long, then much too long; a request follows each */
+    add_oversized(stream, buffer_size);
+    add_ping(stream, 64, false);
+    add_oversized(stream, 3 * buffer_size + 17);
+    add_ping(stream, 64, true);
+}
+
+static void deliver(host_client_t* client, const stream_t* stream, split_t split)
+{
+    srand(SEED);
+    size_t sent = 0;
+    while (sent < stream->len) {
+        size_t piece = stream->len - sent;
+        if (split == SPLIT_BYTES) {
+            piece = 1;
+        } else if (split == SPLIT_RANDOM && piece > 1) {
+            /* Mostly short pieces, now and then one spanning several lines */
+            size_t limit = (rand() % 8 == 0) ? 4096 : 64;
+            size_t random = 1 + (size_t)rand() % limit;
+            piece = random < piece ? random : piece;
+        }
+        HOST_CHECK(host_client_send(client, stream->data + sent, piece));
+        sent += piece;
+        if (split == SPLIT_BYTES || (split == SPLIT_RANDOM && rand() % 4 == 0)) {
+            usleep(BYTE_GAP_US);
+        }
+    }
+}
+
+/* Read every answer to the stream; responses may overtake each other */
+static void check_responses(host_client_t* client, const stream_t* stream)
+{
+    static bool seen[SHORT_REQUESTS + 8];
+    HOST_CHECK(stream->requests < sizeof(seen));
+    memset(seen, 0, sizeof(seen));
+    
+    unsigned oversized = 0;
+    for (unsigned n = 0; n < stream->requests + stream->oversized; n++) {
+        char line[512];
+        int len = host_client_read_line(client, line, sizeof(line), RESPONSE_TIMEOUT_MS);
+        HOST_CHECK(len > 0);
+        mcp_json_token_t tokens[TOKENS];
+        int count = mcp_json_parse(line, (size_t)len, tokens, TOKENS);
+        HOST_CHECK(count > 0);
+        mcp_json_doc_t doc = { line, tokens, count };
+        
+        int id = mcp_json_find(&doc, 0, "id");
+        if (mcp_json_type(&doc, id) == MCP_JSON_NULL) {
+            HOST_CHECK(strstr(line, "Message too large") != NULL);
+            oversized++;
+            continue;
+        }
+        uint32_t value;
+        HOST_CHECK(mcp_json_get_u32(&doc, id, &value) == ESP_OK);
+        HOST_CHECK(value >= 1 && value <= stream->requests && !seen[value]);
+        HOST_CHECK(mcp_json_find(&doc, 0, "result") >= 0);
+        seen[value] = true;
+    }
+    HOST_CHECK(oversized == stream->oversized);
+}
+
+int main(void)
+{
+    mcp_server_config_t server_config;
+    mcp_tcp_transport_config_t transport_config;
+    host_server_default_config(&server_config, &transport_config);
+    host_log_quiet = 1;     /* The oversized lines are logged */
+    
+    host_server_t host;
+    HOST_CHECK(host_server_start(&host, &server_config, &transport_config));
+    build_stream(&s_stream, transport_config.buffer_size);
+    
+    for (split_t split = SPLIT_BYTES; split <= SPLIT_RANDOM; split++) {
+        HOST_CHECK(host_client_connect(&s_client, host.port));
+        deliver(&s_client, &s_stream, split);
+        check_responses(&s_client, &s_stream);
+        host_client_close(&s_client);
+        printf("%-6s: %u requests and %u oversized lines in %zu bytes\n",
+               s_split_names[split], s_stream.requests, s_stream.oversized, s_stream.len);
+    }
+    
+    host_server_stop(&host);
+    printf("test_framing: OK\n");
+    return 0;
+}
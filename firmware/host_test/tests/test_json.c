@@ -0,0 +1,75 @@
+/**
+ * @file test_json.c
+ * @brief Tokenizer and accessor checks for mcp_json
+ */
+
+#include <string.h>
+#include "mcp_json.h"
+#include "host_test.h"
+
+#define TOKENS                      64
+
+static int parse(const char* json, mcp_json_token_t* tokens, unsigned count)
+{
+    return mcp_json_parse(json, strlen(json), tokens, count);
+}
+
+static void test_request(void)
+{
+    const char* json =
+        "{\"jsonrpc\":\"2.0\",\"method\":\"tools/call\",\"id\":7,\"params\":{\"name\":\"display_control\","
+        "\"arguments\":{\"action\":\"show_text\",\"text\":\"Hi \\u00e9\\n\\ud83d\\ude00\",\"x\":-12,"
+        "\"on\":true,\"arr\":[1,2.5e3,{\"a\":null}]}}}\n";
+    mcp_json_token_t tokens[TOKENS];
+    int n = parse(json, tokens, TOKENS);
+    HOST_CHECK(n > 0);
+    HOST_CHECK(mcp_json_parse(json, strlen(json), NULL, 0) == n);
+    
+    mcp_json_doc_t doc = { json, tokens, n };
+    HOST_CHECK(mcp_json_eq(&doc, mcp_json_find(&doc, 0, "method"), "tools/call"));
+    
+    uint32_t id;
+    HOST_CHECK(mcp_json_get_u32(&doc, mcp_json_find(&doc, 0, "id"), &id) == ESP_OK && id == 7);
+    
+    int params = mcp_json_find(&doc, 0, "params");
+    int args = mcp_json_find(&doc, params, "arguments");
+    char text[64];
+    HOST_CHECK(mcp_json_get_string(&doc, mcp_json_find(&doc, args, "text"), text, sizeof(text)) == ESP_OK);
+    HOST_CHECK(strcmp(text, "Hi \xc3\xa9\n\xf0\x9f\x98\x80") == 0);
+    
+    int32_t x;
+    HOST_CHECK(mcp_json_get_int(&doc, mcp_json_find(&doc, args, "x"), &x) == ESP_OK && x == -12);
+    
+    bool on;
+    HOST_CHECK(mcp_json_get_bool(&doc, mcp_json_find(&doc, args, "on"), &on) == ESP_OK && on);
+    HOST_CHECK(mcp_json_find(&doc, args, "missing") == -1);
+    HOST_CHECK(tokens[mcp_json_find(&doc, args, "arr")].size == 3);
+}
+
+static void test_invalid(void)
+{
+    static const char* const invalid[] = {
+        "{", "{\"a\":}", "[1,]", "{\"a\" 1}", "01", "tru", "\"abc", "[1] x", "{\"a\":1,}", "",
+    };
+    mcp_json_token_t tokens[TOKENS];
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        HOST_CHECK(parse(invalid[i], tokens, TOKENS) < 0);
+    }
+    
+    static const char* const valid[] = {
+        "[]", "{}", "-0.5e+3", " \"x\" ", "[[[]]]", "null",
+    };
+    for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); i++) {
+        HOST_CHECK(parse(valid[i], tokens, TOKENS) > 0);
+    }
+    
+    HOST_CHECK(parse("[1,2,3]", tokens, 2) == MCP_JSON_ERR_NOMEM);
+}
+
+int main(void)
+{
+    test_request();
+    test_invalid();
+    printf("test_json: OK\n");
+    return 0;
+}
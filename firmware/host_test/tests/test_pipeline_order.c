@@ -0,0 +1,140 @@
+/**
+ * @file test_pipeline_order.c
+ * @brief Pipelined requests complete out of order and keep their ids
+ * 
+ * Two connections each pipeline the same ids (alternately numeric and
+ * string) to the delay tool with varying sleeps, so later requests finish
+ * first. Every response must carry the id of the request whose tag it
+ * holds, arrive once, on its own connection, and some must overtake.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "mcp_json.h"
+#include "host_client.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define REQUESTS                    200
+#define IN_FLIGHT                   8
+#define RESPONSE_TIMEOUT_MS         5000
+#define TOKENS                      32
+
+typedef struct {
+    char prefix;                    /* Tag prefix identifying the connection */
+    uint16_t port;
+    unsigned overtaken;             /* Responses that arrived before an earlier request's */
+    host_client_t client;
+} client_run_t;
+
+/* Sleep of request i: a scrambled 0..14 ms */
+static int request_delay(unsigned i)
+{
+    return (int)((i * 7919u) % 15u);
+}
+
+static void* client_thread(void* arg)
+{
+    client_run_t* run = arg;
+    host_client_t* client = &run->client;
+    HOST_CHECK(host_client_connect(client, run->port));
+    
+    for (unsigned i = 0; i < REQUESTS; i++) {
+        if (i % 2) {
+            HOST_CHECK(host_client_send_line(client,
+                "{\"jsonrpc\":\"2.0\",\"id\":\"s%u\",\"method\":\"tools/call\",\"params\":{\"name\":\"delay\","
+                "\"arguments\":{\"ms\":%d,\"tag\":\"%c%u\"}}}", i, request_delay(i), run->prefix, i));
+        } else {
+            HOST_CHECK(host_client_send_line(client,
+                "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/call\",\"params\":{\"name\":\"delay\","
+                "\"arguments\":{\"ms\":%d,\"tag\":\"%c%u\"}}}", i, request_delay(i), run->prefix, i));
+        }
+    }
+    
+    bool seen[REQUESTS] = { false };
+    unsigned highest = 0;
+    for (unsigned n = 0; n < REQUESTS; n++) {
+        char line[1024];
+        int len = host_client_read_line(client, line, sizeof(line), RESPONSE_TIMEOUT_MS);
+        HOST_CHECK(len > 0);
+        
+        mcp_json_token_t tokens[TOKENS];
+        int count = mcp_json_parse(line, (size_t)len, tokens, TOKENS);
+        HOST_CHECK(count > 0);
+        mcp_json_doc_t doc = { line, tokens, count };
+        
+        /* The id names the request ... */
+        int id = mcp_json_find(&doc, 0, "id");
+        unsigned index;
+        char text[32];
+        if (mcp_json_type(&doc, id) == MCP_JSON_STRING) {
+            HOST_CHECK(mcp_json_get_string(&doc, id, text, sizeof(text)) == ESP_OK);
+            HOST_CHECK(sscanf(text, "s%u", &index) == 1 && index % 2 == 1);
+        } else {
+            uint32_t value;
+            HOST_CHECK(mcp_json_get_u32(&doc, id, &value) == ESP_OK);
+            index = value;
+            HOST_CHECK(index % 2 == 0);
+        }
+        HOST_CHECK(index < REQUESTS && !seen[index]);
+        seen[index] = true;
+        
+        /* ... and the result must be that request's */
+        char expected[32];
+        snprintf(expected, sizeof(expected), "%c%u", run->prefix, index);
+        HOST_CHECK(strstr(line, expected) != NULL);
+        int result = mcp_json_find(&doc, 0, "result");
+        HOST_CHECK(result >= 0);
+        
+        if (index < highest) {
+            run->overtaken++;
+        } else {
+            highest = index;
+        }
+    }
+    
+    host_client_close(client);
+    return NULL;
+}
+
+int main(void)
+{
+    mcp_server_config_t server_config;
+    mcp_tcp_transport_config_t transport_config;
+    host_server_default_config(&server_config, &transport_config);
+    server_config.worker_count = MCP_SERVER_MAX_WORKERS;
+    server_config.queue_length = 2 * IN_FLIGHT;
+    server_config.cache_max_bytes = 0;
+    transport_config.max_in_flight = IN_FLIGHT;
+    
+    host_server_t host;
+    HOST_CHECK(host_server_start(&host, &server_config, &transport_config));
+    
+    static client_run_t runs[2];
+    for (int i = 0; i < 2; i++) {
+        runs[i].prefix = (char)('a' + i);
+        runs[i].port = host.port;
+    }
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) {
+        pthread_create(&threads[i], NULL, client_thread, &runs[i]);
+    }
+    for (int i = 0; i < 2; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    mcp_tcp_transport_stats_t stats;
+    HOST_CHECK(mcp_tcp_transport_get_stats(host.transport, &stats) == ESP_OK);
+    printf("overtaken: %u and %u of %u; in flight peak %u of %u\n",
+           runs[0].overtaken, runs[1].overtaken, REQUESTS,
+           (unsigned)stats.in_flight_peak, (unsigned)stats.max_in_flight);
+    
+    HOST_CHECK(runs[0].overtaken > 0 && runs[1].overtaken > 0);
+    HOST_CHECK(stats.max_in_flight == IN_FLIGHT);
+    HOST_CHECK(stats.in_flight_peak > 1 && stats.in_flight_peak <= 2 * IN_FLIGHT);
+    
+    host_server_stop(&host);
+    printf("test_pipeline_order: OK\n");
+    return 0;
+}
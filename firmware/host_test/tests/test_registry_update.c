@@ -0,0 +1,173 @@
+/**
+ * @file test_registry_update.c
+ * @brief Tool registration never waits for running tool calls
+ *
+ * - A tool registers another tool from inside its execute function.
+ * - A tool is registered while a long call runs; it must not wait for it.
+ * - Unregistering a tool returns only after its running call has ended,
+ *   and later calls no longer find it.
+ * - Four threads keep calling tools while tools are added and removed;
+ *   every call must succeed and no memory may be left behind.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define CALLERS                     4
+#define UPDATES                     200
+#define OUTPUT_SIZE                 2048
+#define LONG_CALL_MS                300
+
+static mcp_server_handle_t s_server;
+static atomic_bool s_spawned;
+static atomic_bool s_long_call_done;
+static atomic_bool s_stop;
+static atomic_uint s_failed_calls;
+
+static esp_err_t noop_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out)
+{
+    mcp_json_writer_begin_object(out);
+    mcp_json_writer_end_object(out);
+    return ESP_OK;
+}
+
+static const mcp_tool_def_t s_spawned_tool = {
+    .name = "spawned",
+    .description = "Registered by another tool",
+    .type = MCP_TOOL_CUSTOM,
+    .execute = noop_execute,
+};
+
+static esp_err_t spawn_execute(const mcp_json_doc_t* doc, int args, mcp_json_writer_t* out)
+{
+    esp_err_t ret = mcp_server_register_tool(s_server, &s_spawned_tool);
+    mcp_json_writer_begin_object(out);
+    mcp_json_writer_add_bool(out, "registered", ret == ESP_OK);
+    mcp_json_writer_end_object(out);
+    return ESP_OK;
+}
+
+static const mcp_tool_def_t s_spawn_tool = {
+    .name = "spawn",
+    .description = "Registers another tool",
+    .type = MCP_TOOL_CUSTOM,
+    .execute = spawn_execute,
+};
+
+static bool call_tool(const char* name, const char* arguments, char* output)
+{
+    char request[256];
+    snprintf(request, sizeof(request),
+             "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/call\",\"params\":{\"name\":\"%s\","
+             "\"arguments\":%s}}", name, arguments);
+    return mcp_server_process_line(s_server, request, output, OUTPUT_SIZE) == ESP_OK &&
+           strstr(output, "\"result\"") != NULL;
+}
+
+static void* spawn_thread(void* arg)
+{
+    char output[OUTPUT_SIZE];
+    HOST_CHECK(call_tool("spawn", "{}", output));
+    HOST_CHECK(strstr(output, "\"registered\":true") != NULL);
+    atomic_store(&s_spawned, true);
+    return NULL;
+}
+
+static void on_long_call(const mcp_message_t* msg, char* response, size_t response_len, esp_err_t status)
+{
+    HOST_CHECK(status == ESP_OK && strstr(response, "\"long\"") != NULL);
+    atomic_store(&s_long_call_done, true);
+}
+
+static void* caller_thread(void* arg)
+{
+    char output[OUTPUT_SIZE];
+    while (!atomic_load(&s_stop)) {
+        if (!call_tool("echo", "{\"message\":\"hi\"}", output)) {
+            atomic_fetch_add(&s_failed_calls, 1);
+        }
+    }
+    return NULL;
+}
+
+static void wait_for(atomic_bool* flag, int timeout_ms)
+{
+    for (int i = 0; i < timeout_ms && !atomic_load(flag); i++) {
+        usleep(1000);
+    }
+    HOST_CHECK(atomic_load(flag));
+}
+
+int main(void)
+{
+    mcp_server_config_t config;
+    mcp_server_get_default_config(&config);
+    config.worker_count = 2;
+    config.cache_max_bytes = 0;
+    HOST_CHECK(mcp_server_init(&config, &s_server) == ESP_OK);
+    HOST_CHECK(mcp_server_register_tool(s_server, &s_spawn_tool) == ESP_OK);
+    HOST_CHECK(mcp_server_register_tool(s_server, &host_delay_tool) == ESP_OK);
+    HOST_CHECK(mcp_server_start(s_server) == ESP_OK);
+    char output[OUTPUT_SIZE];
+    
+    /* Registering from inside a tool */
+    pthread_t thread;
+    pthread_create(&thread, NULL, spawn_thread, NULL);
+    wait_for(&s_spawned, 2000);
+    pthread_join(thread, NULL);
+    HOST_CHECK(call_tool("spawned", "{}", output));
+    
+    /* Registering during a long call */
+    static const char long_call[] =
+        "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"tools/call\",\"params\":{\"name\":\"delay\","
+        "\"arguments\":{\"ms\":300,\"tag\":\"long\"}}}";
+    HOST_CHECK(mcp_server_submit(s_server, 1, long_call, strlen(long_call), MCP_WIRE_JSON,
+                                 on_long_call, NULL) == ESP_OK);
+    usleep(50 * 1000);
+    int64_t start = esp_timer_get_time();
+    HOST_CHECK(mcp_server_unregister_tool(s_server, "spawned") == ESP_OK);
+    int64_t update_us = esp_timer_get_time() - start;
+    HOST_CHECK(!atomic_load(&s_long_call_done));
+    HOST_CHECK(update_us < (LONG_CALL_MS / 2) * 1000);
+    
+    /* Unregistering the running tool waits for its call */
+    HOST_CHECK(mcp_server_unregister_tool(s_server, "delay") == ESP_OK);
+    HOST_CHECK(atomic_load(&s_long_call_done));
+    HOST_CHECK(!call_tool("delay", "{\"ms\":0}", output));
+    HOST_CHECK(strstr(output, "Tool not found") != NULL);
+    
+    /* Updates under concurrent calls */
+    host_heap_stats_t before, after;
+    host_heap_get_stats(&before);
+    pthread_t callers[CALLERS];
+    for (int i = 0; i < CALLERS; i++) {
+        pthread_create(&callers[i], NULL, caller_thread, NULL);
+    }
+    for (int i = 0; i < UPDATES; i++) {
+        HOST_CHECK(mcp_server_register_tool(s_server, &s_spawned_tool) == ESP_OK);
+        HOST_CHECK(mcp_server_unregister_tool(s_server, "spawned") == ESP_OK);
+    }
+    atomic_store(&s_stop, true);
+    for (int i = 0; i < CALLERS; i++) {
+        pthread_join(callers[i], NULL);
+    }
+    host_heap_get_stats(&after);
+    
+    printf("update during a %d ms call: %lld us; %d updates under load, %u failed calls, "
+           "live bytes %zu -> %zu\n", LONG_CALL_MS, (long long)update_us, 2 * UPDATES,
+           atomic_load(&s_failed_calls), before.live_bytes, after.live_bytes);
+    HOST_CHECK(atomic_load(&s_failed_calls) == 0);
+    HOST_CHECK(after.live_bytes <= before.live_bytes);
+    
+    mcp_server_stop(s_server);
+    mcp_server_deinit(s_server);
+    printf("test_registry_update: OK\n");
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file test_resource_read.c
+ * @brief resources/read always advances the cursor or fails
+ *
+ * - Following nextCursor through a small response buffer returns the whole
+ *   content, each chunk non-empty.
+ * - With response buffers of every size from one that only holds an error
+ *   up, a read either returns at least one character or an error; never an
+ *   empty chunk pointing back at the same offset.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "mcp_json.h"
+#include "mcp_server_simple.h"
+#include "host_test.h"
+
+#define CONTENT_SIZE                3000
+#define OUTPUT_SIZE                 4096
+#define SMALL_OUTPUT_SIZE           512
+#define ERROR_OUTPUT_SIZE           128     /* Holds an error response */
+#define TOKENS                      64
+
+static char s_content[CONTENT_SIZE];
+static char s_output[OUTPUT_SIZE];
+
+static esp_err_t read_content(const char* uri, mcp_resource_chunk_t* chunk, void* user_ctx)
+{
+    mcp_resource_chunk_write(chunk, s_content, sizeof(s_content));
+    return ESP_OK;
+}
+
+static const mcp_resource_def_t s_resource = {
+    .uri = "test://content",
+    .name = "content",
+    .mime_type = "text/plain",
+    .read = read_content,
+};
+
+/* Read at a cursor into output_size bytes; returns the parsed response */
+static int read_at(mcp_server_handle_t server, uint32_t cursor, size_t output_size,
+                   mcp_json_doc_t* doc, mcp_json_token_t* tokens)
+{
+    char request[192];
+    snprintf(request, sizeof(request),
+             "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"resources/read\",\"params\":"
+             "{\"uri\":\"test://content\",\"cursor\":\"%u\"}}", (unsigned)cursor);
+    memset(s_output, 0, sizeof(s_output));
+    mcp_server_process_line(server, request, s_output, output_size);
+    int count = mcp_json_parse(s_output, strlen(s_output), tokens, TOKENS);
+    HOST_CHECK(count > 0);
+    *doc = (mcp_json_doc_t){ s_output, tokens, count };
+    return mcp_json_find(doc, 0, "result");
+}
+
+int main(void)
+{
+    for (size_t i = 0; i < sizeof(s_content); i++) {
+        s_content[i] = 'a' + i % 26;
+    }
+    
+    mcp_server_config_t config;
+    mcp_server_get_default_config(&config);
+    config.cache_max_bytes = 0;
+    mcp_server_handle_t server;
+    HOST_CHECK(mcp_server_init(&config, &server) == ESP_OK);
+    HOST_CHECK(mcp_server_register_resource(server, &s_resource) == ESP_OK);
+    HOST_CHECK(mcp_server_start(server) == ESP_OK);
+    
+    static mcp_json_token_t tokens[TOKENS];
+    mcp_json_doc_t doc;
+    
+    /* Whole content through a small buffer */
+    static char content[CONTENT_SIZE];
+    uint32_t cursor = 0;
+    unsigned chunks = 0;
+    for (;;) {
+        int result = read_at(server, cursor, SMALL_OUTPUT_SIZE, &doc, tokens);
+        HOST_CHECK(result >= 0);
+        int contents = mcp_json_find(&doc, result, "contents");
+        HOST_CHECK(mcp_json_type(&doc, contents) == MCP_JSON_ARRAY);
+        int text = mcp_json_find(&doc, contents + 1, "text");
+        HOST_CHECK(text >= 0);
+        size_t len;
+        const char* raw = mcp_json_raw(&doc, text, &len);
+        HOST_CHECK(len > 0 && cursor + len <= CONTENT_SIZE);
+        memcpy(content + cursor, raw, len);
+        cursor += len;
+        chunks++;
+        
+        int next = mcp_json_find(&doc, result, "nextCursor");
+        if (next < 0) {
+            break;
+        }
+        HOST_CHECK(strtoul(mcp_json_raw(&doc, next, &len), NULL, 10) == cursor);
+    }
+    HOST_CHECK(cursor == CONTENT_SIZE && memcmp(content, s_content, CONTENT_SIZE) == 0);
+    
+    /* Buffers too small for any content fail instead of stalling */
+    unsigned failed = 0;
+    for (size_t size = ERROR_OUTPUT_SIZE; size <= SMALL_OUTPUT_SIZE; size++) {
+        int result = read_at(server, 0, size, &doc, tokens);
+        if (result < 0) {
+            HOST_CHECK(mcp_json_find(&doc, 0, "error") >= 0);
+            failed++;
+            continue;
+        }
+        /* The first chunk ends the content or continues after offset 0 */
+        int next = mcp_json_find(&doc, result, "nextCursor");
+        size_t len;
+        HOST_CHECK(next >= 0 && strtoul(mcp_json_raw(&doc, next, &len), NULL, 10) > 0);
+    }
+    
+    printf("%u chunks through a %d byte buffer; %u of %d buffer sizes too small\n",
+           chunks, SMALL_OUTPUT_SIZE, failed, SMALL_OUTPUT_SIZE - ERROR_OUTPUT_SIZE + 1);
+    HOST_CHECK(failed > 0 && failed < SMALL_OUTPUT_SIZE - ERROR_OUTPUT_SIZE + 1);
+    
+    mcp_server_stop(server);
+    mcp_server_deinit(server);
+    printf("test_resource_read: OK\n");
+    return 0;
+}
@@ -0,0 +1,78 @@
+/**
+ * @file test_rx_release.c
+ * @brief A request outliving its connection frees the receive buffer
+ *
+ * A client starts a request longer than MCP_RESPONSE_TIMEOUT_MS and
+ * disconnects. Its slot is released while the request still reads from
+ * the receive buffer (another client can connect to the single slot and
+ * use its single in-flight slot), and once the request completes no memory
+ * may be left behind.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include "host_client.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define RESPONSE_TIMEOUT_MS         5000
+#define LONG_CALL_MS                (MCP_RESPONSE_TIMEOUT_MS + 3000)
+#define PROBE_TIMEOUT_MS            1000    /* Well before the long call ends */
+
+static host_client_t s_client;
+static host_client_t s_probe;
+
+int main(void)
+{
+    mcp_server_config_t server_config;
+    mcp_tcp_transport_config_t transport_config;
+    host_server_default_config(&server_config, &transport_config);
+    server_config.request_timeout_ms = 0;
+    transport_config.max_clients = 1;
+    transport_config.max_in_flight = 1;
+    host_log_quiet = 1;     /* The release warns about the request in flight */
+    
+    host_server_t host;
+    HOST_CHECK(host_server_start(&host, &server_config, &transport_config));
+    
+    /* Warm up whatever the first connection allocates for good */
+    char line[256];
+    HOST_CHECK(host_client_connect(&s_probe, host.port));
+    HOST_CHECK(host_client_send_line(&s_probe, "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"ping\"}"));
+    HOST_CHECK(host_client_read_line(&s_probe, line, sizeof(line), RESPONSE_TIMEOUT_MS) > 0);
+    host_client_close(&s_probe);
+    usleep(100 * 1000);
+    host_heap_stats_t before, after;
+    host_heap_get_stats(&before);
+    
+    HOST_CHECK(host_client_connect(&s_client, host.port));
+    HOST_CHECK(host_client_send_line(&s_client,
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/call\",\"params\":{\"name\":\"delay\","
+        "\"arguments\":{\"ms\":%d,\"tag\":\"long\"}}}", LONG_CALL_MS));
+    usleep(50 * 1000);
+    host_client_close(&s_client);
+    
+    /* The slot is released without waiting for the request, and the next
+     * connection gets the in-flight slot the request held */
+    usleep((MCP_RESPONSE_TIMEOUT_MS + 500) * 1000);
+    HOST_CHECK(host_client_connect(&s_probe, host.port));
+    HOST_CHECK(host_client_send_line(&s_probe, "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"ping\"}"));
+    HOST_CHECK(host_client_read_line(&s_probe, line, sizeof(line), PROBE_TIMEOUT_MS) > 0);
+    HOST_CHECK(strstr(line, "\"result\"") != NULL);
+    host_client_close(&s_probe);
+    
+    /* The request completes and drops the last reference */
+    for (int i = 0; i < LONG_CALL_MS; i++) {
+        host_heap_get_stats(&after);
+        if (after.live_bytes <= before.live_bytes) {
+            break;
+        }
+        usleep(1000);
+    }
+    printf("live bytes %zu -> %zu\n", before.live_bytes, after.live_bytes);
+    HOST_CHECK(after.live_bytes <= before.live_bytes);
+    
+    host_server_stop(&host);
+    printf("test_rx_release: OK\n");
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * @file test_slow_reader.c
+ * @brief A client that stops reading never holds up the server's workers
+ *
+ * A client that reads nothing pipelines two batches of three tools/list
+ * requests and then two single ones, all admitted at once. The batches
+ * fill its socket, the first single response fills its transmit ring, and
+ * the second one finds no room. With a single worker, waiting for that
+ * ring would stall every client, so another client's pings must keep
+ * being answered quickly. Once the slow client reads, it gets every
+ * response.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include "esp_timer.h"
+#include "mcp_json.h"
+#include "host_client.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define BATCHES                     2
+#define REQUESTS                    (BATCHES + 2)
+#define RESPONSES                   (BATCHES * 3 + 2)
+#define PINGS                       20
+#define PING_LIMIT_MS               1000
+#define RESPONSE_TIMEOUT_MS         5000
+#define TOKENS                      1024
+
+static host_client_t s_slow;
+static host_client_t s_fast;
+static char s_line[16 * 1024];
+static bool s_seen[RESPONSES + 1];
+
+static void check_response(const mcp_json_doc_t* doc, int tok)
+{
+    uint32_t id;
+    HOST_CHECK(mcp_json_get_u32(doc, mcp_json_find(doc, tok, "id"), &id) == ESP_OK);
+    HOST_CHECK(id >= 1 && id <= RESPONSES && !s_seen[id]);
+    s_seen[id] = true;
+    int result = mcp_json_find(doc, tok, "result");
+    HOST_CHECK(mcp_json_find(doc, result, "tools") >= 0);
+}
+
+int main(void)
+{
+    mcp_server_config_t server_config;
+    mcp_tcp_transport_config_t transport_config;
+    host_server_default_config(&server_config, &transport_config);
+    server_config.worker_count = 1;
+    host_sndbuf = 1024;     /* Clamped to the host's smallest */
+    
+    host_server_t host;
+    HOST_CHECK(host_server_start(&host, &server_config, &transport_config));
+    
+    /* The slow client's socket takes little before the ring fills */
+    host_client_rcvbuf = 1024;
+    HOST_CHECK(host_client_connect(&s_slow, host.port));
+    host_client_rcvbuf = 0;
+    unsigned id = 1;
+    for (unsigned i = 0; i < BATCHES; i++, id += 3) {
+        HOST_CHECK(host_client_send_line(&s_slow,
+            "[{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/list\"},"
+            "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/list\"},"
+            "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/list\"}]", id, id + 1, id + 2));
+    }
+    for (; id <= RESPONSES; id++) {
+        HOST_CHECK(host_client_send_line(&s_slow, "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/list\"}", id));
+    }
+    usleep(300 * 1000);
+    
+    /* The other client is served meanwhile */
+    HOST_CHECK(host_client_connect(&s_fast, host.port));
+    int64_t slowest_us = 0;
+    for (unsigned i = 1; i <= PINGS; i++) {
+        int64_t start = esp_timer_get_time();
+        HOST_CHECK(host_client_send_line(&s_fast, "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"ping\"}", i));
+        HOST_CHECK(host_client_read_line(&s_fast, s_line, sizeof(s_line), RESPONSE_TIMEOUT_MS) > 0);
+        HOST_CHECK(strstr(s_line, "\"result\"") != NULL);
+        int64_t elapsed = esp_timer_get_time() - start;
+        if (elapsed > slowest_us) {
+            slowest_us = elapsed;
+        }
+    }
+    printf("slowest ping %lld us while a client was not reading\n", (long long)slowest_us);
+    HOST_CHECK(slowest_us < PING_LIMIT_MS * 1000LL);
+    
+    mcp_tcp_transport_stats_t stats;
+    HOST_CHECK(mcp_tcp_transport_get_stats(host.transport, &stats) == ESP_OK);
+    unsigned backpressured = stats.tx_backpressured;
+    
+    /* The slow client still gets every response, each once */
+    for (unsigned n = 0; n < REQUESTS; n++) {
+        int len = host_client_read_line(&s_slow, s_line, sizeof(s_line), RESPONSE_TIMEOUT_MS);
+        HOST_CHECK(len > 0);
+        static mcp_json_token_t tokens[TOKENS];
+        int count = mcp_json_parse(s_line, (size_t)len, tokens, TOKENS);
+        HOST_CHECK(count > 0);
+        mcp_json_doc_t doc = { s_line, tokens, count };
+        if (mcp_json_type(&doc, 0) != MCP_JSON_ARRAY) {
+            check_response(&doc, 0);
+            continue;
+        }
+        int tok = 1;
+        for (uint16_t i = 0; i < tokens[0].size; i++) {
+            check_response(&doc, tok);
+            tok = mcp_json_next(&doc, tok);
+        }
+    }
+    
+    HOST_CHECK(mcp_tcp_transport_get_stats(host.transport, &stats) == ESP_OK);
+    printf("%u responses to the slow client, %u backpressured, %u dropped\n",
+           RESPONSES, backpressured, (unsigned)stats.messages_dropped);
+    HOST_CHECK(backpressured > 0);
+    HOST_CHECK(stats.messages_dropped == 0);
+    
+    host_client_close(&s_fast);
+    host_client_close(&s_slow);
+    host_server_stop(&host);
+    printf("test_slow_reader: OK\n");
+    return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file test_tx_oversize.c
+ * @brief Messages longer than the transmit ring are delivered whole
+ *
+ * The transmit ring is made much shorter than a tools/list response and the
+ * socket's send buffer small, then a client pipelines tools/list requests
+ * without reading. Once it starts reading, every response must arrive
+ * complete, in its own line and with its id, and nothing may be dropped.
+ * A notification longer than the ring sent to the client must arrive too.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "mcp_json.h"
+#include "host_client.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define REQUESTS                    40
+#define TX_RING_SIZE                256
+#define NOTIFICATION_SIZE           3000
+#define RESPONSE_TIMEOUT_MS         5000
+#define TOKENS                      256
+
+static host_client_t s_client;
+static char s_line[16 * 1024];
+
+int main(void)
+{
+    mcp_server_config_t server_config;
+    mcp_tcp_transport_config_t transport_config;
+    host_server_default_config(&server_config, &transport_config);
+    transport_config.tx_buffer_size = TX_RING_SIZE;
+    transport_config.tx_high_water = TX_RING_SIZE / 2;
+    host_sndbuf = 4096;
+    
+    host_server_t host;
+    HOST_CHECK(host_server_start(&host, &server_config, &transport_config));
+    HOST_CHECK(host_client_connect(&s_client, host.port));
+    
+    /* Let responses pile up in the socket and the transmit queue */
+    for (unsigned i = 1; i <= REQUESTS; i++) {
+        HOST_CHECK(host_client_send_line(&s_client, "{\"jsonrpc\":\"2.0\",\"id\":%u,\"method\":\"tools/list\"}", i));
+    }
+    usleep(300 * 1000);
+    
+    bool seen[REQUESTS + 1] = { false };
+    size_t longest = 0;
+    for (unsigned n = 0; n < REQUESTS; n++) {
+        int len = host_client_read_line(&s_client, s_line, sizeof(s_line), RESPONSE_TIMEOUT_MS);
+        HOST_CHECK(len > TX_RING_SIZE);
+        if ((size_t)len > longest) {
+            longest = len;
+        }
+        
+        static mcp_json_token_t tokens[TOKENS];
+        int count = mcp_json_parse(s_line, (size_t)len, tokens, TOKENS);
+        HOST_CHECK(count > 0);
+        mcp_json_doc_t doc = { s_line, tokens, count };
+        uint32_t id;
+        HOST_CHECK(mcp_json_get_u32(&doc, mcp_json_find(&doc, 0, "id"), &id) == ESP_OK);
+        HOST_CHECK(id >= 1 && id <= REQUESTS && !seen[id]);
+        seen[id] = true;
+        int result = mcp_json_find(&doc, 0, "result");
+        HOST_CHECK(mcp_json_find(&doc, result, "tools") >= 0);
+    }
+    
+    /* A notification longer than the ring (client ids start at 1) */
+    static char notification[NOTIFICATION_SIZE + 1];
+    int prefix = snprintf(notification, sizeof(notification),
+                          "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/message\",\"params\":{\"data\":\"");
+    memset(notification + prefix, 'x', NOTIFICATION_SIZE - prefix - 3);
+    memcpy(notification + NOTIFICATION_SIZE - 3, "\"}}", 4);
+    HOST_CHECK(mcp_tcp_transport_send_message(host.transport, 1, notification, NOTIFICATION_SIZE) == ESP_OK);
+    int len = host_client_read_line(&s_client, s_line, sizeof(s_line), RESPONSE_TIMEOUT_MS);
+    HOST_CHECK(len == NOTIFICATION_SIZE && memcmp(s_line, notification, NOTIFICATION_SIZE) == 0);
+    
+    mcp_tcp_transport_stats_t stats;
+    HOST_CHECK(mcp_tcp_transport_get_stats(host.transport, &stats) == ESP_OK);
+    printf("%u responses of up to %zu bytes through a %u byte ring, %u dropped, %u backpressured\n",
+           REQUESTS, longest, TX_RING_SIZE, (unsigned)stats.messages_dropped,
+           (unsigned)stats.tx_backpressured);
+    HOST_CHECK(stats.messages_dropped == 0);
+    HOST_CHECK(stats.errors == 0);
+    
+    host_client_close(&s_client);
+    host_server_stop(&host);
+    printf("test_tx_oversize: OK\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file test_urgent.c
+ * @brief Only real cancellations jump the queue, and teardown waits for them
+ *
+ * mcp_server_is_urgent must accept a notifications/cancelled notification
+ * in either encoding and reject requests that merely mention the method.
+ *
+ * A cancellation holds no in-flight slot, so the transport has to track it
+ * separately: with the only worker busy, a client sends a cancellation and
+ * disconnects. Its slot must stay reserved until the cancellation has run
+ * (a third client finds the table full), and be free again afterwards.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include "mcp_json_writer.h"
+#include "host_client.h"
+#include "host_server.h"
+#include "host_test.h"
+
+#define RESPONSE_TIMEOUT_MS         5000
+#define BUSY_MS                     400
+
+static const char s_cancel[] =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/cancelled\",\"params\":{\"requestId\":7,\"reason\":\"user\"}}";
+
+static host_client_t s_busy;
+static host_client_t s_canceller;
+static host_client_t s_other;
+
+static void check_classification(void)
+{
+    static const char* const spoofed[] = {
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/call\",\"params\":{\"name\":\"echo\","
+        "\"arguments\":{\"message\":\"notifications/cancelled\"}}}",
+        "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"notifications/cancelled\",\"params\":{\"requestId\":1}}",
+        "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/cancelledX\"}",
+        "{\"jsonrpc\":\"2.0\",\"method\":\"ping\",\"params\":{\"notifications/cancelled\":true}}",
+        "[{\"jsonrpc\":\"2.0\",\"method\":\"notifications/cancelled\",\"params\":{\"requestId\":1}}]",
+        "{\"method\":\"notifications/cancelled\"",
+    };
+    HOST_CHECK(mcp_server_is_urgent(s_cancel, strlen(s_cancel), MCP_WIRE_JSON));
+    for (size_t i = 0; i < sizeof(spoofed) / sizeof(spoofed[0]); i++) {
+        HOST_CHECK(!mcp_server_is_urgent(spoofed[i], strlen(spoofed[i]), MCP_WIRE_JSON));
+    }
+    
+    /* The same cancellation as a CBOR item */
+    char cbor[128];
+    mcp_json_writer_t w;
+    mcp_json_writer_init(&w, cbor, sizeof(cbor));
+    mcp_json_writer_set_format(&w, MCP_WIRE_CBOR);
+    mcp_json_writer_raw(&w, s_cancel, strlen(s_cancel));
+    HOST_CHECK(mcp_json_writer_finish(&w) == ESP_OK);
+    HOST_CHECK(mcp_server_is_urgent(cbor, mcp_json_writer_length(&w), MCP_WIRE_CBOR));
+}
+
+int main(void)
+{
+    check_classification();
+    host_log_quiet = 1;     /* The third client is refused on purpose */
+    
+    mcp_server_config_t server_config;
+    mcp_tcp_transport_config_t transport_config;
+    host_server_default_config(&server_config, &transport_config);
+    server_config.worker_count = 1;
+    transport_config.max_clients = 2;
+    
+    host_server_t host;
+    HOST_CHECK(host_server_start(&host, &server_config, &transport_config));
+    
+    /* Occupy the only worker */
+    HOST_CHECK(host_client_connect(&s_busy, host.port));
+    HOST_CHECK(host_client_send_line(&s_busy,
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/call\",\"params\":{\"name\":\"delay\","
+        "\"arguments\":{\"ms\":%d,\"tag\":\"busy\"}}}", BUSY_MS));
+    usleep(50 * 1000);
+    
+    /* The cancellation waits for the worker while its client goes away */
+    HOST_CHECK(host_client_connect(&s_canceller, host.port));
+    HOST_CHECK(host_client_send_line(&s_canceller, "%s", s_cancel));
+    usleep(50 * 1000);
+    host_client_close(&s_canceller);
+    usleep(50 * 1000);
+    
+    /* Its slot is still reserved, so the table is full */
+    HOST_CHECK(host_client_connect(&s_other, host.port));
+    HOST_CHECK(host_client_wait_closed(&s_other, 1000));
+    host_client_close(&s_other);
+    
+    char line[256];
+    HOST_CHECK(host_client_read_line(&s_busy, line, sizeof(line), RESPONSE_TIMEOUT_MS) > 0);
+    HOST_CHECK(strstr(line, "\"busy\"") != NULL);
+    
+    /* Once the cancellation has run, the slot is free again */
+    usleep(100 * 1000);
+    HOST_CHECK(host_client_connect(&s_other, host.port));
+    HOST_CHECK(host_client_send_line(&s_other, "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"ping\"}"));
+    HOST_CHECK(host_client_read_line(&s_other, line, sizeof(line), RESPONSE_TIMEOUT_MS) > 0);
+    HOST_CHECK(strstr(line, "\"result\"") != NULL);
+    
+    host_client_close(&s_other);
+    host_client_close(&s_busy);
+    host_server_stop(&host);
+    printf("test_urgent: OK\n");
+    return 0;
+}
@@ -21,6 +21,7 @@
 #include "esp_flash.h"
 #include "esp_timer.h"
 #include "esp_task_wdt.h"
+#include "esp_heap_caps.h"
 #include "nvs_flash.h"
 #include "driver/gpio.h"
 #include "display_st7789.h"
@@ -29,9 +30,11 @@
 
 extern "C" {
 #include "mcp_server_simple.h"
+#include "mcp_tools.h"
 #include "mcp_tcp_transport.h"
 #include "wifi_manager.h"
 }
+#include "mcp_tool.hpp"
 
 static const char *TAG = "firmware";
 
@@ -39,6 +42,10 @@ static const char *TAG = "firmware";
 #define STATUS_LED_GPIO         GPIO_NUM_8
 #define USER_BUTTON_GPIO        GPIO_NUM_9
 
+// Free heap thresholds for low-memory warnings
+#define LOW_HEAP_WARNING_BYTES      20000
+#define LOW_HEAP_CRITICAL_BYTES     10000
+
 // Task priorities
 #define STATUS_LED_TASK_PRIORITY    2
 #define SYSTEM_MONITOR_TASK_PRIORITY 3
@@ -100,6 +107,129 @@ extern "C" {
     }
 }
 
+/**
+ * @brief device_status MCP tool
+ *
+ * Declared with the compile-time tool templates: the argument decoder and
+ * the input schema are generated from the fields below.
+ */
+struct device_status_tool {
+    enum class action_t { get_health, get_sensors, get_connections, run_diagnostics };
+    static constexpr const char* actions[] = {
+        "get_health", "get_sensors", "get_connections", "run_diagnostics"
+    };
+
+    struct args_t {
+        action_t action = action_t::get_health;
+        bool include_sensors = false;
+        bool run_full_diagnostics = false;
+    };
+
+    static constexpr const char* name = MCP_TOOL_STATUS_NAME;
+    static constexpr const char* description = MCP_TOOL_STATUS_DESCRIPTION;
+    static constexpr auto fields = std::make_tuple(
+        mcp::one_of("action", &args_t::action, actions),
+        mcp::optional("include_sensors", &args_t::include_sensors),
+        mcp::optional("run_full_diagnostics", &args_t::run_full_diagnostics));
+
+    static void write_sensors(mcp_json_writer_t* out)
+    {
+        mcp_json_writer_key(out, "sensors");
+        mcp_json_writer_begin_object(out);
+        mcp_json_writer_add_bool(out, "button_pressed", gpio_get_level(USER_BUTTON_GPIO) == 0);
+        mcp_json_writer_add_uint(out, "button_presses", s_stats.button_presses);
+        mcp_json_writer_end_object(out);
+    }
+
+    static void write_health(mcp_json_writer_t* out)
+    {
+        const char* health = "ok";
+        if (s_stats.free_heap < LOW_HEAP_CRITICAL_BYTES) {
+            health = "critical";
+        } else if (s_stats.free_heap < LOW_HEAP_WARNING_BYTES || !s_stats.wifi_connected) {
+            health = "degraded";
+        }
+        mcp_json_writer_add_string(out, "health", health);
+        mcp_json_writer_add_uint(out, "uptime_seconds", s_stats.uptime_seconds);
+        mcp_json_writer_add_uint(out, "free_heap", s_stats.free_heap);
+        mcp_json_writer_add_uint(out, "min_free_heap", s_stats.min_free_heap);
+        mcp_json_writer_add_bool(out, "display_ok", s_display_initialized);
+        mcp_json_writer_add_bool(out, "wifi_connected", s_stats.wifi_connected);
+    }
+
+    static void write_connections(mcp_json_writer_t* out)
+    {
+        mcp_json_writer_key(out, "wifi");
+        mcp_json_writer_begin_object(out);
+        mcp_json_writer_add_bool(out, "connected", s_stats.wifi_connected);
+        mcp_json_writer_add_string(out, "ssid", s_stats.wifi_ssid);
+        mcp_json_writer_add_string(out, "ip", s_stats.wifi_ip);
+        mcp_json_writer_add_int(out, "rssi", s_stats.wifi_rssi);
+        mcp_json_writer_end_object(out);
+
+        mcp_json_writer_key(out, "mcp");
+        mcp_json_writer_begin_object(out);
+        bool running = s_mcp_transport_initialized && mcp_tcp_transport_is_running(s_mcp_transport);
+        mcp_json_writer_add_bool(out, "running", running);
+        mcp_json_writer_add_uint(out, "port", running ? mcp_tcp_transport_get_port(s_mcp_transport) : 0);
+        mcp_json_writer_add_uint(out, "clients", running ? mcp_tcp_transport_get_client_count(s_mcp_transport) : 0);
+        mcp_json_writer_end_object(out);
+    }
+
+    static void write_check(mcp_json_writer_t* out, const char* check, bool passed, bool* all_passed)
+    {
+        mcp_json_writer_add_bool(out, check, passed);
+        *all_passed = *all_passed && passed;
+    }
+
+    static void write_diagnostics(mcp_json_writer_t* out, bool full)
+    {
+        bool passed = true;
+        mcp_json_writer_key(out, "checks");
+        mcp_json_writer_begin_object(out);
+        write_check(out, "heap", s_stats.free_heap >= LOW_HEAP_WARNING_BYTES, &passed);
+        write_check(out, "display", s_display_initialized, &passed);
+        write_check(out, "wifi", s_stats.wifi_connected, &passed);
+        write_check(out, "mcp_transport",
+                    s_mcp_transport_initialized && mcp_tcp_transport_is_running(s_mcp_transport), &passed);
+        if (full) {
+            // Walks every heap block, so only on request
+            write_check(out, "heap_integrity", heap_caps_check_integrity_all(true), &passed);
+        }
+        mcp_json_writer_end_object(out);
+        mcp_json_writer_add_bool(out, "passed", passed);
+        mcp_json_writer_add_bool(out, "full", full);
+    }
+
+    static esp_err_t run(const args_t& args, mcp_json_writer_t* out)
+    {
+        switch (args.action) {
+            case action_t::get_health:
+                mcp::begin_result(out, "Device health");
+                write_health(out);
+                break;
+            case action_t::get_sensors:
+                mcp::begin_result(out, "Sensor readings");
+                break;
+            case action_t::get_connections:
+                mcp::begin_result(out, "Connection status");
+                write_connections(out);
+                break;
+            case action_t::run_diagnostics:
+                mcp::begin_result(out, "Diagnostics complete");
+                write_diagnostics(out, args.run_full_diagnostics);
+                break;
+        }
+        if (args.include_sensors || args.action == action_t::get_sensors) {
+            write_sensors(out);
+        }
+        return mcp::end_result(out);
+    }
+};
+
+// Tools implemented by the firmware, as a constant table in flash
+using firmware_tools = mcp::tool_table<device_status_tool>;
+
 /**
  * @brief Print startup banner with chip information
  */
@@ -207,7 +337,7 @@ static void status_led_task(void* pvParameters)
         gpio_set_level(STATUS_LED_GPIO, led_state);
 
         // Adjust blink rate based on system health
-        if (s_stats.free_heap < 20000) {
+        if (s_stats.free_heap < LOW_HEAP_WARNING_BYTES) {
             blink_delay = 200; // Fast blink for low memory
         } else if (s_stats.uptime_seconds < 60) {
             blink_delay = 500; // Medium blink during startup
@@ -280,8 +410,19 @@ static void system_monitor_task(void* pvParameters)
             }
         }
 
+        // Push changed values to MCP subscribers instead of having them poll
+        if (s_mcp_server_initialized) {
+            mcp_system_sample_t sample = {};
+            sample.uptime_seconds = s_stats.uptime_seconds;
+            sample.free_heap = s_stats.free_heap;
+            sample.min_free_heap = s_stats.min_free_heap;
+            sample.wifi_rssi = s_stats.wifi_rssi;
+            sample.button_presses = s_stats.button_presses;
+            mcp_server_publish_sample(s_mcp_server, &sample);
+        }
+
         // Check for low memory condition
-        if (s_stats.free_heap < 10000) {
+        if (s_stats.free_heap < LOW_HEAP_CRITICAL_BYTES) {
             ESP_LOGW(TAG, "Low memory warning: %"PRIu32" bytes free", s_stats.free_heap);
         }
 
@@ -504,6 +645,12 @@ static void init_mcp_server(void)
         return;
     }
     
+    // Register the firmware's own tools next to the built-in ones
+    ret = firmware_tools::register_all(s_mcp_server);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to register firmware tools: %s", esp_err_to_name(ret));
+    }
+    
     s_mcp_server_initialized = true;
     ESP_LOGI(TAG, "Simple MCP server initialized and started successfully");
     ESP_LOGI(TAG, "MCP server ready for JSON-RPC communication");
@@ -512,6 +659,7 @@ static void init_mcp_server(void)
     ESP_LOGI(TAG, "  - display_control: Control ST7789 display");
     ESP_LOGI(TAG, "  - gpio_control: Control LED and read button");
     ESP_LOGI(TAG, "  - system_info: Get system information");
+    ESP_LOGI(TAG, "  - device_status: Get device health and diagnostics");
 }
 
 /**
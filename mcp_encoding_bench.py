@@ -0,0 +1,384 @@
+#!/usr/bin/env python3
+"""
+MCP Encoding Benchmark for ESP32-C6
+
+Compares the JSON and CBOR session encodings of the ESP32-C6 MCP server. For
+every tool reported by tools/list, the same call is made over a JSON session
+and over a session that negotiated CBOR during initialize, and the benchmark
+reports:
+
+- request and response size on the wire
+- client-side encode and decode time
+- round-trip time
+- on-device parse (decode + tokenize) and serialize time, read from
+  server/metrics for tools/call
+
+Usage:
+    python3 mcp_encoding_bench.py <esp32_ip> [--port 8080] [--iterations 50]
+"""
+
+import argparse
+import json
+import socket
+import statistics
+import struct
+import sys
+import time
+from typing import Any, Dict, List, Optional, Tuple
+
+# Arguments for the built-in tools; side-effect free where the tool allows it
+SAMPLE_ARGUMENTS = {
+    "echo": {"message": "Hello ESP32-C6!", "count": 3, "ratio": 0.5, "flags": [True, False, None]},
+    "display_control": {"action": "get_info"},
+    "gpio_control": {"action": "get_status"},
+    "system_info": {"action": "get_info"},
+    "device_status": {"action": "get_health"},
+}
+
+
+class CborError(ValueError):
+    pass
+
+
+class CborShort(CborError):
+    """The buffer ends inside the item"""
+
+
+def cbor_encode(value: Any) -> bytes:
+    """Encode a JSON-compatible value as CBOR (RFC 8949), shortest form"""
+    out = bytearray()
+
+    def head(major: int, arg: int):
+        if arg < 24:
+            out.append(major << 5 | arg)
+        elif arg <= 0xFF:
+            out.extend((major << 5 | 24, arg))
+        elif arg <= 0xFFFF:
+            out.append(major << 5 | 25)
+            out.extend(struct.pack(">H", arg))
+        elif arg <= 0xFFFFFFFF:
+            out.append(major << 5 | 26)
+            out.extend(struct.pack(">I", arg))
+        else:
+            out.append(major << 5 | 27)
+            out.extend(struct.pack(">Q", arg))
+
+    def item(v: Any):
+        if v is None:
+            out.append(0xF6)
+        elif v is True:
+            out.append(0xF5)
+        elif v is False:
+            out.append(0xF4)
+        elif isinstance(v, int):
+            if v >= 0:
+                head(0, v)
+            else:
+                head(1, -1 - v)
+        elif isinstance(v, float):
+            try:
+                single = struct.pack(">f", v)
+            except OverflowError:
+                single = None
+            if single is not None and struct.unpack(">f", single)[0] == v:
+                out.append(0xFA)
+                out.extend(single)
+            else:
+                out.append(0xFB)
+                out.extend(struct.pack(">d", v))
+        elif isinstance(v, str):
+            data = v.encode("utf-8")
+            head(3, len(data))
+            out.extend(data)
+        elif isinstance(v, (bytes, bytearray)):
+            head(2, len(v))
+            out.extend(v)
+        elif isinstance(v, (list, tuple)):
+            head(4, len(v))
+            for element in v:
+                item(element)
+        elif isinstance(v, dict):
+            head(5, len(v))
+            for key, element in v.items():
+                item(str(key))
+                item(element)
+        else:
+            raise TypeError(f"cannot encode {type(v).__name__}")
+
+    item(value)
+    return bytes(out)
+
+
+def cbor_decode(data: bytes, pos: int = 0) -> Tuple[Any, int]:
+    """Decode one CBOR item; returns (value, position after the item)"""
+
+    def need(n: int):
+        if pos + n > len(data):
+            raise CborShort()
+
+    need(1)
+    initial = data[pos]
+    pos += 1
+    major, info = initial >> 5, initial & 0x1F
+
+    if info < 24:
+        arg = info
+    elif info <= 27:
+        n = 1 << (info - 24)
+        need(n)
+        arg = int.from_bytes(data[pos:pos + n], "big")
+        pos += n
+    elif info == 31 and major in (2, 3, 4, 5, 7):
+        arg = None
+    else:
+        raise CborError(f"reserved additional information {info}")
+
+    if major == 0:
+        return arg, pos
+    if major == 1:
+        return -1 - arg, pos
+    if major in (2, 3):
+        if arg is None:
+            chunks = []
+            while True:
+                need(1)
+                if data[pos] == 0xFF:
+                    pos += 1
+                    break
+                chunk, pos = cbor_decode(data, pos)
+                chunks.append(chunk)
+            return (b"" if major == 2 else "").join(chunks), pos
+        need(arg)
+        raw = bytes(data[pos:pos + arg])
+        pos += arg
+        return (raw if major == 2 else raw.decode("utf-8")), pos
+    if major in (4, 5):
+        container = [] if major == 4 else {}
+        count = 0
+        while arg is None or count < arg:
+            if arg is None:
+                need(1)
+                if data[pos] == 0xFF:
+                    pos += 1
+                    break
+            if major == 4:
+                element, pos = cbor_decode(data, pos)
+                container.append(element)
+            else:
+                key, pos = cbor_decode(data, pos)
+                container[key], pos = cbor_decode(data, pos)
+            count += 1
+        return container, pos
+    if major == 6:
+        return cbor_decode(data, pos)
+
+    # Major type 7: simple values and floats
+    if info == 20:
+        return False, pos
+    if info == 21:
+        return True, pos
+    if info == 25:
+        return struct.unpack(">e", arg.to_bytes(2, "big"))[0], pos
+    if info == 26:
+        return struct.unpack(">f", arg.to_bytes(4, "big"))[0], pos
+    if info == 27:
+        return struct.unpack(">d", arg.to_bytes(8, "big"))[0], pos
+    if info == 31:
+        raise CborError("unexpected break")
+    return None, pos
+
+
+class Session:
+    """One MCP connection in a fixed encoding"""
+
+    def __init__(self, host: str, port: int, encoding: str, timeout: float = 10.0):
+        self.encoding = encoding
+        self.socket = socket.create_connection((host, port), timeout=timeout)
+        self.buffer = bytearray()
+        self.message_id = 1
+        self.wire = "json"
+
+    def close(self):
+        self.socket.close()
+
+    def encode(self, message: Dict[str, Any]) -> bytes:
+        if self.wire == "cbor":
+            return cbor_encode(message)
+        return json.dumps(message, separators=(",", ":")).encode("utf-8") + b"\n"
+
+    def receive(self) -> bytes:
+        """Read the raw bytes of one message"""
+        while True:
+            if self.wire == "cbor":
+                # CBOR items carry no delimiter; decoding is the only way to find the end
+                try:
+                    _, end = cbor_decode(self.buffer)
+                    raw = bytes(self.buffer[:end])
+                    del self.buffer[:end]
+                    return raw
+                except CborShort:
+                    pass
+            else:
+                newline = self.buffer.find(b"\n")
+                if newline >= 0:
+                    raw = bytes(self.buffer[:newline + 1])
+                    del self.buffer[:newline + 1]
+                    return raw
+
+            chunk = self.socket.recv(65536)
+            if not chunk:
+                raise ConnectionError("connection closed by server")
+            self.buffer.extend(chunk)
+
+    def decode(self, raw: bytes) -> Dict[str, Any]:
+        return cbor_decode(raw)[0] if self.wire == "cbor" else json.loads(raw)
+
+    def call(self, method: str, params: Optional[Dict[str, Any]] = None) -> Dict[str, Any]:
+        request = {"jsonrpc": "2.0", "method": method, "id": self.message_id}
+        if params is not None:
+            request["params"] = params
+        self.message_id += 1
+        self.socket.sendall(self.encode(request))
+        response = self.decode(self.receive())
+        if "error" in response:
+            raise RuntimeError(f"{method} failed: {response['error']}")
+        return response["result"]
+
+    def initialize(self):
+        accept = ["cbor", "json"] if self.encoding == "cbor" else ["json"]
+        result = self.call("initialize", {
+            "protocolVersion": "2024-11-05",
+            "capabilities": {"experimental": {"encoding": {"accept": accept}}},
+            "clientInfo": {"name": "mcp_encoding_bench", "version": "1.0.0"},
+        })
+        selected = result.get("capabilities", {}).get("experimental", {}).get("encoding", {}).get("selected", "json")
+        if selected != self.encoding:
+            raise RuntimeError(f"server selected {selected}, wanted {self.encoding}")
+
+        # The initialize response is the last message in the old encoding
+        self.wire = selected
+        notification = {"jsonrpc": "2.0", "method": "notifications/initialized"}
+        self.socket.sendall(self.encode(notification))
+
+    def timed_call(self, method: str, params: Dict[str, Any]) -> Dict[str, float]:
+        request = {"jsonrpc": "2.0", "method": method, "id": self.message_id, "params": params}
+        self.message_id += 1
+
+        start = time.perf_counter()
+        data = self.encode(request)
+        encoded = time.perf_counter()
+        self.socket.sendall(data)
+        raw = self.receive()
+        received = time.perf_counter()
+        response = self.decode(raw)
+        decoded = time.perf_counter()
+
+        if "error" in response:
+            raise RuntimeError(f"{method} failed: {response['error']}")
+        return {
+            "request_bytes": len(data),
+            "response_bytes": len(raw),
+            "encode_us": (encoded - start) * 1e6,
+            "decode_us": (decoded - received) * 1e6,
+            "rtt_ms": (received - encoded) * 1e3,  # Includes CBOR framing on the client
+        }
+
+
+def schema_arguments(schema: Dict[str, Any]) -> Dict[str, Any]:
+    """Build arguments for an unknown tool from its input schema"""
+    defaults = {"string": "bench", "integer": 1, "number": 1.5, "boolean": False, "array": [], "object": {}}
+    properties = schema.get("properties", {})
+    arguments = {}
+    for name in schema.get("required", []):
+        prop = properties.get(name, {})
+        if "default" in prop:
+            arguments[name] = prop["default"]
+        elif prop.get("enum"):
+            arguments[name] = prop["enum"][0]
+        else:
+            arguments[name] = defaults.get(prop.get("type"), None)
+    return arguments
+
+
+def device_phases(metrics: Dict[str, Any]) -> Dict[str, int]:
+    """p50 parse and serialize time of tools/call in a metrics window"""
+    fields = metrics.get("fields", [])
+    entry = metrics.get("methods", {}).get("tools/call")
+    if not entry or "p50_us" not in fields:
+        return {}
+    p50 = fields.index("p50_us")
+    return {phase: entry[phase][p50] for phase in ("parse", "serialize") if phase in entry}
+
+
+def bench_tool(session: Session, name: str, arguments: Dict[str, Any], iterations: int) -> Dict[str, float]:
+    session.call("server/metrics", {"reset": True})
+
+    samples = [session.timed_call("tools/call", {"name": name, "arguments": arguments})
+               for _ in range(iterations)]
+
+    result = {key: statistics.median(s[key] for s in samples) for key in samples[0]}
+    phases = device_phases(session.call("server/metrics"))
+    result["device_parse_us"] = phases.get("parse", float("nan"))
+    result["device_serialize_us"] = phases.get("serialize", float("nan"))
+    return result
+
+
+def print_report(results: Dict[str, Dict[str, Dict[str, float]]]):
+    columns = [
+        ("request_bytes", "req B", "{:.0f}"),
+        ("response_bytes", "resp B", "{:.0f}"),
+        ("encode_us", "enc us", "{:.1f}"),
+        ("decode_us", "dec us", "{:.1f}"),
+        ("device_parse_us", "dev parse", "{:.0f}"),
+        ("device_serialize_us", "dev ser", "{:.0f}"),
+        ("rtt_ms", "rtt ms", "{:.2f}"),
+    ]
+
+    header = f"{'tool':<18}{'enc':<6}" + "".join(f"{title:>11}" for _, title, _ in columns)
+    print(header)
+    print("-" * len(header))
+    for tool, by_encoding in results.items():
+        for encoding, row in by_encoding.items():
+            cells = "".join(f"{fmt.format(row[key]):>11}" for key, _, fmt in columns)
+            print(f"{tool:<18}{encoding:<6}{cells}")
+        if "json" in by_encoding and "cbor" in by_encoding:
+            json_bytes = by_encoding["json"]["request_bytes"] + by_encoding["json"]["response_bytes"]
+            cbor_bytes = by_encoding["cbor"]["request_bytes"] + by_encoding["cbor"]["response_bytes"]
+            print(f"{'':<18}{'':<6}  CBOR is {100.0 * cbor_bytes / json_bytes:.0f}% of JSON on the wire")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare JSON and CBOR encodings of the ESP32-C6 MCP server")
+    parser.add_argument("host", help="ESP32-C6 IP address")
+    parser.add_argument("--port", type=int, default=8080, help="MCP TCP port (default: 8080)")
+    parser.add_argument("--iterations", type=int, default=50, help="Calls per tool and encoding (default: 50)")
+    parser.add_argument("--json-output", metavar="FILE", help="Also write the results as JSON")
+    args = parser.parse_args()
+
+    results: Dict[str, Dict[str, Dict[str, float]]] = {}
+    try:
+        for encoding in ("json", "cbor"):
+            session = Session(args.host, args.port, encoding)
+            try:
+                session.initialize()
+                tools: List[Dict[str, Any]] = session.call("tools/list")["tools"]
+                for tool in tools:
+                    name = tool["name"]
+                    arguments = SAMPLE_ARGUMENTS.get(name) or schema_arguments(tool.get("inputSchema", {}))
+                    results.setdefault(name, {})[encoding] = bench_tool(session, name, arguments, args.iterations)
+            finally:
+                session.close()
+    except (OSError, RuntimeError, CborError) as e:
+        print(f"❌ Benchmark failed: {e}")
+        sys.exit(1)
+
+    print_report(results)
+
+    if args.json_output:
+        with open(args.json_output, "w") as f:
+            json.dump(results, f, indent=2)
+        print(f"\n✅ Wrote results to {args.json_output}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+MCP Framing Test for ESP32-C6
+
+Checks that the TCP transport reassembles newline-delimited requests no
+matter how the byte stream is cut into segments. Each case sends a batch of
+ping requests and expects exactly one response per request id:
+
+- byte-by-byte: every byte in its own segment
+- coalesced: a batch of requests in a single send
+- random splits: the batch cut at random points (seeded, repeatable)
+- CRLF line endings and blank lines between requests
+- a request of exactly the longest accepted length
+- an oversized line followed by a valid request: one "Message too large"
+  error, then the valid request is answered normally
+
+Requests refused by the rate limiter still carry their id, so they count as
+correctly framed; a short pause between cases lets the limit recover.
+
+Usage:
+    python3 mcp_framing_test.py <esp32_ip> [--port 8080] [--buffer-size 2048]
+                                [--batch 8] [--splits 20] [--seed 1]
+"""
+
+import argparse
+import json
+import random
+import socket
+import sys
+import time
+from typing import Dict, List, Optional
+
+# Error code of a line longer than the receive buffer (mcp_server_simple.h)
+ERROR_INVALID_REQUEST = -32600
+
+# Pause between cases so the per-client rate limit refills
+CASE_PAUSE_S = 1.0
+
+
+class FramingConnection:
+    """Connection that controls how requests are cut into segments"""
+
+    def __init__(self, host: str, port: int, timeout: float = 5.0):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.buffer = b""
+
+    def send_segments(self, data: bytes, cuts: List[int], gap: float = 0.0):
+        """Send data split at the given offsets, one send per segment"""
+        start = 0
+        for cut in sorted(set(cuts)) + [len(data)]:
+            if cut > start:
+                self.sock.sendall(data[start:cut])
+                start = cut
+                if gap:
+                    time.sleep(gap)
+
+    def receive(self) -> Optional[Dict]:
+        while b"\n" not in self.buffer:
+            data = self.sock.recv(65536)
+            if not data:
+                return None
+            self.buffer += data
+        line, self.buffer = self.buffer.split(b"\n", 1)
+        return json.loads(line)
+
+    def close(self):
+        self.sock.close()
+
+
+def ping(request_id, padding: int = 0) -> bytes:
+    """A ping request, optionally padded with whitespace to a given length"""
+    text = json.dumps({"jsonrpc": "2.0", "id": request_id, "method": "ping"}, separators=(",", ":"))
+    return (text[:-1] + " " * padding + "}").encode()
+
+
+def expect_ids(conn: FramingConnection, ids: List) -> Optional[str]:
+    """Read one response per id; returns a failure description or None"""
+    seen = []
+    try:
+        while len(seen) < len(ids):
+            response = conn.receive()
+            if response is None:
+                return f"connection closed after {len(seen)} of {len(ids)} responses"
+            seen.append(response.get("id"))
+    except socket.timeout:
+        return f"timed out after {len(seen)} of {len(ids)} responses"
+    except json.JSONDecodeError as e:
+        return f"response is not one JSON line: {e}"
+    if sorted(map(str, seen)) != sorted(map(str, ids)):
+        return f"expected ids {ids}, got {seen}"
+    return None
+
+
+def run_case(args, name: str, ids: List, data: bytes, cuts: List[int], gap: float = 0.0) -> bool:
+    conn = FramingConnection(args.host, args.port)
+    try:
+        conn.send_segments(data, cuts, gap)
+        failure = expect_ids(conn, ids)
+    finally:
+        conn.close()
+    print(f"  {'ok  ' if not failure else 'FAIL'} {name}" + (f": {failure}" if failure else ""))
+    time.sleep(CASE_PAUSE_S)
+    return failure is None
+
+
+def batch(first_id: int, count: int, line_end: bytes = b"\n") -> bytes:
+    return b"".join(ping(first_id + i) + line_end for i in range(count))
+
+
+def run_oversized(args) -> bool:
+    """An oversized line is answered once; the next request still works"""
+    conn = FramingConnection(args.host, args.port)
+    failure = None
+    try:
+        oversized = b'{"jsonrpc":"2.0","id":"big","method":"ping","pad":"' + b"x" * (args.buffer_size * 2) + b'"}\n'
+        data = oversized + ping("after") + b"\n"
+        conn.send_segments(data, list(range(0, len(data), 700)))
+        responses = []
+        while len(responses) < 2:
+            response = conn.receive()
+            if response is None:
+                failure = "connection closed"
+                break
+            responses.append(response)
+        if not failure:
+            error = responses[0].get("error", {})
+            if error.get("code") != ERROR_INVALID_REQUEST:
+                failure = f"expected a Message too large error first, got {responses[0]}"
+            elif responses[1].get("id") != "after":
+                failure = f"expected the response to 'after', got {responses[1]}"
+    except socket.timeout:
+        failure = "timed out"
+    finally:
+        conn.close()
+    print(f"  {'ok  ' if not failure else 'FAIL'} oversized line then valid request" +
+          (f": {failure}" if failure else ""))
+    time.sleep(CASE_PAUSE_S)
+    return failure is None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Test request framing of the ESP32-C6 MCP TCP transport")
+    parser.add_argument("host", help="ESP32-C6 IP address")
+    parser.add_argument("--port", type=int, default=8080, help="MCP TCP port (default: 8080)")
+    parser.add_argument("--buffer-size", type=int, default=2048,
+                        help="Transport receive buffer size (default: 2048)")
+    parser.add_argument("--batch", type=int, default=8, help="Requests per batch (default: 8)")
+    parser.add_argument("--splits", type=int, default=20, help="Random split rounds (default: 20)")
+    parser.add_argument("--seed", type=int, default=1, help="Random seed (default: 1)")
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    results = []
+    print(f"Framing test against {args.host}:{args.port}")
+
+    try:
+        data = ping(1) + b"\n"
+        results.append(run_case(args, "byte-by-byte", [1], data, list(range(len(data))), gap=0.002))
+
+        data = batch(100, args.batch)
+        results.append(run_case(args, "coalesced batch", list(range(100, 100 + args.batch)), data, []))
+
+        ids = list(range(200, 200 + args.batch))
+        data = batch(200, args.batch)
+        split_ok = True
+        for _ in range(args.splits):
+            cuts = rng.sample(range(1, len(data)), k=min(len(data) - 1, rng.randint(1, 12)))
+            conn = FramingConnection(args.host, args.port)
+            try:
+                conn.send_segments(data, cuts)
+                failure = expect_ids(conn, ids)
+            finally:
+                conn.close()
+            if failure:
+                print(f"  FAIL random splits at {sorted(cuts)}: {failure}")
+                split_ok = False
+                break
+            time.sleep(CASE_PAUSE_S)
+        if split_ok:
+            print(f"  ok   random splits ({args.splits} rounds)")
+        results.append(split_ok)
+
+        data = b"\r\n".join(ping(300 + i) for i in range(3)) + b"\r\n\n\r\n"
+        results.append(run_case(args, "CRLF and blank lines", [300, 301, 302], data, [5, 50]))
+
+        # The longest accepted message fills the buffer except for its newline
+        longest = ping("max", padding=args.buffer_size - 1 - len(ping("max")))
+        results.append(run_case(args, "message of the longest accepted length", ["max"],
+                                longest + b"\n", [args.buffer_size // 2]))
+
+        results.append(run_oversized(args))
+    except OSError as e:
+        print(f"Connection failed: {e}", file=sys.stderr)
+        sys.exit(2)
+
+    passed = sum(results)
+    print(f"{passed}/{len(results)} cases passed")
+    sys.exit(0 if passed == len(results) else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+"""
+MCP Load Test for ESP32-C6
+
+Checks that admission control keeps the server responsive for well-behaved
+clients while another client floods it. Each well-behaved client calls a
+tool at a steady rate and measures round-trip latency; the flooder pipelines
+requests as fast as the connection allows. The test runs a baseline phase
+with the well-behaved clients alone, then a phase with the flooder active,
+and reports:
+
+- latency percentiles of the well-behaved clients in both phases
+- how many of their requests were refused (they should not be)
+- how many flooder requests were served, rate limited or shed for overload
+
+Usage:
+    python3 mcp_load_test.py <esp32_ip> [--port 8080] [--clients 2] [--rate 5]
+                             [--duration 10] [--tool system_info]
+"""
+
+import argparse
+import json
+import socket
+import statistics
+import sys
+import threading
+import time
+from typing import Dict, List, Optional
+
+# Error codes of refused requests (mcp_server_simple.h)
+ERROR_RATE_LIMITED = -32001
+ERROR_OVERLOADED = -32002
+
+# Side-effect free arguments for the built-in tools
+SAMPLE_ARGUMENTS = {
+    "echo": {"message": "load test"},
+    "gpio_control": {"action": "get_status"},
+    "system_info": {"action": "get_info"},
+}
+
+
+class LineConnection:
+    """Newline-delimited JSON-RPC connection"""
+
+    def __init__(self, host: str, port: int, timeout: float = 10.0):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.buffer = b""
+
+    def send(self, message: Dict):
+        self.sock.sendall(json.dumps(message, separators=(",", ":")).encode() + b"\n")
+
+    def receive(self) -> Optional[Dict]:
+        while b"\n" not in self.buffer:
+            data = self.sock.recv(65536)
+            if not data:
+                return None
+            self.buffer += data
+        line, self.buffer = self.buffer.split(b"\n", 1)
+        return json.loads(line)
+
+    def close(self):
+        self.sock.close()
+
+
+def tool_call(request_id: int, tool: str) -> Dict:
+    return {
+        "jsonrpc": "2.0",
+        "id": request_id,
+        "method": "tools/call",
+        "params": {"name": tool, "arguments": SAMPLE_ARGUMENTS.get(tool, {})},
+    }
+
+
+def error_code(response: Dict) -> Optional[int]:
+    error = response.get("error")
+    return error.get("code") if isinstance(error, dict) else None
+
+
+class WellBehavedClient(threading.Thread):
+    """Calls a tool at a fixed rate, one request at a time"""
+
+    def __init__(self, host: str, port: int, tool: str, rate: float, stop: threading.Event):
+        super().__init__(daemon=True)
+        self.conn = LineConnection(host, port)
+        self.tool = tool
+        self.interval = 1.0 / rate
+        self.stop = stop
+        self.latencies_ms: List[float] = []
+        self.refused = 0
+        self.failed = 0
+
+    def run(self):
+        request_id = 0
+        next_send = time.monotonic()
+        try:
+            while not self.stop.is_set():
+                request_id += 1
+                start = time.perf_counter()
+                self.conn.send(tool_call(request_id, self.tool))
+                response = self.conn.receive()
+                if response is None:
+                    self.failed += 1
+                    break
+                elapsed_ms = (time.perf_counter() - start) * 1000
+                if error_code(response) in (ERROR_RATE_LIMITED, ERROR_OVERLOADED):
+                    self.refused += 1
+                else:
+                    self.latencies_ms.append(elapsed_ms)
+
+                next_send += self.interval
+                delay = next_send - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+                else:
+                    next_send = time.monotonic()
+        except OSError:
+            self.failed += 1
+        finally:
+            self.conn.close()
+
+
+class Flooder(threading.Thread):
+    """Pipelines requests as fast as possible and tallies the answers"""
+
+    def __init__(self, host: str, port: int, tool: str, stop: threading.Event):
+        super().__init__(daemon=True)
+        self.conn = LineConnection(host, port)
+        self.tool = tool
+        self.stop = stop
+        self.sent = 0
+        self.served = 0
+        self.rate_limited = 0
+        self.overloaded = 0
+        self.retry_after_ms: List[int] = []
+        self.reader = threading.Thread(target=self._read, daemon=True)
+
+    def _read(self):
+        try:
+            while True:
+                response = self.conn.receive()
+                if response is None:
+                    return
+                code = error_code(response)
+                if code == ERROR_RATE_LIMITED:
+                    self.rate_limited += 1
+                elif code == ERROR_OVERLOADED:
+                    self.overloaded += 1
+                else:
+                    self.served += 1
+                if code in (ERROR_RATE_LIMITED, ERROR_OVERLOADED):
+                    self.retry_after_ms.append(response["error"].get("data", {}).get("retryAfterMs", 0))
+        except OSError:
+            pass
+
+    def run(self):
+        self.reader.start()
+        try:
+            while not self.stop.is_set():
+                self.sent += 1
+                self.conn.send(tool_call(self.sent, self.tool))
+        except OSError:
+            pass
+        # Let the answers in flight arrive before closing
+        time.sleep(1.0)
+        self.conn.close()
+
+
+def percentile(values: List[float], fraction: float) -> float:
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(fraction * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def run_phase(args, flood: bool) -> Dict:
+    stop = threading.Event()
+    clients = [WellBehavedClient(args.host, args.port, args.tool, args.rate, stop)
+               for _ in range(args.clients)]
+    flooder = Flooder(args.host, args.port, args.tool, stop) if flood else None
+
+    for client in clients:
+        client.start()
+    if flooder:
+        flooder.start()
+    time.sleep(args.duration)
+    stop.set()
+    for client in clients:
+        client.join(timeout=5)
+    if flooder:
+        flooder.join(timeout=5)
+
+    latencies = [ms for client in clients for ms in client.latencies_ms]
+    result = {
+        "requests": len(latencies),
+        "refused": sum(client.refused for client in clients),
+        "failed": sum(client.failed for client in clients),
+    }
+    if latencies:
+        result.update({
+            "p50_ms": statistics.median(latencies),
+            "p95_ms": percentile(latencies, 0.95),
+            "p99_ms": percentile(latencies, 0.99),
+            "max_ms": max(latencies),
+        })
+    if flooder:
+        result["flooder"] = {
+            "sent": flooder.sent,
+            "served": flooder.served,
+            "rate_limited": flooder.rate_limited,
+            "overloaded": flooder.overloaded,
+            "retry_after_max_ms": max(flooder.retry_after_ms, default=0),
+        }
+    return result
+
+
+def print_phase(name: str, result: Dict):
+    print(f"{name}:")
+    if "p50_ms" in result:
+        print(f"  well-behaved  {result['requests']} requests  "
+              f"p50 {result['p50_ms']:.1f} ms  p95 {result['p95_ms']:.1f} ms  "
+              f"p99 {result['p99_ms']:.1f} ms  max {result['max_ms']:.1f} ms")
+    else:
+        print("  well-behaved  no successful requests")
+    print(f"  refused {result['refused']}  failed {result['failed']}")
+    flooder = result.get("flooder")
+    if flooder:
+        print(f"  flooder       sent {flooder['sent']}  served {flooder['served']}  "
+              f"rate limited {flooder['rate_limited']}  overloaded {flooder['overloaded']}  "
+              f"max retry-after {flooder['retry_after_max_ms']} ms")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Load test the admission control of the ESP32-C6 MCP server")
+    parser.add_argument("host", help="ESP32-C6 IP address")
+    parser.add_argument("--port", type=int, default=8080, help="MCP TCP port (default: 8080)")
+    parser.add_argument("--clients", type=int, default=2, help="Well-behaved clients (default: 2)")
+    parser.add_argument("--rate", type=float, default=5.0, help="Requests per second per well-behaved client (default: 5)")
+    parser.add_argument("--duration", type=float, default=10.0, help="Seconds per phase (default: 10)")
+    parser.add_argument("--tool", default="system_info", help="Tool to call (default: system_info)")
+    parser.add_argument("--json-output", metavar="FILE", help="Also write the results as JSON")
+    args = parser.parse_args()
+
+    try:
+        baseline = run_phase(args, flood=False)
+        print_phase("Baseline", baseline)
+        flooded = run_phase(args, flood=True)
+        print_phase("With flooder", flooded)
+    except OSError as e:
+        print(f"Connection failed: {e}", file=sys.stderr)
+        return 1
+
+    if args.json_output:
+        with open(args.json_output, "w") as f:
+            json.dump({"baseline": baseline, "flooded": flooded}, f, indent=2)
+
+    # Well-behaved clients stay within their rate limit and should never be refused
+    if flooded["refused"] or flooded["failed"]:
+        print("FAIL: well-behaved clients were refused or disconnected")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+"""
+MCP Trace Exporter for ESP32-C6
+
+Pulls the request lifecycle trace ring from the ESP32-C6 MCP server with the
+debug/trace_dump method and converts it to Chrome trace JSON, which can be
+opened in chrome://tracing or https://ui.perfetto.dev.
+
+Usage:
+    python3 mcp_trace_to_chrome.py <esp32_ip> [-o trace.json] [--save-raw dump.json]
+    python3 mcp_trace_to_chrome.py --from-raw dump.json [-o trace.json]
+"""
+
+import argparse
+import base64
+import json
+import socket
+import struct
+import sys
+from typing import Any, Dict, List, Optional
+
+# Wire record: timestamp_us, request_id, arg, client_id, event, reserved
+RECORD = struct.Struct("<IIIHBB")
+FORMAT_VERSION = 1
+
+# mcp_trace_event_t -> (name, phase); phase is "b"/"e" for spans, "i" for instants
+EVENTS = {
+    1: ("accept", "i"),
+    2: ("close", "i"),
+    3: ("recv", "i"),
+    4: ("submit", "i"),
+    5: ("parse", "b"),
+    6: ("parse", "e"),
+    7: ("dispatch", "b"),
+    8: ("dispatch", "e"),
+    9: ("tool", "b"),
+    10: ("tool", "e"),
+    11: ("serialize", "b"),
+    12: ("serialize", "e"),
+    13: ("send", "b"),
+    14: ("send", "e"),
+    15: ("shed", "i"),
+}
+
+# Events whose argument is the hash of a method or tool name
+NAMED_EVENTS = {7, 9}
+
+
+class TraceDumper:
+    def __init__(self, host: str, port: int = 8080, timeout: float = 10.0):
+        self.host = host
+        self.port = port
+        self.timeout = timeout
+        self.socket: Optional[socket.socket] = None
+        self.reader = None
+        self.message_id = 1
+
+    def connect(self):
+        self.socket = socket.create_connection((self.host, self.port), timeout=self.timeout)
+        self.reader = self.socket.makefile("r", encoding="utf-8")
+
+    def close(self):
+        if self.reader:
+            self.reader.close()
+        if self.socket:
+            self.socket.close()
+
+    def call(self, method: str, params: Dict[str, Any]) -> Dict[str, Any]:
+        request = {"jsonrpc": "2.0", "method": method, "id": self.message_id, "params": params}
+        self.message_id += 1
+        self.socket.sendall((json.dumps(request) + "\n").encode("utf-8"))
+
+        line = self.reader.readline()
+        if not line:
+            raise ConnectionError("connection closed by server")
+        response = json.loads(line)
+        if "error" in response:
+            raise RuntimeError(f"{method} failed: {response['error']}")
+        return response["result"]
+
+    def dump(self) -> Dict[str, Any]:
+        """Page through the ring once, stopping at the head seen on the first page"""
+        first = self.call("debug/trace_dump", {"names": True})
+        if first.get("version") != FORMAT_VERSION:
+            raise RuntimeError(f"unsupported trace format {first.get('version')}")
+
+        stop_at = first["head"]
+        pages = [first["data"]]
+        cursor = first["next"]
+        more = first["more"]
+        while more and cursor != stop_at:
+            page = self.call("debug/trace_dump", {"cursor": cursor})
+            if not page["data"]:
+                break
+            pages.append(page["data"])
+            cursor = page["next"]
+            more = page["more"]
+
+        return {
+            "version": first["version"],
+            "record_size": first["record_size"],
+            "names": first.get("names", {}),
+            "pages": pages,
+        }
+
+
+def decode_records(dump: Dict[str, Any]) -> List[tuple]:
+    if dump["record_size"] != RECORD.size:
+        raise ValueError(f"unexpected record size {dump['record_size']}")
+
+    records = []
+    for page in dump["pages"]:
+        data = base64.b64decode(page)
+        records.extend(RECORD.iter_unpack(data))
+    return records
+
+
+def to_chrome_trace(dump: Dict[str, Any]) -> Dict[str, Any]:
+    names = {int(k): v for k, v in dump.get("names", {}).items()}
+    events = []
+    clients = set()
+
+    # Timestamps are the low 32 bits of a microsecond clock; unwrap them
+    epoch = 0
+    last = None
+    for timestamp, request_id, arg, client_id, event, _ in decode_records(dump):
+        if last is not None and timestamp < last and last - timestamp > 0x80000000:
+            epoch += 1 << 32
+        last = timestamp
+
+        name, phase = EVENTS.get(event, (f"event_{event}", "i"))
+        if event in NAMED_EVENTS and phase == "b" and arg in names:
+            name = f"{name} {names[arg]}"
+
+        entry = {
+            "name": name,
+            "cat": "mcp",
+            "ph": phase,
+            "ts": epoch + timestamp,
+            "pid": 1,
+            "tid": client_id,
+            "args": {"request": request_id, "arg": arg},
+        }
+        if phase == "i":
+            entry["s"] = "t"
+        else:
+            # Pipelined requests overlap on one client, so spans are async per request
+            entry["id"] = request_id
+        events.append(entry)
+        clients.add(client_id)
+
+    # Async end events must carry the same name as their begin event
+    open_spans: Dict[tuple, str] = {}
+    for entry in events:
+        if entry["ph"] == "b":
+            open_spans[(entry["id"], entry["name"].split(" ")[0])] = entry["name"]
+        elif entry["ph"] == "e":
+            key = (entry["id"], entry["name"].split(" ")[0])
+            entry["name"] = open_spans.pop(key, entry["name"])
+
+    metadata = [{"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "ESP32-C6 MCP"}}]
+    for client_id in sorted(clients):
+        label = f"client {client_id}" if client_id else "server"
+        metadata.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": client_id, "args": {"name": label}})
+
+    return {"traceEvents": metadata + events, "displayTimeUnit": "ms"}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Export the ESP32-C6 MCP trace ring as Chrome trace JSON")
+    parser.add_argument("host", nargs="?", help="ESP32-C6 IP address")
+    parser.add_argument("--port", type=int, default=8080, help="MCP TCP port (default: 8080)")
+    parser.add_argument("-o", "--output", default="mcp_trace.json", help="Chrome trace output file")
+    parser.add_argument("--save-raw", metavar="FILE", help="Also save the raw dump for later conversion")
+    parser.add_argument("--from-raw", metavar="FILE", help="Convert a raw dump instead of connecting")
+    args = parser.parse_args()
+
+    if args.from_raw:
+        with open(args.from_raw) as f:
+            dump = json.load(f)
+    elif args.host:
+        dumper = TraceDumper(args.host, args.port)
+        try:
+            dumper.connect()
+            dump = dumper.dump()
+        except (OSError, RuntimeError, ValueError) as e:
+            print(f"❌ Failed to dump trace: {e}")
+            sys.exit(1)
+        finally:
+            dumper.close()
+    else:
+        parser.error("either an ESP32-C6 IP address or --from-raw is required")
+
+    if args.save_raw:
+        with open(args.save_raw, "w") as f:
+            json.dump(dump, f)
+
+    trace = to_chrome_trace(dump)
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+
+    record_count = len(trace["traceEvents"]) - sum(1 for e in trace["traceEvents"] if e["ph"] == "M")
+    print(f"✅ Wrote {record_count} trace events to {args.output}")
+
+
+if __name__ == "__main__":
+    main()